@@ -0,0 +1,181 @@
+#include "chunk_map.h"
+
+using namespace std;
+
+// Buckets por shard no começo; dobra quando passa de 2 nós por bucket
+const size_t BUCKETS_INICIAIS = 64;
+
+// 21 bits com sinal por eixo (±1 milhão de chunks)
+uint64_t ConcurrentChunkMap::key(int x, int y, int z) {
+    const uint64_t m = (1u << 21) - 1;
+    return ((uint64_t)x & m) | (((uint64_t)y & m) << 21) | (((uint64_t)z & m) << 42);
+}
+
+void ConcurrentChunkMap::unpackKey(uint64_t chave, int& x, int& y, int& z) {
+    auto eixo = [](uint64_t v) { return (int)((int64_t)(v << 43) >> 43); };
+    x = eixo(chave & ((1u << 21) - 1));
+    y = eixo((chave >> 21) & ((1u << 21) - 1));
+    z = eixo((chave >> 42) & ((1u << 21) - 1));
+}
+
+// Mistura dos bits (finalizador do MurmurHash3): os de cima escolhem o shard e os de
+// baixo o bucket
+uint64_t ConcurrentChunkMap::espalha(uint64_t chave) {
+    chave ^= chave >> 33;
+    chave *= 0xff51afd7ed558ccdull;
+    chave ^= chave >> 33;
+    chave *= 0xc4ceb9fe1a85ec53ull;
+    chave ^= chave >> 33;
+    return chave;
+}
+
+ConcurrentChunkMap::Table* ConcurrentChunkMap::novaTabela(size_t buckets) {
+    Table* t = new Table();
+    t->mask = buckets - 1;
+    t->buckets.reset(new atomic<Node*>[buckets]);
+    for (size_t i = 0; i < buckets; i++)
+        t->buckets[i].store(nullptr, memory_order_relaxed);
+    return t;
+}
+
+ConcurrentChunkMap::ConcurrentChunkMap(int numShards) {
+    size_t n = 1;
+    while ((int)n < numShards)
+        n *= 2;
+    shards.reset(new Shard[n]);
+    mascaraShards = n - 1;
+    for (size_t i = 0; i < n; i++)
+        shards[i].tabela.store(novaTabela(BUCKETS_INICIAIS), memory_order_relaxed);
+}
+
+// Sem leitores (quem destrói é o dono): apaga direto
+ConcurrentChunkMap::~ConcurrentChunkMap() {
+    for (size_t s = 0; s <= mascaraShards; s++) {
+        Table* t = shards[s].tabela.load(memory_order_relaxed);
+        for (size_t b = 0; b <= t->mask; b++) {
+            Node* n = t->buckets[b].load(memory_order_relaxed);
+            while (n) {
+                Node* proximo = n->next.load(memory_order_relaxed);
+                delete n->chunk.load(memory_order_relaxed);
+                delete n;
+                n = proximo;
+            }
+        }
+        delete t;
+    }
+}
+
+const Chunk* ConcurrentChunkMap::find(int x, int y, int z) const {
+    uint64_t chave = key(x, y, z), h = espalha(chave);
+    const Table* t = shardDe(h).tabela.load(memory_order_acquire);
+    for (Node* n = t->buckets[h & t->mask].load(memory_order_acquire); n; n = n->next.load(memory_order_acquire))
+        if (n->chave == chave)
+            return n->chunk.load(memory_order_acquire);
+    return nullptr;
+}
+
+bool ConcurrentChunkMap::insert(int x, int y, int z, unique_ptr<Chunk> chunk) {
+    uint64_t chave = key(x, y, z), h = espalha(chave);
+    Shard& shard = shardDe(h);
+    lock_guard<mutex> lock(shard.trava);
+    Table* t = shard.tabela.load(memory_order_relaxed);
+    atomic<Node*>& bucket = t->buckets[h & t->mask];
+    for (Node* n = bucket.load(memory_order_relaxed); n; n = n->next.load(memory_order_relaxed)) {
+        if (n->chave == chave) {
+            Chunk* antigo = n->chunk.exchange(chunk.release(), memory_order_acq_rel);
+            epochRetire(antigo);
+            return false;
+        }
+    }
+    // O nó fica pronto antes de aparecer na lista (release no bucket)
+    Node* novo = new Node();
+    novo->chave = chave;
+    novo->chunk.store(chunk.release(), memory_order_relaxed);
+    novo->next.store(bucket.load(memory_order_relaxed), memory_order_relaxed);
+    bucket.store(novo, memory_order_release);
+    total.fetch_add(1, memory_order_relaxed);
+    if (++shard.count > 2 * (t->mask + 1))
+        cresce(shard);
+    return true;
+}
+
+// Com a trava do shard: uma tabela com o dobro de buckets e nós novos (os antigos
+// continuam encadeados para quem ainda os percorre e são aposentados com a tabela)
+void ConcurrentChunkMap::cresce(Shard& shard) {
+    Table* antiga = shard.tabela.load(memory_order_relaxed);
+    Table* nova = novaTabela(2 * (antiga->mask + 1));
+    for (size_t b = 0; b <= antiga->mask; b++) {
+        for (Node* n = antiga->buckets[b].load(memory_order_relaxed); n; n = n->next.load(memory_order_relaxed)) {
+            atomic<Node*>& destino = nova->buckets[espalha(n->chave) & nova->mask];
+            Node* copia = new Node();
+            copia->chave = n->chave;
+            copia->chunk.store(n->chunk.load(memory_order_relaxed), memory_order_relaxed);
+            copia->next.store(destino.load(memory_order_relaxed), memory_order_relaxed);
+            destino.store(copia, memory_order_relaxed);
+        }
+    }
+    shard.tabela.store(nova, memory_order_release);
+
+    // Os chunks passaram para os nós novos: só os nós e a tabela vão embora
+    for (size_t b = 0; b <= antiga->mask; b++) {
+        Node* n = antiga->buckets[b].load(memory_order_relaxed);
+        while (n) {
+            Node* proximo = n->next.load(memory_order_relaxed);
+            epochRetire(n);
+            n = proximo;
+        }
+    }
+    epochRetire(antiga);
+}
+
+bool ConcurrentChunkMap::erase(int x, int y, int z) {
+    uint64_t chave = key(x, y, z), h = espalha(chave);
+    Shard& shard = shardDe(h);
+    lock_guard<mutex> lock(shard.trava);
+    Table* t = shard.tabela.load(memory_order_relaxed);
+    atomic<Node*>* anterior = &t->buckets[h & t->mask];
+    for (Node* n = anterior->load(memory_order_relaxed); n; n = n->next.load(memory_order_relaxed)) {
+        if (n->chave == chave) {
+            // Quem está parado em n ainda segue n->next, que continua válido
+            anterior->store(n->next.load(memory_order_relaxed), memory_order_release);
+            epochRetire(n->chunk.load(memory_order_relaxed));
+            epochRetire(n);
+            shard.count--;
+            total.fetch_sub(1, memory_order_relaxed);
+            return true;
+        }
+        anterior = &n->next;
+    }
+    return false;
+}
+
+void ConcurrentChunkMap::clear() {
+    for (size_t s = 0; s <= mascaraShards; s++) {
+        Shard& shard = shards[s];
+        lock_guard<mutex> lock(shard.trava);
+        Table* t = shard.tabela.load(memory_order_relaxed);
+        for (size_t b = 0; b <= t->mask; b++) {
+            Node* n = t->buckets[b].exchange(nullptr, memory_order_acq_rel);
+            while (n) {
+                Node* proximo = n->next.load(memory_order_relaxed);
+                epochRetire(n->chunk.load(memory_order_relaxed));
+                epochRetire(n);
+                n = proximo;
+            }
+        }
+        total.fetch_sub(shard.count, memory_order_relaxed);
+        shard.count = 0;
+    }
+}
+
+void ConcurrentChunkMap::keys(vector<uint64_t>& saida) const {
+    saida.clear();
+    for (size_t s = 0; s <= mascaraShards; s++) {
+        Shard& shard = shards[s];
+        lock_guard<mutex> lock(shard.trava);
+        const Table* t = shard.tabela.load(memory_order_relaxed);
+        for (size_t b = 0; b <= t->mask; b++)
+            for (Node* n = t->buckets[b].load(memory_order_relaxed); n; n = n->next.load(memory_order_relaxed))
+                saida.push_back(n->chave);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "epoch.h"
+#include "world.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Chunks por coordenada de chunk (com sinal: o streaming não tem limites de mundo)
+// para várias threads ao mesmo tempo. Leituras não travam: seguem ponteiros atômicos
+// dentro de uma seção de época (EpochGuard) e o chunk devolvido vale até o fim dela.
+// Escritas travam só o shard da chave. Nós e chunks removidos ou substituídos são
+// aposentados (epochRetire), nunca apagados na hora, então nenhum leitor vê memória
+// liberada. Os chunks publicados são tratados como imutáveis: para mudar um, quem
+// escreve põe uma cópia nova com insert
+class ConcurrentChunkMap {
+public:
+    // shards é arredondado para potência de dois
+    explicit ConcurrentChunkMap(int shards = 16);
+    ~ConcurrentChunkMap();
+    ConcurrentChunkMap(const ConcurrentChunkMap&) = delete;
+    ConcurrentChunkMap& operator=(const ConcurrentChunkMap&) = delete;
+
+    static uint64_t key(int x, int y, int z);
+    static void unpackKey(uint64_t chave, int& x, int& y, int& z);
+
+    // Sem trava. Chamar dentro de um EpochGuard; nullptr se não houver
+    const Chunk* find(int x, int y, int z) const;
+
+    // Põe o chunk (substitui e aposenta o anterior). Devolve true se era novo
+    bool insert(int x, int y, int z, std::unique_ptr<Chunk> chunk);
+    // Tira e aposenta. Devolve false se não havia
+    bool erase(int x, int y, int z);
+    // Tira todos
+    void clear();
+
+    size_t size() const { return total.load(std::memory_order_relaxed); }
+
+    // Todas as chaves (cópia feita shard a shard, com a trava de cada um)
+    void keys(std::vector<uint64_t>& saida) const;
+
+private:
+    struct Node {
+        uint64_t chave;
+        std::atomic<Chunk*> chunk;
+        std::atomic<Node*> next;
+    };
+    struct Table {
+        size_t mask;
+        std::unique_ptr<std::atomic<Node*>[]> buckets;
+    };
+    struct alignas(64) Shard {
+        std::mutex trava;
+        std::atomic<Table*> tabela{ nullptr };
+        size_t count = 0;             // com a trava
+    };
+
+    static uint64_t espalha(uint64_t chave);
+    static Table* novaTabela(size_t buckets);
+    void cresce(Shard& shard);
+    Shard& shardDe(uint64_t h) const { return shards[(h >> 48) & mascaraShards]; }
+
+    std::unique_ptr<Shard[]> shards;
+    size_t mascaraShards = 0;
+    std::atomic<size_t> total{ 0 };
+};
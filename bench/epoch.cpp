@@ -0,0 +1,153 @@
+#include "epoch.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+// Tentativa de liberação a cada tantas aposentadorias
+const int APOSENTADOS_POR_COLETA = 64;
+
+// Época publicada por uma thread: 0 fora de seção
+struct alignas(64) EpochSlot {
+    atomic<uint64_t> epoca{ 0 };
+    atomic<bool> livre{ false };
+    int profundidade = 0;         // só a própria thread mexe
+};
+
+struct Aposentado {
+    void* ponteiro;
+    void (*apagar)(void*);
+    uint64_t epoca;
+};
+
+static atomic<uint64_t> epocaGlobal(1);
+static mutex registro;            // slots e aposentados
+static vector<unique_ptr<EpochSlot>> slots;
+static vector<Aposentado> aposentados;
+static long long totalAposentados = 0, totalApagados = 0, avancos = 0;
+static int desdeColeta = 0;
+static thread_local EpochSlot* slotLocal = nullptr;
+
+// Devolve o slot quando a thread termina
+struct EpochSlotOwner {
+    ~EpochSlotOwner() {
+        if (slotLocal) {
+            slotLocal->epoca.store(0, memory_order_release);
+            slotLocal->livre.store(true, memory_order_release);
+        }
+    }
+};
+
+static EpochSlot* slotDaThread() {
+    if (slotLocal)
+        return slotLocal;
+    static thread_local EpochSlotOwner dono;
+    (void)dono;
+    lock_guard<mutex> lock(registro);
+    for (unique_ptr<EpochSlot>& s : slots) {
+        bool esperado = true;
+        if (s->livre.compare_exchange_strong(esperado, false)) {
+            slotLocal = s.get();
+            return slotLocal;
+        }
+    }
+    slots.push_back(make_unique<EpochSlot>());
+    slotLocal = slots.back().get();
+    return slotLocal;
+}
+
+void epochEnter() {
+    EpochSlot* s = slotDaThread();
+    if (s->profundidade++ > 0)
+        return;
+    // A época publicada antes de qualquer leitura da estrutura (seq_cst): quem avança
+    // a época ou vê esta thread na seção, ou a thread vê a estrutura já sem o objeto.
+    // Ler a época (acquire) também traz as remoções feitas antes do avanço; se ela
+    // andou entre a leitura e a publicação, publica de novo
+    uint64_t e = epocaGlobal.load(memory_order_acquire);
+    for (;;) {
+        s->epoca.store(e, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        uint64_t agora = epocaGlobal.load(memory_order_acquire);
+        if (agora == e)
+            break;
+        e = agora;
+    }
+}
+
+void epochExit() {
+    EpochSlot* s = slotLocal;
+    if (--s->profundidade > 0)
+        return;
+    s->epoca.store(0, memory_order_release);
+}
+
+// Com o registro travado: avança se todas as threads em seção já estão na época atual
+static bool tentaAvancar() {
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t atual = epocaGlobal.load(memory_order_relaxed);
+    for (const unique_ptr<EpochSlot>& s : slots) {
+        uint64_t e = s->epoca.load(memory_order_acquire);
+        if (e != 0 && e != atual)
+            return false;
+    }
+    epocaGlobal.store(atual + 1, memory_order_release);
+    avancos++;
+    return true;
+}
+
+// Com o registro travado: tira da lista o que já pode ser apagado
+static void separaLiberaveis(vector<Aposentado>& saida) {
+    uint64_t atual = epocaGlobal.load(memory_order_relaxed);
+    size_t mantidos = 0;
+    for (size_t i = 0; i < aposentados.size(); i++) {
+        if (aposentados[i].epoca + 2 <= atual)
+            saida.push_back(aposentados[i]);
+        else
+            aposentados[mantidos++] = aposentados[i];
+    }
+    aposentados.resize(mantidos);
+    totalApagados += (long long)saida.size();
+}
+
+size_t epochCollect() {
+    vector<Aposentado> liberaveis;
+    {
+        lock_guard<mutex> lock(registro);
+        tentaAvancar();
+        separaLiberaveis(liberaveis);
+        desdeColeta = 0;
+    }
+    // Os destrutores rodam fora da trava
+    for (const Aposentado& a : liberaveis)
+        a.apagar(a.ponteiro);
+    return liberaveis.size();
+}
+
+void epochRetire(void* p, void (*apagar)(void*)) {
+    bool coleta;
+    {
+        lock_guard<mutex> lock(registro);
+        aposentados.push_back({ p, apagar, epocaGlobal.load(memory_order_acquire) });
+        totalAposentados++;
+        coleta = ++desdeColeta >= APOSENTADOS_POR_COLETA;
+    }
+    if (coleta)
+        epochCollect();
+}
+
+EpochStats epochStats() {
+    lock_guard<mutex> lock(registro);
+    EpochStats s;
+    s.epoch = epocaGlobal.load(memory_order_relaxed);
+    s.retired = totalAposentados;
+    s.freed = totalApagados;
+    s.pending = (long long)aposentados.size();
+    s.advances = avancos;
+    for (const unique_ptr<EpochSlot>& slot : slots)
+        s.threads += slot->livre.load(memory_order_relaxed) ? 0 : 1;
+    return s;
+}
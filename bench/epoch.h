@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Reclamação de memória por épocas (EBR) para estruturas lidas sem trava. Um leitor
+// entra numa seção (EpochGuard) antes de seguir ponteiros compartilhados e sai ao
+// terminar; quem tira um objeto da estrutura não o apaga, aposenta (epochRetire). O
+// objeto só é apagado quando a época global andou duas vezes desde a aposentadoria: aí
+// nenhum leitor que pudesse tê-lo visto ainda está na seção. A época só anda quando
+// todas as threads dentro de uma seção já a viram, então uma seção longa segura a
+// liberação (não a leitura nem a escrita). Um domínio só, global, como o profiler;
+// cada thread ganha um slot na primeira seção e o devolve ao terminar
+
+// Seção de leitura. Pode aninhar (só a de fora publica a época)
+void epochEnter();
+void epochExit();
+
+struct EpochGuard {
+    EpochGuard() { epochEnter(); }
+    ~EpochGuard() { epochExit(); }
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+// Aposenta p: apagar(p) roda quando nenhum leitor puder mais alcançá-lo. Chamar
+// depois de tirar p da estrutura. A cada algumas aposentadorias tenta liberar
+void epochRetire(void* p, void (*apagar)(void*));
+
+template <typename T>
+void epochRetire(T* p) {
+    epochRetire(static_cast<void*>(p), [](void* q) { delete static_cast<T*>(q); });
+}
+
+// Tenta avançar a época e apaga o que já pode. Devolve quantos objetos apagou
+size_t epochCollect();
+
+struct EpochStats {
+    uint64_t epoch = 0;
+    long long retired = 0;
+    long long freed = 0;
+    long long pending = 0;
+    long long advances = 0;
+    int threads = 0;          // slots em uso
+};
+EpochStats epochStats();
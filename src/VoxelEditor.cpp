@@ -5,7 +5,31 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
-#include <fstream>
+#include <string>
+#include <cmath>
+#include <cctype>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "chunk_renderer.h"
+#include "chunk_streamer.h"
+#include "edit_queue.h"
+#include "frame_capture.h"
+#include "gl_ext.h"
+#include "headless.h"
+#include "hud.h"
+#include "input_log.h"
+#include "light.h"
+#include "materials.h"
+#include "oit.h"
+#include "profiler.h"
+#include "raymarch.h"
+#include "render_queue.h"
+#include "render_snapshot.h"
+#include "shader.h"
+#include "world.h"
 
 // STB_IMAGE
 #define STB_IMAGE_IMPLEMENTATION
@@ -16,6 +40,11 @@ using namespace std;
 // Dimensões da janela
 const GLuint WIDTH = 1200, HEIGHT = 800;
 
+// Tamanho atual do framebuffer (a janela redimensionada ou o do modo --headless) e
+// para onde presentOIT copia o frame (0 = janela)
+int larguraTela = WIDTH, alturaTela = HEIGHT;
+GLuint framebufferSaida = 0;
+
 // Variáveis globais de controle da câmera (posição, direção e orientação)
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 20.0f);
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -32,29 +61,116 @@ float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
 // IDs de shader e VAO
-GLuint shaderID, VAO;
+GLuint shaderID, shaderChunk, shaderChunkOIT, VAO;
 GLFWwindow* window;
 
-struct Voxel {
-    glm::vec3 pos;
-    float fatorEscala;
-    bool visivel = true, selecionado = false;
-    int texID;
-};
-
+// Mundo de voxels (TAM^3, pode ser alterado com --tam N)
+int TAM = 10;
+World world;
 int selecaoX = 0, selecaoY = 0, selecaoZ = 0;
-const int TAM = 10;
-Voxel grid[TAM][TAM][TAM];
-
-// Lista de texturas
-const int NUM_TEXTURES = 9;
-vector<string> textureNames = {
-    "Moss Block", "Glass", "Blackstone Bricks", "Sponge",
-    "Honey Block", "Loom", "Packed Mud", "Frosted Ice", "Selection"
-};
 
-// IDs das texturas
+// IDs das texturas (individuais e o array com todas as de bloco)
 GLuint texIDList[NUM_TEXTURES];
+GLuint blockTextureArray;
+
+// Plano far da projeção (também usado para quantizar a profundidade na fila)
+const float FAR_PLANE = 1000.0f;
+
+// Cor de fundo da cena
+const glm::vec3 COR_FUNDO = glm::vec3(0.1f, 0.1f, 0.1f);
+
+// Fila de desenho do frame, malhas dos chunks e o modo alternativo por raymarching
+// (que lê o espelho do mundo na GPU)
+RenderQueue renderQueue;
+ChunkRenderer chunkRenderer;
+GpuVolume volumeGPU;
+VoxelRaymarcher raymarcher;
+bool modoRaymarch = false;
+
+// Opções de desenho escolhidas pelas teclas (F2, F3, F5, F1). A thread principal só
+// as muda; quem as aplica ao chunkRenderer e ao HUD é o desenho, a partir do quadro
+bool lodLigado = true, cullingNaGPU = true, malhasNaGPU = false, mostrarHud = true;
+
+// Thread de render (modo interativo): dona do contexto de GL, desenha os quadros que a
+// thread principal publica em caixaRender, com os chunks copiados para mundoRender.
+// "quadro" é o estado do frame sendo desenhado e mundoDesenhado o mundo que ele lê;
+// nos outros modos tudo roda numa thread só e o desenho lê o próprio world. Na thread
+// de render as malhas são refeitas no máximo MALHAS_POR_QUADRO por frame: uma carga ou
+// um R que muda o mundo todo se espalha por alguns frames com as malhas antigas
+SnapshotMailbox caixaRender;
+const int MALHAS_POR_QUADRO = 96;
+World mundoRender;
+World* mundoDesenhado = &world;
+RenderSnapshot quadro;
+vector<int> chunksMudados;
+uint32_t geracaoPublicada = 0;
+
+// Luz do céu e dos blocos, atualizada a cada frame com as edições
+LightEngine luz;
+
+// Edições: os callbacks só mandam comandos (enviaEdicao). No modo interativo eles vão
+// pela fila sem trava para a thread do mundo, que os aplica em lotes, reacende e
+// publica os chunks para o desenho; nos outros modos são aplicados na hora. A entrada
+// vê o tamanho do mundo pelo que a thread do mundo publicou (tamanhoPublicado)
+EditQueue filaEdicoes;
+EditBatcher loteEdicoes;
+bool mundoEmThread = false;
+atomic<int> tamanhoPublicado[3];
+atomic<long long> lotesEdicao(0), comandosEdicao(0), comandosJuntados(0);
+const size_t MAX_LOTE = 1024;
+
+// Streaming (--streaming DIR, só no modo interativo): o mundo fica nas regiões e a thread
+// do mundo mantém na memória os chunks em volta da câmera (e de onde ela vai estar, pela
+// velocidade). Com leituras no disco a thread do mundo acorda a cada ESPERA_STREAMING
+ChunkStreamer streaming;
+string arquivoStreaming;
+glm::vec3 velocidadeCamera = glm::vec3(0.0f);
+const double ESPERA_STREAMING = 0.004;
+
+// Região: C marca um canto, F preenche do canto até a seleção com a textura do
+// pincel (a última escolhida com 1-9), Shift+F esvazia
+int cantoRegiao[3] = { 0, 0, 0 };
+int texturaPincel = 0;
+
+// Capturas da janela: F12 grava o frame atual, F11 liga/desliga a sequência contínua.
+// A leitura é assíncrona (FrameCapture) e a sequência descarta frames se a gravação
+// não acompanhar, para não segurar a renderização. As teclas só contam pedidos; o
+// desenho atende, numera e grava
+FrameCapture capturaTela;
+int pedidosCaptura = 0, capturasFeitas = 0;
+bool sequenciaPedida = false, capturaContinua = false;
+int numeroCaptura = 0, numeroSequencia = 0, quadroSequencia = 0;
+
+// Profiler: F9 liga/desliga e, ao desligar, grava perfil_NNN.json (trace do Chrome).
+// Com --perfil ARQ grava desde o início e salva ARQ na saída
+string arquivoPerfil;
+int numeroPerfil = 0;
+int pedidosPerfil = 0, alternanciasPerfil = 0;
+
+// Informações na própria janela (F1 mostra/esconde). O texto é refeito a cada
+// HUD_INTERVALO segundos e desenhado todo frame numa só chamada
+Hud hud;
+const double HUD_INTERVALO = 0.25;
+
+// Redesenho sob demanda (F7 alterna, --continuo desliga): sem mudança na câmera, no
+// mundo ou na janela, o laço principal dorme em glfwWaitEventsTimeout em vez de
+// redesenhar. Teclas de movimento seguradas mantêm o desenho contínuo. Os frames
+// desenhados com o editor ocioso (sem entrada há OCIOSO_APOS segundos) são contados
+// para o relatório de frames por minuto
+bool sobDemanda = true;
+bool pedidoRedesenho = true;
+uint64_t edicoesPublicadas = 0;
+double ultimaEntrada = 0.0, ultimaMontagemHud = -1.0;
+bool hudAtrasado = false;   // o último frame desenhado mostrou um texto antigo do HUD
+double tempoOcioso = 0.0;
+atomic<long long> framesOciosos(0);
+const double ESPERA_MAXIMA = 0.5, OCIOSO_APOS = 1.0, ESPERA_CURTA = 0.1;
+
+// Gravação da entrada (--gravar-entrada ARQ), reproduzida com --reproduzir ARQ. As
+// teclas que processInput lê a cada frame vão como bits (bit i = TECLAS_CONTINUAS[i])
+InputRecorder gravacaoEntrada;
+const int TECLAS_CONTINUAS[] = { GLFW_KEY_LEFT_SHIFT, GLFW_KEY_ESCAPE, GLFW_KEY_W,     GLFW_KEY_S,
+                                 GLFW_KEY_A,          GLFW_KEY_D,      GLFW_KEY_SPACE, GLFW_KEY_LEFT_ALT };
 
 // Código do Vertex Shader
 const GLchar* vertexShaderSource = R"glsl(
@@ -85,42 +201,146 @@ const GLchar* fragmentShaderSource = R"glsl(
     }
 )glsl";
 
+// Vertex Shader dos chunks: posição local e face vêm compactadas em bytes,
+// a coordenada de textura sai da posição projetada no plano da face.
+// chunk_origin só vem preenchido no desenho indireto (senão vale 0 e a origem está em model)
+const GLchar* chunkVertexShaderSource = R"glsl(
+    #version 450
+    layout (location = 0) in uvec4 position_face;
+    layout (location = 1) in uvec4 material_data;
+    layout (location = 2) in vec3 chunk_origin;
+
+    uniform mat4 view;
+    uniform mat4 proj;
+    uniform mat4 model;
+    out vec3 tex_coord;
+    out float shade;
+    void main()
+    {
+        // Oclusão dos cantos calculada na malha (0 = canto fechado, 3 = livre) e a luz
+        // da célula em frente (céu << 4 | blocos): cada nível abaixo de 15 escurece 20%
+        float ao = 0.55 + 0.15 * float(material_data.y);
+        uint l = max(material_data.z >> 4, material_data.z & 15u);
+        shade = ao * (0.06 + 0.94 * pow(0.8, float(15u - l)));
+        vec3 p = vec3(position_face.xyz);
+        uint face = position_face.w & 7u;
+        vec2 uv;
+        if (face == 0u) uv = vec2(-p.z, p.y);
+        else if (face == 1u) uv = vec2(p.z, p.y);
+        else if (face <= 3u) uv = vec2(p.x, p.z);
+        else if (face == 4u) uv = vec2(p.x, p.y);
+        else uv = vec2(-p.x, p.y);
+        tex_coord = vec3(uv.x, 1.0 - uv.y, float(material_data.x));
+        gl_Position = proj * view * model * vec4(p + chunk_origin, 1.0);
+    }
+)glsl";
+
+// Fragment Shader dos chunks opacos
+const GLchar* chunkFragmentShaderSource = R"glsl(
+    #version 450
+    in vec3 tex_coord;
+    in float shade;
+    out vec4 color;
+    uniform sampler2DArray blocks;
+    void main()
+    {
+        color = texture(blocks, tex_coord);
+        color.rgb *= shade;
+    }
+)glsl";
+
+// Fragment Shader dos chunks transparentes: escreve nos dois alvos do OIT
+const GLchar* chunkOITFragmentShaderSource = R"glsl(
+    #version 450
+    in vec3 tex_coord;
+    in float shade;
+    layout (location = 0) out vec4 accum;
+    layout (location = 1) out float reveal;
+    uniform sampler2DArray blocks;
+    void main()
+    {
+        vec4 color = texture(blocks, tex_coord);
+        if (color.a < 0.01)
+            discard;
+        color.rgb *= shade;
+        // Peso decrescente com a profundidade (equação 10 de McGuire & Bavoil)
+        float w = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 *
+                        pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+        accum = vec4(color.rgb * color.a, color.a) * w;
+        reveal = color.a;
+    }
+)glsl";
+
 // Protótipos de funções
 int loadTexture(string filePath);
+GLuint loadTextureArray(const vector<string>& filePaths);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void window_refresh_callback(GLFWwindow* window);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
-void processInput(GLFWwindow* window);
-void especificaVisualizacao();
-void especificaProjecao();
-void transformaObjeto(float xpos, float ypos, float zpos, 
-                      float xrot, float yrot, float zrot, 
-                      float sx, float sy, float sz);
-GLuint setupShader();
+uint16_t leTeclasContinuas(GLFWwindow* window);
+void processInput(GLFWwindow* window, uint16_t teclas);
+glm::mat4 matrizVisualizacao();
+glm::mat4 matrizProjecao();
+void especificaVisualizacao(GLuint programa);
+void especificaProjecao(GLuint programa);
+glm::mat4 transformaObjeto(float xpos, float ypos, float zpos, 
+                           float xrot, float yrot, float zrot, 
+                           float sx, float sy, float sz);
+void enfileiraSelecao();
+void geraTerrenoTeste(World& mundo, int x0 = 0, int z0 = 0);
+int validaCullingGPU();
+int validaMesherGPU();
+int benchmarkLuz();
+int executaBenchmark(const string& relatorio, const string& cenas, const string& tamanhos, int frames,
+                     const string& caminho);
+int executaHeadless(int frames, const string& captura);
+void capturaFrame();
+void alternaPerfil();
+void gravaPontoCaminho();
+void imprimePerfil();
+void salvaPerfil();
+void atualizaLuz();
+RenderSnapshot vistaAtual();
+void desenhaQuadro();
+void desenhaFrame();
+void enviaEdicao(const EditCommand& comando);
+void aplicaEdicoes(const EditCommand* comandos, size_t n);
+int tamanhoMundo(int eixo);
+void limitaSelecao();
+void publicaMundo();
+void threadMundo();
+void comparaRaymarch();
 GLuint setupGeometry();
-void saveGrid(const char* filename);
-void loadGrid(const char* filename);
 void renderUI();
+void montaHud();
+void marcaEntrada();
+bool precisaRedesenhar(uint16_t teclas);
+void threadRender();
+void alternaSobDemanda();
+void imprimeOcioso();
 void printInstructions();
-void clearScreen(); 
 
-// Limpa o console
-void clearScreen() {
-#ifdef _WIN32
-    system("cls");
-#else
-    system("clear");
-#endif
+// Guarda o tamanho novo do framebuffer; o viewport e os alvos do OIT são refeitos
+// pelo desenho quando o quadro chega com o tamanho novo (o contexto é da thread de render)
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    pedidoRedesenho = true;
+    if (width > 0 && height > 0) {
+        larguraTela = width;
+        alturaTela = height;
+    }
 }
 
-// Atualiza o viewport ao redimensionar a janela
-void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
-    glViewport(0, 0, width, height);
+// A janela precisa ser redesenhada (exposta de novo, restaurada): redesenha mesmo sem mudança
+void window_refresh_callback(GLFWwindow* window) {
+    pedidoRedesenho = true;
 }
 
 // Callback para movimentação do mouse
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+    gravacaoEntrada.cursor(xpos, ypos);
+    marcaEntrada();
     if (firstMouse) {
         lastX = xpos;
         lastY = ypos;
@@ -153,6 +373,8 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 
 // Callback de scroll - altera o FOV (zoom)
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+    gravacaoEntrada.scroll(xoffset, yoffset);
+    marcaEntrada();
     if (fov >= 1.0f && fov <= 120.0f)
         fov -= yoffset;
     if (fov <= 1.0f) fov = 1.0f;
@@ -160,138 +382,226 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode) {
+    PERFIL_ESCOPO("edicao");
+    gravacaoEntrada.key(key, scancode, action, mode);
+    marcaEntrada();
+    EditCommand edicao;
+    edicao.x = selecaoX;
+    edicao.y = selecaoY;
+    edicao.z = selecaoZ;
+
     //Troca visibilidade do voxel
     if (key == GLFW_KEY_DELETE && action == GLFW_PRESS) {
-        grid[selecaoY][selecaoX][selecaoZ].visivel = false;
+        edicao.type = EDICAO_VISIVEL;
+        edicao.value = 0;
+        enviaEdicao(edicao);
     }
     if ((key == GLFW_KEY_V || key == GLFW_KEY_ENTER) && action == GLFW_PRESS) {
-        grid[selecaoY][selecaoX][selecaoZ].visivel = true;
+        edicao.type = EDICAO_VISIVEL;
+        edicao.value = 1;
+        enviaEdicao(edicao);
     }
 
     //Altera textura do voxel
     if (key == GLFW_KEY_T && action == GLFW_PRESS) {
-        int& texID = grid[selecaoY][selecaoX][selecaoZ].texID;
-        texID = (texID + 1) % (NUM_TEXTURES - 1); // Skip selection texture
-        cout << "Textura alterada para: " << textureNames[texID] << endl;
+        edicao.type = EDICAO_PROXIMA_TEXTURA;
+        edicao.value = NUM_TEXTURES - 1; // Skip selection texture
+        enviaEdicao(edicao);
     }
     // (Altera diretamente por numero)
     else if (action == GLFW_PRESS && key >= GLFW_KEY_1 && key <= GLFW_KEY_9) {
         int num = key - GLFW_KEY_1; 
         if (num < NUM_TEXTURES - 1) { 
-            int& texID = grid[selecaoY][selecaoX][selecaoZ].texID;
-            texID = num;
-            cout << "Textura alterada para: " << textureNames[texID] << endl;
+            edicao.type = EDICAO_TEXTURA;
+            edicao.value = (uint8_t)num;
+            enviaEdicao(edicao);
+            texturaPincel = num;
         }
         else {
             cout << "Erro: Textura " << num + 1 << " indisponível (max: " << NUM_TEXTURES - 1 << ")" << endl;
         }
     }
+
+    // Região: marca o canto e preenche/esvazia até a seleção
+    if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+        cantoRegiao[0] = selecaoX;
+        cantoRegiao[1] = selecaoY;
+        cantoRegiao[2] = selecaoZ;
+        cout << "Canto da regiao: (" << selecaoX << ", " << selecaoY << ", " << selecaoZ << ")" << endl;
+    }
+    if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+        edicao.type = EDICAO_PREENCHE;
+        edicao.x1 = cantoRegiao[0];
+        edicao.y1 = cantoRegiao[1];
+        edicao.z1 = cantoRegiao[2];
+        edicao.value = (mode & GLFW_MOD_SHIFT) ? 0 : (uint8_t)(VOXEL_VISIVEL | texturaPincel);
+        enviaEdicao(edicao);
+    }
+
     // Salva e carrega a grid
     if (key == GLFW_KEY_S && action == GLFW_PRESS && (mode & GLFW_MOD_CONTROL)) {
-        saveGrid("voxel_grid.dat");
-        cout << "Grid salva!" << endl;
+        edicao.type = EDICAO_SALVA;
+        enviaEdicao(edicao);
     }
     if (key == GLFW_KEY_L && action == GLFW_PRESS && (mode & GLFW_MOD_CONTROL)) {
-        loadGrid("voxel_grid.dat");
-        cout << "Grid carregada!" << endl;
+        edicao.type = EDICAO_CARREGA;
+        enviaEdicao(edicao);
     }
 
     // Reseta a grid
     if (key == GLFW_KEY_R && action == GLFW_PRESS) {
-        for (int y = 0; y < TAM; y++) {
-            for (int x = 0; x < TAM; x++) {
-                for (int z = 0; z < TAM; z++) {
-                    grid[y][x][z].visivel = false;
-                    grid[y][x][z].texID = 0;
-                }
-            }
+        edicao.type = EDICAO_LIMPA;
+        enviaEdicao(edicao);
+    }
+
+    // Liga/desliga o nível de detalhe dos chunks distantes
+    if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+        lodLigado = !lodLigado;
+        cout << "LOD " << (lodLigado ? "ligado" : "desligado") << endl;
+    }
+
+    // Alterna culling dos chunks entre GPU (compute shader) e CPU
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS) {
+        if (chunkRenderer.gpuCullingSupported()) {
+            cullingNaGPU = !cullingNaGPU;
+            cout << "Culling na " << (cullingNaGPU ? "GPU" : "CPU") << endl;
+        }
+        else {
+            cout << "Culling na GPU indisponivel (requer OpenGL 4.3)" << endl;
+        }
+    }
+
+    // Alterna a geração das malhas entre GPU (compute shader) e CPU
+    if (key == GLFW_KEY_F5 && action == GLFW_PRESS) {
+        if (chunkRenderer.gpuMeshingSupported()) {
+            malhasNaGPU = !malhasNaGPU;
+            cout << "Malhas geradas na " << (malhasNaGPU ? "GPU" : "CPU") << endl;
+        }
+        else {
+            cout << "Mesher na GPU indisponivel (requer OpenGL 4.3)" << endl;
         }
-        cout << "Grid resetada!" << endl;
+    }
+
+    if (key == GLFW_KEY_F9 && action == GLFW_PRESS)
+        pedidosPerfil++;
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        mostrarHud = !mostrarHud;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        gravaPontoCaminho();
+    if (key == GLFW_KEY_F7 && action == GLFW_PRESS)
+        alternaSobDemanda();
+
+    // Capturas: F12 grava o frame, F11 liga/desliga a sequência
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
+        pedidosCaptura++;
+    if (key == GLFW_KEY_F11 && action == GLFW_PRESS)
+        sequenciaPedida = !sequenciaPedida;
+
+    // Alterna entre malhas rasterizadas e raymarching da grade
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS) {
+        modoRaymarch = !modoRaymarch;
+        cout << "Renderizacao: " << (modoRaymarch ? "raymarching" : "malhas") << endl;
     }
 
     // Move a seleção
     if (key == GLFW_KEY_RIGHT && action == GLFW_PRESS) {
-        if (selecaoX + 1 < TAM) {
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = false;
+        if (selecaoX + 1 < tamanhoMundo(0))
             selecaoX++;
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = true;
-        }
     }
     if (key == GLFW_KEY_LEFT && action == GLFW_PRESS) {
-        if (selecaoX - 1 >= 0) {
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = false;
+        if (selecaoX - 1 >= 0)
             selecaoX--;
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = true;
-        }
     }
     if (key == GLFW_KEY_UP && action == GLFW_PRESS) {
-        if (selecaoY + 1 < TAM) {
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = false;
+        if (selecaoY + 1 < tamanhoMundo(1))
             selecaoY++;
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = true;
-        }
     }
     if (key == GLFW_KEY_DOWN && action == GLFW_PRESS) {
-        if (selecaoY - 1 >= 0) {
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = false;
+        if (selecaoY - 1 >= 0)
             selecaoY--;
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = true;
-        }
     }
     if (key == GLFW_KEY_PAGE_UP && action == GLFW_PRESS) {
-        if (selecaoZ + 1 < TAM) {
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = false;
+        if (selecaoZ + 1 < tamanhoMundo(2))
             selecaoZ++;
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = true;
-        }
     }
     if (key == GLFW_KEY_PAGE_DOWN && action == GLFW_PRESS) {
-        if (selecaoZ - 1 >= 0) {
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = false;
+        if (selecaoZ - 1 >= 0)
             selecaoZ--;
-            grid[selecaoY][selecaoX][selecaoZ].selecionado = true;
-        }
     }
 }
 
-// Processa as teclas pressionadas para movimentar a câmera no espaço 3D
-void processInput(GLFWwindow* window) {
+// Estado das teclas contínuas neste frame (um bit por tecla de TECLAS_CONTINUAS)
+uint16_t leTeclasContinuas(GLFWwindow* window) {
+    uint16_t teclas = 0;
+    for (int i = 0; i < (int)(sizeof(TECLAS_CONTINUAS) / sizeof(TECLAS_CONTINUAS[0])); i++)
+        if (glfwGetKey(window, TECLAS_CONTINUAS[i]) == GLFW_PRESS)
+            teclas |= (uint16_t)(1u << i);
+    return teclas;
+}
+
+// Processa as teclas pressionadas para movimentar a câmera no espaço 3D. As teclas
+// vêm de leTeclasContinuas ou do log de entrada (a janela é nula na reprodução sem janela)
+void processInput(GLFWwindow* window, uint16_t teclas) {
+    auto pressionada = [&](int tecla) {
+        for (int i = 0; i < (int)(sizeof(TECLAS_CONTINUAS) / sizeof(TECLAS_CONTINUAS[0])); i++)
+            if (TECLAS_CONTINUAS[i] == tecla)
+                return (teclas & (1u << i)) != 0;
+        return false;
+    };
+    // O mundo pode ter sido carregado com outro tamanho
+    limitaSelecao();
+
+    glm::vec3 antes = cameraPos;
     float cameraSpeed = 5.0f * deltaTime;
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+    if (pressionada(GLFW_KEY_LEFT_SHIFT))
         cameraSpeed *= 5;
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+    if (pressionada(GLFW_KEY_ESCAPE) && window)
         glfwSetWindowShouldClose(window, true);
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+    if (pressionada(GLFW_KEY_W))
         cameraPos += cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+    if (pressionada(GLFW_KEY_S))
         cameraPos -= cameraSpeed * cameraFront;
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+    if (pressionada(GLFW_KEY_A))
         cameraPos -= glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+    if (pressionada(GLFW_KEY_D))
         cameraPos += glm::normalize(glm::cross(cameraFront, cameraUp)) * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
+    if (pressionada(GLFW_KEY_SPACE))
         cameraPos += cameraUp * cameraSpeed;
-    if (glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS)
+    if (pressionada(GLFW_KEY_LEFT_ALT))
         cameraPos -= cameraUp * cameraSpeed;
+    velocidadeCamera = deltaTime > 0.0f ? (cameraPos - antes) / deltaTime : glm::vec3(0.0f);
+}
+
+// Matriz de visualização a partir da posição e direção da câmera do quadro
+glm::mat4 matrizVisualizacao() {
+    return glm::lookAt(quadro.cameraPos, quadro.cameraPos + quadro.cameraFront, quadro.cameraUp);
+}
+
+// Matriz de projeção perspectiva com base no FOV do quadro
+glm::mat4 matrizProjecao() {
+    return glm::perspective(glm::radians(quadro.fov), (float)quadro.width / quadro.height, 0.1f, FAR_PLANE);
 }
 
 // Define a matriz de visualização usando a posição e direção da câmera
-void especificaVisualizacao() {
-    glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-    GLuint loc = glGetUniformLocation(shaderID, "view");
+void especificaVisualizacao(GLuint programa) {
+    glm::mat4 view = matrizVisualizacao();
+    glUseProgram(programa);
+    GLuint loc = glGetUniformLocation(programa, "view");
     glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(view));
 }
 
 // Define a matriz de projeção perspectiva com base no FOV
-void especificaProjecao() {
-    glm::mat4 proj = glm::perspective(glm::radians(fov), (float)WIDTH / HEIGHT, 0.1f, 100.0f);
-    GLuint loc = glGetUniformLocation(shaderID, "proj");
+void especificaProjecao(GLuint programa) {
+    glm::mat4 proj = matrizProjecao();
+    glUseProgram(programa);
+    GLuint loc = glGetUniformLocation(programa, "proj");
     glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(proj));
 }
 
-void transformaObjeto(float xpos, float ypos, float zpos, 
-                      float xrot, float yrot, float zrot, 
-                      float sx, float sy, float sz) {
+// Monta a matriz model do objeto (enviada ao shader pela fila de desenho)
+glm::mat4 transformaObjeto(float xpos, float ypos, float zpos, 
+                           float xrot, float yrot, float zrot, 
+                           float sx, float sy, float sz) {
     glm::mat4 transform = glm::mat4(1.0f);
 
     // especifica as transformações sobre o objeto - model
@@ -300,49 +610,655 @@ void transformaObjeto(float xpos, float ypos, float zpos,
     transform = glm::rotate(transform, glm::radians(yrot), glm::vec3(0, 1, 0));
     transform = glm::rotate(transform, glm::radians(zrot), glm::vec3(0, 0, 1));
     transform = glm::scale(transform, glm::vec3(sx, sy, sz));
-    
-    // Envia os dados para o shader
-    GLuint loc = glGetUniformLocation(shaderID, "model");
-    glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(transform));
+
+    return transform;
 }
 
-// Compila shaders e cria o programa de shader
-GLuint setupShader() {
-    GLint success;
-    GLchar infoLog[512];
+// Adiciona o cubo de seleção na fila de desenho
+void enfileiraSelecao() {
+    glm::vec3 pos = mundoDesenhado->voxelCenter(quadro.selection[0], quadro.selection[1], quadro.selection[2]);
+    const float escala = 0.98f * 1.05f;
+
+    DrawItem item;
+    item.pass = PASS_SELECAO;
+    item.program = shaderID;
+    item.vao = VAO;
+    item.texture = texIDList[TEXTURA_SELECAO];
+    item.model = transformaObjeto(pos.x, pos.y, pos.z,
+                                  0.0f, 0.0f, 0.0f,
+                                  escala, escala, escala);
+    item.first = 0;
+    item.count = 36;
+    item.key = makeSortKey(PASS_SELECAO, 0, TEXTURA_SELECAO, 0);
+
+    renderQueue.push(item);
+}
 
-    GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
-        cout << "Erro no Vertex Shader:\n" << infoLog << endl;
+// Terreno determinístico (colinas de musgo sobre lama) para os testes sem arquivo de grid.
+// Com x0, z0 o mundo é um pedaço de um maior, a partir dessa coluna (criação do streaming)
+void geraTerrenoTeste(World& mundo, int x0, int z0) {
+    for (int x = 0; x < mundo.sizeX(); x++) {
+        for (int z = 0; z < mundo.sizeZ(); z++) {
+            int gx = x0 + x, gz = z0 + z;
+            float h = 0.5f + 0.25f * sin(gx * 0.11f) * cos(gz * 0.07f) + 0.1f * sin((gx + gz) * 0.23f);
+            int altura = (int)(h * mundo.sizeY());
+            for (int y = 0; y < altura && y < mundo.sizeY(); y++) {
+                int texID = (y >= altura - 2) ? 0 : 6;
+                mundo.set(x, y, z, (uint8_t)(VOXEL_VISIVEL | texID));
+            }
+        }
     }
+}
 
-    GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, nullptr, infoLog);
-        cout << "Erro no Fragment Shader:\n" << infoLog << endl;
+// --validar-culling: compara os comandos gerados pelo culling na GPU com o
+// culling da CPU numa órbita de câmeras em volta do mundo. Retorna 0 se todos batem
+int validaCullingGPU() {
+    if (!chunkRenderer.gpuCullingSupported()) {
+        cout << "Culling na GPU indisponivel (requer OpenGL 4.3)" << endl;
+        return 1;
+    }
+    cout << "Renderer: " << glGetString(GL_RENDERER) << " | OpenGL " << glGetString(GL_VERSION) << endl;
+
+    float raio = (float)max(world.sizeX(), max(world.sizeY(), world.sizeZ()));
+    const float distancias[] = { 0.25f, 0.75f, 1.5f, 4.0f };
+    const float pixelSizes[] = { 4.0f, 40.0f };
+    int vistas = 0, divergencias = 0;
+
+    for (int lod = 0; lod < 2; lod++) {
+        chunkRenderer.lodEnabled = (lod == 1);
+        for (float pixelSize : pixelSizes) {
+            chunkRenderer.lodPixelSize = pixelSize;
+            for (float d : distancias) {
+                for (int passo = 0; passo < 16; passo++) {
+                    float angulo = passo * 0.3926991f;
+                    glm::vec3 pos(cos(angulo) * raio * d, raio * 0.3f * sin(angulo * 2.0f), sin(angulo) * raio * d);
+                    glm::vec3 alvo = (passo % 2 == 0) ? glm::vec3(0.0f) : pos + glm::vec3(-sin(angulo), 0.0f, cos(angulo));
+
+                    ChunkView camera;
+                    camera.view = glm::lookAt(pos, alvo, glm::vec3(0.0f, 1.0f, 0.0f));
+                    camera.proj = glm::perspective(glm::radians(fov), (float)WIDTH / HEIGHT, 0.1f, FAR_PLANE);
+                    camera.cameraPos = pos;
+                    camera.fovY = glm::radians(fov);
+                    camera.farPlane = FAR_PLANE;
+                    camera.viewportHeight = HEIGHT;
+
+                    int erros = chunkRenderer.validateGpuCulling(world, camera);
+                    vistas++;
+                    divergencias += erros;
+                    if (erros != 0)
+                        cout << "Vista " << vistas << " (LOD " << (lod ? "ligado" : "desligado")
+                             << ", distancia " << d << "): " << erros << " comandos divergentes" << endl;
+                }
+            }
+        }
     }
+    chunkRenderer.lodEnabled = true;
+    chunkRenderer.lodPixelSize = 4.0f;
+
+    cout << "Validacao do culling na GPU: " << vistas << " vistas, " << divergencias << " divergencias" << endl;
+    return divergencias == 0 ? 0 : 1;
+}
 
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, nullptr, infoLog);
-        cout << "Erro na linkagem do Shader Program:\n" << infoLog << endl;
+// --validar-mesher: espalha voxels transparentes, opacos e buracos pelo mundo e
+// compara as malhas do mesher da GPU com as da CPU em todos os chunks e LODs, antes
+// e depois de uma segunda leva de edições (que chega à GPU por envio parcial). Depois
+// confere os argumentos de desenho que o mesher escreveu pelo culling na GPU
+int validaMesherGPU() {
+    if (!chunkRenderer.gpuMeshingSupported()) {
+        cout << "Mesher na GPU indisponivel (requer OpenGL 4.3)" << endl;
+        return 1;
     }
+    cout << "Renderer: " << glGetString(GL_RENDERER) << " | OpenGL " << glGetString(GL_VERSION) << endl;
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    uint32_t semente = 12345;
+    auto aleatorio = [&]() {
+        semente = semente * 1664525u + 1013904223u;
+        return (int)(semente >> 8);
+    };
+    // Vidro, mel e gelo (transparentes) misturados com opacos
+    const int materiais[] = { 1, 4, 7, 2, 3 };
+    int malhas = 0, divergencias = 0;
+
+    for (int rodada = 0; rodada < 2; rodada++) {
+        int edicoes = world.sizeX() * world.sizeY() * world.sizeZ() / (rodada == 0 ? 16 : 256);
+        for (int i = 0; i < edicoes; i++) {
+            int x = aleatorio() % world.sizeX(), y = aleatorio() % world.sizeY(), z = aleatorio() % world.sizeZ();
+            int sorteio = aleatorio() % 6;
+            if (sorteio == 5)
+                world.setVisible(x, y, z, false);
+            else
+                world.set(x, y, z, (uint8_t)(VOXEL_VISIVEL | materiais[sorteio]));
+        }
+        luz.update(world);
+
+        int erros = chunkRenderer.validateGpuMesher(world);
+        int naoVazios = 0;
+        for (int cy = 0; cy < world.chunksY(); cy++)
+            for (int cz = 0; cz < world.chunksZ(); cz++)
+                for (int cx = 0; cx < world.chunksX(); cx++)
+                    naoVazios += world.chunk(cx, cy, cz).visibleCount > 0;
+        malhas += naoVazios * NUM_LODS;
+        divergencias += erros;
+        if (erros != 0)
+            cout << "Rodada " << rodada + 1 << ": " << erros << " malhas divergentes" << endl;
+    }
 
-    return shaderProgram;
+    // Com o mesher da GPU ligado, os comandos do culling saem dos argumentos que ele escreveu
+    int comandos = 0;
+    if (chunkRenderer.gpuCullingSupported()) {
+        chunkRenderer.gpuMeshing = true;
+        float raio = (float)max(world.sizeX(), max(world.sizeY(), world.sizeZ()));
+        for (int passo = 0; passo < 8; passo++) {
+            float angulo = passo * 0.7853982f;
+            glm::vec3 pos(cos(angulo) * raio, raio * 0.5f, sin(angulo) * raio);
+
+            ChunkView camera;
+            camera.view = glm::lookAt(pos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            camera.proj = glm::perspective(glm::radians(fov), (float)WIDTH / HEIGHT, 0.1f, FAR_PLANE);
+            camera.cameraPos = pos;
+            camera.fovY = glm::radians(fov);
+            camera.farPlane = FAR_PLANE;
+            camera.viewportHeight = HEIGHT;
+            comandos += chunkRenderer.validateGpuCulling(world, camera);
+        }
+        chunkRenderer.gpuMeshing = false;
+        if (comandos != 0)
+            cout << "Argumentos de desenho: " << comandos << " comandos divergentes" << endl;
+    }
+
+    cout << "Validacao do mesher na GPU: " << malhas << " malhas, " << divergencias << " divergencias" << endl;
+    return (divergencias == 0 && comandos == 0) ? 0 : 1;
+}
+
+// Reacende só em volta das edições do último frame (o mundo todo depois de R/carga)
+void atualizaLuz() {
+    PERFIL_ESCOPO("luz");
+    luz.update(world);
+}
+
+// O que o desenho precisa do estado da thread principal (sem o mundo)
+RenderSnapshot vistaAtual() {
+    RenderSnapshot s;
+    s.cameraPos = cameraPos;
+    s.cameraFront = cameraFront;
+    s.cameraUp = cameraUp;
+    s.fov = fov;
+    s.width = larguraTela;
+    s.height = alturaTela;
+    s.selection[0] = selecaoX;
+    s.selection[1] = selecaoY;
+    s.selection[2] = selecaoZ;
+    s.raymarch = modoRaymarch;
+    s.lod = lodLigado;
+    s.gpuCulling = cullingNaGPU;
+    s.gpuMeshing = malhasNaGPU;
+    s.hud = mostrarHud;
+    s.captureRequests = pedidosCaptura;
+    s.sequence = sequenciaPedida;
+    s.profilerToggles = pedidosPerfil;
+    s.onDemand = sobDemanda;
+    s.idleSeconds = tempoOcioso;
+    return s;
+}
+
+// Um frame numa thread só (benchmark, --headless, reprodução): luz, estado e desenho
+void desenhaFrame() {
+    if (streaming.active())
+        streaming.update(world);
+    atualizaLuz();
+    quadro = vistaAtual();
+    desenhaQuadro();
+}
+
+// Coleta a cena do quadro na fila e desenha (opacos, transparentes com OIT e seleção)
+void desenhaQuadro() {
+    chunkRenderer.lodEnabled = quadro.lod;
+    chunkRenderer.gpuCulling = quadro.gpuCulling;
+    chunkRenderer.gpuMeshing = quadro.gpuMeshing;
+    hud.visible = quadro.hud;
+    while (alternanciasPerfil < quadro.profilerToggles) {
+        alternaPerfil();
+        alternanciasPerfil++;
+    }
+
+    glClearColor(COR_FUNDO.x, COR_FUNDO.y, COR_FUNDO.z, 1.0f);
+
+    const GLuint programas[] = { shaderID, shaderChunk, shaderChunkOIT };
+    for (GLuint programa : programas) {
+        especificaVisualizacao(programa);
+        especificaProjecao(programa);
+    }
+
+    int fbHeight = quadro.height;
+    World& mundo = *mundoDesenhado;
+
+    // Coleta os chunks visíveis (remalhando os que mudaram) ou o raymarching, e a seleção
+    renderQueue.clear();
+    if (quadro.raymarch) {
+        RaymarchView camera;
+        camera.view = matrizVisualizacao();
+        camera.proj = matrizProjecao();
+        camera.cameraPos = quadro.cameraPos;
+        camera.fovY = glm::radians(quadro.fov);
+        camera.viewportHeight = fbHeight;
+        camera.background = COR_FUNDO;
+        volumeGPU.update(mundo);
+        raymarcher.enqueue(mundo, volumeGPU, renderQueue, camera);
+    }
+    else {
+        ChunkView camera;
+        camera.view = matrizVisualizacao();
+        camera.proj = matrizProjecao();
+        camera.cameraPos = quadro.cameraPos;
+        camera.fovY = glm::radians(quadro.fov);
+        camera.farPlane = FAR_PLANE;
+        camera.viewportHeight = fbHeight;
+        chunkRenderer.enqueue(mundo, renderQueue, camera);
+    }
+    enfileiraSelecao();
+
+    // Opacos, transparentes (OIT) e seleção; a composição acontece entre os passes
+    {
+        PERFIL_ESCOPO("fila");
+        renderQueue.sort();
+    }
+    renderQueue.submit();
+    presentOIT(framebufferSaida);
+}
+
+// --comparar-raymarch: tempo de frame das malhas contra o raymarching no mesmo
+// terreno em 64^3, 256^3 e 512^3, com a mesma câmera. Os primeiros frames de cada
+// modo (malhas e upload) ficam de fora da medida
+void comparaRaymarch() {
+    const int tamanhos[] = { 64, 256, 512 };
+    const int aquecimento = 3, frames = 10;
+
+    cout << "Renderer: " << glGetString(GL_RENDERER) << endl;
+    cout << "Tamanho | Malhas (ms/frame) | Raymarching (ms/frame) | Triangulos" << endl;
+    for (int tam : tamanhos) {
+        world.resize(tam, tam, tam);
+        geraTerrenoTeste(world);
+        cameraPos = glm::vec3(tam * 0.45f, tam * 0.35f, tam * 0.75f);
+        cameraFront = glm::normalize(glm::vec3(0.0f) - cameraPos);
+        cameraUp = glm::normalize(glm::cross(glm::cross(cameraFront, glm::vec3(0.0f, 1.0f, 0.0f)), cameraFront));
+        selecaoX = selecaoY = selecaoZ = 0;
+
+        double ms[2];
+        long long triangulos = 0;
+        for (int modo = 0; modo < 2; modo++) {
+            modoRaymarch = (modo == 1);
+            for (int i = 0; i < aquecimento; i++)
+                desenhaFrame();
+            glFinish();
+
+            double inicio = glfwGetTime();
+            for (int i = 0; i < frames; i++) {
+                desenhaFrame();
+                glFinish();
+            }
+            ms[modo] = (glfwGetTime() - inicio) * 1000.0 / frames;
+            if (modo == 0)
+                triangulos = chunkRenderer.stats().triangles;
+        }
+        cout << tam << "^3 | " << ms[0] << " | " << ms[1] << " | " << triangulos << endl;
+    }
+    modoRaymarch = false;
+}
+
+// Cenas de estresse do --benchmark, geradas sempre iguais (LCG com semente fixa)
+const char* const CENAS_BENCHMARK[] = { "solido", "xadrez", "esparso", "terreno", "transparente" };
+
+void geraCenaBenchmark(World& mundo, const string& cena) {
+    uint32_t semente = 12345;
+    auto aleatorio = [&]() {
+        semente = semente * 1664525u + 1013904223u;
+        return semente >> 8;
+    };
+    const int sx = mundo.sizeX(), sy = mundo.sizeY(), sz = mundo.sizeZ();
+    for (int y = 0; y < sy; y++)
+        for (int z = 0; z < sz; z++)
+            for (int x = 0; x < sx; x++) {
+                int texID = -1;
+                if (cena == "solido")
+                    texID = 2;
+                else if (cena == "xadrez")   // pior caso das malhas: toda face fica exposta
+                    texID = ((x + y + z) & 1) ? 2 : -1;
+                else if (cena == "esparso")  // 10% dos voxels, materiais opacos misturados
+                    texID = (aleatorio() % 100 < 10) ? (int)(aleatorio() % 3) * 3 : -1;
+                else if (cena == "transparente")  // vidro e gelo alternados: tudo no pass de OIT
+                    texID = ((x + y + z) & 1) ? 1 : 7;
+                if (texID >= 0)
+                    mundo.set(x, y, z, (uint8_t)(VOXEL_VISIVEL | texID));
+            }
+    if (cena == "terreno")
+        geraTerrenoTeste(mundo);
+}
+
+// FNV-1a dos voxels: confirma no relatório que a cena é a mesma entre execuções
+uint64_t hashMundo(const World& mundo) {
+    uint64_t h = 1469598103934665603ull;
+    for (int y = 0; y < mundo.sizeY(); y++)
+        for (int z = 0; z < mundo.sizeZ(); z++)
+            for (int x = 0; x < mundo.sizeX(); x++)
+                h = (h ^ mundo.get(x, y, z)) * 1099511628211ull;
+    return h;
+}
+
+// Catmull-Rom fechada pelos pontos de controle, t em [0, 1)
+glm::vec3 splineFechada(const vector<glm::vec3>& pontos, float t) {
+    int n = (int)pontos.size();
+    float u = t * n;
+    int i = (int)floor(u);
+    float f = u - i;
+    const glm::vec3& p0 = pontos[((i - 1) % n + n) % n];
+    const glm::vec3& p1 = pontos[i % n];
+    const glm::vec3& p2 = pontos[(i + 1) % n];
+    const glm::vec3& p3 = pontos[(i + 2) % n];
+    float f2 = f * f, f3 = f2 * f;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * f + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * f2 +
+                   (3.0f * p1 - p0 - 3.0f * p2 + p3) * f3);
+}
+
+// Caminho da câmera: pares posição/alvo em frações do tamanho do mundo, em volta do
+// centro. Sem arquivo, uma volta que se afasta, sobe e mergulha até perto da superfície.
+// O arquivo (F6 grava a câmera atual em caminho_camera.txt) tem uma linha por ponto
+// com "px py pz ax ay az"
+bool carregaCaminho(const string& arquivo, vector<glm::vec3>& posicoes, vector<glm::vec3>& alvos) {
+    posicoes.clear();
+    alvos.clear();
+    if (arquivo.empty()) {
+        for (int k = 0; k < 8; k++) {
+            float angulo = k * 0.785398f;
+            float raio = (k % 2 == 0) ? 1.1f : 0.6f;
+            posicoes.push_back(glm::vec3(cos(angulo) * raio, 0.15f + 0.35f * (k % 3) / 2.0f, sin(angulo) * raio));
+            alvos.push_back(glm::vec3(0.1f * sin(angulo * 3.0f), -0.1f, 0.1f * cos(angulo * 2.0f)));
+        }
+        return true;
+    }
+    FILE* f = fopen(arquivo.c_str(), "r");
+    if (!f)
+        return false;
+    glm::vec3 p, a;
+    while (fscanf(f, "%f %f %f %f %f %f", &p.x, &p.y, &p.z, &a.x, &a.y, &a.z) == 6) {
+        posicoes.push_back(p);
+        alvos.push_back(a);
+    }
+    fclose(f);
+    return posicoes.size() >= 2;
+}
+
+// Resumo de uma série de tempos de frame (ms), com percentis exatos sobre os tempos
+// ordenados (rank mais próximo) e o "1% low" (média do 1% mais lento)
+struct ResumoTempos {
+    double media = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0, low1 = 0.0, max = 0.0;
+};
+
+ResumoTempos resumeTempos(vector<double> tempos) {
+    ResumoTempos r;
+    if (tempos.empty())
+        return r;
+    sort(tempos.begin(), tempos.end());
+    auto percentil = [&](double p) {
+        size_t k = (size_t)ceil(p * tempos.size());
+        return tempos[min(tempos.size() - 1, k > 0 ? k - 1 : 0)];
+    };
+    double soma = 0.0;
+    for (double ms : tempos)
+        soma += ms;
+    size_t piores = max<size_t>(1, tempos.size() / 100);
+    double somaPiores = 0.0;
+    for (size_t k = tempos.size() - piores; k < tempos.size(); k++)
+        somaPiores += tempos[k];
+    r.media = soma / tempos.size();
+    r.p50 = percentil(0.50);
+    r.p95 = percentil(0.95);
+    r.p99 = percentil(0.99);
+    r.low1 = somaPiores / piores;
+    r.max = tempos.back();
+    return r;
+}
+
+// --benchmark: para cada cena e tamanho, gera o mundo, voa o caminho da câmera (a
+// posição depende só do número do frame, não do tempo) e mede cada frame até o fim
+// da GPU (glFinish), sem vsync. Os primeiros frames (luz e malhas do mundo todo)
+// ficam fora dos percentis e saem à parte. Os contadores (draw calls, triângulos,
+// chunks, memória) e o hash das cenas são idênticos entre execuções; o relatório
+// JSON tem sempre as mesmas chaves na mesma ordem
+int executaBenchmark(const string& relatorio, const string& cenas, const string& tamanhos, int frames,
+                     const string& caminho) {
+    const int aquecimento = 10;
+    vector<glm::vec3> posicoes, alvos;
+    if (!carregaCaminho(caminho, posicoes, alvos)) {
+        cerr << "Caminho da camera invalido: " << caminho << endl;
+        return 1;
+    }
+    auto separa = [](const string& lista) {
+        vector<string> itens;
+        size_t inicio = 0;
+        while (inicio <= lista.size()) {
+            size_t fim = lista.find(',', inicio);
+            if (fim == string::npos)
+                fim = lista.size();
+            if (fim > inicio)
+                itens.push_back(lista.substr(inicio, fim - inicio));
+            inicio = fim + 1;
+        }
+        return itens;
+    };
+    vector<string> listaCenas = separa(cenas);
+    if (listaCenas.empty())
+        listaCenas.assign(begin(CENAS_BENCHMARK), end(CENAS_BENCHMARK));
+    for (const string& cena : listaCenas)
+        if (find(begin(CENAS_BENCHMARK), end(CENAS_BENCHMARK), cena) == end(CENAS_BENCHMARK)) {
+            cerr << "Cena desconhecida: " << cena << endl;
+            return 1;
+        }
+    vector<int> listaTamanhos;
+    for (const string& t : separa(tamanhos))
+        listaTamanhos.push_back(max(1, atoi(t.c_str())));
+
+    FILE* json = fopen(relatorio.c_str(), "w");
+    if (!json) {
+        cerr << "Falha ao criar " << relatorio << endl;
+        return 1;
+    }
+
+    // Sem janela, desenha no framebuffer do FrameCapture (sem capturar)
+    FrameCapture destino;
+    if (!window) {
+        destino.setup(larguraTela, alturaTela);
+        framebufferSaida = destino.framebuffer();
+    }
+    else {
+        glfwSwapInterval(0);
+    }
+    fprintf(json, "{\n  \"renderer\": \"%s\",\n  \"resolucao\": [%d, %d],\n", (const char*)glGetString(GL_RENDERER),
+            larguraTela, alturaTela);
+    fprintf(json, "  \"frames\": %d,\n  \"aquecimento\": %d,\n  \"caminho\": \"%s\",\n  \"cenas\": [", frames,
+            aquecimento, caminho.empty() ? "padrao" : caminho.c_str());
+
+    cout << "Renderer: " << glGetString(GL_RENDERER) << " | " << larguraTela << "x" << alturaTela << endl;
+    cout << "Cena | Tamanho | Primeiro frame (ms) | Media/p50/p95/p99/1% low (ms) | Draw calls | Triangulos" << endl;
+    int resultados = 0;
+    for (const string& cena : listaCenas) {
+        for (int tam : listaTamanhos) {
+            world.resize(tam, tam, tam);
+            geraCenaBenchmark(world, cena);
+            selecaoX = selecaoY = selecaoZ = 0;
+            uint64_t hash = hashMundo(world);
+            const float s = (float)tam;
+
+            vector<double> tempos;
+            double primeiro = 0.0, somaDraws = 0.0, somaTriangulos = 0.0, somaChunks = 0.0;
+            int maxDraws = 0;
+            long long maxTriangulos = 0;
+            size_t maxMalhas = 0, maxVolume = 0;
+            for (int i = 0; i < aquecimento + frames; i++) {
+                // Câmera pelo número do frame: o mesmo caminho a qualquer velocidade
+                float t = (float)max(0, i - aquecimento) / frames;
+                cameraPos = splineFechada(posicoes, t) * s;
+                cameraFront = glm::normalize(splineFechada(alvos, t) * s - cameraPos);
+                cameraUp = glm::normalize(glm::cross(glm::cross(cameraFront, glm::vec3(0.0f, 1.0f, 0.0f)), cameraFront));
+
+                auto inicio = chrono::steady_clock::now();
+                desenhaFrame();
+                if (window) {
+                    glfwSwapBuffers(window);
+                    glfwPollEvents();
+                }
+                glFinish();
+                double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+                if (i == 0)
+                    primeiro = ms;
+                if (i < aquecimento)
+                    continue;
+
+                tempos.push_back(ms);
+                const RenderStats& desenho = renderQueue.stats();
+                const ChunkRenderStats& chunks = chunkRenderer.stats();
+                somaDraws += desenho.drawCalls;
+                somaTriangulos += (double)chunks.triangles;
+                somaChunks += chunks.chunksVisible;
+                maxDraws = max(maxDraws, desenho.drawCalls);
+                maxTriangulos = max(maxTriangulos, chunks.triangles);
+                maxMalhas = max(maxMalhas, chunkRenderer.gpuBytes());
+                maxVolume = max(maxVolume, volumeGPU.gpuBytes());
+            }
+
+            ResumoTempos r = resumeTempos(tempos);
+            const double n = (double)tempos.size();
+
+            fprintf(json, "%s\n    {\n      \"cena\": \"%s\",\n      \"tamanho\": %d,\n      \"hash\": \"%016llx\",\n",
+                    resultados ? "," : "", cena.c_str(), tam, (unsigned long long)hash);
+            fprintf(json, "      \"primeiroFrameMs\": %.3f,\n", primeiro);
+            fprintf(json, "      \"frameMs\": { \"media\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, "
+                          "\"low1\": %.3f, \"max\": %.3f },\n",
+                    r.media, r.p50, r.p95, r.p99, r.low1, r.max);
+            fprintf(json, "      \"drawCalls\": { \"media\": %.2f, \"max\": %d },\n", somaDraws / n, maxDraws);
+            fprintf(json, "      \"triangulos\": { \"media\": %.1f, \"max\": %lld },\n", somaTriangulos / n,
+                    maxTriangulos);
+            fprintf(json, "      \"chunksVisiveis\": { \"media\": %.2f, \"total\": %d },\n", somaChunks / n,
+                    world.chunkCount());
+            fprintf(json, "      \"memoria\": { \"mundoBytes\": %zu, \"malhasGpuBytes\": %zu, \"volumeGpuBytes\": %zu }\n    }",
+                    world.chunkCount() * sizeof(Chunk), maxMalhas, maxVolume);
+            resultados++;
+
+            cout << cena << " | " << tam << "^3 | " << primeiro << " | " << r.media << "/" << r.p50 << "/" << r.p95
+                 << "/" << r.p99 << "/" << r.low1 << " | "
+                 << somaDraws / n << " | " << (long long)(somaTriangulos / n) << endl;
+        }
+    }
+    fprintf(json, "\n  ]\n}\n");
+    fclose(json);
+    cout << "Relatorio: " << relatorio << endl;
+
+    if (!window) {
+        destino.destroy();
+        framebufferSaida = 0;
+    }
+    return 0;
+}
+
+// --benchmark-luz: no terreno de teste com mel (emissor) e vidro espalhados, em 64^3,
+// 128^3 e 256^3, mede a luz inicial do mundo inteiro com 1 thread e com todas, e o
+// tempo de reacender depois de cada edição isolada (Delete, V e emissores colocados e
+// tirados). No fim confere a luz incremental contra uma refeita do zero. Roda sem janela
+int benchmarkLuz() {
+    using relogio = chrono::steady_clock;
+    auto ms = [](relogio::time_point a, relogio::time_point b) {
+        return chrono::duration<double, milli>(b - a).count();
+    };
+    const int tamanhos[] = { 64, 128, 256 };
+    const int numEdicoes = 200;
+    int hw = max(1u, thread::hardware_concurrency());
+    int falhas = 0;
+
+    cout << "Threads: " << hw << endl;
+    cout << "Tamanho | Inicial 1 thread (ms) | Inicial " << hw << " threads (ms) | Edicao media/p95/max (ms) | Celulas por edicao | Divergencias" << endl;
+    for (int tam : tamanhos) {
+        uint32_t semente = 777;
+        auto aleatorio = [&]() {
+            semente = semente * 1664525u + 1013904223u;
+            return (int)(semente >> 8);
+        };
+        // Altura da superfície de cada coluna, para as edições caírem onde a luz muda
+        auto superficie = [&](int x, int z) {
+            int y = tam - 1;
+            while (y > 0 && !world.visible(x, y, z))
+                y--;
+            return y;
+        };
+
+        world.resize(tam, tam, tam);
+        geraTerrenoTeste(world);
+        for (int i = 0; i < tam * tam / 32; i++) {
+            int x = aleatorio() % tam, z = aleatorio() % tam;
+            int y = min(tam - 1, superficie(x, z) + 1 + aleatorio() % 3);
+            world.set(x, y, z, (uint8_t)(VOXEL_VISIVEL | (i % 2 == 0 ? 4 : 1)));
+        }
+
+        luz.threads = 1;
+        auto inicio = relogio::now();
+        luz.relightAll(world);
+        double inicial1 = ms(inicio, relogio::now());
+        luz.threads = hw;
+        inicio = relogio::now();
+        luz.relightAll(world);
+        double inicialN = ms(inicio, relogio::now());
+        luz.update(world);
+
+        vector<double> tempos;
+        long long celulas = 0;
+        vector<VoxelEdit> emissores;
+        for (int i = 0; i < numEdicoes; i++) {
+            int x = aleatorio() % tam, z = aleatorio() % tam;
+            int y = superficie(x, z), acima = min(tam - 1, y + 1);
+            if (i % 4 == 0)
+                world.setVisible(x, y, z, false);   // Delete
+            else if (i % 4 == 1)
+                world.setVisible(x, acima, z, true);  // V
+            else if (i % 4 == 2) {
+                world.set(x, acima, z, (uint8_t)(VOXEL_VISIVEL | 4));
+                emissores.push_back({ x, acima, z });
+            } else {
+                // Tira o emissor colocado antes: o pass de remoção apaga a luz de bloco
+                const VoxelEdit& e = emissores.back();
+                world.setVisible(e.x, e.y, e.z, false);
+                emissores.pop_back();
+            }
+            inicio = relogio::now();
+            luz.update(world);
+            tempos.push_back(ms(inicio, relogio::now()));
+            celulas += luz.stats().cellsRemoved + luz.stats().cellsLit;
+        }
+
+        // A luz incremental tem de ser a mesma de um relightAll
+        vector<uint8_t> incremental;
+        for (int i = 0; i < world.chunkCount(); i++) {
+            const Chunk& c = world.chunk(i % world.chunksX(), i / (world.chunksX() * world.chunksZ()),
+                                         (i / world.chunksX()) % world.chunksZ());
+            incremental.insert(incremental.end(), c.light, c.light + CHUNK_VOLUME);
+        }
+        luz.relightAll(world);
+        long long divergencias = 0;
+        for (int i = 0; i < world.chunkCount(); i++) {
+            const Chunk& c = world.chunk(i % world.chunksX(), i / (world.chunksX() * world.chunksZ()),
+                                         (i / world.chunksX()) % world.chunksZ());
+            for (int j = 0; j < CHUNK_VOLUME; j++)
+                divergencias += c.light[j] != incremental[(size_t)i * CHUNK_VOLUME + j];
+        }
+        falhas += divergencias != 0;
+
+        double soma = 0.0;
+        for (double t : tempos)
+            soma += t;
+        sort(tempos.begin(), tempos.end());
+        cout << tam << "^3 | " << inicial1 << " | " << inicialN << " | " << soma / tempos.size() << " / "
+             << tempos[tempos.size() * 95 / 100] << " / " << tempos.back() << " | "
+             << celulas / numEdicoes << " | " << divergencias << endl;
+    }
+    luz.threads = 0;
+    return falhas == 0 ? 0 : 1;
 }
 
 // Cria o VAO com os vértices e coordenadas de textura do cubo
@@ -420,6 +1336,334 @@ GLuint setupGeometry() {
     return vao;
 }
 
+// Nome do arquivo do frame no padrão do --captura: o único %d (ou %0Nd) vira o número
+// do frame e %% vira %. Qualquer outro % (ou um segundo %d) é recusado: o padrão vem da
+// linha de comando e não vai para o printf. numerado diz se havia o %d
+bool nomeCaptura(const string& padrao, int frame, string& nome, bool& numerado) {
+    nome.clear();
+    numerado = false;
+    for (size_t i = 0; i < padrao.size(); i++) {
+        if (padrao[i] != '%') {
+            nome += padrao[i];
+            continue;
+        }
+        if (i + 1 < padrao.size() && padrao[i + 1] == '%') {
+            nome += '%';
+            i++;
+            continue;
+        }
+        size_t j = i + 1;
+        bool zeros = j < padrao.size() && padrao[j] == '0';
+        if (zeros)
+            j++;
+        int largura = 0;
+        while (j < padrao.size() && isdigit((unsigned char)padrao[j]) && largura < 100)
+            largura = largura * 10 + (padrao[j++] - '0');
+        if (numerado || j >= padrao.size() || padrao[j] != 'd' || largura >= 100)
+            return false;
+        string numero = to_string(frame);
+        if ((int)numero.size() < largura)
+            nome.append(largura - numero.size(), zeros ? '0' : ' ');
+        nome += numero;
+        numerado = true;
+        i = j;
+    }
+    return true;
+}
+
+// --headless: o mesmo caminho de renderização da janela, num contexto EGL sem display.
+// Desenha os frames no framebuffer do FrameCapture e, com --captura ARQ, lê de volta
+// pelos PBOs cada frame (se ARQ tiver um %d, ex. frame_%04d.png) ou só o último
+int executaHeadless(int frames, const string& captura) {
+    string nome;
+    bool todos = false;
+    if (!nomeCaptura(captura, 0, nome, todos)) {
+        cerr << "--captura: use um unico %d (ou %0Nd) para o numero do frame e %% para um %: " << captura
+             << endl;
+        return 1;
+    }
+    FrameCapture saida;
+    saida.setup(larguraTela, alturaTela);
+    framebufferSaida = saida.framebuffer();
+
+    auto inicio = chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        auto inicioFrame = chrono::steady_clock::now();
+        PERFIL_ESCOPO("frame");
+        desenhaFrame();
+        if (!captura.empty() && (todos || i == frames - 1)) {
+            nomeCaptura(captura, i, nome, todos);
+            saida.capture(nome, saida.framebuffer());
+        }
+        saida.poll(false);
+        profilerEndFrame(chrono::duration<double, milli>(chrono::steady_clock::now() - inicioFrame).count());
+    }
+    saida.poll(true);
+    glFinish();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+
+    FrameCaptureStats stats = saida.stats();
+    cout << "Renderer: " << glGetString(GL_RENDERER) << endl;
+    cout << frames << " frames " << larguraTela << "x" << alturaTela << " em " << ms << " ms ("
+         << ms / frames << " ms/frame)" << endl;
+    if (stats.captured > 0)
+        cout << "Capturas: " << stats.written << "/" << stats.captured << " | thread de render "
+             << stats.renderMs / stats.captured << " ms/frame (max " << stats.renderMaxMs << "), gravacao "
+             << stats.writeMs / stats.captured << " ms por frame | esperas: " << stats.stalls << endl;
+    imprimePerfil();
+    saida.destroy();
+    bool ok = saida.stats().written == stats.captured;
+    framebufferSaida = 0;
+    return ok ? 0 : 1;
+}
+
+// Mundo com que o editor começa: vazio, com um voxel de vidro na seleção
+void iniciaMundo(int tamanho) {
+    world.resize(tamanho, tamanho, tamanho);
+    world.setTexture(selecaoX, selecaoY, selecaoZ, 1);
+    world.setVisible(selecaoX, selecaoY, selecaoZ, true);
+}
+
+// Estado do editor no início da gravação da entrada e de volta na reprodução
+InputLogHeader estadoEntrada() {
+    InputLogHeader h;
+    h.worldX = world.sizeX();
+    h.worldY = world.sizeY();
+    h.worldZ = world.sizeZ();
+    h.worldHash = hashMundo(world);
+    for (int i = 0; i < 3; i++) {
+        h.cameraPos[i] = cameraPos[i];
+        h.cameraFront[i] = cameraFront[i];
+        h.cameraUp[i] = cameraUp[i];
+    }
+    h.yaw = yaw;
+    h.pitch = pitch;
+    h.fov = fov;
+    h.lastX = lastX;
+    h.lastY = lastY;
+    h.firstMouse = firstMouse;
+    h.selection[0] = selecaoX;
+    h.selection[1] = selecaoY;
+    h.selection[2] = selecaoZ;
+    return h;
+}
+
+void restauraEstadoEntrada(const InputLogHeader& h) {
+    cameraPos = glm::vec3(h.cameraPos[0], h.cameraPos[1], h.cameraPos[2]);
+    cameraFront = glm::vec3(h.cameraFront[0], h.cameraFront[1], h.cameraFront[2]);
+    cameraUp = glm::vec3(h.cameraUp[0], h.cameraUp[1], h.cameraUp[2]);
+    yaw = h.yaw;
+    pitch = h.pitch;
+    fov = h.fov;
+    lastX = h.lastX;
+    lastY = h.lastY;
+    firstMouse = h.firstMouse != 0;
+    selecaoX = h.selection[0];
+    selecaoY = h.selection[1];
+    selecaoZ = h.selection[2];
+}
+
+// --reproduzir ARQ: refaz uma sessão gravada com --gravar-entrada. Cada frame do log
+// roda com passo fixo (deltaTime = passoMs, não o tempo gravado), processInput com as
+// teclas gravadas e, depois do frame, os eventos do glfwPollEvents daquele frame
+// entregues aos próprios callbacks, na ordem gravada. Assim a câmera e as edições são
+// as mesmas em qualquer máquina e versão, e o hash do mundo no fim tem de bater com o
+// da gravação. Os frames são medidos até o fim da GPU (glFinish), sem vsync; com
+// relatorio, grava tempos e hashes em JSON para comparar versões
+int executaReproducao(const string& arquivo, double passoMs, const string& relatorio) {
+    InputLog log;
+    if (!loadInputLog(arquivo, log) || log.frames.empty()) {
+        cerr << "Log de entrada invalido: " << arquivo << endl;
+        return 1;
+    }
+    const InputLogHeader& h = log.header;
+    restauraEstadoEntrada(h);
+    iniciaMundo(h.worldX);
+    if (world.sizeY() != h.worldY || world.sizeZ() != h.worldZ || hashMundo(world) != h.worldHash) {
+        cerr << "O mundo inicial nao confere com o da gravacao" << endl;
+        return 1;
+    }
+
+    // Sem janela, desenha no framebuffer do FrameCapture; com janela, sem a entrada ao vivo
+    FrameCapture destino;
+    if (!window) {
+        destino.setup(larguraTela, alturaTela);
+        framebufferSaida = destino.framebuffer();
+    }
+    else {
+        glfwSwapInterval(0);
+        glfwSetCursorPosCallback(window, nullptr);
+        glfwSetScrollCallback(window, nullptr);
+        glfwSetKeyCallback(window, nullptr);
+    }
+
+    vector<double> tempos;
+    tempos.reserve(log.frames.size());
+    long long eventos = 0;
+    deltaTime = (float)(passoMs / 1000.0);
+    for (const InputFrame& quadro : log.frames) {
+        auto inicio = chrono::steady_clock::now();
+        {
+            PERFIL_ESCOPO("frame");
+            processInput(window, quadro.keys);
+            desenhaFrame();
+            if (window) {
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+            for (const InputEvent& e : quadro.events) {
+                if (e.type == ENTRADA_TECLA)
+                    key_callback(window, e.key, e.scancode, e.action, e.mods);
+                else if (e.type == ENTRADA_CURSOR)
+                    mouse_callback(window, e.x, e.y);
+                else if (e.type == ENTRADA_SCROLL)
+                    scroll_callback(window, e.x, e.y);
+            }
+            eventos += quadro.events.size();
+            glFinish();
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+        tempos.push_back(ms);
+        profilerEndFrame(ms);
+    }
+    uint64_t hash = hashMundo(world);
+    bool confere = !log.complete || hash == log.finalHash;
+
+    // O primeiro frame (luz e malhas do mundo todo) fica fora dos percentis
+    double primeiro = tempos.front();
+    ResumoTempos r = resumeTempos(vector<double>(tempos.begin() + 1, tempos.end()));
+    cout << "Renderer: " << glGetString(GL_RENDERER) << " | " << larguraTela << "x" << alturaTela << endl;
+    cout << log.frames.size() << " frames, " << eventos << " eventos, passo " << passoMs << " ms" << endl;
+    cout << "Primeiro frame " << primeiro << " ms | media/p50/p95/p99/1% low " << r.media << "/" << r.p50 << "/"
+         << r.p95 << "/" << r.p99 << "/" << r.low1 << " ms | max " << r.max << " ms" << endl;
+    char hashTexto[17], hashGravado[17];
+    snprintf(hashTexto, sizeof(hashTexto), "%016llx", (unsigned long long)hash);
+    snprintf(hashGravado, sizeof(hashGravado), "%016llx", (unsigned long long)log.finalHash);
+    if (log.complete)
+        cout << "Hash do mundo " << hashTexto << (confere ? " confere com a gravacao" : " DIFERENTE da gravacao ")
+             << (confere ? "" : hashGravado) << endl;
+    else
+        cout << "Hash do mundo " << hashTexto << " (log sem o fim da sessao: nada a comparar)" << endl;
+
+    if (!relatorio.empty()) {
+        FILE* json = fopen(relatorio.c_str(), "w");
+        if (json) {
+            fprintf(json, "{\n  \"renderer\": \"%s\",\n  \"resolucao\": [%d, %d],\n", (const char*)glGetString(GL_RENDERER),
+                    larguraTela, alturaTela);
+            fprintf(json, "  \"log\": \"%s\",\n  \"frames\": %zu,\n  \"eventos\": %lld,\n  \"passoMs\": %.3f,\n",
+                    arquivo.c_str(), log.frames.size(), eventos, passoMs);
+            fprintf(json, "  \"primeiroFrameMs\": %.3f,\n", primeiro);
+            fprintf(json, "  \"frameMs\": { \"media\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, "
+                          "\"low1\": %.3f, \"max\": %.3f },\n",
+                    r.media, r.p50, r.p95, r.p99, r.low1, r.max);
+            fprintf(json, "  \"hash\": \"%s\",\n  \"hashGravado\": %s%s%s,\n  \"confere\": %s\n}\n", hashTexto,
+                    log.complete ? "\"" : "", log.complete ? hashGravado : "null", log.complete ? "\"" : "",
+                    confere ? "true" : "false");
+            fclose(json);
+            cout << "Relatorio: " << relatorio << endl;
+        }
+        else {
+            cerr << "Falha ao criar " << relatorio << endl;
+        }
+    }
+    imprimePerfil();
+
+    if (!window) {
+        destino.destroy();
+        framebufferSaida = 0;
+    }
+    return confere ? 0 : 1;
+}
+
+// Enfileira as capturas pedidas do back buffer (depois do frame pronto, antes da
+// troca) e passa para a gravação as leituras que a GPU já terminou
+void capturaFrame() {
+    if (quadro.sequence != capturaContinua) {
+        capturaContinua = quadro.sequence;
+        if (capturaContinua) {
+            numeroSequencia++;
+            quadroSequencia = 0;
+        }
+        cout << "Sequencia " << numeroSequencia << (capturaContinua ? " iniciada" : " parada") << endl;
+    }
+    bool pedirCaptura = capturasFeitas < quadro.captureRequests;
+    if (!pedirCaptura && !capturaContinua) {
+        if (capturaTela.ready())
+            capturaTela.poll(false);
+        return;
+    }
+    if (!capturaTela.ready() || capturaTela.width() != quadro.width || capturaTela.height() != quadro.height) {
+        capturaTela.destroy();
+        capturaTela.setup(quadro.width, quadro.height);
+    }
+
+    char nome[64];
+    if (pedirCaptura) {
+        // A captura pedida nunca é descartada (no pior caso espera um slot)
+        snprintf(nome, sizeof(nome), "captura_%03d.png", ++numeroCaptura);
+        capturaTela.dropWhenBusy = false;
+        capturaTela.capture(nome, 0);
+        cout << "Captura: " << nome << endl;
+        capturasFeitas = quadro.captureRequests;
+    }
+    if (capturaContinua) {
+        snprintf(nome, sizeof(nome), "sequencia%02d_%05d.png", numeroSequencia, quadroSequencia);
+        capturaTela.dropWhenBusy = true;
+        if (capturaTela.capture(nome, 0))
+            quadroSequencia++;
+    }
+    capturaTela.poll(false);
+}
+
+// F9: liga o profiler ou desliga e grava o trace
+void alternaPerfil() {
+    if (!profilerEnabled()) {
+        profilerStart();
+        cout << "Profiler ligado" << endl;
+        return;
+    }
+    profilerStop();
+    char nome[64];
+    snprintf(nome, sizeof(nome), "perfil_%03d.json", ++numeroPerfil);
+    cout << (profilerSaveTrace(nome) ? "Perfil gravado: " : "Falha ao gravar ") << nome << endl;
+    imprimePerfil();
+}
+
+// Tempos de frame da janela do profiler
+void imprimePerfil() {
+    FrameTimeStats perfil = profilerFrameStats();
+    if (perfil.frames == 0)
+        return;
+    cout << "Frame (" << perfil.frames << "): media " << perfil.mean << " ms | p50 " << perfil.p50 << " | p95 "
+         << perfil.p95 << " | p99 " << perfil.p99 << " | 1% low " << perfil.low1 << " ms | GPU " << perfil.gpuMs
+         << " ms";
+    if (perfil.dropped > 0)
+        cout << " | " << perfil.dropped << " eventos perdidos";
+    cout << endl;
+}
+
+// F6: acrescenta a câmera atual (posição e um alvo à frente, em frações do tamanho do
+// mundo) a caminho_camera.txt, o formato de --caminho do --benchmark
+void gravaPontoCaminho() {
+    float s = (float)max(tamanhoMundo(0), max(tamanhoMundo(1), tamanhoMundo(2)));
+    glm::vec3 posicao = cameraPos / s, alvo = (cameraPos + cameraFront * (s * 0.5f)) / s;
+    FILE* f = fopen("caminho_camera.txt", "a");
+    if (!f)
+        return;
+    fprintf(f, "%.4f %.4f %.4f %.4f %.4f %.4f\n", posicao.x, posicao.y, posicao.z, alvo.x, alvo.y, alvo.z);
+    fclose(f);
+    cout << "Ponto do caminho gravado em caminho_camera.txt" << endl;
+}
+
+// Na saída: grava o trace de --perfil e libera as consultas de GL
+void salvaPerfil() {
+    if (!arquivoPerfil.empty()) {
+        profilerStop();
+        cout << (profilerSaveTrace(arquivoPerfil) ? "Perfil gravado: " : "Falha ao gravar ") << arquivoPerfil << endl;
+    }
+    profilerShutdown();
+}
+
 // Carrega uma textura de arquivo
 int loadTexture(string filePath) {
     GLuint texID;
@@ -456,65 +1700,384 @@ int loadTexture(string filePath) {
     return texID;
 }
 
-// Salva o estado da grid em um arquivo .dat
-void saveGrid(const char* filename) {
-    ofstream file(filename, ios::binary);
-    if (!file.is_open()) {
-        cerr << "Falha ao salvar grid!" << endl;
-        return;
-    }
-
-    for (int y = 0; y < TAM; y++) {
-        for (int x = 0; x < TAM; x++) {
-            for (int z = 0; z < TAM; z++) {
-                file.write(reinterpret_cast<char*>(&grid[y][x][z].texID), sizeof(int));
-                file.write(reinterpret_cast<char*>(&grid[y][x][z].visivel), sizeof(bool));
+// Carrega as texturas de bloco em um array 2D (uma camada por material)
+GLuint loadTextureArray(const vector<string>& filePaths) {
+    const int TEX_SIZE = 16;
+    GLuint texID;
+    glGenTextures(1, &texID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, TEX_SIZE, TEX_SIZE, (GLsizei)filePaths.size(),
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    for (size_t layer = 0; layer < filePaths.size(); layer++) {
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(filePaths[layer].c_str(), &width, &height, &nrChannels, 4);
+        if (data && width == TEX_SIZE && height == TEX_SIZE) {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, TEX_SIZE, TEX_SIZE, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, data);
+        } else {
+            cout << "Falha ao carregar textura " << TEX_SIZE << "x" << TEX_SIZE << ": " << filePaths[layer] << endl;
+            unsigned char defaultTex[TEX_SIZE * TEX_SIZE * 4];
+            for (int i = 0; i < TEX_SIZE * TEX_SIZE; i++) {
+                bool magenta = ((i % TEX_SIZE) / 8 + (i / TEX_SIZE) / 8) % 2 == 0;
+                defaultTex[i * 4 + 0] = magenta ? 255 : 0;
+                defaultTex[i * 4 + 1] = 0;
+                defaultTex[i * 4 + 2] = magenta ? 255 : 0;
+                defaultTex[i * 4 + 3] = 255;
             }
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, TEX_SIZE, TEX_SIZE, 1,
+                            GL_RGBA, GL_UNSIGNED_BYTE, defaultTex);
         }
+        stbi_image_free(data);
     }
 
-    file.close();
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return texID;
 }
 
-// Carrega o estado da grid de um arquivo .dat
-void loadGrid(const char* filename) {
-    ifstream file(filename, ios::binary);
-    if (!file.is_open()) {
-        cerr << "Falha ao carregar grid!" << endl;
-        return;
+// Desenha o HUD por cima do frame, refazendo o texto quando passa o intervalo
+void renderUI() {
+    double agora = glfwGetTime();
+    hudAtrasado = hud.visible;
+    if (hud.visible && (ultimaMontagemHud < 0.0 || agora - ultimaMontagemHud >= HUD_INTERVALO)) {
+        montaHud();
+        ultimaMontagemHud = agora;
+        hudAtrasado = false;
     }
+    hud.draw(framebufferSaida, quadro.width, quadro.height);
+}
 
-    for (int y = 0; y < TAM; y++) {
-        for (int x = 0; x < TAM; x++) {
-            for (int z = 0; z < TAM; z++) {
-                file.read(reinterpret_cast<char*>(&grid[y][x][z].texID), sizeof(int));
-                file.read(reinterpret_cast<char*>(&grid[y][x][z].visivel), sizeof(bool));
-            }
+// Texto do HUD: tempo de frame, câmera e seleção, desenho, chunks e memória
+void montaHud() {
+    vector<pair<string, uint32_t>> linhas;
+    char texto[256];
+    const uint32_t branco = hudColor(235, 235, 235), cinza = hudColor(170, 170, 170);
+
+    FrameTimeStats perfil = profilerFrameStats();
+    uint32_t corFrame = perfil.p95 <= 17.0 ? hudColor(120, 230, 120)
+                      : perfil.p95 <= 34.0 ? hudColor(240, 210, 90) : hudColor(240, 100, 90);
+    snprintf(texto, sizeof(texto), "Frame %.2f ms (%.0f fps) | p50 %.1f p95 %.1f p99 %.1f | 1%% low %.1f ms",
+             perfil.mean, perfil.mean > 0.0 ? 1000.0 / perfil.mean : 0.0, perfil.p50, perfil.p95, perfil.p99,
+             perfil.low1);
+    linhas.push_back({ texto, corFrame });
+    if (profilerEnabled()) {
+        snprintf(texto, sizeof(texto), "Profiler gravando (F9 grava o trace) | GPU %.2f ms", perfil.gpuMs);
+        linhas.push_back({ texto, hudColor(240, 100, 90) });
+    }
+
+    const World& mundo = *mundoDesenhado;
+    const int* selecao = quadro.selection;
+    snprintf(texto, sizeof(texto), "Posicao (%.1f, %.1f, %.1f) | Selecao (%d, %d, %d) %s, %s", quadro.cameraPos.x,
+             quadro.cameraPos.y, quadro.cameraPos.z, selecao[0], selecao[1], selecao[2],
+             mundo.visible(selecao[0], selecao[1], selecao[2]) ? "visivel" : "oculto",
+             textureNames[mundo.texture(selecao[0], selecao[1], selecao[2]) % NUM_TEXTURES]);
+    linhas.push_back({ texto, branco });
+
+    const RenderStats& desenho = renderQueue.stats();
+    const ChunkRenderStats& chunks = chunkRenderer.stats();
+    snprintf(texto, sizeof(texto), "Draw calls %d | Trocas de estado %d (sem ordenar %d)", desenho.drawCalls,
+             desenho.stateChangesSorted, desenho.stateChangesUnsorted);
+    linhas.push_back({ texto, branco });
+    snprintf(texto, sizeof(texto), "Triangulos %lld (sem LOD %lld) | Chunks %d/%d | %d por remalhar",
+             chunks.triangles, chunks.trianglesNoLod, chunks.chunksVisible, chunks.chunksTotal, chunks.chunksPending);
+    linhas.push_back({ texto, branco });
+
+    string lods = string("LOD ") + (chunkRenderer.lodEnabled ? "ligado" : "desligado") + " (";
+    for (int lod = 0; lod < NUM_LODS; lod++)
+        lods += (lod ? " " : "") + to_string(1 << lod) + "x:" + to_string(chunks.chunksPerLod[lod]);
+    linhas.push_back({ lods + ")", branco });
+
+    if (quadro.raymarch)
+        snprintf(texto, sizeof(texto), "Raymarching | Volume GPU: %zu bytes/frame, %d bricks pendentes",
+                 volumeGPU.uploadedBytes(), volumeGPU.pendingBricks());
+    else
+        snprintf(texto, sizeof(texto), "Malhas | Culling na %s | Malhas na %s",
+                 chunkRenderer.gpuCulling && chunkRenderer.gpuCullingSupported() ? "GPU" : "CPU",
+                 chunkRenderer.gpuMeshing && chunkRenderer.gpuMeshingSupported() ? "GPU" : "CPU");
+    linhas.push_back({ texto, branco });
+
+    const double mb = 1.0 / (1024.0 * 1024.0);
+    snprintf(texto, sizeof(texto), "Memoria: mundo %.1f MB | GPU: malhas %.1f MB, volume %.1f MB",
+             mundo.chunkCount() * sizeof(Chunk) * mb, chunkRenderer.gpuBytes() * mb, volumeGPU.gpuBytes() * mb);
+    linhas.push_back({ texto, branco });
+    if (mundoDesenhado == &mundoRender) {
+        SnapshotMailboxStats caixa = caixaRender.stats();
+        snprintf(texto, sizeof(texto), "Thread de render: %lld quadros, %lld juntados ao seguinte", caixa.taken,
+                 caixa.merged);
+        linhas.push_back({ texto, branco });
+        snprintf(texto, sizeof(texto), "Edicoes: %lld comandos em %lld lotes, %lld juntados | fila %zu",
+                 comandosEdicao.load(), lotesEdicao.load(), comandosJuntados.load(), filaEdicoes.size());
+        linhas.push_back({ texto, branco });
+    }
+    if (!arquivoStreaming.empty()) {
+        StreamingStats s = streaming.stats();
+        snprintf(texto, sizeof(texto), "Streaming: %d/%d chunks, %d lendo, %d gravando | %lld lidos (%lld previstos), "
+                 "%lld descartados | update %.2f ms (max %.2f)", s.resident, s.budget, s.loading, s.writing, s.loaded,
+                 s.prefetched, s.evicted, s.updateMs, s.updateMaxMs);
+        linhas.push_back({ texto, branco });
+    }
+
+    if (capturaTela.ready()) {
+        FrameCaptureStats captura = capturaTela.stats();
+        snprintf(texto, sizeof(texto), "Capturas: %d/%d gravadas, %d descartadas%s", captura.written,
+                 captura.captured, captura.dropped, capturaContinua ? " | sequencia gravando" : "");
+        linhas.push_back({ texto, branco });
+    }
+    snprintf(texto, sizeof(texto), "Redesenho %s (F7) | ocioso: %.0f frames/min em %.0f s",
+             quadro.onDemand ? "sob demanda" : "continuo",
+             quadro.idleSeconds > 0.0 ? framesOciosos * 60.0 / quadro.idleSeconds : 0.0, quadro.idleSeconds);
+    linhas.push_back({ texto, cinza });
+    linhas.push_back({ "F1: esconder | controles no console", cinza });
+
+    // Painel translúcido atrás das linhas, uma célula de margem
+    size_t colunas = 0;
+    for (const auto& linha : linhas)
+        colunas = max(colunas, linha.first.size());
+    hud.scale = max(1, quadro.height / 400);
+    hud.begin();
+    hud.panel(0, 0, (int)colunas + 2, (int)linhas.size() + 2, hudColor(0, 0, 0, 150));
+    for (size_t i = 0; i < linhas.size(); i++)
+        hud.text(1, (int)i + 1, linhas[i].first, linhas[i].second);
+}
+
+// Qualquer evento de entrada: redesenha e marca o fim do tempo ocioso
+void marcaEntrada() {
+    pedidoRedesenho = true;
+    ultimaEntrada = glfwGetTime();
+}
+
+// Sob demanda, a thread principal só publica a vista se algo mudou desde a última:
+// entrada ou janela (pedidoRedesenho), teclas de movimento seguradas e a sequência de
+// capturas ligada. As edições chegam ao desenho pela thread do mundo, e o que só o
+// desenho sabe (bricks por enviar, HUD vencido) a thread de render redesenha sozinha
+// (redesenhoProprio)
+bool precisaRedesenhar(uint16_t teclas) {
+    return !sobDemanda || pedidoRedesenho || teclas != 0 || sequenciaPedida;
+}
+
+// Manda uma edição para a thread do mundo ou, sem ela, aplica na hora
+void enviaEdicao(const EditCommand& comando) {
+    if (mundoEmThread)
+        filaEdicoes.push(comando);
+    else
+        aplicaEdicoes(&comando, 1);
+}
+
+// Um lote de comandos: os de voxel passam pelo loteEdicoes (juntados por célula e
+// escritos de uma vez), limpar/salvar/carregar vão na ordem, depois de escrever o que
+// veio antes
+void aplicaEdicoes(const EditCommand* comandos, size_t n) {
+    PERFIL_ESCOPO("edicoes");
+    long long juntadosAntes = loteEdicoes.stats().coalesced;
+    for (size_t i = 0; i < n; i++) {
+        const EditCommand& c = comandos[i];
+        if (loteEdicoes.add(world, c))
+            continue;
+        loteEdicoes.flush(world);
+        if (streaming.active() && c.type != EDICAO_SALVA) {
+            cout << "Resetar e carregar a grid ficam desligados com --streaming" << endl;
+            continue;
+        }
+        if (c.type == EDICAO_LIMPA) {
+            world.clear();
+            cout << "Grid resetada!" << endl;
+        }
+        else if (c.type == EDICAO_SALVA && streaming.active()) {
+            cout << "Chunks gravados: " << streaming.flush(world) << endl;
+        }
+        else if (c.type == EDICAO_SALVA) {
+            if (saveGrid(world, "voxel_grid.dat"))
+                cout << "Grid salva!" << endl;
+        }
+        else if (c.type == EDICAO_CARREGA) {
+            if (loadGrid(world, "voxel_grid.dat"))
+                cout << "Grid carregada!" << endl;
         }
     }
+    loteEdicoes.flush(world);
+
+    int textura = loteEdicoes.takeLastTexture();
+    if (textura >= 0)
+        cout << "Textura alterada para: " << textureNames[textura] << endl;
+    for (int eixo = 0; eixo < 3; eixo++)
+        tamanhoPublicado[eixo] = eixo == 0 ? world.sizeX() : eixo == 1 ? world.sizeY() : world.sizeZ();
+    lotesEdicao++;
+    comandosEdicao += (long long)n;
+    comandosJuntados += loteEdicoes.stats().coalesced - juntadosAntes;
+}
 
-    file.close();
+// Tamanho do mundo para a entrada: o último que a thread do mundo publicou ou, sem
+// ela, o do próprio mundo
+int tamanhoMundo(int eixo) {
+    if (mundoEmThread)
+        return tamanhoPublicado[eixo];
+    return eixo == 0 ? world.sizeX() : eixo == 1 ? world.sizeY() : world.sizeZ();
 }
 
-// Imprime informações
-void renderUI() {
-    static bool firstFrame = true;
-    if (firstFrame) {
-        printInstructions();
-        firstFrame = false;
+void limitaSelecao() {
+    selecaoX = max(0, min(selecaoX, tamanhoMundo(0) - 1));
+    selecaoY = max(0, min(selecaoY, tamanhoMundo(1) - 1));
+    selecaoZ = max(0, min(selecaoZ, tamanhoMundo(2) - 1));
+}
+
+// Publica para a thread de render as cópias dos chunks que mudaram desde a publicação
+// anterior, pelo registro do mundo (todos quando o mundo foi recriado ou o registro não
+// basta). Com streaming, os que saíram da memória vão sem cópia e o espelho os tira também
+void publicaMundo() {
+    PERFIL_ESCOPO("publicacao");
+    bool soMudados = world.takeChangedChunks(chunksMudados);
+    bool novaGeracao = geracaoPublicada != world.generation();
+    geracaoPublicada = world.generation();
+    const World& mundo = world;
+    vector<pair<int, shared_ptr<const Chunk>>> copias;
+    auto publica = [&](int i) {
+        if (mundo.resident(i))
+            copias.push_back({ i, make_shared<const Chunk>(mundo.chunk(i)) });
+        else if (!novaGeracao)
+            copias.push_back({ i, nullptr });
+    };
+    if (soMudados && !novaGeracao) {
+        for (int i : chunksMudados)
+            publica(i);
+    }
+    else {
+        for (int i = 0; i < world.chunkCount(); i++)
+            publica(i);
+    }
+    edicoesPublicadas = world.edits();
+    int tamanho[3] = { world.sizeX(), world.sizeY(), world.sizeZ() };
+    caixaRender.publishWorld(tamanho, world.generation(), move(copias));
+}
+
+// Thread do mundo (modo interativo): esvazia a fila de edições em lotes de até
+// MAX_LOTE comandos, reacende em volta do que mudou e publica os chunks. Com a fila
+// vazia dorme até o próximo comando (ou, com streaming, até a câmera andar); ao
+// fechar, aplica o que sobrou e grava os chunks sujos
+void threadMundo() {
+    profilerThreadName("mundo");
+    vector<EditCommand> lote(MAX_LOTE);
+    for (;;) {
+        size_t n = filaEdicoes.pop(lote.data(), lote.size());
+        if (n > 0) {
+            PERFIL_ESCOPO("lote");
+            aplicaEdicoes(lote.data(), n);
+            atualizaLuz();
+        }
+        if (streaming.active() && streaming.update(world))
+            atualizaLuz();
+        if (world.edits() != edicoesPublicadas)
+            publicaMundo();
+        if (n == 0) {
+            if (filaEdicoes.closed() && filaEdicoes.size() == 0)
+                break;
+            filaEdicoes.wait(streaming.busy() ? ESPERA_STREAMING : ESPERA_MAXIMA);
+        }
     }
+    streaming.close(world);
+}
+
+// Sob demanda, a thread de render também redesenha o último quadro sem um novo: bricks
+// do volume ainda por enviar (orçamento de upload), malhas ainda por refazer (orçamento
+// de remalha) e o texto do HUD vencido
+bool redesenhoProprio() {
+    if (volumeGPU.pendingBricks() > 0 || chunkRenderer.stats().chunksPending > 0)
+        return true;
+    return hudAtrasado && hud.visible && glfwGetTime() - ultimaMontagemHud >= HUD_INTERVALO;
+}
 
-    static int frameCount = 0;
-    if (frameCount++ % 60 == 0) {
-        clearScreen();  //limpa o console
-        printInstructions();
-        
-        cout << "\n=== Editor de Voxel ===" << endl;
-        cout << "Posicao: (" << cameraPos.x << ", " << cameraPos.y << ", " << cameraPos.z << ")" << endl;
-        cout << "Selecao: (" << selecaoX << ", " << selecaoY << ", " << selecaoZ << ")" << endl;
-        cout << "Voxel: " << (grid[selecaoY][selecaoX][selecaoZ].visivel ? "Visivel" : "Oculto");
-        cout << " | Textura: " << textureNames[grid[selecaoY][selecaoX][selecaoZ].texID] << endl;
+// Quanto a thread de render pode dormir esperando um quadro: até o HUD vencer ou
+// ESPERA_MAXIMA, pouco se há capturas na GPU para entregar
+double esperaRender() {
+    double espera = ESPERA_MAXIMA;
+    if (hudAtrasado && hud.visible)
+        espera = min(espera, max(0.0, ultimaMontagemHud + HUD_INTERVALO - glfwGetTime()));
+    if (capturaTela.ready() && capturaTela.pending() > 0)
+        espera = min(espera, 0.005);
+    return espera;
+}
+
+// Thread de render (modo interativo): dona do contexto de GL. Pega o quadro mais novo
+// (sob demanda dorme até chegar um), aplica as cópias de chunks ao espelho e desenha,
+// com o HUD, as capturas e a troca de buffers. No modo contínuo, sem quadro novo,
+// redesenha o último: o ritmo de apresentação não depende da thread principal
+void threadRender() {
+    glfwMakeContextCurrent(window);
+    profilerThreadName("render");
+    uint32_t geracaoEspelhada = 0;
+    RenderSnapshot novo;
+    bool temQuadro = false, aposEspera = true;
+    double ultimoFrame = glfwGetTime();
+
+    while (!caixaRender.closed()) {
+        double espera = 0.0;
+        if (!temQuadro)
+            espera = ESPERA_MAXIMA;
+        else if (quadro.onDemand && !redesenhoProprio())
+            espera = esperaRender();
+        double inicioEspera = glfwGetTime();
+        if (caixaRender.take(novo, espera)) {
+            PERFIL_ESCOPO("espelho");
+            applySnapshotChunks(novo, mundoRender, geracaoEspelhada);
+            novo.chunks.clear();
+            if (novo.width != quadro.width || novo.height != quadro.height) {
+                glViewport(0, 0, novo.width, novo.height);
+                resizeOIT(novo.width, novo.height);
+            }
+            quadro = move(novo);
+            temQuadro = true;
+        }
+        else if (!temQuadro || (quadro.onDemand && !redesenhoProprio())) {
+            if (capturaTela.ready() && capturaTela.pending() > 0)
+                capturaTela.poll(false);
+            aposEspera = true;
+            continue;
+        }
+        // Um intervalo com mais de ESPERA_CURTA dormindo é o editor parado, não um frame lento
+        double agora = glfwGetTime();
+        if (agora - inicioEspera > ESPERA_CURTA)
+            aposEspera = true;
+
+        {
+            PERFIL_ESCOPO("frame");
+            desenhaQuadro();
+            renderUI();
+            capturaFrame();
+            {
+                PERFIL_ESCOPO("troca");
+                glfwSwapBuffers(window);
+            }
+        }
+        if (quadro.idle)
+            framesOciosos++;
+        if (!aposEspera)
+            profilerEndFrame((agora - ultimoFrame) * 1000.0);
+        ultimoFrame = agora;
+        aposEspera = false;
     }
+    glfwMakeContextCurrent(nullptr);
+}
+
+// F7: alterna entre o redesenho sob demanda e o contínuo (recomeça a contagem ociosa)
+void alternaSobDemanda() {
+    imprimeOcioso();
+    sobDemanda = !sobDemanda;
+    tempoOcioso = 0.0;
+    framesOciosos = 0;
+    cout << "Redesenho " << (sobDemanda ? "sob demanda" : "continuo") << endl;
+}
+
+// Frames desenhados por minuto com o editor ocioso, no modo atual
+void imprimeOcioso() {
+    if (tempoOcioso <= 0.0)
+        return;
+    cout << "Ocioso (" << (sobDemanda ? "sob demanda" : "continuo") << "): " << framesOciosos << " frames em "
+         << tempoOcioso << " s (" << framesOciosos * 60.0 / tempoOcioso << " frames/min)" << endl;
 }
 
 // Imprime controles
@@ -532,139 +2095,413 @@ void printInstructions() {
     cout << "[1 - 9]: Mudar para textura especifica" << endl;
     cout << "V: Colocar voxel" << endl;
     cout << "Delete: Apagar/Esconder voxel" << endl;
+    cout << "C: Marcar canto da regiao" << endl;
+    cout << "F: Preencher regiao (canto ate a selecao) | Shift + F: Esvaziar" << endl;
     cout << "Ctrl + S: Salvar grid" << endl;
     cout << "Ctrl + L: Carregar grid" << endl;
     cout << "R: Resetar grid" << endl;
+    cout << "F1: Mostrar/esconder HUD" << endl;
+    cout << "F2: Ligar/desligar LOD" << endl;
+    cout << "F3: Culling na GPU/CPU" << endl;
+    cout << "F4: Malhas/raymarching" << endl;
+    cout << "F5: Malhas geradas na GPU/CPU" << endl;
+    cout << "F6: Gravar ponto do caminho da camera (--benchmark --caminho)" << endl;
+    cout << "F7: Redesenho sob demanda/continuo" << endl;
+    cout << "F9: Ligar/desligar profiler (grava perfil_NNN.json)" << endl;
+    cout << "F11: Ligar/desligar captura continua" << endl;
+    cout << "F12: Capturar tela" << endl;
     cout << "ESC: Sair" << endl;
 }
 
 // Função principal
-int main() {
-    if (!glfwInit()) {
-        cerr << "Falha ao inicializar GLFW" << endl;
-        return -1;
+int main(int argc, char** argv) {
+    // --tam N: tamanho do mundo (N^3 voxels)
+    // --validar-culling: compara o culling da GPU com o da CPU (sem janela visível) e sai
+    // --comparar-raymarch: mede malhas x raymarching em 64^3, 256^3 e 512^3 e sai
+    // --validar-mesher: compara o mesher da GPU com o da CPU (sem janela visível) e sai
+    // --orcamento-upload KB: bytes por frame para os bricks editados do volume na GPU (0 = sem limite)
+    // --benchmark-luz: mede a luz inicial e a incremental por edição (sem janela) e sai
+    // --headless: desenha sem janela nem display (EGL) e sai; com --frames N, --tamanho LxA,
+    //   --captura ARQ (.png ou cru; um %d ou %0Nd numera cada frame, %% é um %) e
+    //   --camera X,Y,Z --yaw G --pitch G
+    // --perfil ARQ: profiler ligado desde o início; grava o trace do Chrome em ARQ na saída
+    // --benchmark: cenas de estresse num caminho de câmera fixo, sem vsync, relatório JSON e sai;
+    //   com --cenas a,b (solido, xadrez, esparso, terreno, transparente), --tamanhos N,M,
+    //   --frames N (por cena), --relatorio ARQ e --caminho ARQ (pontos gravados com F6).
+    //   Com --headless, desenha sem janela
+    // --continuo: redesenha todo frame (sem isso, só quando a câmera, o mundo ou a janela mudam)
+    // --gravar-entrada ARQ: grava teclado, mouse e scroll da sessão num log binário
+    // --reproduzir ARQ: refaz a sessão do log com passo fixo (--passo MS, padrão 1/60 s),
+    //   mede os frames, confere o hash final do mundo e sai; com --relatorio ARQ grava
+    //   o resultado em JSON e com --headless desenha sem janela
+    // --streaming DIR: o mundo fica em regiões no diretório DIR (criadas com o terreno de
+    //   teste de --tam N se não existem) e só os chunks perto da câmera ficam na memória;
+    //   com --memoria-chunks MB
+    //   (padrão 256) e --raio-streaming N (chunks, padrão 8; saem a partir de N + 2)
+    bool validarCulling = false, validarMesher = false, compararRaymarch = false, headless = false;
+    bool benchmark = false;
+    string relatorio, cenasBenchmark, tamanhosBenchmark = "32,64", caminhoCamera;
+    int framesHeadless = 1, framesBenchmark = 240;
+    string arquivoGravacao, arquivoReproducao;
+    double passoReproducao = 1000.0 / 60.0;
+    string captura;
+    bool cameraDada = false;
+    glm::vec3 cameraInicial(0.0f);
+    float yawInicial = yaw, pitchInicial = pitch;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--tam" && i + 1 < argc)
+            TAM = max(1, atoi(argv[++i]));
+        else if (string(argv[i]) == "--validar-culling")
+            validarCulling = true;
+        else if (string(argv[i]) == "--validar-mesher")
+            validarMesher = true;
+        else if (string(argv[i]) == "--comparar-raymarch")
+            compararRaymarch = true;
+        else if (string(argv[i]) == "--orcamento-upload" && i + 1 < argc)
+            volumeGPU.uploadBudget = (size_t)max(0, atoi(argv[++i])) * 1024;
+        else if (string(argv[i]) == "--benchmark-luz")
+            return benchmarkLuz();
+        else if (string(argv[i]) == "--headless")
+            headless = true;
+        else if (string(argv[i]) == "--frames" && i + 1 < argc)
+            framesHeadless = framesBenchmark = max(1, atoi(argv[++i]));
+        else if (string(argv[i]) == "--tamanho" && i + 1 < argc)
+            sscanf(argv[++i], "%dx%d", &larguraTela, &alturaTela);
+        else if (string(argv[i]) == "--captura" && i + 1 < argc)
+            captura = argv[++i];
+        else if (string(argv[i]) == "--perfil" && i + 1 < argc)
+            arquivoPerfil = argv[++i];
+        else if (string(argv[i]) == "--benchmark")
+            benchmark = true;
+        else if (string(argv[i]) == "--relatorio" && i + 1 < argc)
+            relatorio = argv[++i];
+        else if (string(argv[i]) == "--cenas" && i + 1 < argc)
+            cenasBenchmark = argv[++i];
+        else if (string(argv[i]) == "--tamanhos" && i + 1 < argc)
+            tamanhosBenchmark = argv[++i];
+        else if (string(argv[i]) == "--caminho" && i + 1 < argc)
+            caminhoCamera = argv[++i];
+        else if (string(argv[i]) == "--continuo")
+            sobDemanda = false;
+        else if (string(argv[i]) == "--gravar-entrada" && i + 1 < argc)
+            arquivoGravacao = argv[++i];
+        else if (string(argv[i]) == "--reproduzir" && i + 1 < argc)
+            arquivoReproducao = argv[++i];
+        else if (string(argv[i]) == "--passo" && i + 1 < argc)
+            passoReproducao = max(0.001, atof(argv[++i]));
+        else if (string(argv[i]) == "--camera" && i + 1 < argc) {
+            sscanf(argv[++i], "%f,%f,%f", &cameraInicial.x, &cameraInicial.y, &cameraInicial.z);
+            cameraDada = true;
+        }
+        else if (string(argv[i]) == "--yaw" && i + 1 < argc)
+            yawInicial = (float)atof(argv[++i]);
+        else if (string(argv[i]) == "--pitch" && i + 1 < argc)
+            pitchInicial = max(-89.0f, min(89.0f, (float)atof(argv[++i])));
+        else if (string(argv[i]) == "--streaming" && i + 1 < argc)
+            arquivoStreaming = argv[++i];
+        else if (string(argv[i]) == "--memoria-chunks" && i + 1 < argc)
+            streaming.memoryBudget = (size_t)max(1, atoi(argv[++i])) << 20;
+        else if (string(argv[i]) == "--raio-streaming" && i + 1 < argc) {
+            streaming.loadRadius = (float)max(1, atoi(argv[++i]));
+            streaming.unloadRadius = streaming.loadRadius + 2.0f;
+        }
     }
+    larguraTela = max(1, larguraTela);
+    alturaTela = max(1, alturaTela);
+
+    GLADloadproc carregador;
+    if (headless) {
+        if (!createHeadlessContext())
+            return -1;
+        carregador = (GLADloadproc)headlessProcAddress;
+    }
+    else {
+        if (!glfwInit()) {
+            cerr << "Falha ao inicializar GLFW" << endl;
+            return -1;
+        }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    window = glfwCreateWindow(WIDTH, HEIGHT, "Editor de Voxel - Ender Hugo", nullptr, nullptr);
-    if (!window) {
-        cerr << "Falha ao criar janela GLFW" << endl;
-        glfwTerminate();
-        return -1;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        if (validarCulling || validarMesher || compararRaymarch)
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        window = glfwCreateWindow(WIDTH, HEIGHT, "Editor de Voxel - Ender Hugo", nullptr, nullptr);
+        if (!window) {
+            cerr << "Falha ao criar janela GLFW" << endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+        carregador = (GLADloadproc)glfwGetProcAddress;
     }
-    glfwMakeContextCurrent(window);
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+    if (!gladLoadGLLoader(carregador)) {
         cerr << "Falha ao inicializar GLAD" << endl;
         return -1;
     }
+    loadGLExtensions(carregador);
+
+    if (window) {
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetScrollCallback(window, scroll_callback);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetWindowRefreshCallback(window, window_refresh_callback);
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwGetFramebufferSize(window, &larguraTela, &alturaTela);
+    }
 
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetScrollCallback(window, scroll_callback);
-    glfwSetKeyCallback(window, key_callback);
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-
-    glViewport(0, 0, WIDTH, HEIGHT);
+    glViewport(0, 0, larguraTela, alturaTela);
     glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    shaderID = setupShader();
+    shaderID = setupShader(vertexShaderSource, fragmentShaderSource);
+    shaderChunk = setupShader(chunkVertexShaderSource, chunkFragmentShaderSource);
+    shaderChunkOIT = setupShader(chunkVertexShaderSource, chunkOITFragmentShaderSource);
+    setupOIT(larguraTela, alturaTela);
+    renderQueue.setPassCallback(beginOITPass);
     VAO = setupGeometry();
 
-    texIDList[0] = loadTexture("../assets/block_tex/moss_block.png");
-    texIDList[1] = loadTexture("../assets/block_tex/glass.png");
-    texIDList[2] = loadTexture("../assets/block_tex/polished_blackstone_bricks.png");
-    texIDList[3] = loadTexture("../assets/block_tex/sponge.png");
-    texIDList[4] = loadTexture("../assets/block_tex/honey_block_top.png");
-    texIDList[5] = loadTexture("../assets/block_tex/loom_bottom.png");
-    texIDList[6] = loadTexture("../assets/block_tex/packed_mud.png");
-    texIDList[7] = loadTexture("../assets/block_tex/frosted_ice_0.png");
-    texIDList[8] = loadTexture("../assets/block_tex/selected.png");
-
-    for (int y = 0, yPos = -TAM/2; y < TAM; y++, yPos += 1.0f) {
-        for (int x = 0, xPos = -TAM/2; x < TAM; x++, xPos += 1.0f) {
-            for (int z = 0, zPos = -TAM/2; z < TAM; z++, zPos += 1.0f) {
-                grid[y][x][z].pos = glm::vec3(xPos, yPos, zPos);
-                grid[y][x][z].texID = 0;
-                grid[y][x][z].fatorEscala = 0.98f;
-                grid[y][x][z].visivel = false;
-            }
-        }
+    vector<string> blockFiles;
+    for (int i = 0; i < NUM_TEXTURES; i++) {
+        string path = string("../assets/block_tex/") + textureFiles[i];
+        texIDList[i] = loadTexture(path);
+        blockFiles.push_back(path);
+    }
+    blockTextureArray = loadTextureArray(blockFiles);
+    volumeGPU.setup();
+    chunkRenderer.setup(shaderChunk, shaderChunkOIT, blockTextureArray, &volumeGPU);
+    raymarcher.setup(blockTextureArray);
+
+    // --streaming só vale no modo interativo; nele o mundo vem das regiões, sem passar
+    // inteiro pela memória
+    if (validarCulling || validarMesher || benchmark || headless || compararRaymarch || !arquivoReproducao.empty())
+        arquivoStreaming.clear();
+    if (arquivoStreaming.empty())
+        iniciaMundo(TAM);
+    cameraPos = glm::vec3(0.0f, 0.0f, TAM / 2 + 15.0f);
+
+    if (validarCulling || validarMesher || (headless && arquivoReproducao.empty())) {
+        // Usa a grid salva se houver, senão um terreno gerado
+        if (!loadGrid(world, "voxel_grid.dat"))
+            geraTerrenoTeste(world);
+    }
+    if (validarCulling || validarMesher) {
+        int resultado = validarCulling ? validaCullingGPU() : 0;
+        if (validarMesher && resultado == 0)
+            resultado = validaMesherGPU();
+        chunkRenderer.destroy();
+        volumeGPU.destroy();
+        glfwTerminate();
+        return resultado;
     }
 
-    grid[selecaoY][selecaoX][selecaoZ].selecionado = true;
-    grid[selecaoY][selecaoX][selecaoZ].visivel = true;
-    grid[selecaoY][selecaoX][selecaoZ].texID = 1;
+    // Câmera de --camera/--yaw/--pitch; no modo sem janela, sem --camera, a das medidas
+    // (acima e à frente do mundo, olhando para o centro)
+    if (headless && !cameraDada && arquivoReproducao.empty()) {
+        float s = (float)max(world.sizeX(), max(world.sizeY(), world.sizeZ()));
+        cameraInicial = glm::vec3(s * 0.45f, s * 0.35f, s * 0.75f);
+        glm::vec3 d = glm::normalize(-cameraInicial);
+        yawInicial = glm::degrees(atan2(d.z, d.x));
+        pitchInicial = glm::degrees(asin(d.y));
+        cameraDada = true;
+    }
+    if (cameraDada) {
+        cameraPos = cameraInicial;
+        yaw = yawInicial;
+        pitch = pitchInicial;
+        glm::vec3 front(cos(glm::radians(yaw)) * cos(glm::radians(pitch)), sin(glm::radians(pitch)),
+                        sin(glm::radians(yaw)) * cos(glm::radians(pitch)));
+        cameraFront = glm::normalize(front);
+        glm::vec3 right = glm::normalize(glm::cross(cameraFront, glm::vec3(0.0f, 1.0f, 0.0f)));
+        cameraUp = glm::normalize(glm::cross(right, cameraFront));
+    }
+
+    profilerThreadName("principal");
+    if (!arquivoPerfil.empty())
+        profilerStart();
 
     glUseProgram(shaderID);
     glUniform1i(glGetUniformLocation(shaderID, "tex_buff"), 0);
+    glUseProgram(shaderChunk);
+    glUniform1i(glGetUniformLocation(shaderChunk, "blocks"), 0);
+    glUseProgram(shaderChunkOIT);
+    glUniform1i(glGetUniformLocation(shaderChunkOIT, "blocks"), 0);
+
+    if (benchmark) {
+        int resultado = executaBenchmark(relatorio.empty() ? "benchmark.json" : relatorio, cenasBenchmark, tamanhosBenchmark, framesBenchmark, caminhoCamera);
+        salvaPerfil();
+        chunkRenderer.destroy();
+        volumeGPU.destroy();
+        raymarcher.destroy();
+        destroyOIT();
+        if (headless)
+            destroyHeadlessContext();
+        else
+            glfwTerminate();
+        return resultado;
+    }
+
+    if (!arquivoReproducao.empty()) {
+        int resultado = executaReproducao(arquivoReproducao, passoReproducao, relatorio);
+        salvaPerfil();
+        chunkRenderer.destroy();
+        volumeGPU.destroy();
+        raymarcher.destroy();
+        destroyOIT();
+        if (headless)
+            destroyHeadlessContext();
+        else
+            glfwTerminate();
+        return resultado;
+    }
+
+    if (headless) {
+        int resultado = executaHeadless(framesHeadless, captura);
+        salvaPerfil();
+        chunkRenderer.destroy();
+        volumeGPU.destroy();
+        raymarcher.destroy();
+        destroyOIT();
+        destroyHeadlessContext();
+        return resultado;
+    }
+
+    if (compararRaymarch) {
+        comparaRaymarch();
+        chunkRenderer.destroy();
+        volumeGPU.destroy();
+        raymarcher.destroy();
+        glfwTerminate();
+        return 0;
+    }
+
+    hud.setup();
+    printInstructions();
+    if (!arquivoGravacao.empty()) {
+        if (gravacaoEntrada.open(arquivoGravacao, estadoEntrada()))
+            cout << "Gravando a entrada em " << arquivoGravacao << endl;
+        else
+            cerr << "Falha ao criar " << arquivoGravacao << endl;
+    }
+
+    if (!arquivoStreaming.empty()) {
+        // Diretório novo: o terreno de teste de --tam gerado e gravado por janelas
+        bool aberto;
+        if (FILE* existente = fopen(RegionStore::regionPath(arquivoStreaming, 0, 0, 0).c_str(), "rb")) {
+            fclose(existente);
+            aberto = streaming.open(arquivoStreaming, world);
+        }
+        else {
+            int tamanho[3] = { TAM, TAM, TAM };
+            aberto = streaming.create(arquivoStreaming, tamanho, geraTerrenoTeste, world);
+        }
+        if (!aberto) {
+            cerr << "Streaming desligado" << endl;
+            arquivoStreaming.clear();
+            iniciaMundo(TAM);
+        }
+        else if (!cameraDada) {
+            // No meio do mundo, acima das colinas do terreno de teste
+            cameraPos = world.origin() + glm::vec3(world.sizeX() * 0.5f, world.sizeY() * 0.9f, world.sizeZ() * 0.5f);
+        }
+        streaming.setCamera(cameraPos, cameraFront, glm::vec3(0.0f));
+    }
 
+    // Daqui em diante o contexto de GL é da thread de render, que desenha o espelho do
+    // mundo, e o mundo (edições e luz) é da thread do mundo; a thread principal fica
+    // com a entrada e a câmera
+    quadro = vistaAtual();
+    caixaRender.publishView(vistaAtual());
+    atualizaLuz();
+    publicaMundo();
+    for (int eixo = 0; eixo < 3; eixo++)
+        tamanhoPublicado[eixo] = eixo == 0 ? world.sizeX() : eixo == 1 ? world.sizeY() : world.sizeZ();
+    mundoDesenhado = &mundoRender;
+    chunkRenderer.remeshBudget = MALHAS_POR_QUADRO;
+    mundoEmThread = true;
+    glfwMakeContextCurrent(nullptr);
+    thread render(threadRender);
+    thread mundo(threadMundo);
+
+    double ultimaVolta = glfwGetTime();
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        processInput(window);
-        
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        especificaVisualizacao();
-        especificaProjecao();
-
-        glBindVertexArray(VAO);
-        for (int x = 0; x < TAM; x++) {
-            for (int y = 0; y < TAM; y++) {
-                for (int z = 0; z < TAM; z++) {
-                    if (grid[y][x][z].visivel) {
-                        glBindTexture(GL_TEXTURE_2D, texIDList[grid[y][x][z].texID]);
-                        transformaObjeto(
-                            grid[y][x][z].pos.x, 
-                            grid[y][x][z].pos.y, 
-                            grid[y][x][z].pos.z,
-                            0.0f, 0.0f, 0.0f,
-                            grid[y][x][z].fatorEscala,
-                            grid[y][x][z].fatorEscala,
-                            grid[y][x][z].fatorEscala
-                        );
-                        glDrawArrays(GL_TRIANGLES, 0, 36);
-                    }
-                }
-            }
+        uint16_t teclas = leTeclasContinuas(window);
+        bool ocioso = teclas == 0 && currentFrame - ultimaEntrada >= OCIOSO_APOS;
+        if (ocioso)
+            tempoOcioso += currentFrame - ultimaVolta;
+        ultimaVolta = currentFrame;
+
+        if (!precisaRedesenhar(teclas)) {
+            // Nada mudou: dorme até um evento ou ESPERA_MAXIMA (a thread de render cuida
+            // do HUD e das capturas sozinha)
+            glfwWaitEventsTimeout(ESPERA_MAXIMA);
+            // A câmera não anda pelo tempo dormido
+            lastFrame = glfwGetTime();
+            continue;
         }
-        for (int x = 0; x < TAM; x++) {
-            for (int y = 0; y < TAM; y++) {
-                for (int z = 0; z < TAM; z++) {
-                    if (grid[y][x][z].selecionado) {
-                        glBindTexture(GL_TEXTURE_2D, texIDList[8]);
-                        transformaObjeto(
-                            grid[y][x][z].pos.x, 
-                            grid[y][x][z].pos.y, 
-                            grid[y][x][z].pos.z,
-                            0.0f, 0.0f, 0.0f,
-                            grid[y][x][z].fatorEscala * 1.05f,
-                            grid[y][x][z].fatorEscala * 1.05f,
-                            grid[y][x][z].fatorEscala * 1.05f
-                        );
-                        glDrawArrays(GL_TRIANGLES, 0, 36);
-                    }
-                }
+        pedidoRedesenho = false;
+
+        {
+            PERFIL_ESCOPO("simulacao");
+            {
+                PERFIL_ESCOPO("entrada");
+                gravacaoEntrada.beginFrame(deltaTime, teclas);
+                processInput(window, teclas);
+            }
+            if (streaming.active()) {
+                // A thread do mundo acorda para pedir os chunks da posição nova
+                streaming.setCamera(cameraPos, cameraFront, velocidadeCamera);
+                if (teclas != 0)
+                    filaEdicoes.wake();
             }
+            RenderSnapshot vista = vistaAtual();
+            vista.idle = ocioso;
+            caixaRender.publishView(move(vista));
+        }
+        {
+            // No máximo um quadro à frente do desenho; os eventos continuam chegando
+            // (e as edições seguindo para a thread do mundo) enquanto a thread de
+            // render termina o anterior
+            PERFIL_ESCOPO("entrada");
+            glfwPollEvents();
+            while (!caixaRender.waitTaken(0.005) && !glfwWindowShouldClose(window))
+                glfwPollEvents();
         }
-
-        renderUI();
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
     }
 
+    filaEdicoes.close();
+    mundo.join();
+    mundoEmThread = false;
+    caixaRender.close();
+    render.join();
+    glfwMakeContextCurrent(window);
+    mundoDesenhado = &world;
+    chunkRenderer.remeshBudget = 0;
+
+    imprimeOcioso();
+    if (gravacaoEntrada.recording()) {
+        gravacaoEntrada.finish(hashMundo(world));
+        cout << "Entrada gravada: " << gravacaoEntrada.frames() << " frames, " << gravacaoEntrada.bytes() << " bytes"
+             << endl;
+    }
+    salvaPerfil();
+    hud.destroy();
+    capturaTela.destroy();
+    chunkRenderer.destroy();
+    volumeGPU.destroy();
+    raymarcher.destroy();
     glDeleteVertexArrays(1, &VAO);
     glDeleteProgram(shaderID);
+    glDeleteProgram(shaderChunk);
+    glDeleteProgram(shaderChunkOIT);
+    glDeleteTextures(1, &blockTextureArray);
+    destroyOIT();
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "light.h"
+#include "materials.h"
+#include "path_tracer.h"
+#include "soft_raster.h"
+#include "world.h"
+
+// STB_IMAGE e STB_IMAGE_WRITE
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+using namespace std;
+
+// Renderizador offline: carrega um .dat do editor e gera um PNG por path tracing na
+// CPU, sem janela nem GPU. A câmera segue as convenções do editor (cameraPos,
+// yaw/pitch e fov); sem --camera, usa a posição inicial do editor para o tamanho do mundo.
+// Com --raster a imagem sai do rasterizador na CPU (SoftRasterizer), e --miniaturas gera
+// uma miniatura rasterizada para cada .dat de uma pasta
+
+// Carrega as texturas de bloco (16x16). Uma textura que falta fica cinza
+BlockImages carregaTexturas(const string& pasta) {
+    BlockImages images;
+    images.size = 16;
+    images.count = NUM_TEXTURES;
+    images.rgba.assign((size_t)NUM_TEXTURES * 16 * 16 * 4, 200);
+    for (int i = 0; i < NUM_TEXTURES; i++) {
+        string path = pasta + "/" + textureFiles[i];
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 4);
+        if (data && width == 16 && height == 16)
+            memcpy(&images.rgba[(size_t)i * 16 * 16 * 4], data, 16 * 16 * 4);
+        else
+            cout << "Falha ao carregar textura 16x16: " << path << endl;
+        stbi_image_free(data);
+    }
+    return images;
+}
+
+void printUso() {
+    cout << "Uso: VoxelRender <mundo.dat> [opcoes]" << endl;
+    cout << "  --saida ARQ.png          imagem gerada (padrao: render.png)" << endl;
+    cout << "  --tamanho LxA            resolucao (padrao: 1200x800, a da janela do editor)" << endl;
+    cout << "  --amostras N             amostras por pixel (padrao: 16)" << endl;
+    cout << "  --saltos N               rebatidas difusas (padrao: 3)" << endl;
+    cout << "  --threads N              threads (padrao: todos os nucleos)" << endl;
+    cout << "  --camera X,Y,Z           posicao da camera no mundo" << endl;
+    cout << "  --yaw G --pitch G --fov G  orientacao e fov vertical em graus (padrao: -90, 0, 45)" << endl;
+    cout << "  --texturas DIR           pasta das texturas (padrao: ../assets/block_tex)" << endl;
+    cout << "  --escala                 mede raios/s com 1, 2, 4... threads ate todos os nucleos" << endl;
+    cout << "  --raster                 rasteriza na CPU em vez do path tracing" << endl;
+    cout << "  --luz                    calcula a luz (LightEngine) antes de rasterizar" << endl;
+    cout << "Uso: VoxelRender --miniaturas DIR [--saida DIR] [--tamanho LxA] [--threads N] [--luz]" << endl;
+    cout << "  rasteriza uma miniatura (padrao 256x256) de cada .dat de DIR" << endl;
+}
+
+// Câmera da rasterização com as mesmas contas do editor (front pelo yaw/pitch)
+static SoftRasterStats rasteriza(const SoftRasterizer& raster, const World& world, const PathTraceCamera& camera,
+                                 const SoftRasterSettings& settings, vector<uint8_t>& rgb) {
+    glm::vec3 front(cos(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch)), sin(glm::radians(camera.pitch)),
+                    sin(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch)));
+    glm::mat4 view = glm::lookAt(camera.position, camera.position + glm::normalize(front), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(camera.fov), (float)settings.width / settings.height, 0.1f, 1000.0f);
+    return raster.render(world, view, proj, camera.position, glm::radians(camera.fov), settings, rgb);
+}
+
+// Câmera das miniaturas: acima, à direita e à frente do mundo, olhando para o centro
+static PathTraceCamera cameraMiniatura(const World& world) {
+    PathTraceCamera camera;
+    float tam = (float)max(world.sizeX(), max(world.sizeY(), world.sizeZ()));
+    camera.position = glm::vec3(tam * 0.6f, tam * 0.5f, tam * 0.9f);
+    glm::vec3 d = glm::normalize(-camera.position);
+    camera.yaw = glm::degrees(atan2(d.z, d.x));
+    camera.pitch = glm::degrees(asin(d.y));
+    return camera;
+}
+
+// Uma miniatura por arquivo, com os arquivos divididos entre as threads (cada
+// miniatura rasteriza numa thread só: com muitos arquivos é o que escala melhor)
+static int geraMiniaturas(const string& pasta, const string& saida, const BlockImages& images,
+                          SoftRasterSettings settings, bool luz) {
+    namespace fs = std::filesystem;
+    vector<fs::path> arquivos;
+    for (const fs::directory_entry& e : fs::directory_iterator(pasta))
+        if (e.is_regular_file() && e.path().extension() == ".dat")
+            arquivos.push_back(e.path());
+    sort(arquivos.begin(), arquivos.end());
+    fs::create_directories(saida);
+
+    SoftRasterizer raster;
+    raster.setup(images);
+    int numThreads = settings.threads > 0 ? settings.threads : (int)max(1u, thread::hardware_concurrency());
+    settings.threads = 1;
+    settings.lighting = luz;
+    atomic<int> next(0), falhas(0);
+    auto inicio = chrono::steady_clock::now();
+    auto worker = [&]() {
+        vector<uint8_t> rgb;
+        for (int i = next++; i < (int)arquivos.size(); i = next++) {
+            World world;
+            if (!loadGrid(world, arquivos[i].string().c_str())) {
+                falhas++;
+                continue;
+            }
+            if (luz)
+                LightEngine().relightAll(world);
+            rasteriza(raster, world, cameraMiniatura(world), settings, rgb);
+            string png = (fs::path(saida) / arquivos[i].stem()).string() + ".png";
+            if (!stbi_write_png(png.c_str(), settings.width, settings.height, 3, rgb.data(), settings.width * 3))
+                falhas++;
+        }
+    };
+    vector<thread> pool;
+    for (int t = 1; t < min(numThreads, (int)arquivos.size()); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (thread& t : pool)
+        t.join();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+    cout << arquivos.size() - falhas << " miniaturas " << settings.width << "x" << settings.height << " em " << saida
+         << " (" << ms << " ms, " << (arquivos.empty() ? 0.0 : ms / arquivos.size()) << " ms por mundo, "
+         << numThreads << " threads)" << endl;
+    return falhas > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || string(argv[1]) == "--ajuda") {
+        printUso();
+        return argc < 2 ? 1 : 0;
+    }
+
+    bool miniaturas = string(argv[1]) == "--miniaturas";
+    if (miniaturas && argc < 3) {
+        printUso();
+        return 1;
+    }
+    string arquivo = miniaturas ? argv[2] : argv[1], saida = miniaturas ? "miniaturas" : "render.png";
+    string pastaTexturas = "../assets/block_tex";
+    PathTraceSettings settings;
+    PathTraceCamera camera;
+    bool cameraDada = false, escala = false, raster = false, luz = false;
+    if (miniaturas)
+        settings.width = settings.height = 256;
+    for (int i = miniaturas ? 3 : 2; i < argc; i++) {
+        string arg = argv[i];
+        bool temValor = i + 1 < argc;
+        if (arg == "--saida" && temValor)
+            saida = argv[++i];
+        else if (arg == "--tamanho" && temValor)
+            sscanf(argv[++i], "%dx%d", &settings.width, &settings.height);
+        else if (arg == "--amostras" && temValor)
+            settings.samples = max(1, atoi(argv[++i]));
+        else if (arg == "--saltos" && temValor)
+            settings.bounces = max(0, atoi(argv[++i]));
+        else if (arg == "--threads" && temValor)
+            settings.threads = max(0, atoi(argv[++i]));
+        else if (arg == "--camera" && temValor) {
+            sscanf(argv[++i], "%f,%f,%f", &camera.position.x, &camera.position.y, &camera.position.z);
+            cameraDada = true;
+        }
+        else if (arg == "--yaw" && temValor)
+            camera.yaw = (float)atof(argv[++i]);
+        else if (arg == "--pitch" && temValor)
+            camera.pitch = max(-89.0f, min(89.0f, (float)atof(argv[++i])));
+        else if (arg == "--fov" && temValor)
+            camera.fov = (float)atof(argv[++i]);
+        else if (arg == "--texturas" && temValor)
+            pastaTexturas = argv[++i];
+        else if (arg == "--escala")
+            escala = true;
+        else if (arg == "--raster")
+            raster = true;
+        else if (arg == "--luz")
+            luz = true;
+        else {
+            cout << "Opcao desconhecida: " << arg << endl;
+            printUso();
+            return 1;
+        }
+    }
+    settings.width = max(1, settings.width);
+    settings.height = max(1, settings.height);
+
+    SoftRasterSettings rasterSettings;
+    rasterSettings.width = settings.width;
+    rasterSettings.height = settings.height;
+    rasterSettings.threads = settings.threads;
+    if (miniaturas)
+        return geraMiniaturas(arquivo, saida, carregaTexturas(pastaTexturas), rasterSettings, luz);
+
+    World world;
+    if (!loadGrid(world, arquivo.c_str()))
+        return 1;
+    if (!cameraDada)
+        camera.position = glm::vec3(0.0f, 0.0f, world.sizeZ() / 2 + 15.0f);
+
+    if (raster) {
+        auto inicio = chrono::steady_clock::now();
+        if (luz)
+            LightEngine().relightAll(world);
+        double luzMs = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+        SoftRasterizer rasterizer;
+        rasterizer.setup(carregaTexturas(pastaTexturas));
+        rasterSettings.lighting = luz;
+        vector<uint8_t> rgb;
+        SoftRasterStats stats = rasteriza(rasterizer, world, camera, rasterSettings, rgb);
+        if (!stbi_write_png(saida.c_str(), settings.width, settings.height, 3, rgb.data(), settings.width * 3)) {
+            cerr << "Falha ao salvar " << saida << endl;
+            return 1;
+        }
+        cout << "Mundo " << world.sizeX() << "x" << world.sizeY() << "x" << world.sizeZ() << ", "
+             << settings.width << "x" << settings.height << " rasterizado -> " << saida << endl;
+        cout << stats.chunks << " chunks, " << stats.triangles << " triangulos, " << stats.binned
+             << " entradas nos blocos" << endl;
+        cout << "Luz " << luzMs << " ms, malhas " << stats.meshMs << " ms, listas " << stats.setupMs
+             << " ms, rasterizacao " << stats.rasterMs << " ms, total "
+             << stats.meshMs + stats.setupMs + stats.rasterMs << " ms" << endl;
+        return 0;
+    }
+
+    PathTracer tracer;
+    tracer.setup(world, carregaTexturas(pastaTexturas));
+    vector<uint8_t> rgb;
+
+    if (escala) {
+        int hw = max(1u, thread::hardware_concurrency());
+        double base = 0.0;
+        cout << "Threads | Raios/s | Aceleracao" << endl;
+        for (int n = 1;; n = min(hw, n * 2)) {
+            settings.threads = n;
+            PathTraceStats stats = tracer.render(camera, settings, rgb);
+            if (n == 1)
+                base = stats.raysPerSecond();
+            cout << n << " | " << stats.raysPerSecond() << " | " << stats.raysPerSecond() / base << "x" << endl;
+            if (n == hw)
+                break;
+        }
+        return 0;
+    }
+
+    PathTraceStats stats = tracer.render(camera, settings, rgb);
+    if (!stbi_write_png(saida.c_str(), settings.width, settings.height, 3, rgb.data(), settings.width * 3)) {
+        cerr << "Falha ao salvar " << saida << endl;
+        return 1;
+    }
+    cout << "Mundo " << world.sizeX() << "x" << world.sizeY() << "x" << world.sizeZ() << ", "
+         << settings.width << "x" << settings.height << ", " << settings.samples << " amostras, "
+         << settings.bounces << " saltos -> " << saida << endl;
+    cout << "Raios: " << stats.rays << " em " << stats.seconds << " s = " << stats.raysPerSecond() / 1e6
+         << " Mraios/s (" << stats.threads << " threads, " << stats.tiles << " blocos, "
+         << stats.raysPerSecond() / 1e6 / stats.threads << " Mraios/s por thread)" << endl;
+    return 0;
+}
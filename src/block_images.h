@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Texturas de bloco na CPU (renderizadores sem GPU): size x size texels RGBA8 por
+// material, na ordem de textureFiles, linha 0 no topo da imagem
+struct BlockImages {
+    int size = 16;
+    int count = 0;
+    std::vector<uint8_t> rgba;   // count * size * size * 4
+};
@@ -0,0 +1,630 @@
+#include "chunk_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+using namespace std;
+
+void packChunk(const Chunk& chunk, uint8_t* registro) {
+    memcpy(registro, chunk.voxels, CHUNK_VOLUME);
+    memcpy(registro + CHUNK_VOLUME, chunk.light, CHUNK_VOLUME);
+}
+
+void unpackChunk(const uint8_t* registro, Chunk& chunk) {
+    memcpy(chunk.voxels, registro, CHUNK_VOLUME);
+    memcpy(chunk.light, registro + CHUNK_VOLUME, CHUNK_VOLUME);
+    int visiveis = 0;
+    for (int i = 0; i < CHUNK_VOLUME; i++)
+        visiveis += (int)voxelVisivel(chunk.voxels[i]);
+    chunk.visibleCount = visiveis;
+}
+
+void ChunkIO::conta(const ChunkIOCompletion& c) {
+    emAndamento--;
+    estatisticas.completed++;
+    if (c.result < 0)
+        estatisticas.errors++;
+    else if (c.op == IO_LEITURA)
+        estatisticas.bytesRead += c.result;
+    else
+        estatisticas.bytesWritten += c.result;
+}
+
+void ChunkIO::drain(vector<ChunkIOCompletion>& saida) {
+    while (inFlight() > 0)
+        poll(saida, true);
+}
+
+// --- Fallback: grupo de threads com pread/pwrite ---
+
+// Lê ou grava tudo (pread/pwrite podem devolver menos ou ser interrompidos)
+static int64_t transfereTudo(const ChunkIORequest& pedido) {
+    uint8_t* p = static_cast<uint8_t*>(pedido.buffer);
+    size_t feito = 0;
+    while (feito < pedido.bytes) {
+        int64_t n = pedido.op == IO_LEITURA
+                        ? readChunkFile(pedido.fd, p + feito, pedido.bytes - feito, pedido.offset + feito)
+                        : writeChunkFile(pedido.fd, p + feito, pedido.bytes - feito, pedido.offset + feito);
+        if (n < 0) {
+            if (n == -EINTR)
+                continue;
+            return n;
+        }
+        if (n == 0)
+            break;                // fim do arquivo
+        feito += (size_t)n;
+    }
+    return (int64_t)feito;
+}
+
+class ThreadPoolChunkIO : public ChunkIO {
+public:
+    explicit ThreadPoolChunkIO(int numThreads) {
+        for (int i = 0; i < max(1, numThreads); i++)
+            threads.emplace_back([this]() { trabalha(); });
+    }
+    ~ThreadPoolChunkIO() override {
+        {
+            lock_guard<mutex> lock(trava);
+            parar = true;
+        }
+        temPedido.notify_all();
+        for (thread& t : threads)
+            t.join();
+    }
+
+    const char* name() const override { return "threads"; }
+
+    void submit(const ChunkIORequest* requests, size_t n) override {
+        if (n == 0)
+            return;
+        {
+            lock_guard<mutex> lock(trava);
+            pedidos.insert(pedidos.end(), requests, requests + n);
+        }
+        if (n == 1)
+            temPedido.notify_one();
+        else
+            temPedido.notify_all();
+        emAndamento += n;
+        estatisticas.submitted += (long long)n;
+        estatisticas.syscalls++;
+    }
+
+    size_t poll(vector<ChunkIOCompletion>& saida, bool wait) override {
+        unique_lock<mutex> lock(trava);
+        if (wait && emAndamento > 0)
+            temConclusao.wait(lock, [this]() { return !concluidos.empty(); });
+        size_t n = concluidos.size();
+        for (const ChunkIOCompletion& c : concluidos) {
+            saida.push_back(c);
+            conta(c);
+        }
+        concluidos.clear();
+        return n;
+    }
+
+private:
+    void trabalha() {
+        unique_lock<mutex> lock(trava);
+        for (;;) {
+            temPedido.wait(lock, [this]() { return parar || !pedidos.empty(); });
+            if (pedidos.empty())
+                return;
+            ChunkIORequest pedido = pedidos.front();
+            pedidos.pop_front();
+            lock.unlock();
+            ChunkIOCompletion c;
+            c.tag = pedido.tag;
+            c.op = pedido.op;
+            c.buffer = pedido.buffer;
+            c.result = transfereTudo(pedido);
+            lock.lock();
+            concluidos.push_back(c);
+            temConclusao.notify_one();
+        }
+    }
+
+    vector<thread> threads;
+    mutex trava;
+    condition_variable temPedido, temConclusao;
+    deque<ChunkIORequest> pedidos;
+    vector<ChunkIOCompletion> concluidos;
+    bool parar = false;
+};
+
+// --- io_uring pelas syscalls ---
+
+#ifdef __linux__
+
+static int uringSetup(unsigned entradas, io_uring_params* params) {
+    return (int)syscall(__NR_io_uring_setup, entradas, params);
+}
+
+static int uringEnter(int fd, unsigned enviar, unsigned minimo, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, enviar, minimo, flags, nullptr, 0);
+}
+
+// Anel de submissão (SQ) e de conclusão (CQ) mapeados do kernel. Os SQEs usam
+// READV/WRITEV (presentes desde o primeiro io_uring, 5.1); o iovec de cada pedido
+// fica num slot até a conclusão e o user_data do SQE é o índice do slot
+class UringChunkIO : public ChunkIO {
+public:
+    ~UringChunkIO() override {
+        if (sqes)
+            munmap(sqes, tamanhoSqes);
+        if (cqAnel && cqAnel != sqAnel)
+            munmap(cqAnel, tamanhoCq);
+        if (sqAnel)
+            munmap(sqAnel, tamanhoSq);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    // false se o kernel não deixou criar o anel
+    bool inicia(unsigned profundidade) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = uringSetup(profundidade, &params);
+        if (fd < 0)
+            return false;
+
+        tamanhoSq = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        tamanhoCq = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool umMapa = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (umMapa)
+            tamanhoSq = tamanhoCq = max(tamanhoSq, tamanhoCq);
+        sqAnel = mmap(nullptr, tamanhoSq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqAnel == MAP_FAILED) {
+            sqAnel = nullptr;
+            return false;
+        }
+        if (umMapa) {
+            cqAnel = sqAnel;
+        }
+        else {
+            cqAnel = mmap(nullptr, tamanhoCq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cqAnel == MAP_FAILED) {
+                cqAnel = nullptr;
+                return false;
+            }
+        }
+        tamanhoSqes = params.sq_entries * sizeof(io_uring_sqe);
+        void* mapa = mmap(nullptr, tamanhoSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (mapa == MAP_FAILED)
+            return false;
+        sqes = static_cast<io_uring_sqe*>(mapa);
+
+        uint8_t* sq = static_cast<uint8_t*>(sqAnel);
+        sqCabeca = reinterpret_cast<atomic<unsigned>*>(sq + params.sq_off.head);
+        sqCauda = reinterpret_cast<atomic<unsigned>*>(sq + params.sq_off.tail);
+        sqMascara = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqIndices = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        uint8_t* cq = static_cast<uint8_t*>(cqAnel);
+        cqCabeca = reinterpret_cast<atomic<unsigned>*>(cq + params.cq_off.head);
+        cqCauda = reinterpret_cast<atomic<unsigned>*>(cq + params.cq_off.tail);
+        cqMascara = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // No máximo sq_entries no kernel: o CQ (o dobro) nunca transborda
+        slots.resize(params.sq_entries);
+        for (unsigned i = 0; i < params.sq_entries; i++)
+            livres.push_back(params.sq_entries - 1 - i);
+        return true;
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+    void submit(const ChunkIORequest* requests, size_t n) override {
+        espera.insert(espera.end(), requests, requests + n);
+        emAndamento += n;
+        estatisticas.submitted += (long long)n;
+        enviaEspera();
+    }
+
+    size_t poll(vector<ChunkIOCompletion>& saida, bool wait) override {
+        colheEEnvia();
+        while (prontas.empty() && wait && emAndamento > 0) {
+            // Nada no kernel: o que falta está na espera (enviaEspera entrega ou falha)
+            if (noKernel == 0) {
+                if (espera.empty() && repetir.empty())
+                    break;
+                enviaEspera();
+                continue;
+            }
+            if (uringEnter(fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+                break;
+            estatisticas.syscalls++;
+            colheEEnvia();
+        }
+        size_t n = prontas.size();
+        for (const ChunkIOCompletion& c : prontas) {
+            saida.push_back(c);
+            conta(c);
+        }
+        prontas.clear();
+        return n;
+    }
+
+private:
+    struct Slot {
+        iovec iov;
+        ChunkIORequest pedido;
+        uint32_t feito;           // bytes já transferidos (as transferências curtas repetem o resto)
+    };
+
+    // SQE do slot para o que falta do pedido
+    void preparaSqe(unsigned s, unsigned cauda) {
+        Slot& slot = slots[s];
+        slot.iov.iov_base = static_cast<uint8_t*>(slot.pedido.buffer) + slot.feito;
+        slot.iov.iov_len = slot.pedido.bytes - slot.feito;
+
+        unsigned indice = cauda & sqMascara;
+        io_uring_sqe& sqe = sqes[indice];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = slot.pedido.op == IO_LEITURA ? IORING_OP_READV : IORING_OP_WRITEV;
+        sqe.fd = slot.pedido.fd;
+        sqe.off = slot.pedido.offset + slot.feito;
+        sqe.addr = (uint64_t)(uintptr_t)&slot.iov;
+        sqe.len = 1;
+        sqe.user_data = s;
+        sqIndices[indice] = indice;
+    }
+
+    // Preenche SQEs com os restos a repetir e o que espera (enquanto houver slot) e
+    // entrega cada leva num io_uring_enter só
+    void enviaEspera() {
+        while (!repetir.empty() || (!espera.empty() && !livres.empty())) {
+            unsigned cauda = sqCauda->load(memory_order_relaxed);
+            unsigned preenchidos = 0;
+            for (unsigned s : repetir) {
+                preparaSqe(s, cauda++);
+                preenchidos++;
+            }
+            repetir.clear();
+            while (!espera.empty() && !livres.empty()) {
+                unsigned s = livres.back();
+                livres.pop_back();
+                slots[s].pedido = espera.front();
+                slots[s].feito = 0;
+                espera.pop_front();
+                preparaSqe(s, cauda++);
+                preenchidos++;
+            }
+            // Os SQEs visíveis antes da cauda nova
+            sqCauda->store(cauda, memory_order_release);
+            while (preenchidos > 0) {
+                int r = uringEnter(fd, preenchidos, 0, 0);
+                estatisticas.syscalls++;
+                if (r >= 0) {
+                    preenchidos -= (unsigned)r;
+                    noKernel += (unsigned)r;
+                    continue;
+                }
+                if (errno == EINTR)
+                    continue;
+                if (errno == EBUSY || errno == EAGAIN) {
+                    // CQ cheio ou kernel sem memória: libera conclusões antes de tentar de
+                    // novo (e, se não havia nenhuma, espera uma do que está no kernel)
+                    if (colheAnel() == 0 && noKernel > 0 &&
+                        uringEnter(fd, 0, 1, IORING_ENTER_GETEVENTS) >= 0)
+                        colheAnel();
+                    continue;
+                }
+                // Erro que não passa: os SQEs não aceitos saem do anel e concluem com o erro
+                descartaNaoEnviados(-errno);
+                preenchidos = 0;
+            }
+        }
+    }
+
+    // Tira do anel os SQEs que o kernel não consumiu (sem SQPOLL só o io_uring_enter lê
+    // a cauda, então dá para recuar) e conclui os pedidos com erro
+    void descartaNaoEnviados(int erro) {
+        unsigned cabeca = sqCabeca->load(memory_order_acquire);
+        unsigned cauda = sqCauda->load(memory_order_relaxed);
+        for (unsigned i = cabeca; i != cauda; i++)
+            termina((unsigned)sqes[sqIndices[i & sqMascara]].user_data, erro);
+        sqCauda->store(cabeca, memory_order_release);
+    }
+
+    // Conclusão do pedido do slot em prontas e o slot de volta para os livres
+    void termina(unsigned s, int64_t resultado) {
+        const Slot& slot = slots[s];
+        ChunkIOCompletion c;
+        c.tag = slot.pedido.tag;
+        c.op = slot.pedido.op;
+        c.buffer = slot.pedido.buffer;
+        c.result = resultado;
+        prontas.push_back(c);
+        livres.push_back(s);
+    }
+
+    // Lê o CQ. Como no pread/pwrite das threads, uma transferência curta volta para o
+    // anel com o resto (e um EINTR com tudo); só o fim do arquivo ou um erro encerram
+    // antes de bytes. Devolve quantas entradas leu
+    size_t colheAnel() {
+        unsigned cabeca = cqCabeca->load(memory_order_relaxed);
+        unsigned cauda = cqCauda->load(memory_order_acquire);
+        size_t n = 0;
+        for (; cabeca != cauda; cabeca++, n++) {
+            const io_uring_cqe& cqe = cqes[cabeca & cqMascara];
+            unsigned s = (unsigned)cqe.user_data;
+            Slot& slot = slots[s];
+            noKernel--;
+            if (cqe.res == -EINTR) {
+                repetir.push_back(s);
+                continue;
+            }
+            if (cqe.res < 0) {
+                termina(s, cqe.res);
+                continue;
+            }
+            slot.feito += (uint32_t)cqe.res;
+            if (cqe.res > 0 && slot.feito < slot.pedido.bytes)
+                repetir.push_back(s);
+            else
+                termina(s, slot.feito);
+        }
+        cqCabeca->store(cabeca, memory_order_release);
+        return n;
+    }
+
+    void colheEEnvia() {
+        colheAnel();
+        if (!repetir.empty() || (!espera.empty() && !livres.empty()))
+            enviaEspera();
+    }
+
+    int fd = -1;
+    void* sqAnel = nullptr;
+    void* cqAnel = nullptr;
+    size_t tamanhoSq = 0, tamanhoCq = 0, tamanhoSqes = 0;
+    io_uring_sqe* sqes = nullptr;
+    atomic<unsigned>* sqCabeca = nullptr;
+    atomic<unsigned>* sqCauda = nullptr;
+    unsigned sqMascara = 0;
+    unsigned* sqIndices = nullptr;
+    atomic<unsigned>* cqCabeca = nullptr;
+    atomic<unsigned>* cqCauda = nullptr;
+    unsigned cqMascara = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    vector<Slot> slots;
+    vector<unsigned> livres;
+    vector<unsigned> repetir;         // slots com transferência curta, a entregar de novo
+    deque<ChunkIORequest> espera;     // além da profundidade do anel
+    unsigned noKernel = 0;            // SQEs aceitos pelo kernel e ainda sem CQE
+    vector<ChunkIOCompletion> prontas;
+};
+
+#endif
+
+unique_ptr<ChunkIO> createChunkIO(ChunkIOBackend backend, int depth, int threads) {
+#ifdef __linux__
+    if (backend != IO_THREADS) {
+        unique_ptr<UringChunkIO> uring = make_unique<UringChunkIO>();
+        if (uring->inicia((unsigned)max(1, depth)))
+            return uring;
+    }
+#endif
+    if (backend == IO_URING)
+        return nullptr;
+    return make_unique<ThreadPoolChunkIO>(threads);
+}
+
+int openChunkFile(const char* path, bool write, bool direct, bool* gotDirect) {
+    if (gotDirect)
+        *gotDirect = false;
+#ifdef _WIN32
+    // Sem O_DIRECT; _O_BINARY para o CRT não traduzir as quebras de linha
+    (void)direct;
+    int flags = (write ? (_O_RDWR | _O_CREAT) : _O_RDONLY) | _O_BINARY;
+    return _open(path, flags, _S_IREAD | _S_IWRITE);
+#else
+    int flags = write ? (O_RDWR | O_CREAT) : O_RDONLY;
+#ifdef O_DIRECT
+    if (direct) {
+        int fd = open(path, flags | O_DIRECT, 0644);
+        if (fd >= 0) {
+            if (gotDirect)
+                *gotDirect = true;
+            return fd;
+        }
+        // tmpfs e alguns sistemas de arquivos recusam O_DIRECT
+        if (errno != EINVAL)
+            return -1;
+    }
+#else
+    (void)direct;
+#endif
+    return open(path, flags, 0644);
+#endif
+}
+
+void closeChunkFile(int fd) {
+    if (fd < 0)
+        return;
+#ifdef _WIN32
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+void dropFileCache(int fd) {
+    syncChunkFile(fd);
+#ifdef POSIX_FADV_DONTNEED
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+}
+
+#ifdef _WIN32
+// ReadFile/WriteFile com o offset no OVERLAPPED fazem o papel do pread/pwrite
+static int64_t transfereWindows(int fd, void* buffer, size_t bytes, uint64_t offset, bool escrita) {
+    HANDLE arquivo = (HANDLE)_get_osfhandle(fd);
+    if (arquivo == INVALID_HANDLE_VALUE)
+        return -EBADF;
+    OVERLAPPED posicao = {};
+    posicao.Offset = (DWORD)offset;
+    posicao.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD n = 0;
+    DWORD pedido = (DWORD)min(bytes, (size_t)1 << 30);
+    BOOL ok = escrita ? WriteFile(arquivo, buffer, pedido, &n, &posicao)
+                      : ReadFile(arquivo, buffer, pedido, &n, &posicao);
+    if (!ok)
+        return GetLastError() == ERROR_HANDLE_EOF ? 0 : -EIO;
+    return (int64_t)n;
+}
+#endif
+
+int64_t readChunkFile(int fd, void* buffer, size_t bytes, uint64_t offset) {
+#ifdef _WIN32
+    return transfereWindows(fd, buffer, bytes, offset, false);
+#else
+    ssize_t n = pread(fd, buffer, bytes, (off_t)offset);
+    return n < 0 ? -(int64_t)errno : (int64_t)n;
+#endif
+}
+
+int64_t writeChunkFile(int fd, const void* buffer, size_t bytes, uint64_t offset) {
+#ifdef _WIN32
+    return transfereWindows(fd, const_cast<void*>(buffer), bytes, offset, true);
+#else
+    ssize_t n = pwrite(fd, buffer, bytes, (off_t)offset);
+    return n < 0 ? -(int64_t)errno : (int64_t)n;
+#endif
+}
+
+bool syncChunkFile(int fd) {
+#if defined(_WIN32)
+    return FlushFileBuffers((HANDLE)_get_osfhandle(fd)) != 0;
+#elif defined(__APPLE__)
+    return fsync(fd) == 0;       // o macOS não tem fdatasync
+#else
+    return fdatasync(fd) == 0;
+#endif
+}
+
+bool truncateChunkFile(int fd, uint64_t bytes) {
+#ifdef _WIN32
+    return _chsize_s(fd, (__int64)bytes) == 0;
+#else
+    return ftruncate(fd, (off_t)bytes) == 0;
+#endif
+}
+
+int64_t chunkFileSize(int fd) {
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_fstat64(fd, &info) != 0)
+        return -1;
+#else
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+        return -1;
+#endif
+    return (int64_t)info.st_size;
+}
+
+// posix_memalign não existe no Windows: lá o par é _aligned_malloc/_aligned_free
+static uint8_t* alocaAlinhado(size_t bytes) {
+#ifdef _WIN32
+    return static_cast<uint8_t*>(_aligned_malloc(bytes, IO_ALINHAMENTO));
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, IO_ALINHAMENTO, bytes) != 0)
+        return nullptr;
+    return static_cast<uint8_t*>(p);
+#endif
+}
+
+static void liberaAlinhado(uint8_t* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+AlignedBuffer::~AlignedBuffer() {
+    liberaAlinhado(dados);
+}
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& outro) noexcept : dados(outro.dados), tamanho(outro.tamanho) {
+    outro.dados = nullptr;
+    outro.tamanho = 0;
+}
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& outro) noexcept {
+    if (this != &outro) {
+        liberaAlinhado(dados);
+        dados = outro.dados;
+        tamanho = outro.tamanho;
+        outro.dados = nullptr;
+        outro.tamanho = 0;
+    }
+    return *this;
+}
+
+void AlignedBuffer::allocate(size_t bytes) {
+    liberaAlinhado(dados);
+    dados = nullptr;
+    tamanho = (bytes + IO_ALINHAMENTO - 1) / IO_ALINHAMENTO * IO_ALINHAMENTO;
+    if (tamanho == 0)
+        return;
+    dados = alocaAlinhado(tamanho);
+    if (!dados) {
+        tamanho = 0;
+        return;
+    }
+    memset(dados, 0, tamanho);
+}
+
+bool writeSequential(ChunkIO& io, int fd, uint64_t offset, const uint8_t* data, size_t bytes, size_t pedaco) {
+    pedaco = max(IO_ALINHAMENTO, pedaco / IO_ALINHAMENTO * IO_ALINHAMENTO);
+    vector<ChunkIORequest> pedidos;
+    for (size_t feito = 0; feito < bytes; feito += pedaco) {
+        ChunkIORequest p;
+        p.op = IO_ESCRITA;
+        p.fd = fd;
+        p.offset = offset + feito;
+        p.buffer = const_cast<uint8_t*>(data + feito);
+        p.bytes = (uint32_t)min(pedaco, bytes - feito);
+        p.tag = feito;
+        pedidos.push_back(p);
+    }
+    io.submit(pedidos.data(), pedidos.size());
+    vector<ChunkIOCompletion> concluidos;
+    io.drain(concluidos);
+    bool ok = true;
+    for (const ChunkIOCompletion& c : concluidos)
+        ok = ok && c.result == (int64_t)min(pedaco, bytes - (size_t)c.tag);
+    return ok;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Alinhamento exigido pelo O_DIRECT: endereço do buffer, offset e tamanho múltiplos dele
+const size_t IO_ALINHAMENTO = 4096;
+
+// Um chunk em disco: voxels seguidos da luz. 8 KiB, dois blocos de O_DIRECT
+const size_t CHUNK_REGISTRO = 2 * CHUNK_VOLUME;
+static_assert(CHUNK_REGISTRO % IO_ALINHAMENTO == 0, "registro de chunk fora do alinhamento");
+
+// Copia o chunk para um registro e de volta (o visibleCount é recontado; as versões
+// ficam como estão, quem troca o chunk no mundo é que as avança)
+void packChunk(const Chunk& chunk, uint8_t* registro);
+void unpackChunk(const uint8_t* registro, Chunk& chunk);
+
+enum ChunkIOOp { IO_LEITURA, IO_ESCRITA };
+
+struct ChunkIORequest {
+    ChunkIOOp op = IO_LEITURA;
+    int fd = -1;
+    uint64_t offset = 0;
+    void* buffer = nullptr;
+    uint32_t bytes = 0;
+    uint64_t tag = 0;             // devolvido na conclusão (ex.: a chave do chunk)
+};
+
+struct ChunkIOCompletion {
+    uint64_t tag = 0;
+    ChunkIOOp op = IO_LEITURA;
+    void* buffer = nullptr;
+    int64_t result = 0;           // bytes transferidos (menos que bytes só no fim do arquivo) ou -errno
+};
+
+struct ChunkIOStats {
+    long long submitted = 0;
+    long long completed = 0;
+    long long errors = 0;         // result < 0
+    long long syscalls = 0;       // io_uring_enter (io_uring) ou lotes entregues às threads
+    long long bytesRead = 0;
+    long long bytesWritten = 0;
+};
+
+// Leituras e escritas de chunks sem bloquear quem pede. submit() entrega um lote de
+// pedidos de uma vez e volta na hora; poll() recolhe as conclusões. Os buffers têm de
+// viver até a conclusão. Pensado para um dono só (a thread do mundo ou do streaming):
+// submit e poll não são para chamar de threads diferentes ao mesmo tempo, e as
+// conclusões voltam para quem chama poll, que decide onde continuar o trabalho.
+//
+// No Linux o backend é o io_uring (pelas syscalls, sem liburing): um lote inteiro
+// custa um io_uring_enter e os pedidos correm em paralelo no kernel. Onde o io_uring
+// não existe ou o kernel recusa (seccomp, kernel antigo), um grupo de threads faz
+// pread/pwrite. Pedidos além da profundidade da fila esperam dentro do backend e
+// entram conforme os anteriores concluem. Nos dois, uma transferência curta é repetida
+// com o resto até completar, chegar ao fim do arquivo ou falhar
+class ChunkIO {
+public:
+    virtual ~ChunkIO() = default;
+    virtual const char* name() const = 0;
+
+    virtual void submit(const ChunkIORequest* requests, size_t n) = 0;
+    // Acrescenta as conclusões prontas em saida. Com wait, espera ao menos uma se há
+    // pedidos em andamento. Devolve quantas acrescentou
+    virtual size_t poll(std::vector<ChunkIOCompletion>& saida, bool wait) = 0;
+
+    // Pedidos entregues e ainda sem conclusão recolhida
+    size_t inFlight() const { return emAndamento; }
+    // Espera e recolhe tudo que está em andamento
+    void drain(std::vector<ChunkIOCompletion>& saida);
+
+    ChunkIOStats stats() const { return estatisticas; }
+
+protected:
+    void conta(const ChunkIOCompletion& c);
+
+    size_t emAndamento = 0;
+    ChunkIOStats estatisticas;
+};
+
+enum ChunkIOBackend { IO_AUTOMATICO, IO_URING, IO_THREADS };
+
+// depth: pedidos no kernel ao mesmo tempo (io_uring); threads: tamanho do grupo no
+// fallback. IO_URING devolve nullptr se o io_uring não estiver disponível
+std::unique_ptr<ChunkIO> createChunkIO(ChunkIOBackend backend = IO_AUTOMATICO, int depth = 128, int threads = 4);
+
+// Abre um arquivo de chunks. Com direct pede O_DIRECT (sem passar pelo cache de
+// páginas) e, se o sistema de arquivos não aceitar, abre sem; gotDirect diz o que
+// valeu. Com write cria o arquivo se preciso. -1 em erro
+int openChunkFile(const char* path, bool write, bool direct, bool* gotDirect = nullptr);
+void closeChunkFile(int fd);
+// Grava o que estiver sujo e tira o arquivo do cache de páginas: a próxima leitura vem
+// do disco
+void dropFileCache(int fd);
+
+// E/S síncrona num offset, sem mexer na posição do arquivo (pread/pwrite; no Windows,
+// ReadFile/WriteFile com o offset no OVERLAPPED). Uma chamada só: pode transferir menos
+// que bytes. Devolve os bytes ou -errno
+int64_t readChunkFile(int fd, void* buffer, size_t bytes, uint64_t offset);
+int64_t writeChunkFile(int fd, const void* buffer, size_t bytes, uint64_t offset);
+// Dados do arquivo no disco (fdatasync; fsync no macOS, FlushFileBuffers no Windows)
+bool syncChunkFile(int fd);
+bool truncateChunkFile(int fd, uint64_t bytes);
+// Tamanho em bytes, -1 em erro
+int64_t chunkFileSize(int fd);
+
+// Buffer zerado com endereço e tamanho alinhados a IO_ALINHAMENTO (O_DIRECT)
+class AlignedBuffer {
+public:
+    AlignedBuffer() = default;
+    explicit AlignedBuffer(size_t bytes) { allocate(bytes); }
+    ~AlignedBuffer();
+    AlignedBuffer(AlignedBuffer&& outro) noexcept;
+    AlignedBuffer& operator=(AlignedBuffer&& outro) noexcept;
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    // Arredonda bytes para cima até o alinhamento
+    void allocate(size_t bytes);
+    uint8_t* data() { return dados; }
+    const uint8_t* data() const { return dados; }
+    size_t size() const { return tamanho; }
+
+private:
+    uint8_t* dados = nullptr;
+    size_t tamanho = 0;
+};
+
+// Grava bytes a partir de offset em pedaços de pedaco bytes, todos num lote só, e
+// espera o fim. Com o arquivo em O_DIRECT, data, offset e bytes seguem o alinhamento.
+// Chamar sem outros pedidos em andamento. Devolve false se algum pedaço falhou ou ficou
+// curto
+bool writeSequential(ChunkIO& io, int fd, uint64_t offset, const uint8_t* data, size_t bytes,
+                     size_t pedaco = 1 << 20);
@@ -0,0 +1,1123 @@
+#include "chunk_renderer.h"
+#include "gl_ext.h"
+#include "profiler.h"
+#include "shader.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+// Contadores escritos pelo compute shader: comandos opacos, comandos transparentes,
+// chunks visíveis, chunks por LOD, triângulos e triângulos sem LOD
+enum {
+    CONT_OPACOS = 0,
+    CONT_TRANSPARENTES = 1,
+    CONT_VISIVEIS = 2,
+    CONT_LOD = 3,
+    CONT_TRIANGULOS = CONT_LOD + NUM_LODS,
+    CONT_TRIANGULOS_SEM_LOD,
+    NUM_CONTADORES
+};
+
+// Faixas da arena são reservadas em múltiplos disso, para a malha poder crescer
+// um pouco sem realocar
+const int ARENA_GRANULARIDADE = 64;
+
+// Mesmo culling, escolha de LOD e saia do caminho da CPU (ver enqueue/cullCpu).
+// Um invocation por chunk; os comandos visíveis são compactados com atomicAdd:
+// opacos em commands[0, chunkCount), transparentes em commands[chunkCount, 2 * chunkCount)
+static const char* cullShaderBody = R"glsl(
+    layout (local_size_x = 64) in;
+
+    struct ChunkInfo {
+        vec4 boxMin;
+        vec4 boxMax;
+        vec4 center;
+        uvec4 flags;
+        uvec4 lod[NUM_LODS];   // primeiro vértice, opacos, saia, transparentes
+    };
+    struct DrawCommand {
+        uint count;
+        uint instanceCount;
+        uint firstIndex;
+        int baseVertex;
+        uint baseInstance;
+    };
+
+    layout (std430, binding = 0) readonly buffer Chunks { ChunkInfo chunks[]; };
+    layout (std430, binding = 1) writeonly buffer Commands { DrawCommand commands[]; };
+    layout (std430, binding = 2) buffer Counters { uint counters[]; };
+
+    uniform vec4 planes[6];
+    uniform vec3 cameraPos;
+    uniform float pixelsPerUnitAt1;
+    uniform float lodPixelSize;
+    uniform bool lodEnabled;
+    uniform ivec3 dims;
+    uniform uint chunkCount;
+
+    const ivec3 FACE_DIR[6] = ivec3[6](ivec3(1, 0, 0), ivec3(-1, 0, 0), ivec3(0, 1, 0),
+                                       ivec3(0, -1, 0), ivec3(0, 0, 1), ivec3(0, 0, -1));
+
+    bool intersectsBox(vec3 boxMin, vec3 boxMax) {
+        for (int i = 0; i < 6; i++) {
+            vec4 p = planes[i];
+            vec3 v = vec3(p.x >= 0.0 ? boxMax.x : boxMin.x,
+                          p.y >= 0.0 ? boxMax.y : boxMin.y,
+                          p.z >= 0.0 ? boxMax.z : boxMin.z);
+            precise float d = p.x * v.x + p.y * v.y + p.z * v.z + p.w;
+            if (d < 0.0)
+                return false;
+        }
+        return true;
+    }
+
+    int chooseLod(vec3 center) {
+        vec3 delta = center - cameraPos;
+        precise float lengthSq = delta.x * delta.x + delta.y * delta.y + delta.z * delta.z;
+        float distance = sqrt(lengthSq) - float(CHUNK_TAM) * 0.8660254;
+        if (distance < 1.0) distance = 1.0;
+        float pixelsPerUnit = pixelsPerUnitAt1 / distance;
+        int lod = 0;
+        while (lod < MAX_LOD && float(1 << (lod + 1)) * pixelsPerUnit <= lodPixelSize)
+            lod++;
+        return lod;
+    }
+
+    void main() {
+        uint i = gl_GlobalInvocationID.x;
+        if (i >= chunkCount || (chunks[i].flags.x & 1u) == 0u)
+            return;
+        if (!intersectsBox(chunks[i].boxMin.xyz, chunks[i].boxMax.xyz))
+            return;
+
+        int lod = lodEnabled ? chooseLod(chunks[i].center.xyz) : 0;
+
+        // Saia só quando algum vizinho não vazio está em outro LOD
+        bool skirt = false;
+        if (lodEnabled) {
+            int idx = int(i);
+            ivec3 c = ivec3(idx % dims.x, idx / (dims.x * dims.z), (idx / dims.x) % dims.z);
+            for (int f = 0; f < 6 && !skirt; f++) {
+                ivec3 n = c + FACE_DIR[f];
+                if (any(lessThan(n, ivec3(0))) || any(greaterThanEqual(n, dims)))
+                    continue;
+                uint ni = uint((n.y * dims.z + n.z) * dims.x + n.x);
+                if ((chunks[ni].flags.x & 1u) == 0u)
+                    continue;
+                skirt = chooseLod(chunks[ni].center.xyz) != lod;
+            }
+        }
+
+        uvec4 mesh = chunks[i].lod[lod];
+        uint opaque = mesh.y + (skirt ? mesh.z : 0u);
+        if (opaque > 0u) {
+            uint slot = atomicAdd(counters[CONT_OPACOS], 1u);
+            commands[slot] = DrawCommand(opaque * 6u, 1u, 0u, int(mesh.x), i);
+        }
+        if (mesh.w > 0u) {
+            uint slot = atomicAdd(counters[CONT_TRANSPARENTES], 1u);
+            commands[chunkCount + slot] = DrawCommand(mesh.w * 6u, 1u, 0u, int(mesh.x + (mesh.y + mesh.z) * 4u), i);
+        }
+
+        uvec4 lod0 = chunks[i].lod[0];
+        atomicAdd(counters[CONT_VISIVEIS], 1u);
+        atomicAdd(counters[CONT_LOD + lod], 1u);
+        atomicAdd(counters[CONT_TRIANGULOS], 2u * (opaque + mesh.w));
+        atomicAdd(counters[CONT_TRIANGULOS_SEM_LOD], 2u * (lod0.y + lod0.w));
+    }
+)glsl";
+
+Frustum::Frustum(const glm::mat4& m) {
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; i++)
+        row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    planes[0] = row[3] + row[0];
+    planes[1] = row[3] - row[0];
+    planes[2] = row[3] + row[1];
+    planes[3] = row[3] - row[1];
+    planes[4] = row[3] + row[2];
+    planes[5] = row[3] - row[2];
+}
+
+// Testa o vértice da caixa mais à frente de cada plano
+bool Frustum::intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    for (int i = 0; i < 6; i++) {
+        const glm::vec4& p = planes[i];
+        glm::vec3 v(p.x >= 0.0f ? boxMax.x : boxMin.x,
+                    p.y >= 0.0f ? boxMax.y : boxMin.y,
+                    p.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+void ChunkRenderer::setup(GLuint opaque, GLuint transparent, GLuint textures, GpuVolume* gpuVolume) {
+    opaqueProgram = opaque;
+    transparentProgram = transparent;
+    blockTextures = textures;
+    volume = gpuVolume;
+    mesher.setup();
+    glGenBuffers(1, &quadIBO);
+    ensureQuadIndices(CHUNK_VOLUME);
+
+    glGenBuffers(1, &arenaVBO);
+    glGenVertexArrays(1, &arenaVAO);
+    glGenVertexArrays(1, &indirectVAO);
+    bindArena(arenaVAO);
+    bindArena(indirectVAO);
+
+    if (glExt.compute) {
+        string source = "#version 430\n";
+        source += "#define CHUNK_TAM " + to_string(CHUNK_TAM) + "\n";
+        source += "#define MAX_LOD " + to_string(MAX_LOD) + "\n";
+        source += "#define NUM_LODS " + to_string(NUM_LODS) + "\n";
+        source += "#define CONT_OPACOS " + to_string(CONT_OPACOS) + "\n";
+        source += "#define CONT_TRANSPARENTES " + to_string(CONT_TRANSPARENTES) + "\n";
+        source += "#define CONT_VISIVEIS " + to_string(CONT_VISIVEIS) + "\n";
+        source += "#define CONT_LOD " + to_string(CONT_LOD) + "\n";
+        source += "#define CONT_TRIANGULOS " + to_string(CONT_TRIANGULOS) + "\n";
+        source += "#define CONT_TRIANGULOS_SEM_LOD " + to_string(CONT_TRIANGULOS_SEM_LOD) + "\n";
+        source += cullShaderBody;
+        cullProgram = setupComputeShader(source.c_str());
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(cullProgram, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            glDeleteProgram(cullProgram);
+            cullProgram = 0;
+        }
+    }
+    if (cullProgram) {
+        glGenBuffers(1, &infoBuffer);
+        glGenBuffers(1, &commandBuffer);
+        glGenBuffers(COUNTER_SLOTS, counterBuffers);
+        for (GLuint counters : counterBuffers) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, counters);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, NUM_CONTADORES * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+            glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        // Cópias dos contadores para a CPU: mapeadas de forma persistente e coerente, a
+        // leitura é só olhar a memória depois da fence
+        const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr bytes = (GLsizeiptr)COUNTER_SLOTS * NUM_CONTADORES * sizeof(GLuint);
+        glGenBuffers(1, &counterReadback);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, counterReadback);
+        glBufferStorage(GL_COPY_WRITE_BUFFER, bytes, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+        counterMapped = (const GLuint*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bytes, flags);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        counterFrame = 0;
+        lastCounters.assign(NUM_CONTADORES, 0);
+    }
+}
+
+void ChunkRenderer::destroy() {
+    chunks.clear();
+    glDeleteVertexArrays(1, &arenaVAO);
+    glDeleteVertexArrays(1, &indirectVAO);
+    glDeleteBuffers(1, &arenaVBO);
+    glDeleteBuffers(1, &quadIBO);
+    arenaVAO = indirectVAO = arenaVBO = quadIBO = 0;
+    arenaCapacity = arenaTop = 0;
+    freeRanges.clear();
+    quadIBOQuads = 0;
+
+    if (cullProgram) {
+        glDeleteProgram(cullProgram);
+        glDeleteBuffers(1, &infoBuffer);
+        glDeleteBuffers(1, &commandBuffer);
+        glDeleteBuffers(COUNTER_SLOTS, counterBuffers);
+        for (GLsync& fence : counterFences) {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (counterMapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, counterReadback);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &counterReadback);
+        counterMapped = nullptr;
+        cullProgram = infoBuffer = commandBuffer = counterReadback = 0;
+    }
+    mesher.destroy();
+    meshJobs.clear();
+    meshPending.clear();
+    dimX = dimY = dimZ = -1;
+    worldGeneration = ~0u;
+    trackedWorld = nullptr;
+}
+
+// Descarta as malhas quando o mundo é recriado (resize)
+void ChunkRenderer::reset(const World& world) {
+    chunks.assign(world.chunkCount(), ChunkGPU());
+    arenaTop = 0;
+    freeRanges.clear();
+    dimX = world.chunksX();
+    dimY = world.chunksY();
+    dimZ = world.chunksZ();
+    worldGeneration = world.generation();
+    // O próximo collectChanges marca todos
+    trackedWorld = nullptr;
+    dirtyChunks.clear();
+    dirtyMark.assign(chunks.size(), 0);
+    occupiedChunks.clear();
+    occupiedSlot.assign(chunks.size(), -1);
+    chosenLod.assign(chunks.size(), -1);
+    chosenSkirt.assign(chunks.size(), 0);
+    visibleList.clear();
+
+    if (!cullProgram)
+        return;
+
+    // Caixas e centros não mudam até o próximo resize
+    infos.assign(chunks.size(), ChunkCullInfo());
+    memset(infos.data(), 0, infos.size() * sizeof(ChunkCullInfo));
+    glm::vec3 origin = world.origin();
+    glm::vec3 worldMax = origin + glm::vec3((float)world.sizeX(), (float)world.sizeY(), (float)world.sizeZ());
+    for (int cy = 0; cy < dimY; cy++)
+        for (int cz = 0; cz < dimZ; cz++)
+            for (int cx = 0; cx < dimX; cx++) {
+                ChunkCullInfo& info = infos[world.chunkIndex(cx, cy, cz)];
+                glm::vec3 boxMin = origin + glm::vec3((float)cx, (float)cy, (float)cz) * (float)CHUNK_TAM;
+                glm::vec3 boxMax = glm::min(boxMin + glm::vec3((float)CHUNK_TAM), worldMax);
+                glm::vec3 center = chunkCenter(world, cx, cy, cz);
+                for (int k = 0; k < 3; k++) {
+                    info.boxMin[k] = boxMin[k];
+                    info.boxMax[k] = boxMax[k];
+                    info.center[k] = center[k];
+                }
+            }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, infoBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, infos.size() * sizeof(ChunkCullInfo), infos.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * infos.size() * sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Origem do chunk por instância, lida do próprio buffer de culling
+    glBindVertexArray(indirectVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, infoBuffer);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(ChunkCullInfo), (GLvoid*)0);
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+size_t ChunkRenderer::gpuBytes() const {
+    return (size_t)arenaCapacity * sizeof(ChunkVertex) + (size_t)quadIBOQuads * 6 * sizeof(GLuint) +
+           (cullProgram ? infos.size() * (sizeof(ChunkCullInfo) + 2 * sizeof(DrawCommand)) : 0);
+}
+
+// Índices 0,1,2 0,2,3 de cada quad, compartilhados por todas as malhas
+void ChunkRenderer::ensureQuadIndices(int quads) {
+    if (quads <= quadIBOQuads)
+        return;
+    vector<GLuint> indices((size_t)quads * 6);
+    for (int q = 0; q < quads; q++) {
+        GLuint v = q * 4;
+        GLuint* idx = &indices[(size_t)q * 6];
+        idx[0] = v; idx[1] = v + 1; idx[2] = v + 2;
+        idx[3] = v; idx[4] = v + 2; idx[5] = v + 3;
+    }
+    // GL_COPY_WRITE_BUFFER para não mexer no element buffer do VAO ligado
+    glBindBuffer(GL_COPY_WRITE_BUFFER, quadIBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    quadIBOQuads = quads;
+}
+
+// Aponta os atributos do VAO para o VBO atual da arena
+void ChunkRenderer::bindArena(GLuint vao) {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, arenaVBO);
+
+    // x, y, z, face
+    glVertexAttribIPointer(0, 4, GL_UNSIGNED_BYTE, sizeof(ChunkVertex), (GLvoid*)0);
+    glEnableVertexAttribArray(0);
+    // material, oclusão, reservado
+    glVertexAttribIPointer(1, 4, GL_UNSIGNED_BYTE, sizeof(ChunkVertex), (GLvoid*)4);
+    glEnableVertexAttribArray(1);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIBO);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// First-fit na lista de faixas livres; sem espaço, cresce a arena copiando o conteúdo
+int ChunkRenderer::allocateVertices(int count) {
+    for (size_t i = 0; i < freeRanges.size(); i++) {
+        if (freeRanges[i].second < count)
+            continue;
+        int first = freeRanges[i].first;
+        freeRanges[i].first += count;
+        freeRanges[i].second -= count;
+        if (freeRanges[i].second == 0)
+            freeRanges.erase(freeRanges.begin() + i);
+        return first;
+    }
+
+    if (arenaTop + count > arenaCapacity) {
+        int capacity = max(max(arenaCapacity * 2, arenaTop + count), 1 << 16);
+        GLuint bigger;
+        glGenBuffers(1, &bigger);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)capacity * sizeof(ChunkVertex), nullptr, GL_DYNAMIC_DRAW);
+        if (arenaTop > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, arenaVBO);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                                (GLsizeiptr)arenaTop * sizeof(ChunkVertex));
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &arenaVBO);
+        arenaVBO = bigger;
+        arenaCapacity = capacity;
+        bindArena(arenaVAO);
+        bindArena(indirectVAO);
+    }
+
+    int first = arenaTop;
+    arenaTop += count;
+    return first;
+}
+
+// Devolve a faixa, juntando com as vizinhas livres
+void ChunkRenderer::releaseVertices(int first, int count) {
+    if (count <= 0)
+        return;
+    auto it = lower_bound(freeRanges.begin(), freeRanges.end(), make_pair(first, 0));
+    it = freeRanges.insert(it, make_pair(first, count));
+    auto next = it + 1;
+    if (next != freeRanges.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        freeRanges.erase(next);
+    }
+    if (it != freeRanges.begin()) {
+        auto prev = it - 1;
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            it = freeRanges.erase(it) - 1;
+        }
+    }
+    // Faixa livre no topo volta para o topo
+    if (it->first + it->second == arenaTop) {
+        arenaTop = it->first;
+        freeRanges.erase(it);
+    }
+}
+
+// Garante espaço para a malha na faixa do slot (realoca se não cabe)
+void ChunkRenderer::reserve(MeshSlot& slot, int count) {
+    if (count <= slot.capacity)
+        return;
+    releaseVertices(slot.firstVertex, slot.capacity);
+    slot.capacity = (count + ARENA_GRANULARIDADE - 1) / ARENA_GRANULARIDADE * ARENA_GRANULARIDADE;
+    slot.firstVertex = allocateVertices(slot.capacity);
+}
+
+void ChunkRenderer::upload(MeshSlot& slot, const ChunkMesh& mesh) {
+    PERFIL_ESCOPO("upload");
+    ensureQuadIndices(mesh.quads());
+
+    int count = (int)mesh.vertices.size();
+    reserve(slot, count);
+    if (count > 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, arenaVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)slot.firstVertex * sizeof(ChunkVertex),
+                        count * sizeof(ChunkVertex), mesh.vertices.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    slot.opaqueQuads = mesh.opaqueQuads;
+    slot.skirtQuads = mesh.skirtQuads;
+    slot.transparentQuads = mesh.transparentQuads;
+}
+
+// Refaz a malha do LOD se algo que ela enxerga mudou. Retorna se remalhou
+bool ChunkRenderer::remesh(const World& world, int cx, int cy, int cz, int lod) {
+    ChunkGPU& chunk = chunks[world.chunkIndex(cx, cy, cz)];
+    MeshSlot& slot = chunk.lod[lod];
+    uint64_t stamp = dependencyStamp(world, cx, cy, cz, lod);
+    if (slot.stamp == stamp)
+        return false;
+    if (gpuMeshing && gpuMeshingSupported()) {
+        queueGpuMesh(world, cx, cy, cz, lod, stamp, false);
+        return true;
+    }
+
+    meshChunk(world, cx, cy, cz, lod, scratch);
+    upload(slot, scratch);
+    slot.stamp = stamp;
+    frameStats.chunksMeshed++;
+    if (lod == 0) {
+        chunk.lod0Quads = scratch.opaqueQuads + scratch.transparentQuads;
+        chunk.lod0Stamp = stamp;
+    }
+    return true;
+}
+
+void ChunkRenderer::queueGpuMesh(const World& world, int cx, int cy, int cz, int lod, uint64_t stamp, bool countOnly) {
+    GpuMeshJob job;
+    job.cx = cx;
+    job.cy = cy;
+    job.cz = cz;
+    job.lod = lod;
+    meshJobs.push_back(job);
+    meshPending.push_back({ world.chunkIndex(cx, cy, cz), lod, stamp, countOnly });
+}
+
+// Roda os dois passes do mesher da GPU para as malhas pedidas no frame: conta os
+// quads, reserva as faixas na arena e gera os vértices lá. Retorna false se o espelho
+// ainda tem bricks pendentes; aí nada é remalhado e os pedidos voltam no próximo frame
+bool ChunkRenderer::flushGpuMeshes(const World& world) {
+    if (meshJobs.empty())
+        return true;
+    volume->update(world);
+    if (volume->pendingBricks() > 0) {
+        meshJobs.clear();
+        meshPending.clear();
+        return false;
+    }
+
+    mesher.count(*volume, meshJobs);
+
+    // Argumentos de desenho escritos pelo mesher: o uvec4 do LOD no ChunkCullInfo
+    const int infoVec4s = sizeof(ChunkCullInfo) / (4 * sizeof(uint32_t));
+    const int lodVec4 = offsetof(ChunkCullInfo, lod) / (4 * sizeof(uint32_t));
+    vector<GpuMeshJob> emitJobs;
+    int maxQuads = 0;
+    for (size_t i = 0; i < meshJobs.size(); i++) {
+        const PendingMesh& pending = meshPending[i];
+        GpuMeshJob& job = meshJobs[i];
+        ChunkGPU& chunk = chunks[pending.chunk];
+        if (pending.lod == 0) {
+            chunk.lod0Quads = job.opaqueQuads + job.transparentQuads;
+            chunk.lod0Stamp = pending.stamp;
+        }
+        if (pending.countOnly)
+            continue;
+
+        MeshSlot& slot = chunk.lod[pending.lod];
+        reserve(slot, job.quads() * 4);
+        slot.opaqueQuads = job.opaqueQuads;
+        slot.skirtQuads = job.skirtQuads;
+        slot.transparentQuads = job.transparentQuads;
+        slot.stamp = pending.stamp;
+        frameStats.chunksMeshed++;
+        maxQuads = max(maxQuads, job.quads());
+
+        job.firstVertex = slot.firstVertex;
+        if (cullProgram) {
+            job.argsIndex = pending.chunk * infoVec4s + lodVec4 + pending.lod;
+            uint32_t* mesh = infos[pending.chunk].lod[pending.lod];
+            mesh[0] = (uint32_t)slot.firstVertex;
+            mesh[1] = (uint32_t)slot.opaqueQuads;
+            mesh[2] = (uint32_t)slot.skirtQuads;
+            mesh[3] = (uint32_t)slot.transparentQuads;
+        }
+        if (job.quads() > 0 || job.argsIndex >= 0)
+            emitJobs.push_back(job);
+    }
+
+    ensureQuadIndices(maxQuads);
+    mesher.emit(*volume, emitJobs, arenaVBO, cullProgram ? infoBuffer : 0);
+    meshJobs.clear();
+    meshPending.clear();
+    return true;
+}
+
+// Muda sempre que algo que a malha enxerga muda: o próprio chunk e os 26 vizinhos
+// (a oclusão dos cantos enxerga também os vizinhos de aresta e de quina). No LOD 0
+// basta a camada de borda do vizinho voltada para este chunk, pela versão de uma das
+// faces dele que a contém; nos LODs reduzidos o vizinho inteiro entra no voto
+uint64_t ChunkRenderer::dependencyStamp(const World& world, int cx, int cy, int cz, int lod) const {
+    uint64_t stamp = world.chunk(cx, cy, cz).version;
+    for (int dy = -1; dy <= 1; dy++)
+        for (int dz = -1; dz <= 1; dz++)
+            for (int dx = -1; dx <= 1; dx++) {
+                if ((dx | dy | dz) == 0 || !world.chunkInside(cx + dx, cy + dy, cz + dz))
+                    continue;
+                const Chunk& n = world.chunk(cx + dx, cy + dy, cz + dz);
+                if (lod != 0) {
+                    stamp += n.version;
+                    continue;
+                }
+                // Face do vizinho voltada para cá (FACE_DIR: +X, -X, +Y, -Y, +Z, -Z)
+                int face = dx != 0 ? (dx > 0 ? 1 : 0) : dy != 0 ? (dy > 0 ? 3 : 2) : (dz > 0 ? 5 : 4);
+                stamp += n.faceVersion[face];
+            }
+    return stamp;
+}
+
+glm::vec3 ChunkRenderer::chunkCenter(const World& world, int cx, int cy, int cz) const {
+    return world.origin() + glm::vec3(cx + 0.5f, cy + 0.5f, cz + 0.5f) * (float)CHUNK_TAM;
+}
+
+// Maior LOD cujo voxel ainda cabe em lodPixelSize pixels na distância do chunk
+int ChunkRenderer::chooseLod(const glm::vec3& center, const glm::vec3& cameraPos, float pixelsPerUnitAt1) const {
+    const float radius = CHUNK_TAM * 0.8660254f;
+    float distance = glm::length(center - cameraPos) - radius;
+    if (distance < 1.0f) distance = 1.0f;
+    float pixelsPerUnit = pixelsPerUnitAt1 / distance;
+
+    int lod = 0;
+    while (lod < MAX_LOD && (1 << (lod + 1)) * pixelsPerUnit <= lodPixelSize)
+        lod++;
+    return lod;
+}
+
+// Marca o que mudou no mundo desde o frame anterior. Sem registro (primeira vez,
+// resize, touchAll ou outro mundo) todos os chunks entram
+void ChunkRenderer::collectChanges(World& world) {
+    bool onlyChanged = world.takeChangedChunks(changedChunks);
+    if (!onlyChanged || trackedWorld != &world) {
+        trackedWorld = &world;
+        for (int i = 0; i < (int)chunks.size(); i++) {
+            markDirty(i);
+            updateOccupied(world, i);
+        }
+        return;
+    }
+    for (int i : changedChunks) {
+        updateOccupied(world, i);
+        // As malhas dos vizinhos enxergam este chunk (dependencyStamp)
+        int cx = i % dimX, cz = (i / dimX) % dimZ, cy = i / (dimX * dimZ);
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dz = -1; dz <= 1; dz++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if (world.chunkInside(cx + dx, cy + dy, cz + dz))
+                        markDirty(world.chunkIndex(cx + dx, cy + dy, cz + dz));
+    }
+}
+
+// Só com culling na GPU: no caminho da CPU as malhas seguem os chunks visíveis
+void ChunkRenderer::markDirty(int index) {
+    if (!cullProgram || dirtyMark[index])
+        return;
+    dirtyMark[index] = 1;
+    dirtyChunks.push_back(index);
+}
+
+void ChunkRenderer::updateOccupied(const World& world, int index) {
+    bool occupied = world.chunk(index).visibleCount > 0;
+    int& slot = occupiedSlot[index];
+    if (occupied == (slot >= 0))
+        return;
+    if (occupied) {
+        slot = (int)occupiedChunks.size();
+        occupiedChunks.push_back(index);
+        return;
+    }
+    int last = occupiedChunks.back();
+    occupiedChunks[slot] = last;
+    occupiedSlot[last] = slot;
+    occupiedChunks.pop_back();
+    slot = -1;
+}
+
+// Põe em ordem de distância à câmera os count chunks mais perto, no começo da lista
+void ChunkRenderer::nearestFirst(const World& world, vector<int>& list, size_t count, const glm::vec3& cameraPos) const {
+    auto distance = [&](int i) {
+        int cx = i % dimX, cz = (i / dimX) % dimZ, cy = i / (dimX * dimZ);
+        glm::vec3 d = chunkCenter(world, cx, cy, cz) - cameraPos;
+        return glm::dot(d, d);
+    };
+    auto nearer = [&](int a, int b) { return distance(a) < distance(b); };
+    count = min(count, list.size());
+    nth_element(list.begin(), list.begin() + count, list.end(), nearer);
+    sort(list.begin(), list.begin() + count, nearer);
+}
+
+// Frustum culling, escolha de LOD e de saia na CPU (preenche visibleList, na ordem dos
+// índices). Passa só pelos chunks não vazios
+void ChunkRenderer::cullCpu(const World& world, const ChunkView& camera) {
+    const glm::vec3& cameraPos = camera.cameraPos;
+    Frustum frustum(camera.proj * camera.view);
+    float pixelsPerUnitAt1 = camera.viewportHeight / (2.0f * tan(camera.fovY * 0.5f));
+    glm::vec3 origin = world.origin();
+    glm::vec3 worldMax = origin + glm::vec3((float)world.sizeX(), (float)world.sizeY(), (float)world.sizeZ());
+
+    // Só os visíveis do frame anterior têm LOD escolhido
+    for (int i : visibleList) {
+        chosenLod[i] = -1;
+        chosenSkirt[i] = 0;
+    }
+    visibleList.clear();
+    for (int i : occupiedChunks) {
+        int cx = i % dimX, cz = (i / dimX) % dimZ, cy = i / (dimX * dimZ);
+        glm::vec3 boxMin = origin + glm::vec3((float)cx, (float)cy, (float)cz) * (float)CHUNK_TAM;
+        glm::vec3 boxMax = glm::min(boxMin + glm::vec3((float)CHUNK_TAM), worldMax);
+        if (!frustum.intersectsBox(boxMin, boxMax))
+            continue;
+        chosenLod[i] = (int8_t)(lodEnabled ? chooseLod(chunkCenter(world, cx, cy, cz), cameraPos, pixelsPerUnitAt1) : 0);
+        visibleList.push_back(i);
+    }
+    sort(visibleList.begin(), visibleList.end());
+
+    // Saia só quando algum vizinho está em outro LOD
+    for (int i : visibleList) {
+        int cx = i % dimX, cz = (i / dimX) % dimZ, cy = i / (dimX * dimZ);
+        bool skirt = false;
+        for (int f = 0; f < NUM_FACES && lodEnabled && !skirt; f++) {
+            int nx = cx + FACE_DIR[f][0], ny = cy + FACE_DIR[f][1], nz = cz + FACE_DIR[f][2];
+            if (!world.chunkInside(nx, ny, nz) || world.chunk(nx, ny, nz).visibleCount == 0)
+                continue;
+            int ni = world.chunkIndex(nx, ny, nz);
+            int neighborLod = chosenLod[ni] >= 0 ? chosenLod[ni]
+                                                 : chooseLod(chunkCenter(world, nx, ny, nz), cameraPos, pixelsPerUnitAt1);
+            skirt = (neighborLod != chosenLod[i]);
+        }
+        chosenSkirt[i] = skirt;
+    }
+}
+
+// Com culling na GPU todos os LODs dos chunks não vazios ficam prontos na arena,
+// porque quem escolhe o nível é o compute shader. Só confere os chunks marcados
+void ChunkRenderer::syncGpuChunks(const World& world, const glm::vec3& cameraPos) {
+    if (dirtyChunks.empty())
+        return;
+
+    // Sem orçamento para todos: os mais perto da câmera vêm primeiro, o resto espera
+    size_t count = dirtyChunks.size();
+    if ((size_t)remeshLeft < count)
+        nearestFirst(world, dirtyChunks, remeshLeft, cameraPos);
+
+    size_t done = 0;
+    for (; done < count && remeshLeft > 0; done++) {
+        int i = dirtyChunks[done];
+        int cx = i % dimX, cz = (i / dimX) % dimZ, cy = i / (dimX * dimZ);
+        if (world.chunk(i).visibleCount > 0)
+            for (int lod = 0; lod < NUM_LODS; lod++)
+                if (remesh(world, cx, cy, cz, lod))
+                    remeshLeft--;
+    }
+    // Malhas adiadas pelo mesher da GPU: os chunks ficam marcados para o próximo frame
+    if (!flushGpuMeshes(world))
+        return;
+
+    changedInfos.clear();
+    for (size_t k = 0; k < done; k++) {
+        int i = dirtyChunks[k];
+        dirtyMark[i] = 0;
+        ChunkCullInfo& info = infos[i];
+        bool changed = false;
+
+        uint32_t flags = world.chunk(i).visibleCount > 0 ? 1u : 0u;
+        if (info.flags[0] != flags) {
+            info.flags[0] = flags;
+            changed = true;
+        }
+        if (flags) {
+            for (int lod = 0; lod < NUM_LODS; lod++) {
+                const MeshSlot& slot = chunks[i].lod[lod];
+                uint32_t mesh[4] = { (uint32_t)slot.firstVertex, (uint32_t)slot.opaqueQuads,
+                                     (uint32_t)slot.skirtQuads, (uint32_t)slot.transparentQuads };
+                if (memcmp(info.lod[lod], mesh, sizeof(mesh)) != 0) {
+                    memcpy(info.lod[lod], mesh, sizeof(mesh));
+                    changed = true;
+                }
+            }
+        }
+        if (changed)
+            changedInfos.push_back(i);
+    }
+    dirtyChunks.erase(dirtyChunks.begin(), dirtyChunks.begin() + done);
+
+    // Um envio por faixa de índices próximos (buracos pequenos vão junto)
+    const int BURACO_MAX = 16;
+    sort(changedInfos.begin(), changedInfos.end());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, infoBuffer);
+    for (size_t a = 0; a < changedInfos.size();) {
+        size_t b = a + 1;
+        while (b < changedInfos.size() && changedInfos[b] - changedInfos[b - 1] <= BURACO_MAX)
+            b++;
+        int first = changedInfos[a], last = changedInfos[b - 1];
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)first * sizeof(ChunkCullInfo),
+                        (GLsizeiptr)(last - first + 1) * sizeof(ChunkCullInfo), &infos[first]);
+        a = b;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+// Zera os contadores, roda o compute shader e deixa os comandos prontos para o desenho
+void ChunkRenderer::dispatchCull(const ChunkView& camera, GLuint counters) {
+    GLuint chunkCount = (GLuint)infos.size();
+    Frustum frustum(camera.proj * camera.view);
+    float pixelsPerUnitAt1 = camera.viewportHeight / (2.0f * tan(camera.fovY * 0.5f));
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counters);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    // Sem contagem na GPU o multi-draw percorre todos os comandos: os não escritos ficam zerados
+    if (!glExt.indirectCount) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glUseProgram(cullProgram);
+    glUniform4fv(glGetUniformLocation(cullProgram, "planes"), 6, glm::value_ptr(frustum.planes[0]));
+    glUniform3fv(glGetUniformLocation(cullProgram, "cameraPos"), 1, glm::value_ptr(camera.cameraPos));
+    glUniform1f(glGetUniformLocation(cullProgram, "pixelsPerUnitAt1"), pixelsPerUnitAt1);
+    glUniform1f(glGetUniformLocation(cullProgram, "lodPixelSize"), lodPixelSize);
+    glUniform1i(glGetUniformLocation(cullProgram, "lodEnabled"), lodEnabled ? 1 : 0);
+    glUniform3i(glGetUniformLocation(cullProgram, "dims"), dimX, dimY, dimZ);
+    glUniform1ui(glGetUniformLocation(cullProgram, "chunkCount"), chunkCount);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, infoBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, counters);
+    glDispatchCompute((chunkCount + 63) / 64, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glUseProgram(0);
+}
+
+// Leva os contadores do frame para a fatia dele no readback, atrás de uma fence (a
+// barreira do dispatchCull já cobre a cópia)
+void ChunkRenderer::copyCounters(GLuint counters) {
+    int fatia = counterFrame % COUNTER_SLOTS;
+    // A GPU ficou COUNTER_SLOTS frames atrás: a leitura antiga da fatia se perde
+    if (counterFences[fatia])
+        glDeleteSync(counterFences[fatia]);
+    glBindBuffer(GL_COPY_READ_BUFFER, counters);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, counterReadback);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+                        (GLintptr)fatia * NUM_CONTADORES * sizeof(GLuint), NUM_CONTADORES * sizeof(GLuint));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    counterFences[fatia] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Estatísticas agregadas do culling na GPU (só contadores, não a visibilidade por chunk):
+// as da cópia mais nova que a GPU já terminou, sem esperar por ela. Enquanto nenhuma
+// nova termina, repete as anteriores
+void ChunkRenderer::readCounters() {
+    // Da mais antiga para a mais nova; a GPU termina em ordem, então a primeira que não
+    // passou encerra a busca
+    for (int atras = COUNTER_SLOTS; atras >= 1; atras--) {
+        int frame = counterFrame - atras;
+        if (frame < 0)
+            continue;
+        GLsync& fence = counterFences[frame % COUNTER_SLOTS];
+        if (!fence)
+            continue;
+        GLenum estado = glClientWaitSync(fence, 0, 0);
+        if (estado != GL_ALREADY_SIGNALED && estado != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(fence);
+        fence = nullptr;
+        if (counterMapped)
+            memcpy(lastCounters.data(), counterMapped + (frame % COUNTER_SLOTS) * NUM_CONTADORES,
+                   NUM_CONTADORES * sizeof(GLuint));
+    }
+    const GLuint* values = lastCounters.data();
+
+    frameStats.chunksVisible = (int)values[CONT_VISIVEIS];
+    for (int lod = 0; lod < NUM_LODS; lod++)
+        frameStats.chunksPerLod[lod] = (int)values[CONT_LOD + lod];
+    frameStats.triangles = values[CONT_TRIANGULOS];
+    frameStats.trianglesNoLod = values[CONT_TRIANGULOS_SEM_LOD];
+}
+
+// Comandos que o compute shader deveria gerar para o resultado de cullCpu
+void ChunkRenderer::cpuCommands(vector<DrawCommand>& opaque, vector<DrawCommand>& transparent) const {
+    opaque.clear();
+    transparent.clear();
+    for (int i : visibleList) {
+        const MeshSlot& slot = chunks[i].lod[chosenLod[i]];
+        int opaqueQuads = slot.opaqueQuads + (chosenSkirt[i] ? slot.skirtQuads : 0);
+        if (opaqueQuads > 0)
+            opaque.push_back({ (GLuint)opaqueQuads * 6, 1, 0, slot.firstVertex, (GLuint)i });
+        if (slot.transparentQuads > 0)
+            transparent.push_back({ (GLuint)slot.transparentQuads * 6, 1, 0,
+                                    slot.firstVertex + (slot.opaqueQuads + slot.skirtQuads) * 4, (GLuint)i });
+    }
+}
+
+int ChunkRenderer::validateGpuCulling(World& world, const ChunkView& camera) {
+    if (!cullProgram)
+        return -1;
+    if (worldGeneration != world.generation())
+        reset(world);
+    collectChanges(world);
+
+    // Tudo em dia antes de comparar, sem orçamento
+    remeshLeft = INT_MAX;
+    syncGpuChunks(world, camera.cameraPos);
+    cullCpu(world, camera);
+    vector<DrawCommand> expected[2];
+    cpuCommands(expected[0], expected[1]);
+
+    GLuint counters = counterBuffers[counterFrame % COUNTER_SLOTS];
+    dispatchCull(camera, counters);
+
+    GLuint values[NUM_CONTADORES];
+    glBindBuffer(GL_COPY_READ_BUFFER, counters);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(values), values);
+
+    int mismatches = abs((int)values[CONT_VISIVEIS] - (int)visibleList.size());
+    auto byChunk = [](const DrawCommand& a, const DrawCommand& b) { return a.baseInstance < b.baseInstance; };
+    for (int list = 0; list < 2; list++) {
+        vector<DrawCommand> got(values[list == 0 ? CONT_OPACOS : CONT_TRANSPARENTES]);
+        if (!got.empty()) {
+            glBindBuffer(GL_COPY_READ_BUFFER, commandBuffer);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, (GLintptr)(list * infos.size() * sizeof(DrawCommand)),
+                               got.size() * sizeof(DrawCommand), got.data());
+        }
+        sort(got.begin(), got.end(), byChunk);
+        sort(expected[list].begin(), expected[list].end(), byChunk);
+
+        // Compara as duas listas ordenadas pelo chunk
+        size_t a = 0, b = 0;
+        while (a < got.size() || b < expected[list].size()) {
+            if (b == expected[list].size() || (a < got.size() && got[a].baseInstance < expected[list][b].baseInstance)) {
+                mismatches++;
+                a++;
+            }
+            else if (a == got.size() || expected[list][b].baseInstance < got[a].baseInstance) {
+                mismatches++;
+                b++;
+            }
+            else {
+                if (memcmp(&got[a], &expected[list][b], sizeof(DrawCommand)) != 0)
+                    mismatches++;
+                a++;
+                b++;
+            }
+        }
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return mismatches;
+}
+
+// Quads de uma faixa (4 vértices = 32 bytes cada), ordenados: a GPU não segue a ordem da CPU
+static vector<array<uint64_t, 4>> sortedQuads(const ChunkVertex* vertices, int quads) {
+    static_assert(4 * sizeof(ChunkVertex) == sizeof(array<uint64_t, 4>), "quad deve ter 32 bytes");
+    vector<array<uint64_t, 4>> out(quads);
+    if (quads > 0)
+        memcpy(out.data(), vertices, (size_t)quads * 4 * sizeof(ChunkVertex));
+    sort(out.begin(), out.end());
+    return out;
+}
+
+int ChunkRenderer::validateGpuMesher(const World& world) {
+    if (!gpuMeshingSupported())
+        return -1;
+    // O mesher só lê o espelho: envia tudo antes, sem respeitar o orçamento
+    do
+        volume->update(world);
+    while (volume->pendingBricks() > 0);
+
+    vector<GpuMeshJob> all;
+    for (int cy = 0; cy < world.chunksY(); cy++)
+        for (int cz = 0; cz < world.chunksZ(); cz++)
+            for (int cx = 0; cx < world.chunksX(); cx++) {
+                if (world.chunk(cx, cy, cz).visibleCount == 0)
+                    continue;
+                for (int lod = 0; lod < NUM_LODS; lod++) {
+                    GpuMeshJob job;
+                    job.cx = cx;
+                    job.cy = cy;
+                    job.cz = cz;
+                    job.lod = lod;
+                    all.push_back(job);
+                }
+            }
+
+    // Em lotes, para o buffer de vértices temporário não crescer com o mundo
+    const size_t LOTE = 1024;
+    int mismatches = 0;
+    GLuint vertexBuffer;
+    glGenBuffers(1, &vertexBuffer);
+    for (size_t first = 0; first < all.size(); first += LOTE) {
+        vector<GpuMeshJob> jobs(all.begin() + first, all.begin() + min(all.size(), first + LOTE));
+        mesher.count(*volume, jobs);
+        int total = 0;
+        for (GpuMeshJob& job : jobs) {
+            job.firstVertex = total;
+            total += job.quads() * 4;
+        }
+        vector<ChunkVertex> got(total);
+        if (total > 0) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, vertexBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)total * sizeof(ChunkVertex), nullptr, GL_STREAM_READ);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            mesher.emit(*volume, jobs, vertexBuffer, 0);
+            glBindBuffer(GL_COPY_READ_BUFFER, vertexBuffer);
+            glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)total * sizeof(ChunkVertex), got.data());
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        }
+
+        for (const GpuMeshJob& job : jobs) {
+            meshChunk(world, job.cx, job.cy, job.cz, job.lod, scratch);
+            if (job.opaqueQuads != scratch.opaqueQuads || job.skirtQuads != scratch.skirtQuads ||
+                job.transparentQuads != scratch.transparentQuads) {
+                mismatches++;
+                continue;
+            }
+            // Compara faixa a faixa: opacos, saia, transparentes
+            const int faixas[3] = { job.opaqueQuads, job.skirtQuads, job.transparentQuads };
+            int offset = 0;
+            bool same = true;
+            for (int quads : faixas) {
+                same = same && sortedQuads(got.data() + job.firstVertex + offset * 4, quads) ==
+                               sortedQuads(scratch.vertices.data() + offset * 4, quads);
+                offset += quads;
+            }
+            if (!same)
+                mismatches++;
+        }
+    }
+    glDeleteBuffers(1, &vertexBuffer);
+    return mismatches;
+}
+
+void ChunkRenderer::enqueue(World& world, RenderQueue& queue, const ChunkView& camera) {
+    if (worldGeneration != world.generation())
+        reset(world);
+    collectChanges(world);
+
+    frameStats = ChunkRenderStats();
+    frameStats.chunksTotal = world.chunkCount();
+    remeshLeft = remeshBudget > 0 ? remeshBudget : INT_MAX;
+
+    DrawItem item;
+    item.textureTarget = GL_TEXTURE_2D_ARRAY;
+    item.texture = blockTextures;
+    item.indexed = true;
+    item.first = 0;
+
+    if (gpuCulling && cullProgram) {
+        if (chunks.empty())
+            return;
+        syncGpuChunks(world, camera.cameraPos);
+        frameStats.chunksPending = (int)dirtyChunks.size();
+
+        // Estatísticas de alguns frames atrás; as deste ficam para quando a GPU terminar
+        readCounters();
+        GLuint counters = counterBuffers[counterFrame % COUNTER_SLOTS];
+        {
+            PERFIL_ESCOPO("culling");
+            PERFIL_GPU("culling");
+            dispatchCull(camera, counters);
+        }
+        copyCounters(counters);
+        counterFrame++;
+
+        item.vao = indirectVAO;
+        item.indirectBuffer = commandBuffer;
+        item.countBuffer = counters;
+        item.count = (GLsizei)infos.size();
+
+        item.pass = PASS_OPACO;
+        item.program = opaqueProgram;
+        item.indirectOffset = 0;
+        item.countOffset = CONT_OPACOS * sizeof(GLuint);
+        item.key = makeSortKey(PASS_OPACO, 2, 0, 0);
+        queue.push(item);
+
+        item.pass = PASS_TRANSPARENTE;
+        item.program = transparentProgram;
+        item.indirectOffset = (GLintptr)(infos.size() * sizeof(DrawCommand));
+        item.countOffset = CONT_TRANSPARENTES * sizeof(GLuint);
+        item.key = makeSortKey(PASS_TRANSPARENTE, 3, 0, 0);
+        queue.push(item);
+        return;
+    }
+
+    // Culling e escolha de LOD na CPU; malhas geradas só para o LOD escolhido
+    {
+        PERFIL_ESCOPO("culling");
+        cullCpu(world, camera);
+    }
+    const glm::vec3& cameraPos = camera.cameraPos;
+    glm::vec3 origin = world.origin();
+    item.vao = arenaVAO;
+
+    PERFIL_ESCOPO("malhas");
+    // Com orçamento, os mais perto da câmera remalham primeiro
+    meshOrder = visibleList;
+    if (remeshBudget > 0)
+        nearestFirst(world, meshOrder, meshOrder.size(), cameraPos);
+    for (size_t k = 0; k < meshOrder.size(); k++) {
+        // Sem orçamento fica a malha antiga, até um frame seguinte
+        if (remeshLeft <= 0) {
+            frameStats.chunksPending = (int)(meshOrder.size() - k);
+            break;
+        }
+        int i = meshOrder[k];
+        int cx = i % dimX, cz = (i / dimX) % dimZ, cy = i / (dimX * dimZ);
+        int lod = chosenLod[i];
+        ChunkGPU& chunk = chunks[i];
+        // A faixa pode ter mudado de lugar: o culling da GPU confere o chunk
+        if (remesh(world, cx, cy, cz, lod)) {
+            markDirty(i);
+            remeshLeft--;
+        }
+
+        // Mesmo chunk sem LOD (só a contagem de quads do LOD 0, refeita quando muda)
+        if (lod != 0) {
+            uint64_t stamp0 = dependencyStamp(world, cx, cy, cz, 0);
+            if (chunk.lod0Stamp != stamp0) {
+                if (gpuMeshing && gpuMeshingSupported()) {
+                    queueGpuMesh(world, cx, cy, cz, 0, stamp0, true);
+                }
+                else {
+                    meshChunk(world, cx, cy, cz, 0, scratch);
+                    chunk.lod0Quads = scratch.opaqueQuads + scratch.transparentQuads;
+                    chunk.lod0Stamp = stamp0;
+                }
+                remeshLeft--;
+            }
+        }
+    }
+    flushGpuMeshes(world);
+
+    for (int i : visibleList) {
+        int cx = i % dimX, cz = (i / dimX) % dimZ, cy = i / (dimX * dimZ);
+        int lod = chosenLod[i];
+        const ChunkGPU& chunk = chunks[i];
+        const MeshSlot& slot = chunk.lod[lod];
+
+        int opaqueQuads = slot.opaqueQuads + (chosenSkirt[i] ? slot.skirtQuads : 0);
+        frameStats.chunksVisible++;
+        frameStats.chunksPerLod[lod]++;
+        frameStats.triangles += 2LL * (opaqueQuads + slot.transparentQuads);
+        frameStats.trianglesNoLod += 2LL * chunk.lod0Quads;
+
+        glm::vec3 chunkOrigin = origin + glm::vec3((float)cx, (float)cy, (float)cz) * (float)CHUNK_TAM;
+        uint32_t depth = quantizeDepth(glm::length(chunkCenter(world, cx, cy, cz) - cameraPos), camera.farPlane);
+        item.model = glm::translate(glm::mat4(1.0f), chunkOrigin);
+
+        if (opaqueQuads > 0) {
+            item.pass = PASS_OPACO;
+            item.program = opaqueProgram;
+            item.count = opaqueQuads * 6;
+            item.baseVertex = slot.firstVertex;
+            item.key = makeSortKey(PASS_OPACO, 2, 0, depth);
+            queue.push(item);
+        }
+        if (slot.transparentQuads > 0) {
+            item.pass = PASS_TRANSPARENTE;
+            item.program = transparentProgram;
+            item.count = slot.transparentQuads * 6;
+            item.baseVertex = slot.firstVertex + (slot.opaqueQuads + slot.skirtQuads) * 4;
+            item.key = makeSortKey(PASS_TRANSPARENTE, 3, 0, depth);
+            queue.push(item);
+        }
+    }
+}
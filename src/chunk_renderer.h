@@ -0,0 +1,204 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gpu_mesher.h"
+#include "gpu_volume.h"
+#include "mesher.h"
+#include "render_queue.h"
+#include "world.h"
+
+#include <vector>
+
+// Contadores do último frame (com o culling na GPU, visíveis, LODs e triângulos são de
+// alguns frames atrás: chegam sem esperar a GPU)
+struct ChunkRenderStats {
+    int chunksTotal = 0;
+    int chunksVisible = 0;     // passaram no frustum e não estão vazios
+    int chunksMeshed = 0;      // remalhados neste frame
+    int chunksPending = 0;     // a conferir nos próximos frames pelo remeshBudget (na CPU, os visíveis que sobraram)
+    int chunksPerLod[NUM_LODS] = {};
+    long long triangles = 0;       // triângulos enviados com o LOD atual
+    long long trianglesNoLod = 0;  // os mesmos chunks visíveis todos no LOD 0
+};
+
+// Câmera do frame como o renderizador de chunks precisa
+struct ChunkView {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec3 cameraPos;
+    float fovY;           // radianos
+    float farPlane;
+    int viewportHeight;
+};
+
+// Dados de um chunk lidos pelo compute shader de culling (layout std430).
+// boxMin também é o atributo por instância com a origem do chunk no desenho indireto
+struct ChunkCullInfo {
+    float boxMin[4];
+    float boxMax[4];
+    float center[4];
+    uint32_t flags[4];              // x: 1 = chunk tem voxels visíveis
+    uint32_t lod[NUM_LODS][4];      // primeiro vértice na arena, quads opacos, saia, transparentes
+};
+static_assert(sizeof(ChunkCullInfo) == 128, "ChunkCullInfo deve seguir o layout std430");
+
+// Desenha o mundo como malhas de chunk. Cada chunk tem uma malha por LOD, gerada
+// sob demanda quando o chunk (ou a borda de um vizinho) muda, e guardada numa arena
+// de vértices compartilhada. O LOD é escolhido pelo tamanho em pixels de um voxel
+// do nível na distância do chunk.
+//
+// Com culling na GPU (GL 4.3), um compute shader faz o frustum culling, escolhe o
+// LOD e a saia de cada chunk e escreve os comandos de desenho compactados com um
+// contador atômico; a CPU só submete dois multi-draws indiretos por frame.
+//
+// Com o mesher da GPU, as malhas são geradas por compute shader a partir do espelho
+// do mundo (GpuVolume) direto na arena, sem passar os vértices pela CPU. Enquanto o
+// espelho tem bricks pendentes (orçamento de envio), os chunks ficam com a malha antiga
+class ChunkRenderer {
+public:
+    void setup(GLuint opaqueProgram, GLuint transparentProgram, GLuint blockTextures, GpuVolume* volume);
+    void destroy();
+
+    // Consome o registro de chunks mudados do mundo (World::takeChangedChunks): o
+    // renderer é o leitor dele no mundo que desenha
+    void enqueue(World& world, RenderQueue& queue, const ChunkView& camera);
+
+    // Roda o culling da GPU e o da CPU para a mesma câmera e compara os comandos
+    // gerados. Retorna o número de divergências (-1 se não há culling na GPU)
+    int validateGpuCulling(World& world, const ChunkView& camera);
+    // Gera as malhas de todos os chunks não vazios em todos os LODs na GPU e na CPU
+    // e compara os conjuntos de quads de cada faixa. Retorna o número de malhas
+    // diferentes (-1 se não há mesher na GPU)
+    int validateGpuMesher(const World& world);
+
+    const ChunkRenderStats& stats() const { return frameStats; }
+    bool gpuCullingSupported() const { return cullProgram != 0; }
+    bool gpuMeshingSupported() const { return mesher.supported() && volume; }
+    // Memória de GPU alocada: arena de vértices, índices e buffers do culling
+    size_t gpuBytes() const;
+
+    bool lodEnabled = true;
+    // Um nível só é usado se seu voxel cobre no máximo esse número de pixels
+    float lodPixelSize = 4.0f;
+    // Culling e geração de comandos na GPU (ignorado sem suporte a compute)
+    bool gpuCulling = true;
+    // Malhas geradas na GPU (ignorado sem suporte a compute)
+    bool gpuMeshing = false;
+    // Malhas refeitas por frame no enqueue (0 = sem limite). Acima disso os chunks seguem
+    // com a malha antiga e são refeitos nos próximos frames, os mais perto da câmera
+    // primeiro: uma carga, um R ou um voo pelo streaming não param o desenho
+    int remeshBudget = 0;
+
+private:
+    struct MeshSlot {
+        int firstVertex = 0, capacity = 0;  // faixa reservada na arena, em vértices
+        int opaqueQuads = 0, skirtQuads = 0, transparentQuads = 0;
+        uint64_t stamp = 0;
+    };
+    struct ChunkGPU {
+        MeshSlot lod[NUM_LODS];
+        // Quads do LOD 0 (para a estatística sem LOD quando o chunk está em outro nível)
+        int lod0Quads = 0;
+        uint64_t lod0Stamp = 0;
+    };
+    // Malha pedida ao mesher da GPU, resolvida em flushGpuMeshes
+    struct PendingMesh {
+        int chunk, lod;
+        uint64_t stamp;
+        bool countOnly;   // só os quads do LOD 0 para a estatística sem LOD
+    };
+    // Comando de glMultiDrawElementsIndirect
+    struct DrawCommand {
+        GLuint count, instanceCount, firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    void reset(const World& world);
+    void ensureQuadIndices(int quads);
+    void bindArena(GLuint vao);
+    int allocateVertices(int count);
+    void releaseVertices(int first, int count);
+    void reserve(MeshSlot& slot, int vertices);
+    void upload(MeshSlot& slot, const ChunkMesh& mesh);
+    bool remesh(const World& world, int cx, int cy, int cz, int lod);
+    void queueGpuMesh(const World& world, int cx, int cy, int cz, int lod, uint64_t stamp, bool countOnly);
+    bool flushGpuMeshes(const World& world);
+    uint64_t dependencyStamp(const World& world, int cx, int cy, int cz, int lod) const;
+    glm::vec3 chunkCenter(const World& world, int cx, int cy, int cz) const;
+    int chooseLod(const glm::vec3& center, const glm::vec3& cameraPos, float pixelsPerUnitAt1) const;
+
+    void collectChanges(World& world);
+    void markDirty(int index);
+    void updateOccupied(const World& world, int index);
+    void nearestFirst(const World& world, std::vector<int>& list, size_t count, const glm::vec3& cameraPos) const;
+    void cullCpu(const World& world, const ChunkView& camera);
+    void syncGpuChunks(const World& world, const glm::vec3& cameraPos);
+    void dispatchCull(const ChunkView& camera, GLuint counters);
+    void readCounters();
+    void copyCounters(GLuint counters);
+    void cpuCommands(std::vector<DrawCommand>& opaque, std::vector<DrawCommand>& transparent) const;
+
+    GLuint opaqueProgram = 0, transparentProgram = 0, blockTextures = 0;
+    GLuint quadIBO = 0;
+    int quadIBOQuads = 0;
+
+    // Arena de vértices: um só VBO para todos os chunks, com lista de faixas livres.
+    // arenaVAO desenha com matriz model (caminho da CPU); indirectVAO soma a origem
+    // do chunk por instância (baseInstance = índice do chunk)
+    GLuint arenaVBO = 0, arenaVAO = 0, indirectVAO = 0;
+    int arenaCapacity = 0, arenaTop = 0;
+    std::vector<std::pair<int, int>> freeRanges;  // (primeiro vértice, quantidade), ordenadas
+
+    // Culling na GPU
+    GLuint cullProgram = 0;
+    GLuint infoBuffer = 0, commandBuffer = 0;
+    // Contadores: o frame N usa counterBuffers[N % COUNTER_SLOTS] e copia o resultado para
+    // a mesma fatia de counterReadback (mapeado), com uma fence. As estatísticas vêm da
+    // fatia mais nova cuja fence já passou, alguns frames atrás, sem esperar a GPU
+    static const int COUNTER_SLOTS = 3;
+    GLuint counterBuffers[COUNTER_SLOTS] = {};
+    GLuint counterReadback = 0;
+    const GLuint* counterMapped = nullptr;
+    GLsync counterFences[COUNTER_SLOTS] = {};
+    int counterFrame = 0;
+    std::vector<GLuint> lastCounters;
+    std::vector<ChunkCullInfo> infos;
+    // Chunks a conferir no próximo syncGpuChunks: os que mudaram no mundo (pelo registro
+    // dele), os 26 vizinhos de cada um e os remalhados pelo caminho da CPU
+    std::vector<int> dirtyChunks;
+    std::vector<uint8_t> dirtyMark;
+    std::vector<int> changedInfos;
+    int remeshLeft = 0;   // o que resta do remeshBudget no frame
+
+    // Mesher na GPU
+    GpuMesher mesher;
+    GpuVolume* volume = nullptr;
+    std::vector<GpuMeshJob> meshJobs;
+    std::vector<PendingMesh> meshPending;
+
+    int dimX = -1, dimY = -1, dimZ = -1;
+    uint32_t worldGeneration = ~0u;
+    const World* trackedWorld = nullptr;   // de quem vem o registro de chunks mudados
+    std::vector<int> changedChunks;
+    std::vector<ChunkGPU> chunks;
+    // Chunks não vazios, em qualquer ordem: o culling na CPU só passa por eles
+    std::vector<int> occupiedChunks;
+    std::vector<int> occupiedSlot;   // posição em occupiedChunks, ou -1
+    std::vector<int8_t> chosenLod;
+    std::vector<uint8_t> chosenSkirt;
+    std::vector<int> visibleList;
+    std::vector<int> meshOrder;
+    ChunkMesh scratch;
+    ChunkRenderStats frameStats;
+};
+
+// Frustum a partir de proj * view (Gribb & Hartmann), planos com normal para dentro
+struct Frustum {
+    glm::vec4 planes[6];
+
+    explicit Frustum(const glm::mat4& viewProj);
+    bool intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+};
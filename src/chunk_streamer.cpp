@@ -0,0 +1,518 @@
+#include "chunk_streamer.h"
+#include "light.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+// Setores liberados nas regiões que fazem o update gravar as tabelas (só com o disco
+// parado), para os buracos voltarem a ser usados
+const uint32_t COMMIT_APOS_SETORES = 2048;
+
+// Lado em chunks das janelas da criação por gerador. Cada janela leva em volta uma borda
+// de um chunk só para a luz: ela anda no máximo LUZ_MAX - 1 voxels para o lado, então a
+// dos chunks de dentro sai igual à do mundo inteiro
+const int JANELA_CHUNKS = 8;
+static_assert(LUZ_MAX - 1 < CHUNK_TAM, "a borda da janela tem de cobrir o alcance da luz");
+
+static inline uint64_t tagDe(int indice, int slot) {
+    return ((uint64_t)indice << 16) | (uint64_t)slot;
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    if (io) {
+        vector<ChunkIOCompletion> resto;
+        io->drain(resto);
+    }
+}
+
+// Centro do chunk em voxels
+glm::vec3 ChunkStreamer::centroVoxels(int indice) const {
+    int x = indice % cx, z = (indice / cx) % cz, y = indice / (cx * cz);
+    return (glm::vec3(x, y, z) + 0.5f) * (float)CHUNK_TAM;
+}
+
+bool ChunkStreamer::abreArquivo(const string& path, World& world) {
+    if (!regioes.open(path)) {
+        cerr << "Falha ao abrir o mundo em " << path << endl;
+        return false;
+    }
+    caminho = path;
+    const int* tamanho = regioes.worldSize();
+    world.resize(tamanho[0], tamanho[1], tamanho[2], false);
+    cx = world.chunksX();
+    cy = world.chunksY();
+    cz = world.chunksZ();
+    origem = world.origin();
+    size_t n = (size_t)world.chunkCount();
+    estado.assign(n, AUSENTE);
+    versaoLimpa.assign(n, 0);
+    ultimoUso.assign(n, 0);
+    lruAnterior.assign(n, -1);
+    lruProximo.assign(n, -1);
+    lruCabeca = lruCauda = -1;
+    volta = 0;
+    orcamentoChunks = max<size_t>(1, memoryBudget / sizeof(Chunk));
+
+    if (!io)
+        io = createChunkIO(IO_AUTOMATICO, maxReads + maxWrites);
+    buffersLeitura.allocate((size_t)maxReads * CHUNK_REGISTRO);
+    buffersGravacao.allocate((size_t)maxWrites * CHUNK_REGISTRO);
+    leituraLivre.clear();
+    for (int s = maxReads - 1; s >= 0; s--)
+        leituraLivre.push_back(s);
+    gravacaoLivre.clear();
+    for (int s = maxWrites - 1; s >= 0; s--)
+        gravacaoLivre.push_back(s);
+    gravando.clear();
+    prontos.clear();
+
+    cout << "Streaming de " << path << ": " << tamanho[0] << "x" << tamanho[1] << "x" << tamanho[2] << ", " << n
+         << " chunks, ate " << orcamentoChunks << " na memoria (" << io->name() << ")" << endl;
+    return true;
+}
+
+bool ChunkStreamer::open(const string& path, World& world) {
+    return abreArquivo(path, world);
+}
+
+bool ChunkStreamer::create(const string& path, World& world) {
+    if (!io)
+        io = createChunkIO(IO_AUTOMATICO, maxReads + maxWrites);
+    if (!regioes.create(path, world, *io)) {
+        cerr << "Falha ao gravar o mundo em " << path << endl;
+        return false;
+    }
+    return abreArquivo(path, world);
+}
+
+bool ChunkStreamer::create(const string& path, const int size[3], const TerrainGenerator& generator, World& world) {
+    if (!io)
+        io = createChunkIO(IO_AUTOMATICO, maxReads + maxWrites);
+    if (!regioes.beginCreate(path, size)) {
+        cerr << "Falha ao gravar o mundo em " << path << endl;
+        return false;
+    }
+    int ncx = (size[0] + CHUNK_TAM - 1) / CHUNK_TAM, ncy = (size[1] + CHUNK_TAM - 1) / CHUNK_TAM,
+        ncz = (size[2] + CHUNK_TAM - 1) / CHUNK_TAM;
+    World janela;
+    LightEngine luz;
+    for (int jz = 0; jz < ncz; jz += JANELA_CHUNKS)
+        for (int jx = 0; jx < ncx; jx += JANELA_CHUNKS) {
+            // A borda é cortada nos limites do mundo: ali a janela acaba onde ele acaba
+            int bx0 = max(jx - 1, 0), bz0 = max(jz - 1, 0);
+            int bx1 = min(jx + JANELA_CHUNKS + 1, ncx), bz1 = min(jz + JANELA_CHUNKS + 1, ncz);
+            int x0 = bx0 * CHUNK_TAM, z0 = bz0 * CHUNK_TAM;
+            janela.resize(min(bx1 * CHUNK_TAM, size[0]) - x0, size[1], min(bz1 * CHUNK_TAM, size[2]) - z0);
+            generator(janela, x0, z0);
+            luz.relightAll(janela);
+
+            int fimX = min(jx + JANELA_CHUNKS, ncx), fimZ = min(jz + JANELA_CHUNKS, ncz);
+            for (int y = 0; y < ncy; y++)
+                for (int z = jz; z < fimZ; z++)
+                    for (int x = jx; x < fimX; x++)
+                        if (!regioes.put((y * ncz + z) * ncx + x, janela.chunk(x - bx0, y, z - bz0), *io)) {
+                            regioes.close();
+                            cerr << "Falha ao gravar o mundo em " << path << endl;
+                            return false;
+                        }
+        }
+    if (!regioes.finishCreate(*io)) {
+        cerr << "Falha ao gravar o mundo em " << path << endl;
+        return false;
+    }
+    return abreArquivo(path, world);
+}
+
+void ChunkStreamer::close(World& world) {
+    if (!regioes.isOpen())
+        return;
+    int gravados = flush(world);
+    // Leituras ainda no disco: os buffers só podem sumir depois delas
+    while (io->inFlight() > 0) {
+        concluidos.clear();
+        io->poll(concluidos, true);
+        recolheConcluidos();
+    }
+    prontos.clear();
+    RegionStats regiao = regioes.stats();
+    regioes.close();
+    cout << "Streaming fechado: " << contadores.loaded << " chunks lidos (" << contadores.prefetched
+         << " pela previsao, " << contadores.fromWriteBuffer << " do buffer de gravacao), " << contadores.evicted
+         << " descartados, " << contadores.writtenBack << " gravados (" << gravados << " na saida) | update max "
+         << contadores.updateMaxMs << " ms | regioes: " << regiao.usedSectors << " setores em uso, "
+         << regiao.freeSectors << " livres" << endl;
+}
+
+void ChunkStreamer::setCamera(const glm::vec3& position, const glm::vec3& front, const glm::vec3& velocity) {
+    lock_guard<mutex> lock(travaCamera);
+    cameraPos = position;
+    cameraFrente = front;
+    velocidade = velocity;
+}
+
+bool ChunkStreamer::busy() const {
+    return regioes.isOpen() && (io->inFlight() > 0 || !prontos.empty());
+}
+
+// --- LRU ---
+
+void ChunkStreamer::lruTira(int indice) {
+    int a = lruAnterior[indice], p = lruProximo[indice];
+    if (a >= 0)
+        lruProximo[a] = p;
+    else if (lruCabeca == indice)
+        lruCabeca = p;
+    if (p >= 0)
+        lruAnterior[p] = a;
+    else if (lruCauda == indice)
+        lruCauda = a;
+    lruAnterior[indice] = lruProximo[indice] = -1;
+}
+
+void ChunkStreamer::lruPoeNaFrente(int indice) {
+    if (lruCabeca == indice)
+        return;
+    lruTira(indice);
+    lruProximo[indice] = lruCabeca;
+    if (lruCabeca >= 0)
+        lruAnterior[lruCabeca] = indice;
+    lruCabeca = indice;
+    if (lruCauda < 0)
+        lruCauda = indice;
+}
+
+// --- Disco ---
+
+// Conclusões em concluidos: leituras viram chunks prontos, gravações liberam o slot
+void ChunkStreamer::recolheConcluidos() {
+    for (const ChunkIOCompletion& c : concluidos) {
+        int indice = (int)(c.tag >> 16), slot = (int)(c.tag & 0xFFFF);
+        if (c.op == IO_ESCRITA) {
+            auto g = gravando.find(indice);
+            // Conclusão repetida ou de uma gravação que não é nossa: o slot não é dela
+            if (g == gravando.end() || g->second.slot != slot) {
+                cerr << "Conclusao de gravacao inesperada: chunk " << indice << ", slot " << slot << endl;
+                continue;
+            }
+            if (c.result != (int64_t)regionSectors(g->second.bytes) * (int64_t)REGIAO_SETOR)
+                cerr << "Falha ao gravar o chunk " << indice << " no streaming" << endl;
+            gravacaoLivre.push_back(slot);
+            gravando.erase(g);
+            continue;
+        }
+        if (indice < 0 || indice >= (int)estado.size() || estado[indice] != LENDO) {
+            cerr << "Conclusao de leitura inesperada: chunk " << indice << ", slot " << slot << endl;
+            continue;
+        }
+        // A entrada na tabela não muda durante a leitura (só se grava o que está na memória)
+        int local;
+        RegionFile* regiao = regioes.region(indice, local);
+        uint32_t bytes = regiao ? regiao->entry(local).bytes : 0;
+        unique_ptr<Chunk> chunk = make_unique<Chunk>();
+        bool ok = c.result == (int64_t)regionSectors(bytes) * (int64_t)REGIAO_SETOR &&
+                  decodeChunkPayload(static_cast<const uint8_t*>(c.buffer), bytes, *chunk);
+        if (!ok) {
+            // Erro de leitura ou conteúdo estragado: vazio, como fora do mundo
+            cerr << "Falha ao ler o chunk " << indice << " no streaming" << endl;
+            decodeChunkPayload(nullptr, 0, *chunk);
+        }
+        leituraLivre.push_back(slot);
+        estado[indice] = PRONTO;
+        prontos.push_back({ indice, move(chunk) });
+    }
+    concluidos.clear();
+}
+
+// Os chunks em volta de centro (raio de carga): residentes vão para a frente da LRU,
+// ausentes para a fila de prioridade
+void ChunkStreamer::enfileiraEm(const glm::vec3& centro, const glm::vec3& camera, const glm::vec3& frente,
+                                bool previsto) {
+    int r = (int)ceil(loadRadius);
+    glm::ivec3 c0 = glm::ivec3(glm::floor(centro / (float)CHUNK_TAM));
+    float raio = loadRadius * CHUNK_TAM;
+    for (int y = max(0, c0.y - r); y <= min(cy - 1, c0.y + r); y++)
+        for (int z = max(0, c0.z - r); z <= min(cz - 1, c0.z + r); z++)
+            for (int x = max(0, c0.x - r); x <= min(cx - 1, c0.x + r); x++) {
+                int i = (y * cz + z) * cx + x;
+                glm::vec3 c = (glm::vec3(x, y, z) + 0.5f) * (float)CHUNK_TAM;
+                if (glm::length(c - centro) > raio)
+                    continue;
+                if (estado[i] == RESIDENTE) {
+                    ultimoUso[i] = volta;
+                    lruPoeNaFrente(i);
+                    continue;
+                }
+                if (estado[i] != AUSENTE)
+                    continue;
+                // Distância em chunks até a câmera; atrás dela conta em dobro, e o que
+                // só a previsão pede vem depois do que está em volta agora
+                glm::vec3 d = c - camera;
+                float distancia = glm::length(d) / CHUNK_TAM;
+                float frontal = distancia > 0.0f ? glm::dot(d, frente) / (distancia * CHUNK_TAM) : 1.0f;
+                float prioridade = distancia * (1.5f - 0.5f * frontal) * (previsto ? 1.25f : 1.0f);
+                fila.push({ prioridade, i, previsto });
+                desejados++;
+            }
+}
+
+// Lidos entram no mundo, os mais perto primeiro e no máximo installsPerUpdate por
+// update (não por quadro: o remeshBudget do renderer é que limita as malhas); os que
+// a câmera deixou para trás (além do raio de descarte) nem entram
+int ChunkStreamer::poeProntos(World& world, const glm::vec3& camera, float raioDescarte) {
+    if (prontos.empty())
+        return 0;
+    sort(prontos.begin(), prontos.end(), [&](const Lido& a, const Lido& b) {
+        return glm::length(centroVoxels(a.indice) - camera) < glm::length(centroVoxels(b.indice) - camera);
+    });
+    int postos = 0;
+    size_t k = 0;
+    for (; k < prontos.size() && postos < installsPerUpdate; k++) {
+        int i = prontos[k].indice;
+        if (glm::length(centroVoxels(i) - camera) > raioDescarte) {
+            estado[i] = AUSENTE;
+            continue;
+        }
+        world.installChunk(i, move(prontos[k].chunk));
+        versaoLimpa[i] = world.chunk(i % cx, i / (cx * cz), (i / cx) % cz).version;
+        estado[i] = RESIDENTE;
+        ultimoUso[i] = volta;
+        lruPoeNaFrente(i);
+        postos++;
+    }
+    prontos.erase(prontos.begin(), prontos.begin() + k);
+    return postos;
+}
+
+// Tira um residente; sujo, vai para um slot de gravação. false se não dá agora (sem
+// slot livre ou a gravação anterior do mesmo chunk ainda no disco)
+bool ChunkStreamer::tiraDoMundo(World& world, int indice) {
+    const World& leitura = world;
+    const Chunk& atual = leitura.chunk(indice % cx, indice / (cx * cz), (indice / cx) % cz);
+    bool sujo = atual.version != versaoLimpa[indice];
+    if (sujo && gravando.count(indice))
+        return false;
+
+    if (sujo && !gravaChunk(indice, atual))
+        return false;
+    world.evictChunk(indice);
+    estado[indice] = AUSENTE;
+    lruTira(indice);
+    if (sujo)
+        contadores.writtenBack++;
+    contadores.evicted++;
+    return true;
+}
+
+// Codifica o chunk num slot de gravação e pede o lugar novo na região (um pedido em
+// pedidos). Vazio, só sai da tabela. false sem slot livre ou sem a região
+bool ChunkStreamer::gravaChunk(int indice, const Chunk& chunk) {
+    int local;
+    RegionFile* regiao = regioes.region(indice, local);
+    if (!regiao || gravacaoLivre.empty())
+        return false;
+    int slot = gravacaoLivre.back();
+    uint8_t* buffer = buffersGravacao.data() + (size_t)slot * CHUNK_REGISTRO;
+    uint32_t bytes = encodeChunkPayload(chunk, buffer);
+    uint64_t offset = regiao->allocate(local, bytes);
+    if (bytes == 0)
+        return true;
+    uint32_t total = regionSectors(bytes) * (uint32_t)REGIAO_SETOR;
+    memset(buffer + bytes, 0, total - bytes);
+    gravacaoLivre.pop_back();
+    ChunkIORequest p;
+    p.op = IO_ESCRITA;
+    p.fd = regiao->descriptor();
+    p.offset = offset;
+    p.buffer = buffer;
+    p.bytes = total;
+    p.tag = tagDe(indice, slot);
+    pedidos.push_back(p);
+    gravando[indice] = { slot, bytes };
+    return true;
+}
+
+// Da cauda da LRU (menos usados) até o primeiro que este update quis: saem os além do
+// raio de descarte (da câmera e da previsão) e, acima do orçamento, qualquer um
+int ChunkStreamer::descarta(World& world, const glm::vec3& camera, const glm::vec3& prevista, bool usaPrevista,
+                            uint32_t voltaAtual) {
+    float raio = unloadRadius * CHUNK_TAM;
+    size_t ocupados = (size_t)world.residentCount() + prontos.size() + (size_t)(maxReads - (int)leituraLivre.size());
+    int tirados = 0;
+    pedidos.clear();
+    for (int i = lruCauda; i >= 0;) {
+        int anterior = lruAnterior[i];
+        if (ultimoUso[i] == voltaAtual)
+            break;
+        glm::vec3 c = centroVoxels(i);
+        bool longe = glm::length(c - camera) > raio && (!usaPrevista || glm::length(c - prevista) > raio);
+        if ((longe || ocupados > orcamentoChunks) && tiraDoMundo(world, i)) {
+            ocupados--;
+            tirados++;
+        }
+        i = anterior;
+    }
+    if (!pedidos.empty())
+        io->submit(pedidos.data(), pedidos.size());
+    return tirados;
+}
+
+// Tira da fila os mais urgentes enquanto houver slot de leitura e orçamento (residentes,
+// lidos por pôr e leituras no disco contam nele)
+void ChunkStreamer::pedeLeituras(World& world) {
+    pedidos.clear();
+    size_t ocupados = (size_t)world.residentCount() + prontos.size() + (size_t)(maxReads - (int)leituraLivre.size());
+    while (!fila.empty() && ocupados < orcamentoChunks) {
+        Pedido p = fila.top();
+        fila.pop();
+        if (estado[p.indice] != AUSENTE)
+            continue;
+        auto gravacao = gravando.find(p.indice);
+        int local;
+        RegionFile* regiao = regioes.region(p.indice, local);
+        if (gravacao != gravando.end() || !regiao || regiao->entry(local).bytes == 0) {
+            // Ainda no buffer de gravação, vazio na região (ou sem ela): sem ir ao disco
+            unique_ptr<Chunk> chunk = make_unique<Chunk>();
+            if (gravacao != gravando.end()) {
+                decodeChunkPayload(buffersGravacao.data() + (size_t)gravacao->second.slot * CHUNK_REGISTRO,
+                                   gravacao->second.bytes, *chunk);
+                contadores.fromWriteBuffer++;
+            }
+            else {
+                decodeChunkPayload(nullptr, 0, *chunk);
+                contadores.empty++;
+            }
+            estado[p.indice] = PRONTO;
+            prontos.push_back({ p.indice, move(chunk) });
+            ocupados++;
+            continue;
+        }
+        if (leituraLivre.empty())
+            break;
+        int slot = leituraLivre.back();
+        leituraLivre.pop_back();
+        const RegionEntry& e = regiao->entry(local);
+        ChunkIORequest r;
+        r.op = IO_LEITURA;
+        r.fd = regiao->descriptor();
+        r.offset = regiao->offsetOf(e);
+        r.buffer = buffersLeitura.data() + (size_t)slot * CHUNK_REGISTRO;
+        r.bytes = regionSectors(e.bytes) * (uint32_t)REGIAO_SETOR;
+        r.tag = tagDe(p.indice, slot);
+        pedidos.push_back(r);
+        estado[p.indice] = LENDO;
+        contadores.loaded++;
+        if (p.previsto)
+            contadores.prefetched++;
+        ocupados++;
+    }
+    // O que sobrou na fila volta a ser calculado no próximo update
+    fila = priority_queue<Pedido>();
+    if (!pedidos.empty())
+        io->submit(pedidos.data(), pedidos.size());
+}
+
+bool ChunkStreamer::update(World& world) {
+    if (!regioes.isOpen())
+        return false;
+    PERFIL_ESCOPO("streaming");
+    auto inicio = chrono::steady_clock::now();
+    uint64_t editsAntes = world.edits();
+    volta++;
+
+    glm::vec3 camera, frente, vel;
+    {
+        lock_guard<mutex> lock(travaCamera);
+        camera = cameraPos - origem;
+        frente = cameraFrente;
+        vel = velocidade;
+    }
+    // A previsão só vale quando a câmera anda mais de meio chunk no tempo dela
+    glm::vec3 prevista = camera + vel * prefetchSeconds;
+    bool usaPrevista = glm::length(prevista - camera) > CHUNK_TAM * 0.5f;
+
+    concluidos.clear();
+    io->poll(concluidos, false);
+    recolheConcluidos();
+    desejados = 0;
+    enfileiraEm(camera, camera, frente, false);
+    if (usaPrevista)
+        enfileiraEm(prevista, camera, frente, true);
+    poeProntos(world, camera, unloadRadius * CHUNK_TAM);
+    descarta(world, camera, prevista, usaPrevista, volta);
+    pedeLeituras(world);
+    if (gravando.empty() && regioes.pendingSectors() >= COMMIT_APOS_SETORES)
+        regioes.commit();
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+    contadores.resident = world.residentCount();
+    contadores.budget = (int)orcamentoChunks;
+    contadores.loading = maxReads - (int)leituraLivre.size();
+    contadores.ready = (int)prontos.size();
+    contadores.writing = (int)gravando.size();
+    contadores.wanted = desejados;
+    contadores.updateMs = ms;
+    contadores.updateMaxMs = max(contadores.updateMaxMs, ms);
+    {
+        lock_guard<mutex> lock(travaEstatisticas);
+        estatisticas = contadores;
+    }
+    return world.edits() != editsAntes;
+}
+
+int ChunkStreamer::flush(World& world) {
+    if (!regioes.isOpen())
+        return 0;
+    // Primeiro as gravações de descarte: o mesmo chunk não vai duas vezes ao disco
+    // ao mesmo tempo
+    while (!gravando.empty()) {
+        concluidos.clear();
+        io->poll(concluidos, true);
+        recolheConcluidos();
+    }
+    const World& leitura = world;
+    int gravados = 0;
+    pedidos.clear();
+    for (int i = lruCabeca; i >= 0; i = lruProximo[i]) {
+        const Chunk& c = leitura.chunk(i % cx, i / (cx * cz), (i / cx) % cz);
+        if (c.version == versaoLimpa[i])
+            continue;
+        while (gravacaoLivre.empty()) {
+            io->submit(pedidos.data(), pedidos.size());
+            pedidos.clear();
+            concluidos.clear();
+            io->poll(concluidos, true);
+            recolheConcluidos();
+        }
+        if (!gravaChunk(i, c))
+            continue;
+        versaoLimpa[i] = c.version;
+        gravados++;
+    }
+    io->submit(pedidos.data(), pedidos.size());
+    pedidos.clear();
+    while (!gravando.empty()) {
+        concluidos.clear();
+        io->poll(concluidos, true);
+        recolheConcluidos();
+    }
+    // Os conteúdos estão no disco: agora as tabelas
+    regioes.commit();
+    contadores.writtenBack += gravados;
+    contadores.writing = 0;
+    {
+        lock_guard<mutex> lock(travaEstatisticas);
+        estatisticas = contadores;
+    }
+    return gravados;
+}
+
+StreamingStats ChunkStreamer::stats() const {
+    lock_guard<mutex> lock(travaEstatisticas);
+    return estatisticas;
+}
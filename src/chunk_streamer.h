@@ -0,0 +1,168 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "chunk_io.h"
+#include "region_file.h"
+#include "world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct StreamingStats {
+    int resident = 0;             // chunks na memória
+    int budget = 0;               // máximo de chunks na memória
+    int loading = 0;              // leituras no disco
+    int ready = 0;                // lidos esperando a vez de entrar no mundo
+    int writing = 0;              // gravações no disco
+    int wanted = 0;               // dentro do raio (ou da previsão) e ainda fora
+    long long loaded = 0;
+    long long prefetched = 0;     // pedidos pela posição prevista, não pela atual
+    long long evicted = 0;
+    long long writtenBack = 0;    // sujos gravados ao sair (e no flush)
+    long long fromWriteBuffer = 0;  // voltaram antes da gravação terminar
+    long long empty = 0;          // vazios na região: nem vão ao disco
+    double updateMs = 0.0;        // último update
+    double updateMaxMs = 0.0;
+};
+
+// Streaming de chunks em volta da câmera, para mundos maiores que a memória. O mundo
+// fica num diretório de regiões (RegionStore) e na memória só os chunks perto da
+// câmera: o World começa sem nenhum residente e update() põe e tira chunks.
+//
+// A cada update, os chunks dentro de loadRadius da câmera e da posição prevista pela
+// velocidade (prefetchSeconds adiante) são pedidos numa fila de prioridade: mais
+// perto primeiro, os da frente da câmera antes dos de trás, os só da previsão depois
+// dos da posição atual. As leituras saem em lotes pelo ChunkIO e entram no mundo no
+// máximo installsPerUpdate por update (vários updates podem cair no mesmo snapshot;
+// quem limita as malhas refeitas por quadro na thread de render é o remeshBudget do
+// ChunkRenderer). Os residentes usados no update vão para a frente de uma lista LRU;
+// saem os que passaram de unloadRadius (histerese: entre os dois raios ficam) e,
+// acima do orçamento de memória, os mais antigos da LRU que o update não quis. Um
+// chunk que mudou desde a leitura volta para o disco ao sair (um lugar novo na região,
+// a tabela vai para o disco no flush); se for pedido de novo antes da gravação
+// terminar, volta do próprio buffer.
+//
+// setCamera é da thread principal; o resto é da thread do mundo (dona do World)
+class ChunkStreamer {
+public:
+    ChunkStreamer() = default;
+    ~ChunkStreamer();
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    // Abre as regiões do diretório e redimensiona world para o tamanho gravado, sem
+    // residentes
+    bool open(const std::string& path, World& world);
+    // Grava o mundo inteiro em regiões novas (lotes sequenciais com O_DIRECT), tira
+    // todos os chunks da memória e segue como open
+    bool create(const std::string& path, World& world);
+    // Preenche janela, um mundo com a altura toda e as colunas de voxels a partir de
+    // (x0, z0) do mundo sendo criado
+    using TerrainGenerator = std::function<void(World& janela, int x0, int z0)>;
+    // Cria as regiões de um mundo de size voxels sem tê-lo inteiro na memória: gera uma
+    // janela de colunas de chunks por vez, calcula a luz dela e a grava. Segue como open
+    bool create(const std::string& path, const int size[3], const TerrainGenerator& generator, World& world);
+    // Grava os sujos e as tabelas, espera o disco e fecha
+    void close(World& world);
+    bool active() const { return regioes.isOpen(); }
+
+    // Câmera em coordenadas de mundo (as do editor) e velocidade em unidades/s
+    void setCamera(const glm::vec3& position, const glm::vec3& front, const glm::vec3& velocity);
+
+    // Recolhe o disco, põe os chunks lidos, tira os que sobram e pede os próximos.
+    // Devolve true se o mundo mudou (há o que publicar)
+    bool update(World& world);
+    // Grava todos os residentes sujos e as tabelas das regiões e espera. Devolve quantos
+    // gravou
+    int flush(World& world);
+    // Leituras, gravações ou chunks lidos por pôr: vale chamar update logo
+    bool busy() const;
+
+    // Raios em chunks
+    float loadRadius = 8.0f;
+    float unloadRadius = 10.0f;
+    float prefetchSeconds = 0.75f;
+    size_t memoryBudget = (size_t)256 << 20;
+    int installsPerUpdate = 16;
+    int maxReads = 64;            // leituras no disco ao mesmo tempo
+    int maxWrites = 64;
+
+    // Cópia, segura de qualquer thread (o HUD lê da thread de render)
+    StreamingStats stats() const;
+
+private:
+    enum Estado : uint8_t { AUSENTE, LENDO, PRONTO, RESIDENTE };
+
+    struct Pedido {
+        float prioridade;
+        int indice;
+        bool previsto;
+        bool operator<(const Pedido& outro) const { return prioridade > outro.prioridade; }   // menor primeiro
+    };
+    struct Lido {
+        int indice;
+        std::unique_ptr<Chunk> chunk;
+    };
+    struct Gravacao {
+        int slot;
+        uint32_t bytes;          // tamanho do conteúdo codificado no slot
+    };
+
+    bool abreArquivo(const std::string& path, World& world);
+    glm::vec3 centroVoxels(int indice) const;
+    void recolheConcluidos();
+    void enfileiraEm(const glm::vec3& centro, const glm::vec3& camera, const glm::vec3& frente, bool previsto);
+    int poeProntos(World& world, const glm::vec3& camera, float raioDescarte);
+    int descarta(World& world, const glm::vec3& camera, const glm::vec3& prevista, bool usaPrevista,
+                 uint32_t voltaAtual);
+    bool tiraDoMundo(World& world, int indice);
+    bool gravaChunk(int indice, const Chunk& chunk);
+    void pedeLeituras(World& world);
+
+    // LRU intrusiva sobre os índices residentes (cabeça = mais recente)
+    void lruTira(int indice);
+    void lruPoeNaFrente(int indice);
+
+    std::string caminho;
+    RegionStore regioes;
+    std::unique_ptr<ChunkIO> io;
+    int cx = 0, cy = 0, cz = 0;
+    glm::vec3 origem = glm::vec3(0.0f);
+    size_t orcamentoChunks = 0;
+
+    std::vector<uint8_t> estado;
+    std::vector<uint32_t> versaoLimpa;   // version do chunk quando bateu com o disco
+    std::vector<uint32_t> ultimoUso;     // volta do update que o quis por último
+    std::vector<int> lruAnterior, lruProximo;
+    int lruCabeca = -1, lruCauda = -1;
+    uint32_t volta = 0;
+
+    // Buffers alinhados: slots de leitura e de gravação. As tags das conclusões levam
+    // o slot nos 16 bits de baixo e o índice do chunk acima
+    AlignedBuffer buffersLeitura, buffersGravacao;
+    std::vector<int> leituraLivre, gravacaoLivre;
+    std::unordered_map<int, Gravacao> gravando;   // índice do chunk -> slot de gravação
+    std::vector<Lido> prontos;
+    std::priority_queue<Pedido> fila;
+    std::vector<ChunkIORequest> pedidos;
+    std::vector<ChunkIOCompletion> concluidos;
+    int desejados = 0;
+
+    // Câmera da thread principal
+    mutable std::mutex travaCamera;
+    glm::vec3 cameraPos = glm::vec3(0.0f), cameraFrente = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 velocidade = glm::vec3(0.0f);
+
+    // contadores é da thread do mundo; estatisticas, a cópia que stats() lê
+    StreamingStats contadores;
+    mutable std::mutex travaEstatisticas;
+    StreamingStats estatisticas;
+};
@@ -0,0 +1,117 @@
+#include "edit_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+void EditQueue::push(const EditCommand& comando) {
+    if (!anel.push(comando)) {
+        esperasCheia.fetch_add(1, memory_order_relaxed);
+        do {
+            this_thread::yield();
+        } while (!anel.push(comando));
+    }
+    // A cauda publicada antes de ler "dormindo" (seq_cst dos dois lados): ou o
+    // consumidor já vê o comando ao conferir a fila, ou o produtor o vê dormindo
+    atomic_thread_fence(memory_order_seq_cst);
+    if (dormindo.load(memory_order_relaxed)) {
+        lock_guard<mutex> lock(trava);
+        acorda.notify_one();
+    }
+}
+
+void EditQueue::wait(double timeout) {
+    unique_lock<mutex> lock(trava);
+    dormindo.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (anel.size() == 0 && !closed() && !acordar.load(memory_order_relaxed))
+        acorda.wait_for(lock, chrono::duration<double>(timeout));
+    dormindo.store(false, memory_order_relaxed);
+    acordar.store(false, memory_order_relaxed);
+}
+
+// Mesmo aperto de mão do push, com o pedido no lugar do comando
+void EditQueue::wake() {
+    acordar.store(true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (dormindo.load(memory_order_relaxed)) {
+        lock_guard<mutex> lock(trava);
+        acorda.notify_one();
+    }
+}
+
+void EditQueue::close() {
+    fechada.store(true, memory_order_release);
+    lock_guard<mutex> lock(trava);
+    acorda.notify_one();
+}
+
+bool EditBatcher::add(World& world, const EditCommand& comando) {
+    if (comando.type == EDICAO_LIMPA || comando.type == EDICAO_SALVA || comando.type == EDICAO_CARREGA)
+        return false;
+    estatisticas.commands++;
+
+    if (comando.type == EDICAO_PREENCHE) {
+        flush(world);
+        int x0 = min(comando.x, comando.x1), y0 = min(comando.y, comando.y1), z0 = min(comando.z, comando.z1);
+        int x1 = max(comando.x, comando.x1), y1 = max(comando.y, comando.y1), z1 = max(comando.z, comando.z1);
+        estatisticas.chunksMarked += world.fill(x0, y0, z0, x1, y1, z1, comando.value);
+        estatisticas.fills++;
+        return true;
+    }
+
+    if (!world.inside(comando.x, comando.y, comando.z))
+        return true;
+    uint64_t celula = (uint64_t)(((int64_t)comando.y * world.sizeZ() + comando.z) * world.sizeX() + comando.x);
+    auto achado = posicao.find(celula);
+    uint8_t voxel;
+    if (achado != posicao.end()) {
+        voxel = pendentes[achado->second].voxel;
+        estatisticas.coalesced++;
+    }
+    else {
+        voxel = world.get(comando.x, comando.y, comando.z);
+    }
+
+    switch (comando.type) {
+    case EDICAO_VISIVEL:
+        voxel = comando.value ? (voxel | VOXEL_VISIVEL) : (voxel & VOXEL_TEXTURA);
+        break;
+    case EDICAO_TEXTURA:
+        voxel = (uint8_t)((voxel & VOXEL_VISIVEL) | (comando.value & VOXEL_TEXTURA));
+        ultimaTextura = comando.value & VOXEL_TEXTURA;
+        break;
+    case EDICAO_PROXIMA_TEXTURA:
+        ultimaTextura = comando.value > 0 ? (voxelTextura(voxel) + 1) % comando.value : 0;
+        voxel = (uint8_t)((voxel & VOXEL_VISIVEL) | ultimaTextura);
+        break;
+    default:
+        break;
+    }
+
+    if (achado != posicao.end()) {
+        pendentes[achado->second].voxel = voxel;
+    }
+    else {
+        posicao.emplace(celula, (uint32_t)pendentes.size());
+        pendentes.push_back({ comando.x, comando.y, comando.z, voxel });
+    }
+    return true;
+}
+
+void EditBatcher::flush(World& world) {
+    if (pendentes.empty())
+        return;
+    estatisticas.chunksMarked += world.applyWrites(pendentes.data(), pendentes.size());
+    estatisticas.cellsWritten += (long long)pendentes.size();
+    pendentes.clear();
+    posicao.clear();
+}
+
+int EditBatcher::takeLastTexture() {
+    int textura = ultimaTextura;
+    ultimaTextura = -1;
+    return textura;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "world.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Edições do mundo como comandos: os callbacks de entrada não mexem no World, só
+// empurram comandos numa fila de um produtor e um consumidor (a thread do mundo), que
+// os aplica em lotes. É o ponto único por onde toda edição passa (desfazer, diário e
+// rede entram aqui)
+
+enum EditType : uint8_t {
+    EDICAO_VISIVEL = 0,          // value = 1 mostra, 0 esconde (mantém a textura)
+    EDICAO_TEXTURA = 1,          // value = textura (mantém a visibilidade)
+    EDICAO_PROXIMA_TEXTURA = 2,  // textura + 1, módulo value (T)
+    EDICAO_PREENCHE = 3,         // caixa x0..x1 com o voxel value
+    EDICAO_LIMPA = 4,            // mundo todo vazio (R)
+    EDICAO_SALVA = 5,            // grava o .dat (Ctrl+S)
+    EDICAO_CARREGA = 6,          // lê o .dat, talvez com outro tamanho (Ctrl+L)
+};
+
+struct EditCommand {
+    EditType type = EDICAO_VISIVEL;
+    uint8_t value = 0;
+    int32_t x = 0, y = 0, z = 0;
+    int32_t x1 = 0, y1 = 0, z1 = 0;  // canto oposto (EDICAO_PREENCHE)
+};
+
+// Anel sem trava para exatamente um produtor e um consumidor. A capacidade é uma
+// potência de dois; os índices só crescem (a posição é o índice & máscara). Cada lado
+// guarda uma cópia do índice do outro e só relê o atômico quando ela não basta, para
+// não disputar a linha de cache a cada operação
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacidadeMinima) {
+        size_t capacidade = 2;
+        while (capacidade < capacidadeMinima)
+            capacidade *= 2;
+        itens.resize(capacidade);
+        mascara = capacidade - 1;
+    }
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Produtor. Devolve false com o anel cheio
+    bool push(const T& item) {
+        size_t fim = cauda.load(std::memory_order_relaxed);
+        if (fim - cabecaVista == itens.size()) {
+            cabecaVista = cabeca.load(std::memory_order_acquire);
+            if (fim - cabecaVista == itens.size())
+                return false;
+        }
+        itens[fim & mascara] = item;
+        cauda.store(fim + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumidor: tira até max itens de uma vez. Devolve quantos
+    size_t pop(T* saida, size_t max) {
+        size_t inicio = cabeca.load(std::memory_order_relaxed);
+        if (caudaVista == inicio)
+            caudaVista = cauda.load(std::memory_order_acquire);
+        size_t n = caudaVista - inicio;
+        if (n > max)
+            n = max;
+        for (size_t i = 0; i < n; i++)
+            saida[i] = itens[(inicio + i) & mascara];
+        if (n > 0)
+            cabeca.store(inicio + n, std::memory_order_release);
+        return n;
+    }
+
+    // Aproximado fora das duas threads
+    size_t size() const { return cauda.load(std::memory_order_acquire) - cabeca.load(std::memory_order_acquire); }
+    size_t capacity() const { return itens.size(); }
+
+private:
+    std::vector<T> itens;
+    size_t mascara = 0;
+    alignas(64) std::atomic<size_t> cabeca{ 0 };   // escrita pelo consumidor
+    size_t caudaVista = 0;                          // cópia do consumidor
+    alignas(64) std::atomic<size_t> cauda{ 0 };    // escrita pelo produtor
+    size_t cabecaVista = 0;                         // cópia do produtor
+};
+
+// Fila de edições: o anel mais o sono da thread do mundo. push e pop não travam; o
+// mutex só serve para o consumidor dormir com a fila vazia (e o produtor o acordar)
+class EditQueue {
+public:
+    explicit EditQueue(size_t capacidade = 4096) : anel(capacidade) {}
+
+    // Produtor: com o anel cheio espera o consumidor abrir espaço
+    void push(const EditCommand& comando);
+    // Consumidor: até max comandos, sem esperar
+    size_t pop(EditCommand* saida, size_t max) { return anel.pop(saida, max); }
+    // Consumidor: dorme até chegar um comando, a fila fechar, wake() ou timeout segundos
+    void wait(double timeout);
+    // Acorda o consumidor sem comando (a câmera andou e o streaming tem o que fazer)
+    void wake();
+
+    // Depois de fechada o consumidor ainda esvazia o que ficou
+    void close();
+    bool closed() const { return fechada.load(std::memory_order_acquire); }
+
+    size_t size() const { return anel.size(); }
+    long long fullWaits() const { return esperasCheia.load(std::memory_order_relaxed); }
+
+private:
+    SpscQueue<EditCommand> anel;
+    std::mutex trava;
+    std::condition_variable acorda;
+    std::atomic<bool> dormindo{ false };
+    std::atomic<bool> acordar{ false };
+    std::atomic<bool> fechada{ false };
+    std::atomic<long long> esperasCheia{ 0 };
+};
+
+struct EditBatchStats {
+    long long commands = 0;
+    long long coalesced = 0;        // comandos pontuais sobre uma célula já pendente no lote
+    long long cellsWritten = 0;     // células escritas (as pontuais depois de juntar)
+    long long fills = 0;
+    long long chunksMarked = 0;     // marcações de chunk (uma por chunk por escrita em lote)
+};
+
+// Aplica comandos pontuais e caixas ao mundo em lote. Os pontuais sobre a mesma
+// célula se juntam (vale o estado final, resolvido na ordem de chegada, inclusive o
+// "próxima textura" que depende do valor anterior); flush escreve tudo de uma vez com
+// World::applyWrites. Uma caixa escreve direto com World::fill, depois de um flush,
+// para manter a ordem. Limpar, salvar e carregar ficam com quem chama, também depois
+// de um flush
+class EditBatcher {
+public:
+    // Devolve false para os comandos que não são de voxel (limpar, salvar, carregar)
+    bool add(World& world, const EditCommand& comando);
+    void flush(World& world);
+
+    // Textura da última edição de textura aplicada (-1 se nenhuma desde a última chamada)
+    int takeLastTexture();
+
+    const EditBatchStats& stats() const { return estatisticas; }
+
+private:
+    std::vector<VoxelWrite> pendentes;
+    std::unordered_map<uint64_t, uint32_t> posicao;   // célula -> índice em pendentes
+    EditBatchStats estatisticas;
+    int ultimaTextura = -1;
+};
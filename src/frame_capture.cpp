@@ -0,0 +1,261 @@
+#include "frame_capture.h"
+#include "gl_ext.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+// STB_IMAGE_WRITE (o editor só grava imagens por aqui)
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+using namespace std;
+
+static double msDesde(chrono::steady_clock::time_point inicio) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - inicio).count();
+}
+
+bool saveFrame(const string& path, int width, int height, const uint8_t* rgba) {
+    size_t ponto = path.find_last_of('.');
+    string extensao = ponto == string::npos ? "" : path.substr(ponto);
+    if (extensao == ".png" || extensao == ".PNG")
+        return stbi_write_png(path.c_str(), width, height, 4, rgba, width * 4) != 0;
+
+    FILE* arquivo = fopen(path.c_str(), "wb");
+    if (!arquivo)
+        return false;
+    size_t bytes = (size_t)width * height * 4;
+    bool ok = fwrite(rgba, 1, bytes, arquivo) == bytes;
+    fclose(arquivo);
+    return ok;
+}
+
+FrameCapture::~FrameCapture() {
+    // Sem contexto de GL aqui: só encerra a thread (destroy() libera o resto)
+    if (writer.joinable()) {
+        {
+            lock_guard<mutex> lock(trava);
+            parar = true;
+        }
+        cond.notify_all();
+        writer.join();
+    }
+}
+
+void FrameCapture::setup(int width, int height, int ringSize) {
+    largura = width;
+    altura = height;
+
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "Framebuffer de captura incompleto!" << endl;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    const GLsizeiptr bytes = (GLsizeiptr)width * height * 4;
+    slots.clear();
+    for (int i = 0; i < ringSize; i++) {
+        slots.push_back(make_unique<Slot>());
+        Slot& slot = *slots.back();
+        glGenBuffers(1, &slot.pbo);
+        // O contexto é 4.5 (glBufferStorage é do núcleo desde o 4.4): o PBO fica mapeado
+        // do setup ao destroy e a thread de gravação lê dele direto
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_PIXEL_PACK_BUFFER, bytes, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+        slot.mapped = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, flags);
+        if (!slot.mapped)
+            cerr << "Falha ao mapear o PBO de captura" << endl;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    next = 0;
+    lendo.clear();
+    fila.clear();
+    estatisticas = FrameCaptureStats();
+    parar = false;
+    writer = thread(&FrameCapture::writerLoop, this);
+}
+
+void FrameCapture::destroy() {
+    if (!fbo)
+        return;
+    poll(true);
+    {
+        lock_guard<mutex> lock(trava);
+        parar = true;
+    }
+    cond.notify_all();
+    writer.join();
+
+    for (unique_ptr<Slot>& slot : slots) {
+        if (slot->fence)
+            glDeleteSync(slot->fence);
+        if (slot->mapped) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->pbo);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glDeleteBuffers(1, &slot->pbo);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slots.clear();
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    fbo = colorBuffer = 0;
+}
+
+void FrameCapture::medeRender(double ms) {
+    lock_guard<mutex> lock(trava);
+    estatisticas.renderMs += ms;
+    estatisticas.renderMaxMs = max(estatisticas.renderMaxMs, ms);
+    estatisticas.renderCalls++;
+}
+
+FrameCaptureStats FrameCapture::stats() const {
+    lock_guard<mutex> lock(trava);
+    return estatisticas;
+}
+
+bool FrameCapture::capture(const string& path, GLuint source) {
+    PERFIL_ESCOPO("captura");
+    auto inicio = chrono::steady_clock::now();
+
+    // Os slots são usados em ordem: o próximo é sempre o mais antigo
+    Slot& slot = *slots[next];
+    if (slot.state != SLOT_LIVRE) {
+        if (dropWhenBusy) {
+            {
+                lock_guard<mutex> lock(trava);
+                estatisticas.dropped++;
+            }
+            medeRender(msDesde(inicio));
+            return false;
+        }
+        if (slot.state == SLOT_LENDO)
+            handOff(lendo.front());
+        unique_lock<mutex> lock(trava);
+        estatisticas.stalls++;
+        slotLivre.wait(lock, [&]() { return slot.state == SLOT_LIVRE; });
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source);
+    glReadBuffer(source ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    // BGRA é o formato nativo do framebuffer na maioria dos drivers: a cópia não converte
+    glReadPixels(0, 0, largura, altura, GL_BGRA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.path = path;
+    slot.state = SLOT_LENDO;
+    // Sem flush a fence pode nunca chegar à GPU e o poll sem espera não avança
+    glFlush();
+
+    lendo.push_back(next);
+    next = (next + 1) % (int)slots.size();
+    {
+        lock_guard<mutex> lock(trava);
+        estatisticas.captured++;
+    }
+    medeRender(msDesde(inicio));
+    return true;
+}
+
+int FrameCapture::poll(bool wait) {
+    auto inicio = chrono::steady_clock::now();
+    int entregues = 0;
+    while (!lendo.empty()) {
+        Slot& slot = *slots[lendo.front()];
+        if (!wait) {
+            GLenum estado = glClientWaitSync(slot.fence, 0, 0);
+            if (estado != GL_ALREADY_SIGNALED && estado != GL_CONDITION_SATISFIED)
+                break;
+        }
+        handOff(lendo.front());
+        entregues++;
+    }
+    if (wait) {
+        // Até a última gravação terminar
+        unique_lock<mutex> lock(trava);
+        slotLivre.wait(lock, [&]() {
+            return all_of(slots.begin(), slots.end(), [](const unique_ptr<Slot>& s) { return s->state == SLOT_LIVRE; });
+        });
+    }
+    else if (entregues > 0) {
+        medeRender(msDesde(inicio));
+    }
+    return entregues;
+}
+
+// Entrega o slot mais antigo em leitura à thread de gravação, esperando a fence se
+// ela ainda não passou. O mapeamento é persistente e coerente: basta a fence, e o PBO
+// é da thread de gravação até ela devolver o slot
+void FrameCapture::handOff(int index) {
+    Slot& slot = *slots[index];
+    glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    lendo.pop_front();
+    {
+        lock_guard<mutex> lock(trava);
+        slot.state = SLOT_GRAVANDO;
+        fila.push_back(index);
+    }
+    cond.notify_one();
+}
+
+// Thread de gravação: vira as linhas (o GL lê de baixo para cima), troca BGRA por
+// RGBA, comprime e grava
+void FrameCapture::writerLoop() {
+    profilerThreadName("gravacao");
+    const size_t linha = (size_t)largura * 4;
+    vector<uint8_t> pixels(linha * altura);
+    for (;;) {
+        int index;
+        {
+            unique_lock<mutex> lock(trava);
+            cond.wait(lock, [&]() { return parar || !fila.empty(); });
+            if (fila.empty())
+                return;
+            index = fila.front();
+            fila.pop_front();
+        }
+
+        PERFIL_ESCOPO("gravacao");
+        Slot& slot = *slots[index];
+        auto inicio = chrono::steady_clock::now();
+        const uint8_t* dados = slot.mapped;
+        bool ok = dados != nullptr;
+        if (ok) {
+            for (int y = 0; y < altura; y++) {
+                const uint8_t* origem = dados + (size_t)(altura - 1 - y) * linha;
+                uint8_t* destino = &pixels[(size_t)y * linha];
+                for (size_t i = 0; i < linha; i += 4) {
+                    destino[i] = origem[i + 2];
+                    destino[i + 1] = origem[i + 1];
+                    destino[i + 2] = origem[i];
+                    destino[i + 3] = origem[i + 3];
+                }
+            }
+            ok = saveFrame(slot.path, largura, altura, pixels.data());
+        }
+        if (!ok)
+            cerr << "Falha ao gravar " << slot.path << endl;
+
+        {
+            lock_guard<mutex> lock(trava);
+            estatisticas.written += ok ? 1 : 0;
+            estatisticas.writeMs += msDesde(inicio);
+            slot.state = SLOT_LIVRE;
+        }
+        slotLivre.notify_all();
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FrameCaptureStats {
+    int captured = 0;        // leituras enfileiradas
+    int written = 0;         // arquivos gravados
+    int dropped = 0;         // frames descartados com o anel cheio (dropWhenBusy)
+    int stalls = 0;          // leituras que tiveram de esperar a GPU ou a gravação (anel cheio)
+    double renderMs = 0.0;   // tempo na thread de renderização (capture + poll, acumulado)
+    double renderMaxMs = 0.0;
+    int renderCalls = 0;     // frames com capture ou poll medidos
+    double writeMs = 0.0;    // codificar e gravar os arquivos na thread de gravação (acumulado)
+};
+
+// Leitura de frames sem travar a renderização. capture() só enfileira um glReadPixels
+// para o próximo PBO livre de um anel (a cópia roda na GPU em paralelo com os frames
+// seguintes) e uma fence; poll() passa para a thread de gravação as leituras cuja
+// fence já passou, sem esperar. Os PBOs ficam mapeados de forma persistente (o contexto
+// é 4.5) e a thread de gravação lê direto deles: a thread de renderização nunca copia
+// pixels. Virar as linhas, comprimir o PNG e gravar acontecem todos na thread de
+// gravação, e o PBO só volta ao anel quando o arquivo foi gravado.
+//
+// Com o anel cheio (a gravação não acompanha), dropWhenBusy descarta o frame (captura
+// contínua interativa); senão espera o slot mais antigo (modo --headless, que precisa
+// de todos os frames). Arquivos .png saem pelo stb_image_write; qualquer outra
+// extensão grava os bytes RGBA crus, linha 0 no topo
+class FrameCapture {
+public:
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    ~FrameCapture();
+
+    void setup(int width, int height, int ringSize = 4);
+    // Espera as gravações pendentes e libera os objetos de GL
+    void destroy();
+    bool ready() const { return fbo != 0; }
+
+    // Framebuffer próprio (destino do frame no modo --headless)
+    GLuint framebuffer() const { return fbo; }
+    int width() const { return largura; }
+    int height() const { return altura; }
+
+    // Lê o frame de source (0 = back buffer da janela). Devolve false se descartou
+    bool capture(const std::string& path, GLuint source);
+    // Entrega à gravação as leituras prontas (todas, esperando a GPU e a gravação, se
+    // wait). Devolve quantas entregou
+    int poll(bool wait);
+    // Leituras ainda esperando a GPU (precisam de poll para chegar à gravação)
+    int pending() const { return (int)lendo.size(); }
+
+    bool dropWhenBusy = false;
+
+    FrameCaptureStats stats() const;
+
+private:
+    enum SlotState { SLOT_LIVRE, SLOT_LENDO, SLOT_GRAVANDO };
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        const uint8_t* mapped = nullptr;   // mapeamento persistente
+        std::string path;
+        std::atomic<int> state{ SLOT_LIVRE };
+    };
+
+    void handOff(int index);
+    void writerLoop();
+    void medeRender(double ms);
+
+    int largura = 0, altura = 0;
+    GLuint fbo = 0, colorBuffer = 0;
+    std::vector<std::unique_ptr<Slot>> slots;
+    int next = 0;                          // próximo slot a ler
+    std::deque<int> lendo;                 // slots com leitura na GPU, em ordem
+
+    // Thread de gravação
+    std::thread writer;
+    mutable std::mutex trava;
+    std::condition_variable cond;
+    std::condition_variable slotLivre;
+    std::deque<int> fila;                  // slots prontos para gravar
+    bool parar = false;
+    FrameCaptureStats estatisticas;
+};
+
+// Grava RGBA (linha 0 no topo) em .png ou cru, pela extensão
+bool saveFrame(const std::string& path, int width, int height, const uint8_t* rgba);
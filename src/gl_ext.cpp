@@ -0,0 +1,53 @@
+#include "gl_ext.h"
+
+#include <cstring>
+
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = nullptr;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC glad_glMultiDrawElementsIndirectCount = nullptr;
+PFNGLCLEARBUFFERDATAPROC glad_glClearBufferData = nullptr;
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = nullptr;
+
+GLExtSupport glExt;
+
+static bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (ext && strcmp(ext, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+bool loadGLExtensions(GLADloadproc load) {
+    glExt = GLExtSupport();
+    int version = GLVersion.major * 10 + GLVersion.minor;
+
+    // O loader pode devolver ponteiros para funções que o contexto não expõe,
+    // por isso a versão/extensão é conferida antes
+    if (version >= 43 || (hasExtension("GL_ARB_compute_shader") &&
+                          hasExtension("GL_ARB_shader_storage_buffer_object") &&
+                          hasExtension("GL_ARB_multi_draw_indirect"))) {
+        glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+        glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)load("glMemoryBarrier");
+        glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC)load("glMultiDrawElementsIndirect");
+        glad_glClearBufferData = (PFNGLCLEARBUFFERDATAPROC)load("glClearBufferData");
+        glExt.compute = glad_glDispatchCompute && glad_glMemoryBarrier &&
+                        glad_glMultiDrawElementsIndirect && glad_glClearBufferData;
+    }
+
+    if (version >= 46)
+        glad_glMultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)load("glMultiDrawElementsIndirectCount");
+    else if (hasExtension("GL_ARB_indirect_parameters"))
+        glad_glMultiDrawElementsIndirectCount = (PFNGLMULTIDRAWELEMENTSINDIRECTCOUNTPROC)load("glMultiDrawElementsIndirectCountARB");
+    glExt.indirectCount = glExt.compute && glad_glMultiDrawElementsIndirectCount;
+
+    if (version >= 44 || hasExtension("GL_ARB_buffer_storage"))
+        glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)load("glBufferStorage");
+    glExt.bufferStorage = glad_glBufferStorage != nullptr;
+
+    return glExt.compute;
+}
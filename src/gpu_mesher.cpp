@@ -0,0 +1,357 @@
+#include "gpu_mesher.h"
+#include "gl_ext.h"
+#include "materials.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <string>
+
+using namespace std;
+
+// Mesmas unidades de textura do raymarching (a fila não usa)
+const int UNIDADE_VOXELS = 2;
+const int UNIDADE_OCUPACAO = 3;
+const int UNIDADE_LUZ = 4;
+
+// Máximo de work groups por dispatch garantido pelo GL
+const size_t MAX_GRUPOS = 65535;
+
+// Job na GPU (std430): chunk.xyz + LOD, e primeiro vértice, quads opacos, quads de
+// saia e índice dos argumentos (só no emit)
+struct JobGPU {
+    GLint chunk[4];
+    GLint mesh[4];
+};
+
+// Segue meshChunk: células do LOD com borda de 1, voto de maioria nos LODs reduzidos,
+// faceVisible, oclusão dos cantos, luz da célula da frente e as três faixas. FACE_CORNERS igual ao do mesher da CPU
+static const char* meshShaderBody = R"glsl(
+    layout (local_size_x = 64) in;
+
+    struct Job {
+        ivec4 chunk;   // xyz = chunk, w = LOD
+        ivec4 mesh;    // primeiro vértice, quads opacos, quads de saia, índice dos argumentos
+    };
+
+    layout (std430, binding = 0) readonly buffer Jobs { Job jobs[]; };
+    layout (std430, binding = 1) writeonly buffer Counts { uvec4 counts[]; };
+    layout (std430, binding = 2) writeonly buffer Vertices { uint vertices[]; };
+    layout (std430, binding = 3) writeonly buffer Args { uvec4 args[]; };
+
+    uniform usampler3D voxels;
+    uniform usampler3D occupancy;
+    uniform usampler3D light;
+    uniform ivec3 gridSize;
+    uniform uint transparentMask;
+    uniform bool emitVertices;
+    uniform uint jobOffset;
+
+    const int P_MAX = CHUNK_TAM + 2;
+    // Bits 0-7: valor do voxel (como voxelAt), bits 8-15: luz
+    shared uint cells[P_MAX * P_MAX * P_MAX];
+    shared uint quadCount[3];
+
+    const ivec3 FACE_DIR[6] = ivec3[6](ivec3(1, 0, 0), ivec3(-1, 0, 0), ivec3(0, 1, 0),
+                                       ivec3(0, -1, 0), ivec3(0, 0, 1), ivec3(0, 0, -1));
+    const uvec3 FACE_CORNERS[24] = uvec3[24](
+        uvec3(1, 0, 0), uvec3(1, 1, 0), uvec3(1, 1, 1), uvec3(1, 0, 1),
+        uvec3(0, 0, 1), uvec3(0, 1, 1), uvec3(0, 1, 0), uvec3(0, 0, 0),
+        uvec3(0, 1, 0), uvec3(0, 1, 1), uvec3(1, 1, 1), uvec3(1, 1, 0),
+        uvec3(0, 0, 0), uvec3(1, 0, 0), uvec3(1, 0, 1), uvec3(0, 0, 1),
+        uvec3(0, 0, 1), uvec3(1, 0, 1), uvec3(1, 1, 1), uvec3(0, 1, 1),
+        uvec3(1, 0, 0), uvec3(0, 0, 0), uvec3(0, 1, 0), uvec3(1, 1, 0));
+
+    // 0 = vazio, senão material + 1. Fora do mundo e bricks vazios (que não são
+    // reenviados) contam como vazio
+    uint voxelAt(ivec3 p) {
+        if (any(lessThan(p, ivec3(0))) || any(greaterThanEqual(p, gridSize)))
+            return 0u;
+        if (texelFetch(occupancy, p / BRICK_TAM, 0).r == 0u)
+            return 0u;
+        return texelFetch(voxels, p, 0).r;
+    }
+
+    // Fora do mundo é céu aberto (LUZ_FORA)
+    uint lightAt(ivec3 p) {
+        if (any(lessThan(p, ivec3(0))) || any(greaterThanEqual(p, gridSize)))
+            return 0xF0u;
+        return texelFetch(light, p, 0).r;
+    }
+
+    // Maior nível de cada canal em s^3 voxels (blockLight da CPU)
+    uint blockLight(ivec3 p0, int s) {
+        uint ceu = 0u, bloco = 0u;
+        for (int y = 0; y < s; y++)
+            for (int z = 0; z < s; z++)
+                for (int x = 0; x < s; x++) {
+                    uint l = lightAt(p0 + ivec3(x, y, z));
+                    ceu = max(ceu, l >> 4);
+                    bloco = max(bloco, l & 15u);
+                }
+        return (ceu << 4) | bloco;
+    }
+
+    bool transparent(uint v) {
+        uint material = v - 1u;
+        return material < 32u && (transparentMask & (1u << material)) != 0u;
+    }
+
+    // Material majoritário em s^3 voxels, com o desempate do mesher da CPU: sólido
+    // ganha do vazio, entre sólidos ganha o que apareceu primeiro (ordem y, z, x)
+    uint majority(ivec3 p0, int s) {
+        uint count[MATERIAIS];
+        uint first[MATERIAIS];
+        for (int m = 0; m < MATERIAIS; m++)
+            count[m] = 0u;
+
+        uint n = 0u;
+        for (int y = 0; y < s; y++)
+            for (int z = 0; z < s; z++)
+                for (int x = 0; x < s; x++) {
+                    uint v = voxelAt(p0 + ivec3(x, y, z));
+                    if (count[v] == 0u)
+                        first[v] = n;
+                    count[v]++;
+                    n++;
+                }
+
+        uint best = 0u, bestCount = 0u, bestFirst = 0xFFFFFFFFu;
+        for (int m = 1; m < MATERIAIS; m++) {
+            if (count[m] > bestCount || (count[m] == bestCount && count[m] > 0u && first[m] < bestFirst)) {
+                best = uint(m);
+                bestCount = count[m];
+                bestFirst = first[m];
+            }
+        }
+        return (best != 0u && bestCount >= count[0]) ? best : 0u;
+    }
+
+    // Mesma sombra de occludes e vertexAO do mesher da CPU
+    bool occludes(uint v) {
+        return v != 0u && !transparent(v);
+    }
+
+    uint cellAt(ivec3 c, int P) {
+        return cells[((c.y + 1) * P + (c.z + 1)) * P + (c.x + 1)] & 0xFFu;
+    }
+
+    uint lightOf(ivec3 c, int P) {
+        return cells[((c.y + 1) * P + (c.z + 1)) * P + (c.x + 1)] >> 8;
+    }
+
+    uint vertexAO(bool side1, bool side2, bool corner) {
+        if (side1 && side2)
+            return 0u;
+        return 3u - uint(side1) - uint(side2) - uint(corner);
+    }
+
+    // Mesmo teste de faceVisible
+    bool faceVisible(uint a, uint b) {
+        if (b == 0u) return true;
+        if (!transparent(b)) return false;
+        if (transparent(a)) return a != b;
+        return true;
+    }
+
+    void main() {
+        uint job = gl_WorkGroupID.x + jobOffset;
+        int lod = jobs[job].chunk.w;
+        int s = 1 << lod;
+        int R = CHUNK_TAM >> lod;
+        int P = R + 2;
+        ivec3 base = jobs[job].chunk.xyz * CHUNK_TAM;
+
+        if (gl_LocalInvocationIndex == 0u) {
+            quadCount[0] = 0u;
+            quadCount[1] = 0u;
+            quadCount[2] = 0u;
+        }
+        for (int i = int(gl_LocalInvocationIndex); i < P * P * P; i += 64) {
+            ivec3 c = ivec3(i % P, i / (P * P), (i / P) % P) - 1;
+            if (lod == 0)
+                cells[i] = voxelAt(base + c) | (lightAt(base + c) << 8);
+            else
+                cells[i] = majority(base + c * s, s) | (blockLight(base + c * s, s) << 8);
+        }
+        memoryBarrierShared();
+        barrier();
+
+        ivec4 mesh = jobs[job].mesh;
+        for (int i = int(gl_LocalInvocationIndex); i < R * R * R; i += 64) {
+            ivec3 c = ivec3(i % R, i / (R * R), (i / R) % R);
+            uint a = cellAt(c, P);
+            if (a == 0u)
+                continue;
+            bool transp = transparent(a);
+
+            for (int f = 0; f < 6; f++) {
+                ivec3 n = c + FACE_DIR[f];
+                uint b = cellAt(n, P);
+                int faixa;
+                if (faceVisible(a, b))
+                    faixa = transp ? 2 : 0;
+                else if (!transp && (any(lessThan(n, ivec3(0))) || any(greaterThanEqual(n, ivec3(R)))))
+                    faixa = 1;
+                else
+                    continue;
+
+                uint q = atomicAdd(quadCount[faixa], 1u);
+                if (!emitVertices)
+                    continue;
+
+                // Oclusão dos cantos na camada da frente (nos dois eixos da face,
+                // o canto 0/1 vira o passo -1/+1)
+                int u = (FACE_DIR[f].x == 0) ? 0 : 1;
+                int w = (FACE_DIR[f].z == 0) ? 2 : 1;
+                uint ao[4];
+                for (int k = 0; k < 4; k++) {
+                    ivec3 side1 = ivec3(0), side2 = ivec3(0);
+                    side1[u] = int(FACE_CORNERS[f * 4 + k][u]) * 2 - 1;
+                    side2[w] = int(FACE_CORNERS[f * 4 + k][w]) * 2 - 1;
+                    ao[k] = vertexAO(occludes(cellAt(n + side1, P)), occludes(cellAt(n + side2, P)),
+                                     occludes(cellAt(n + side1 + side2, P)));
+                }
+                int start = (ao[0] + ao[2] < ao[1] + ao[3]) ? 1 : 0;
+                uint luz = lightOf(n, P);
+
+                uint v = uint(mesh.x) + q * 4u;
+                if (faixa >= 1) v += uint(mesh.y) * 4u;
+                if (faixa == 2) v += uint(mesh.z) * 4u;
+                uvec3 p = uvec3(c * s);
+                for (int k = 0; k < 4; k++) {
+                    int i = (start + k) & 3;
+                    uvec3 corner = p + FACE_CORNERS[f * 4 + i] * uint(s);
+                    vertices[(v + uint(k)) * 2u] = corner.x | (corner.y << 8) | (corner.z << 16) | (uint(f) << 24);
+                    vertices[(v + uint(k)) * 2u + 1u] = (a - 1u) | (ao[i] << 8) | (luz << 16);
+                }
+            }
+        }
+        memoryBarrierShared();
+        barrier();
+
+        if (gl_LocalInvocationIndex != 0u)
+            return;
+        if (!emitVertices)
+            counts[job] = uvec4(quadCount[0], quadCount[1], quadCount[2], 0u);
+        else if (mesh.w >= 0)
+            args[mesh.w] = uvec4(uint(mesh.x), uint(mesh.y), uint(mesh.z), quadCount[2]);
+    }
+)glsl";
+
+bool GpuMesher::setup() {
+    if (!glExt.compute)
+        return false;
+
+    string source = "#version 430\n";
+    source += "#define CHUNK_TAM " + to_string(CHUNK_TAM) + "\n";
+    source += "#define BRICK_TAM " + to_string(BRICK_TAM) + "\n";
+    // Valores do volume: 0 e material + 1 para as 128 texturas possíveis
+    source += "#define MATERIAIS " + to_string(VOXEL_TEXTURA + 2) + "\n";
+    source += meshShaderBody;
+    program = setupComputeShader(source.c_str());
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    uint32_t transparentMask = 0;
+    for (int i = 0; i < NUM_TEXTURES; i++)
+        if (isTransparent(i))
+            transparentMask |= 1u << i;
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "voxels"), UNIDADE_VOXELS);
+    glUniform1i(glGetUniformLocation(program, "occupancy"), UNIDADE_OCUPACAO);
+    glUniform1i(glGetUniformLocation(program, "light"), UNIDADE_LUZ);
+    glUniform1ui(glGetUniformLocation(program, "transparentMask"), transparentMask);
+    glUseProgram(0);
+
+    glGenBuffers(1, &jobBuffer);
+    glGenBuffers(1, &countBuffer);
+    return true;
+}
+
+void GpuMesher::destroy() {
+    if (!program)
+        return;
+    glDeleteProgram(program);
+    glDeleteBuffers(1, &jobBuffer);
+    glDeleteBuffers(1, &countBuffer);
+    program = jobBuffer = countBuffer = 0;
+    jobCapacity = 0;
+}
+
+void GpuMesher::dispatch(const GpuVolume& volume, const vector<GpuMeshJob>& jobs, bool emitVertices) {
+    vector<JobGPU> data(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        const GpuMeshJob& job = jobs[i];
+        data[i] = { { job.cx, job.cy, job.cz, job.lod },
+                    { job.firstVertex, job.opaqueQuads, job.skirtQuads, job.argsIndex } };
+    }
+
+    // Os dois buffers crescem juntos; o de contagem tem um uvec4 por job
+    if (jobs.size() > jobCapacity) {
+        jobCapacity = max(jobs.size(), jobCapacity * 2);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, jobBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, jobCapacity * sizeof(JobGPU), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, countBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, jobCapacity * 4 * sizeof(GLuint), nullptr, GL_DYNAMIC_READ);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, jobBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, data.size() * sizeof(JobGPU), data.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glUseProgram(program);
+    glUniform3i(glGetUniformLocation(program, "gridSize"), volume.sizeX(), volume.sizeY(), volume.sizeZ());
+    glUniform1i(glGetUniformLocation(program, "emitVertices"), emitVertices ? 1 : 0);
+    glActiveTexture(GL_TEXTURE0 + UNIDADE_VOXELS);
+    glBindTexture(GL_TEXTURE_3D, volume.voxelTexture());
+    glActiveTexture(GL_TEXTURE0 + UNIDADE_OCUPACAO);
+    glBindTexture(GL_TEXTURE_3D, volume.occupancyTexture());
+    glActiveTexture(GL_TEXTURE0 + UNIDADE_LUZ);
+    glBindTexture(GL_TEXTURE_3D, volume.lightTexture());
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, jobBuffer);
+    for (size_t first = 0; first < jobs.size(); first += MAX_GRUPOS) {
+        glUniform1ui(glGetUniformLocation(program, "jobOffset"), (GLuint)first);
+        glDispatchCompute((GLuint)min(MAX_GRUPOS, jobs.size() - first), 1, 1);
+    }
+    glUseProgram(0);
+}
+
+void GpuMesher::count(const GpuVolume& volume, vector<GpuMeshJob>& jobs) {
+    if (jobs.empty())
+        return;
+    // Os bindings de vértices e argumentos não são escritos neste pass
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, countBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, countBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, countBuffer);
+    dispatch(volume, jobs, false);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    vector<GLuint> counts(jobs.size() * 4);
+    glBindBuffer(GL_COPY_READ_BUFFER, countBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, counts.size() * sizeof(GLuint), counts.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        jobs[i].opaqueQuads = (int)counts[i * 4];
+        jobs[i].skirtQuads = (int)counts[i * 4 + 1];
+        jobs[i].transparentQuads = (int)counts[i * 4 + 2];
+    }
+}
+
+void GpuMesher::emit(const GpuVolume& volume, const vector<GpuMeshJob>& jobs, GLuint vertexBuffer, GLuint argsBuffer) {
+    if (jobs.empty())
+        return;
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, countBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, vertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, argsBuffer ? argsBuffer : countBuffer);
+    dispatch(volume, jobs, true);
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT |
+                    GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
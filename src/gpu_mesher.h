@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "gpu_volume.h"
+
+#include <vector>
+
+// Um chunk num LOD para o mesher da GPU
+struct GpuMeshJob {
+    int cx = 0, cy = 0, cz = 0, lod = 0;
+    int opaqueQuads = 0, skirtQuads = 0, transparentQuads = 0;  // saída de count()
+    int firstVertex = 0;   // entrada de emit(): onde a malha começa no buffer de vértices
+    int argsIndex = -1;    // entrada de emit(): uvec4 do buffer de argumentos (-1 = não escreve)
+
+    int quads() const { return opaqueQuads + skirtQuads + transparentQuads; }
+};
+
+// Mesma malha de meshChunk (mesmas faces, cantos e faixas opacos | saia | transparentes),
+// gerada por compute shader a partir do espelho do mundo (GpuVolume). Um work group
+// por job: as células do chunk com a borda dos vizinhos vão para memória compartilhada
+// e cada face visível pega seu lugar na faixa com um contador atômico.
+//
+// São dois passes: count() conta os quads de cada job (a CPU lê só esses números
+// para reservar espaço na arena) e emit() escreve os vértices direto no buffer de
+// vértices e, por job, os argumentos de desenho (primeiro vértice e quads por faixa)
+// que o culling na GPU transforma em comandos indiretos. A ordem dos quads dentro de
+// cada faixa não é a da CPU, só o conjunto é o mesmo
+class GpuMesher {
+public:
+    // Requer compute shaders (glExt.compute). Retorna se o mesher está disponível
+    bool setup();
+    void destroy();
+    bool supported() const { return program != 0; }
+
+    // O volume precisa estar em dia (sem bricks pendentes) para o resultado bater com a CPU
+    void count(const GpuVolume& volume, std::vector<GpuMeshJob>& jobs);
+    void emit(const GpuVolume& volume, const std::vector<GpuMeshJob>& jobs, GLuint vertexBuffer, GLuint argsBuffer);
+
+private:
+    void dispatch(const GpuVolume& volume, const std::vector<GpuMeshJob>& jobs, bool emitVertices);
+
+    GLuint program = 0;
+    GLuint jobBuffer = 0, countBuffer = 0;
+    size_t jobCapacity = 0;
+};
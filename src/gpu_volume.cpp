@@ -0,0 +1,185 @@
+#include "gpu_volume.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void GpuVolume::setup() {
+    glGenTextures(1, &voxels);
+    glGenTextures(1, &occupancy);
+    glGenTextures(1, &light);
+    for (GLuint tex : { voxels, occupancy, light }) {
+        glBindTexture(GL_TEXTURE_3D, tex);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void GpuVolume::destroy() {
+    glDeleteTextures(1, &voxels);
+    glDeleteTextures(1, &occupancy);
+    glDeleteTextures(1, &light);
+    voxels = occupancy = light = 0;
+    sx = sy = sz = 0;
+    worldGeneration = ~0u;
+    seenEdits = ~0ull;
+}
+
+// Copia o mundo inteiro para as texturas 3D
+void GpuVolume::fullUpload(const World& world) {
+    sx = world.sizeX();
+    sy = world.sizeY();
+    sz = world.sizeZ();
+    bx = (sx + BRICK_TAM - 1) / BRICK_TAM;
+    by = (sy + BRICK_TAM - 1) / BRICK_TAM;
+    bz = (sz + BRICK_TAM - 1) / BRICK_TAM;
+
+    // x varia mais rápido, depois y, depois z (layout da textura 3D)
+    vector<uint8_t> data((size_t)sx * sy * sz, 0);
+    vector<uint8_t> lightData((size_t)sx * sy * sz, 0);
+    brickOccupied.assign((size_t)bx * by * bz, 0);
+    for (int cy = 0; cy < world.chunksY(); cy++)
+        for (int cz = 0; cz < world.chunksZ(); cz++)
+            for (int cx = 0; cx < world.chunksX(); cx++) {
+                const Chunk& chunk = world.chunk(cx, cy, cz);
+                for (int ly = 0; ly < CHUNK_TAM; ly++)
+                    for (int lz = 0; lz < CHUNK_TAM; lz++)
+                        for (int lx = 0; lx < CHUNK_TAM; lx++) {
+                            int x = cx * CHUNK_TAM + lx, y = cy * CHUNK_TAM + ly, z = cz * CHUNK_TAM + lz;
+                            if (!world.inside(x, y, z))
+                                continue;
+                            size_t i = ((size_t)z * sy + y) * sx + x;
+                            lightData[i] = chunk.light[Chunk::index(lx, ly, lz)];
+                            uint8_t voxel = chunk.voxels[Chunk::index(lx, ly, lz)];
+                            if (!voxelVisivel(voxel))
+                                continue;
+                            data[i] = (uint8_t)(voxelTextura(voxel) + 1);
+                            brickOccupied[((size_t)(z / BRICK_TAM) * by + y / BRICK_TAM) * bx + x / BRICK_TAM] = 1;
+                        }
+            }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_3D, voxels);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R8UI, sx, sy, sz, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data.data());
+    glBindTexture(GL_TEXTURE_3D, occupancy);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R8UI, bx, by, bz, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, brickOccupied.data());
+    glBindTexture(GL_TEXTURE_3D, light);
+    glTexImage3D(GL_TEXTURE_3D, 0, GL_R8UI, sx, sy, sz, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, lightData.data());
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    lastUpload += data.size() + brickOccupied.size() + lightData.size();
+
+    // Tudo em dia: registra as versões atuais (as versões começam em 1) e descarta a fila
+    chunkVersions.assign(world.chunkCount(), 0);
+    brickVersions.assign(brickOccupied.size(), 0);
+    queued.assign(brickOccupied.size(), 0);
+    dirty.clear();
+    collectDirty(world);
+    dirty.clear();
+    dirtyHead = 0;
+    fill(queued.begin(), queued.end(), 0);
+}
+
+// Compara as versões dos chunks e, nos que mudaram, as dos bricks
+void GpuVolume::collectDirty(const World& world) {
+    for (int cy = 0; cy < world.chunksY(); cy++)
+        for (int cz = 0; cz < world.chunksZ(); cz++)
+            for (int cx = 0; cx < world.chunksX(); cx++) {
+                int ci = world.chunkIndex(cx, cy, cz);
+                const Chunk& chunk = world.chunk(cx, cy, cz);
+                if (chunkVersions[ci] == chunk.version)
+                    continue;
+                chunkVersions[ci] = chunk.version;
+
+                for (int lb = 0; lb < BRICKS_POR_CHUNK; lb++) {
+                    int gx = cx * BRICKS_POR_EIXO + lb % BRICKS_POR_EIXO;
+                    int gz = cz * BRICKS_POR_EIXO + (lb / BRICKS_POR_EIXO) % BRICKS_POR_EIXO;
+                    int gy = cy * BRICKS_POR_EIXO + lb / (BRICKS_POR_EIXO * BRICKS_POR_EIXO);
+                    if (gx >= bx || gy >= by || gz >= bz)
+                        continue;
+                    int brick = (gz * by + gy) * bx + gx;
+                    if (brickVersions[brick] == chunk.brickVersion[lb])
+                        continue;
+                    brickVersions[brick] = chunk.brickVersion[lb];
+                    if (!queued[brick]) {
+                        queued[brick] = 1;
+                        dirty.push_back(brick);
+                    }
+                }
+            }
+}
+
+// Envia um brick (recortado na borda do mundo). Retorna os bytes enviados
+size_t GpuVolume::uploadBrick(const World& world, int brick) {
+    int gx = brick % bx, gy = (brick / bx) % by, gz = brick / (bx * by);
+    int x0 = gx * BRICK_TAM, y0 = gy * BRICK_TAM, z0 = gz * BRICK_TAM;
+    int w = min(BRICK_TAM, sx - x0), h = min(BRICK_TAM, sy - y0), d = min(BRICK_TAM, sz - z0);
+
+    uint8_t data[BRICK_TAM * BRICK_TAM * BRICK_TAM];
+    uint8_t lightData[BRICK_TAM * BRICK_TAM * BRICK_TAM];
+    uint8_t occupied = 0;
+    for (int z = 0; z < d; z++)
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++) {
+                uint8_t voxel = world.get(x0 + x, y0 + y, z0 + z);
+                uint8_t value = voxelVisivel(voxel) ? (uint8_t)(voxelTextura(voxel) + 1) : 0;
+                data[(z * h + y) * w + x] = value;
+                lightData[(z * h + y) * w + x] = world.light(x0 + x, y0 + y, z0 + z);
+                occupied |= (value != 0);
+            }
+
+    size_t bytes = 0;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // A luz muda também no ar, então vai sempre
+    glBindTexture(GL_TEXTURE_3D, light);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, x0, y0, z0, w, h, d, GL_RED_INTEGER, GL_UNSIGNED_BYTE, lightData);
+    bytes += (size_t)w * h * d;
+    // Brick vazio não é lido (a ocupação diz que está vazio), então não precisa dos voxels
+    if (occupied) {
+        glBindTexture(GL_TEXTURE_3D, voxels);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, x0, y0, z0, w, h, d, GL_RED_INTEGER, GL_UNSIGNED_BYTE, data);
+        bytes += (size_t)w * h * d;
+    }
+    if (brickOccupied[brick] != occupied) {
+        brickOccupied[brick] = occupied;
+        glBindTexture(GL_TEXTURE_3D, occupancy);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, gx, gy, gz, 1, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &occupied);
+        bytes += 1;
+    }
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return bytes;
+}
+
+void GpuVolume::update(const World& world) {
+    PERFIL_ESCOPO("upload volume");
+    PERFIL_GPU("upload volume");
+    lastUpload = 0;
+    if (worldGeneration != world.generation()) {
+        fullUpload(world);
+        worldGeneration = world.generation();
+        seenEdits = world.edits();
+        return;
+    }
+
+    if (seenEdits != world.edits()) {
+        seenEdits = world.edits();
+        collectDirty(world);
+    }
+
+    const size_t brickBytes = 2 * BRICK_TAM * BRICK_TAM * BRICK_TAM + 1;
+    while (dirtyHead < dirty.size()) {
+        if (uploadBudget != 0 && lastUpload > 0 && lastUpload + brickBytes > uploadBudget)
+            break;
+        int brick = dirty[dirtyHead++];
+        queued[brick] = 0;
+        lastUpload += uploadBrick(world, brick);
+    }
+    if (dirtyHead == dirty.size()) {
+        dirty.clear();
+        dirtyHead = 0;
+    }
+}
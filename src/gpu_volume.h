@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "world.h"
+
+#include <cstddef>
+#include <vector>
+
+// Espelho do mundo na GPU para quem lê a grade em shader (raymarching, compute).
+// Texturas 3D GL_R8UI: os voxels (0 = vazio, senão material + 1), a ocupação, com um
+// texel por brick de 8^3 (1 = tem voxel visível), e a luz de cada voxel (mesmo byte de
+// Chunk::light). As edições marcam bricks sujos (pelas versões de brick dos chunks) e
+// cada frame envia só esses, com glTexSubImage3D, até o orçamento de bytes. Bricks
+// vazios não reenviam os voxels, só a ocupação e a luz: quem lê o volume deve
+// consultar a ocupação antes dos voxels
+class GpuVolume {
+public:
+    void setup();
+    void destroy();
+
+    // Envia os bricks sujos dentro do orçamento. Se o mundo foi recriado (resize),
+    // realoca e envia tudo de uma vez (fora do orçamento)
+    void update(const World& world);
+
+    GLuint voxelTexture() const { return voxels; }
+    GLuint occupancyTexture() const { return occupancy; }
+    GLuint lightTexture() const { return light; }
+    int sizeX() const { return sx; }
+    int sizeY() const { return sy; }
+    int sizeZ() const { return sz; }
+
+    // Bytes enviados no último update e bricks ainda na fila
+    size_t uploadedBytes() const { return lastUpload; }
+    int pendingBricks() const { return (int)(dirty.size() - dirtyHead); }
+    // Memória das três texturas (zero antes do primeiro update)
+    size_t gpuBytes() const { return (size_t)sx * sy * sz * 2 + (size_t)bx * by * bz; }
+
+    // Bytes por frame para os bricks sujos (0 = sem limite). Pelo menos um brick
+    // sai por frame, mesmo que passe do orçamento
+    size_t uploadBudget = 1 << 20;
+
+private:
+    void fullUpload(const World& world);
+    void collectDirty(const World& world);
+    size_t uploadBrick(const World& world, int brick);
+
+    GLuint voxels = 0, occupancy = 0, light = 0;
+    int sx = 0, sy = 0, sz = 0;
+    int bx = 0, by = 0, bz = 0;   // bricks por eixo
+
+    uint32_t worldGeneration = ~0u;
+    uint64_t seenEdits = ~0ull;
+    std::vector<uint32_t> chunkVersions;   // última versão vista de cada chunk
+    std::vector<uint32_t> brickVersions;   // idem por brick (índice do brick no mundo)
+    std::vector<uint8_t> brickOccupied;    // ocupação já enviada
+    std::vector<uint8_t> queued;
+    std::vector<int> dirty;                // fila FIFO de bricks sujos
+    size_t dirtyHead = 0;
+    size_t lastUpload = 0;
+};
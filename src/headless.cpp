@@ -0,0 +1,108 @@
+#include "headless.h"
+
+#include <iostream>
+
+#ifdef VOXEL_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+
+using namespace std;
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+static EGLSurface surface = EGL_NO_SURFACE;
+
+static bool temExtensao(EGLDisplay dpy, const char* nome) {
+    const char* lista = eglQueryString(dpy, EGL_EXTENSIONS);
+    return lista && strstr(lista, nome) != nullptr;
+}
+
+bool createHeadlessContext() {
+    // Plataforma surfaceless do Mesa: não abre X11/Wayland nem precisa de /dev/dri
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay && temExtensao(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless"))
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        cerr << "Falha ao inicializar EGL" << endl;
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        cerr << "EGL sem suporte a OpenGL desktop" << endl;
+        return false;
+    }
+
+    bool semSuperficie = temExtensao(display, "EGL_KHR_surfaceless_context");
+    const EGLint atributos[] = {
+        EGL_SURFACE_TYPE, semSuperficie ? 0 : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display, atributos, &config, 1, &numConfigs) || numConfigs == 0) {
+        cerr << "Nenhuma configuracao EGL com OpenGL" << endl;
+        return false;
+    }
+
+    const EGLint contexto[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, 5,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contexto);
+    if (context == EGL_NO_CONTEXT) {
+        cerr << "Falha ao criar contexto OpenGL 4.5 por EGL" << endl;
+        return false;
+    }
+
+    if (!semSuperficie) {
+        const EGLint pbuffer[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, pbuffer);
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        cerr << "Falha ao ativar o contexto EGL" << endl;
+        return false;
+    }
+    return true;
+}
+
+void destroyHeadlessContext() {
+    if (display == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE)
+        eglDestroySurface(display, surface);
+    if (context != EGL_NO_CONTEXT)
+        eglDestroyContext(display, context);
+    eglTerminate(display);
+    display = EGL_NO_DISPLAY;
+    context = EGL_NO_CONTEXT;
+    surface = EGL_NO_SURFACE;
+}
+
+void* headlessProcAddress(const char* name) {
+    return (void*)eglGetProcAddress(name);
+}
+
+#else
+
+bool createHeadlessContext() {
+    std::cerr << "Modo sem janela indisponivel: compilado sem EGL" << std::endl;
+    return false;
+}
+
+void destroyHeadlessContext() {}
+
+void* headlessProcAddress(const char*) {
+    return nullptr;
+}
+
+#endif
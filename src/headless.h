@@ -0,0 +1,14 @@
+#pragma once
+
+// Contexto OpenGL 4.5 core sem janela nem display, por EGL: tenta a plataforma
+// surfaceless do Mesa (funciona com o llvmpipe em servidores sem GPU) e cai para o
+// display padrão. Com EGL_KHR_surfaceless_context o contexto fica corrente sem
+// superfície nenhuma; senão usa um pbuffer de 1x1. Em ambos os casos o desenho vai
+// para framebuffers próprios (OIT e FrameCapture), nunca para o padrão.
+// Só existe com VOXEL_EGL (Linux com EGL); sem ele createHeadlessContext falha
+
+bool createHeadlessContext();
+void destroyHeadlessContext();
+
+// Carregador de funções para o gladLoadGLLoader/loadGLExtensions
+void* headlessProcAddress(const char* name);
@@ -0,0 +1,272 @@
+#include "hud.h"
+#include "shader.h"
+
+#include <algorithm>
+#include <cstddef>
+
+using namespace std;
+
+// Glifo sólido (último da fonte): fundo dos painéis
+static const uint32_t GLIFO_SOLIDO = 95;
+static const int NUM_GLIFOS = 96;
+
+// Fonte 5x7 para ASCII 32..126, uma coluna por byte (bit 0 no topo); g, j, p, q e y
+// descem até o bit 7. Cada glifo ocupa uma célula de 6x9 na textura
+static const uint8_t FONTE[NUM_GLIFOS * 5] = {
+    0x00, 0x00, 0x00, 0x00, 0x00,  // ' '
+    0x00, 0x00, 0x5F, 0x00, 0x00,  // '!'
+    0x00, 0x07, 0x00, 0x07, 0x00,  // '"'
+    0x14, 0x7F, 0x14, 0x7F, 0x14,  // '#'
+    0x24, 0x2A, 0x7F, 0x2A, 0x12,  // '$'
+    0x23, 0x13, 0x08, 0x64, 0x62,  // '%'
+    0x36, 0x49, 0x55, 0x22, 0x50,  // '&'
+    0x00, 0x05, 0x03, 0x00, 0x00,  // '''
+    0x00, 0x1C, 0x22, 0x41, 0x00,  // '('
+    0x00, 0x41, 0x22, 0x1C, 0x00,  // ')'
+    0x14, 0x08, 0x3E, 0x08, 0x14,  // '*'
+    0x08, 0x08, 0x3E, 0x08, 0x08,  // '+'
+    0x00, 0xA0, 0x60, 0x00, 0x00,  // ','
+    0x08, 0x08, 0x08, 0x08, 0x08,  // '-'
+    0x00, 0x60, 0x60, 0x00, 0x00,  // '.'
+    0x20, 0x10, 0x08, 0x04, 0x02,  // '/'
+    0x3E, 0x51, 0x49, 0x45, 0x3E,  // '0'
+    0x00, 0x42, 0x7F, 0x40, 0x00,  // '1'
+    0x42, 0x61, 0x51, 0x49, 0x46,  // '2'
+    0x21, 0x41, 0x45, 0x4B, 0x31,  // '3'
+    0x18, 0x14, 0x12, 0x7F, 0x10,  // '4'
+    0x27, 0x45, 0x45, 0x45, 0x39,  // '5'
+    0x3C, 0x4A, 0x49, 0x49, 0x30,  // '6'
+    0x01, 0x71, 0x09, 0x05, 0x03,  // '7'
+    0x36, 0x49, 0x49, 0x49, 0x36,  // '8'
+    0x06, 0x49, 0x49, 0x29, 0x1E,  // '9'
+    0x00, 0x36, 0x36, 0x00, 0x00,  // ':'
+    0x00, 0x56, 0x36, 0x00, 0x00,  // ';'
+    0x08, 0x14, 0x22, 0x41, 0x00,  // '<'
+    0x14, 0x14, 0x14, 0x14, 0x14,  // '='
+    0x00, 0x41, 0x22, 0x14, 0x08,  // '>'
+    0x02, 0x01, 0x51, 0x09, 0x06,  // '?'
+    0x32, 0x49, 0x79, 0x41, 0x3E,  // '@'
+    0x7E, 0x11, 0x11, 0x11, 0x7E,  // 'A'
+    0x7F, 0x49, 0x49, 0x49, 0x36,  // 'B'
+    0x3E, 0x41, 0x41, 0x41, 0x22,  // 'C'
+    0x7F, 0x41, 0x41, 0x22, 0x1C,  // 'D'
+    0x7F, 0x49, 0x49, 0x49, 0x41,  // 'E'
+    0x7F, 0x09, 0x09, 0x09, 0x01,  // 'F'
+    0x3E, 0x41, 0x49, 0x49, 0x7A,  // 'G'
+    0x7F, 0x08, 0x08, 0x08, 0x7F,  // 'H'
+    0x00, 0x41, 0x7F, 0x41, 0x00,  // 'I'
+    0x20, 0x40, 0x41, 0x3F, 0x01,  // 'J'
+    0x7F, 0x08, 0x14, 0x22, 0x41,  // 'K'
+    0x7F, 0x40, 0x40, 0x40, 0x40,  // 'L'
+    0x7F, 0x02, 0x0C, 0x02, 0x7F,  // 'M'
+    0x7F, 0x04, 0x08, 0x10, 0x7F,  // 'N'
+    0x3E, 0x41, 0x41, 0x41, 0x3E,  // 'O'
+    0x7F, 0x09, 0x09, 0x09, 0x06,  // 'P'
+    0x3E, 0x41, 0x51, 0x21, 0x5E,  // 'Q'
+    0x7F, 0x09, 0x19, 0x29, 0x46,  // 'R'
+    0x46, 0x49, 0x49, 0x49, 0x31,  // 'S'
+    0x01, 0x01, 0x7F, 0x01, 0x01,  // 'T'
+    0x3F, 0x40, 0x40, 0x40, 0x3F,  // 'U'
+    0x1F, 0x20, 0x40, 0x20, 0x1F,  // 'V'
+    0x3F, 0x40, 0x38, 0x40, 0x3F,  // 'W'
+    0x63, 0x14, 0x08, 0x14, 0x63,  // 'X'
+    0x07, 0x08, 0x70, 0x08, 0x07,  // 'Y'
+    0x61, 0x51, 0x49, 0x45, 0x43,  // 'Z'
+    0x00, 0x7F, 0x41, 0x41, 0x00,  // '['
+    0x02, 0x04, 0x08, 0x10, 0x20,  // '\\'
+    0x00, 0x41, 0x41, 0x7F, 0x00,  // ']'
+    0x04, 0x02, 0x01, 0x02, 0x04,  // '^'
+    0x40, 0x40, 0x40, 0x40, 0x40,  // '_'
+    0x00, 0x01, 0x02, 0x04, 0x00,  // '`'
+    0x20, 0x54, 0x54, 0x54, 0x78,  // 'a'
+    0x7F, 0x48, 0x44, 0x44, 0x38,  // 'b'
+    0x38, 0x44, 0x44, 0x44, 0x20,  // 'c'
+    0x38, 0x44, 0x44, 0x48, 0x7F,  // 'd'
+    0x38, 0x54, 0x54, 0x54, 0x18,  // 'e'
+    0x08, 0x7E, 0x09, 0x01, 0x02,  // 'f'
+    0x18, 0xA4, 0xA4, 0xA4, 0x7C,  // 'g'
+    0x7F, 0x08, 0x04, 0x04, 0x78,  // 'h'
+    0x00, 0x44, 0x7D, 0x40, 0x00,  // 'i'
+    0x40, 0x80, 0x84, 0x7D, 0x00,  // 'j'
+    0x7F, 0x10, 0x28, 0x44, 0x00,  // 'k'
+    0x00, 0x41, 0x7F, 0x40, 0x00,  // 'l'
+    0x7C, 0x04, 0x18, 0x04, 0x78,  // 'm'
+    0x7C, 0x08, 0x04, 0x04, 0x78,  // 'n'
+    0x38, 0x44, 0x44, 0x44, 0x38,  // 'o'
+    0xFC, 0x24, 0x24, 0x24, 0x18,  // 'p'
+    0x18, 0x24, 0x24, 0x24, 0xFC,  // 'q'
+    0x7C, 0x08, 0x04, 0x04, 0x08,  // 'r'
+    0x48, 0x54, 0x54, 0x54, 0x20,  // 's'
+    0x04, 0x3F, 0x44, 0x40, 0x20,  // 't'
+    0x3C, 0x40, 0x40, 0x20, 0x7C,  // 'u'
+    0x1C, 0x20, 0x40, 0x20, 0x1C,  // 'v'
+    0x3C, 0x40, 0x30, 0x40, 0x3C,  // 'w'
+    0x44, 0x28, 0x10, 0x28, 0x44,  // 'x'
+    0x1C, 0xA0, 0xA0, 0xA0, 0x7C,  // 'y'
+    0x44, 0x64, 0x54, 0x4C, 0x44,  // 'z'
+    0x00, 0x08, 0x36, 0x41, 0x00,  // '{'
+    0x00, 0x00, 0x7F, 0x00, 0x00,  // '|'
+    0x00, 0x41, 0x36, 0x08, 0x00,  // '}'
+    0x10, 0x08, 0x08, 0x10, 0x08,  // '~'
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF,  // bloco
+};
+
+// Um quad por instância, cantos a partir de gl_VertexID (tira de 4 vértices)
+static const GLchar* hudVertexSource = R"glsl(
+    #version 450
+    layout (location = 0) in vec4 rect;
+    layout (location = 1) in uint glyph;
+    layout (location = 2) in vec4 color;
+
+    uniform vec2 screen;
+
+    out vec2 local;
+    flat out uint glyphIndex;
+    out vec4 glyphColor;
+
+    void main()
+    {
+        vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+        vec2 pixel = rect.xy + corner * rect.zw;
+        gl_Position = vec4(pixel.x / screen.x * 2.0 - 1.0, 1.0 - pixel.y / screen.y * 2.0, 0.0, 1.0);
+        local = corner;
+        glyphIndex = glyph;
+        glyphColor = color;
+    }
+)glsl";
+
+static const GLchar* hudFragmentSource = R"glsl(
+    #version 450
+    in vec2 local;
+    flat in uint glyphIndex;
+    in vec4 glyphColor;
+
+    out vec4 color;
+
+    uniform usampler2D font;
+    uniform uint solid;
+
+    void main()
+    {
+        float coverage = 1.0;
+        if (glyphIndex != solid) {
+            ivec2 texel = ivec2(glyphIndex * 6u + uint(local.x * 6.0), uint(local.y * 9.0));
+            coverage = float(texelFetch(font, texel, 0).r);
+        }
+        if (coverage == 0.0)
+            discard;
+        color = glyphColor;
+    }
+)glsl";
+
+void Hud::setup() {
+    program = setupShader(hudVertexSource, hudFragmentSource);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "font"), 0);
+    glUniform1ui(glGetUniformLocation(program, "solid"), GLIFO_SOLIDO);
+    screenLoc = glGetUniformLocation(program, "screen");
+
+    // Fonte: 1 onde o glifo tem pixel, linha 0 no topo
+    const int largura = NUM_GLIFOS * CELL_W;
+    vector<uint8_t> texels((size_t)largura * CELL_H, 0);
+    for (int g = 0; g < NUM_GLIFOS; g++)
+        for (int coluna = 0; coluna < 5; coluna++)
+            for (int linha = 0; linha < 8; linha++)
+                if (FONTE[g * 5 + coluna] & (1 << linha))
+                    texels[(size_t)linha * largura + g * CELL_W + coluna] = 1;
+    glGenTextures(1, &font);
+    glBindTexture(GL_TEXTURE_2D, font);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, largura, CELL_H, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, texels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Glyph), (GLvoid*)offsetof(Glyph, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Glyph), (GLvoid*)offsetof(Glyph, glyph));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Glyph), (GLvoid*)offsetof(Glyph, color));
+    glEnableVertexAttribArray(2);
+    for (GLuint atributo = 0; atributo < 3; atributo++)
+        glVertexAttribDivisor(atributo, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Hud::destroy() {
+    glDeleteProgram(program);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteTextures(1, &font);
+    program = vao = vbo = font = 0;
+    capacity = 0;
+}
+
+void Hud::begin() {
+    glyphs.clear();
+    dirty = true;
+}
+
+void Hud::text(int column, int row, const string& str, uint32_t color) {
+    const float w = (float)(CELL_W * scale), h = (float)(CELL_H * scale);
+    int x = column;
+    for (char c : str) {
+        if (c == '\n') {
+            x = column;
+            row++;
+            continue;
+        }
+        // Fora do ASCII imprimível vira '?'
+        uint32_t glyph = (c >= 32 && c <= 126) ? (uint32_t)(c - 32) : (uint32_t)('?' - 32);
+        if (glyph != 0)
+            glyphs.push_back({ x * w, row * h, w, h, glyph, color });
+        x++;
+    }
+}
+
+void Hud::panel(int column, int row, int columns, int rows, uint32_t color) {
+    const float w = (float)(CELL_W * scale), h = (float)(CELL_H * scale);
+    glyphs.push_back({ column * w, row * h, columns * w, rows * h, GLIFO_SOLIDO, color });
+}
+
+void Hud::draw(GLuint framebuffer, int width, int height) {
+    if (!visible || glyphs.empty())
+        return;
+
+    // Só reenvia quando o texto mudou; o buffer cresce em potências de 2
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (dirty) {
+        if (glyphs.size() > capacity) {
+            capacity = max<size_t>(256, capacity);
+            while (capacity < glyphs.size())
+                capacity *= 2;
+            glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Glyph), nullptr, GL_DYNAMIC_DRAW);
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, glyphs.size() * sizeof(Glyph), glyphs.data());
+        dirty = false;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glUseProgram(program);
+    glUniform2f(screenLoc, (float)width, (float)height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, font);
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)glyphs.size());
+    glBindVertexArray(0);
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Texto sobre a imagem (HUD) desenhado pela própria janela, sem o console. Cada
+// caractere é uma instância de um quad que lê uma fonte bitmap 5x7 (ASCII 32..126,
+// células de 6x9 pixels, numa textura R8), e os painéis de fundo são instâncias do
+// mesmo quad com um glifo sólido: o HUD inteiro sai num só glDrawArraysInstanced.
+// As instâncias só são reenviadas quando o texto muda (entre begin e draw)
+class Hud {
+public:
+    void setup();
+    void destroy();
+
+    // Recomeça o texto. Coordenadas em células (coluna, linha) a partir do canto
+    // superior esquerdo, multiplicadas por scale
+    void begin();
+    void text(int column, int row, const std::string& str, uint32_t color = 0xFFFFFFFF);
+    void panel(int column, int row, int columns, int rows, uint32_t color);
+
+    // Desenha por cima do que já está em framebuffer (width x height em pixels)
+    void draw(GLuint framebuffer, int width, int height);
+
+    int scale = 2;
+    bool visible = true;
+
+    // Tamanho da célula em pixels da fonte
+    static const int CELL_W = 6, CELL_H = 9;
+
+private:
+    struct Glyph {
+        float x, y, w, h;    // em pixels, y para baixo
+        uint32_t glyph;
+        uint32_t color;      // RGBA8 (R no byte mais baixo)
+    };
+
+    GLuint program = 0, vao = 0, vbo = 0, font = 0;
+    GLint screenLoc = -1;
+    std::vector<Glyph> glyphs;
+    size_t capacity = 0;
+    bool dirty = false;
+};
+
+// Cores RGBA8 na ordem dos bytes da instância
+inline uint32_t hudColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+    return (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16) | ((uint32_t)a << 24);
+}
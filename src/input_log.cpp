@@ -0,0 +1,238 @@
+#include "input_log.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+static const char MAGICO[4] = { 'V', 'X', 'I', 'N' };
+static const uint32_t VERSAO = 1;
+
+// O arquivo é little-endian: numa máquina big-endian os bytes de cada número (inteiro
+// ou float) são invertidos na gravação e na leitura
+static void ordemArquivo(void* numero, size_t n) {
+    const uint16_t um = 1;
+    uint8_t primeiro;
+    memcpy(&primeiro, &um, 1);
+    if (primeiro == 1)
+        return;
+    uint8_t* b = static_cast<uint8_t*>(numero);
+    reverse(b, b + n);
+}
+
+// Campos do cabeçalho, na ordem do arquivo (um número por chamada)
+template <typename Funcao>
+static void camposCabecalho(InputLogHeader& h, Funcao campo) {
+    campo(&h.worldX, sizeof(h.worldX));
+    campo(&h.worldY, sizeof(h.worldY));
+    campo(&h.worldZ, sizeof(h.worldZ));
+    campo(&h.worldHash, sizeof(h.worldHash));
+    for (float& v : h.cameraPos)
+        campo(&v, sizeof(v));
+    for (float& v : h.cameraFront)
+        campo(&v, sizeof(v));
+    for (float& v : h.cameraUp)
+        campo(&v, sizeof(v));
+    campo(&h.yaw, sizeof(h.yaw));
+    campo(&h.pitch, sizeof(h.pitch));
+    campo(&h.fov, sizeof(h.fov));
+    campo(&h.lastX, sizeof(h.lastX));
+    campo(&h.lastY, sizeof(h.lastY));
+    campo(&h.firstMouse, sizeof(h.firstMouse));
+    for (int32_t& v : h.selection)
+        campo(&v, sizeof(v));
+}
+
+bool InputRecorder::open(const string& path, const InputLogHeader& header) {
+    close();
+    arquivo = fopen(path.c_str(), "wb");
+    if (!arquivo)
+        return false;
+    quadros = 0;
+    tamanho = 0;
+    escreve(MAGICO, sizeof(MAGICO));
+    escreveNumero(&VERSAO, sizeof(VERSAO));
+    InputLogHeader h = header;
+    camposCabecalho(h, [this](const void* dados, size_t n) { escreveNumero(dados, n); });
+    inicioQuadro = chrono::steady_clock::now();
+    return true;
+}
+
+void InputRecorder::escreve(const void* dados, size_t n) {
+    fwrite(dados, 1, n, arquivo);
+    tamanho += (long)n;
+}
+
+void InputRecorder::escreveNumero(const void* numero, size_t n) {
+    uint8_t bytes[8];
+    memcpy(bytes, numero, n);
+    ordemArquivo(bytes, n);
+    escreve(bytes, n);
+}
+
+// Tipo e tempo desde o início do frame (até ~71 minutos num frame)
+void InputRecorder::escreveEvento(InputEventType tipo) {
+    auto us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - inicioQuadro).count();
+    uint32_t tempo = (uint32_t)min<long long>(max<long long>(0, us), UINT32_MAX);
+    escreve(&tipo, sizeof(tipo));
+    escreveNumero(&tempo, sizeof(tempo));
+}
+
+void InputRecorder::beginFrame(float deltaTime, uint16_t keys) {
+    if (!arquivo)
+        return;
+    inicioQuadro = chrono::steady_clock::now();
+    InputEventType tipo = ENTRADA_QUADRO;
+    escreve(&tipo, sizeof(tipo));
+    escreveNumero(&deltaTime, sizeof(deltaTime));
+    escreveNumero(&keys, sizeof(keys));
+    quadros++;
+}
+
+void InputRecorder::key(int key, int scancode, int action, int mods) {
+    if (!arquivo)
+        return;
+    escreveEvento(ENTRADA_TECLA);
+    int16_t tecla = (int16_t)key, codigo = (int16_t)scancode;
+    uint8_t acao = (uint8_t)action, modificadores = (uint8_t)mods;
+    escreveNumero(&tecla, sizeof(tecla));
+    escreveNumero(&codigo, sizeof(codigo));
+    escreve(&acao, sizeof(acao));
+    escreve(&modificadores, sizeof(modificadores));
+}
+
+// Posições em double: mouse_callback faz as contas a partir delas, e a reprodução
+// só chega à mesma câmera com os mesmos bits
+void InputRecorder::cursor(double x, double y) {
+    if (!arquivo)
+        return;
+    escreveEvento(ENTRADA_CURSOR);
+    escreveNumero(&x, sizeof(x));
+    escreveNumero(&y, sizeof(y));
+}
+
+void InputRecorder::scroll(double x, double y) {
+    if (!arquivo)
+        return;
+    escreveEvento(ENTRADA_SCROLL);
+    escreveNumero(&x, sizeof(x));
+    escreveNumero(&y, sizeof(y));
+}
+
+void InputRecorder::finish(uint64_t worldHash) {
+    if (!arquivo)
+        return;
+    InputEventType tipo = ENTRADA_FIM;
+    uint32_t n = (uint32_t)quadros;
+    escreve(&tipo, sizeof(tipo));
+    escreveNumero(&worldHash, sizeof(worldHash));
+    escreveNumero(&n, sizeof(n));
+    close();
+}
+
+void InputRecorder::close() {
+    if (arquivo) {
+        fclose(arquivo);
+        arquivo = nullptr;
+    }
+}
+
+bool loadInputLog(const string& path, InputLog& log) {
+    FILE* arquivo = fopen(path.c_str(), "rb");
+    if (!arquivo)
+        return false;
+    vector<uint8_t> dados;
+    uint8_t bloco[1 << 16];
+    size_t n;
+    while ((n = fread(bloco, 1, sizeof(bloco), arquivo)) > 0)
+        dados.insert(dados.end(), bloco, bloco + n);
+    fclose(arquivo);
+
+    size_t pos = 0;
+    auto le = [&](void* destino, size_t bytes) {
+        if (pos + bytes > dados.size())
+            return false;
+        memcpy(destino, dados.data() + pos, bytes);
+        pos += bytes;
+        return true;
+    };
+    auto leNumero = [&](void* destino, size_t bytes) {
+        if (!le(destino, bytes))
+            return false;
+        ordemArquivo(destino, bytes);
+        return true;
+    };
+
+    char magico[4];
+    uint32_t versao = 0;
+    if (!le(magico, sizeof(magico)) || memcmp(magico, MAGICO, sizeof(MAGICO)) != 0 || !leNumero(&versao, sizeof(versao)) ||
+        versao != VERSAO)
+        return false;
+    log = InputLog();
+    bool cabecalhoOk = true;
+    camposCabecalho(log.header,
+                    [&](void* destino, size_t bytes) { cabecalhoOk = cabecalhoOk && leNumero(destino, bytes); });
+    if (!cabecalhoOk)
+        return false;
+
+    // Um frame só entra quando o próximo começa ou no registro final: o último de um
+    // log cortado pode estar pela metade e fica de fora. Eventos antes do primeiro frame
+    // (entre o open e o primeiro beginFrame) vão para o começo do frame 0
+    InputFrame atual;
+    bool temQuadro = false;
+    uint8_t tipo;
+    while (le(&tipo, sizeof(tipo))) {
+        if (tipo == ENTRADA_QUADRO) {
+            InputFrame proximo;
+            if (!leNumero(&proximo.deltaTime, sizeof(proximo.deltaTime)) ||
+                !leNumero(&proximo.keys, sizeof(proximo.keys)))
+                break;
+            if (temQuadro) {
+                log.frames.push_back(move(atual));
+            }
+            else {
+                for (InputEvent& e : atual.events)
+                    e.offsetUs = 0;
+                proximo.events.swap(atual.events);
+            }
+            atual = move(proximo);
+            temQuadro = true;
+        }
+        else if (tipo == ENTRADA_TECLA) {
+            InputEvent e;
+            int16_t tecla, codigo;
+            uint8_t acao, modificadores;
+            if (!leNumero(&e.offsetUs, sizeof(e.offsetUs)) || !leNumero(&tecla, sizeof(tecla)) ||
+                !leNumero(&codigo, sizeof(codigo)) || !le(&acao, sizeof(acao)) ||
+                !le(&modificadores, sizeof(modificadores)))
+                break;
+            e.type = ENTRADA_TECLA;
+            e.key = tecla;
+            e.scancode = codigo;
+            e.action = acao;
+            e.mods = modificadores;
+            atual.events.push_back(e);
+        }
+        else if (tipo == ENTRADA_CURSOR || tipo == ENTRADA_SCROLL) {
+            InputEvent e;
+            if (!leNumero(&e.offsetUs, sizeof(e.offsetUs)) || !leNumero(&e.x, sizeof(e.x)) ||
+                !leNumero(&e.y, sizeof(e.y)))
+                break;
+            e.type = (InputEventType)tipo;
+            atual.events.push_back(e);
+        }
+        else if (tipo == ENTRADA_FIM) {
+            uint32_t quadros;
+            if (!leNumero(&log.finalHash, sizeof(log.finalHash)) || !leNumero(&quadros, sizeof(quadros)))
+                break;
+            if (temQuadro)
+                log.frames.push_back(move(atual));
+            log.complete = quadros == log.frames.size();
+            break;
+        }
+        else {
+            break;   // registro desconhecido: trata como corte
+        }
+    }
+    return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Gravação da entrada do editor num log binário compacto, para reproduzir sessões
+// reais de edição (com --headless, contra outras versões) e comparar os tempos de
+// frame e o hash final do mundo. O log tem um cabeçalho com o estado inicial (mundo,
+// câmera e seleção) e, por frame, um registro com o deltaTime e as teclas contínuas
+// que processInput leu (um bit por tecla), seguido dos eventos que os callbacks
+// receberam no glfwPollEvents daquele frame (tecla, cursor e scroll), cada um com o
+// tempo desde o início do frame. Um registro final guarda o hash do mundo na saída.
+// Números sempre em little-endian (invertidos na gravação e na leitura numa máquina
+// big-endian). Eventos antes do primeiro frame entram no começo do frame 0
+
+// Estado do editor no início da gravação
+struct InputLogHeader {
+    int32_t worldX = 0, worldY = 0, worldZ = 0;
+    uint64_t worldHash = 0;
+    float cameraPos[3] = { 0.0f, 0.0f, 0.0f };
+    float cameraFront[3] = { 0.0f, 0.0f, -1.0f };
+    float cameraUp[3] = { 0.0f, 1.0f, 0.0f };
+    float yaw = 0.0f, pitch = 0.0f, fov = 45.0f;
+    float lastX = 0.0f, lastY = 0.0f;
+    uint8_t firstMouse = 1;
+    int32_t selection[3] = { 0, 0, 0 };
+};
+
+enum InputEventType : uint8_t {
+    ENTRADA_QUADRO = 0,
+    ENTRADA_TECLA = 1,
+    ENTRADA_CURSOR = 2,
+    ENTRADA_SCROLL = 3,
+    ENTRADA_FIM = 4,
+};
+
+struct InputEvent {
+    InputEventType type = ENTRADA_TECLA;
+    uint32_t offsetUs = 0;               // desde o início do frame
+    int32_t key = 0, scancode = 0, action = 0, mods = 0;
+    double x = 0.0, y = 0.0;             // cursor ou scroll
+};
+
+struct InputFrame {
+    float deltaTime = 0.0f;              // o da gravação (a reprodução usa passo fixo)
+    uint16_t keys = 0;                   // teclas contínuas pressionadas
+    std::vector<InputEvent> events;
+};
+
+class InputRecorder {
+public:
+    InputRecorder() = default;
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+    ~InputRecorder() { close(); }
+
+    bool open(const std::string& path, const InputLogHeader& header);
+    bool recording() const { return arquivo != nullptr; }
+
+    // Começo de um frame: os eventos seguintes são dele
+    void beginFrame(float deltaTime, uint16_t keys);
+    void key(int key, int scancode, int action, int mods);
+    void cursor(double x, double y);
+    void scroll(double x, double y);
+
+    // Grava o registro final com o hash do mundo e fecha
+    void finish(uint64_t worldHash);
+    void close();
+
+    int frames() const { return quadros; }
+    long bytes() const { return tamanho; }
+
+private:
+    void escreve(const void* dados, size_t n);
+    void escreveNumero(const void* numero, size_t n);   // em little-endian
+    void escreveEvento(InputEventType tipo);
+
+    FILE* arquivo = nullptr;
+    std::chrono::steady_clock::time_point inicioQuadro;
+    int quadros = 0;
+    long tamanho = 0;
+};
+
+// Log inteiro lido para a memória
+struct InputLog {
+    InputLogHeader header;
+    std::vector<InputFrame> frames;
+    bool complete = false;               // tem o registro final (a sessão não caiu)
+    uint64_t finalHash = 0;
+};
+
+// Lê o log. Devolve false se não abrir ou o cabeçalho for inválido; um log cortado
+// (sessão interrompida) devolve os frames inteiros até o corte, com complete = false
+bool loadInputLog(const std::string& path, InputLog& log);
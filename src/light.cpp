@@ -0,0 +1,316 @@
+#include "light.h"
+#include "materials.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+using namespace std;
+
+// Canais de luz: 0 = céu (bits 4-7), 1 = blocos (bits 0-3)
+const int CANAL_CEU = 0;
+const int CANAL_BLOCO = 1;
+// Índice de -Y em FACE_DIR (a luz do céu desce sem perder nível)
+const int FACE_BAIXO = 3;
+
+static inline int nivel(uint8_t luz, int canal) {
+    return canal == CANAL_CEU ? luzCeu(luz) : luzBloco(luz);
+}
+
+static inline uint8_t comNivel(uint8_t luz, int canal, int valor) {
+    return canal == CANAL_CEU ? empacotaLuz(valor, luzBloco(luz)) : empacotaLuz(luzCeu(luz), valor);
+}
+
+// Vazio e transparente deixam a luz passar
+static inline bool passaLuz(uint8_t voxel) {
+    return !voxelVisivel(voxel) || isTransparent(voxelTextura(voxel));
+}
+
+static inline int emissao(uint8_t voxel) {
+    int tex = voxelTextura(voxel);
+    return (voxelVisivel(voxel) && tex < NUM_TEXTURES) ? luzEmitida[tex] : 0;
+}
+
+// Nível que uma célula com 'valor' leva ao vizinho na direção f
+static inline int nivelVizinho(int canal, int valor, int f) {
+    return (canal == CANAL_CEU && valor == LUZ_MAX && f == FACE_BAIXO) ? LUZ_MAX : valor - 1;
+}
+
+static inline uint8_t& luzRef(World& world, int x, int y, int z) {
+    return world.chunk(x / CHUNK_TAM, y / CHUNK_TAM, z / CHUNK_TAM)
+        .light[Chunk::index(x % CHUNK_TAM, y % CHUNK_TAM, z % CHUNK_TAM)];
+}
+
+// Distribui os índices 0..n-1 entre as threads (a chamadora também trabalha)
+template <typename F>
+static void parallelFor(int n, int threads, F func) {
+    atomic<int> next(0);
+    auto worker = [&]() {
+        PERFIL_ESCOPO("luz");
+        for (int i = next++; i < n; i = next++)
+            func(i);
+    };
+    vector<thread> pool;
+    for (int t = 1; t < min(threads, n); t++)
+        pool.emplace_back([&]() {
+            PERFIL_THREAD("luz");
+            worker();
+        });
+    worker();
+    for (thread& t : pool)
+        t.join();
+}
+
+// Fila de propagação de um canal: cada célula acende os vizinhos que ganham com a sua luz
+void LightEngine::propagate(World& world, int canal) {
+    vector<Node>& fila = addQueue[canal];
+    for (size_t i = 0; i < fila.size(); i++) {
+        Node q = fila[i];
+        int valor = nivel(world.light(q.x, q.y, q.z), canal);
+        if (valor <= 1)
+            continue;
+        for (int f = 0; f < NUM_FACES; f++) {
+            int nx = q.x + FACE_DIR[f][0], ny = q.y + FACE_DIR[f][1], nz = q.z + FACE_DIR[f][2];
+            if (!world.inside(nx, ny, nz) || !passaLuz(world.get(nx, ny, nz)))
+                continue;
+            int novo = nivelVizinho(canal, valor, f);
+            uint8_t luz = world.light(nx, ny, nz);
+            if (novo <= nivel(luz, canal))
+                continue;
+            world.setLight(nx, ny, nz, comNivel(luz, canal, novo));
+            fila.push_back({ nx, ny, nz, (uint8_t)novo });
+            lastStats.cellsLit++;
+        }
+    }
+    fila.clear();
+}
+
+void LightEngine::update(World& world) {
+    lastStats = LightStats();
+    if (!world.takeEdits(edits)) {
+        relightAll(world);
+        return;
+    }
+    if (edits.empty())
+        return;
+    lastStats.edits = (int)edits.size();
+
+    // Apaga as posições editadas (a luz antiga vira semente de remoção)
+    for (const VoxelEdit& e : edits) {
+        uint8_t luz = world.light(e.x, e.y, e.z);
+        world.setLight(e.x, e.y, e.z, 0);
+        for (int canal = 0; canal < 2; canal++)
+            if (nivel(luz, canal) > 0)
+                removeQueue[canal].push_back({ e.x, e.y, e.z, (uint8_t)nivel(luz, canal) });
+    }
+
+    for (int canal = 0; canal < 2; canal++) {
+        // Remoção: apaga quem dependia da luz removida; quem tem luz própria (de outra
+        // fonte) fica na borda e vira semente de propagação
+        vector<Node>& remover = removeQueue[canal];
+        for (size_t i = 0; i < remover.size(); i++) {
+            Node q = remover[i];
+            for (int f = 0; f < NUM_FACES; f++) {
+                int nx = q.x + FACE_DIR[f][0], ny = q.y + FACE_DIR[f][1], nz = q.z + FACE_DIR[f][2];
+                if (!world.inside(nx, ny, nz))
+                    continue;
+                uint8_t luz = world.light(nx, ny, nz);
+                int vizinho = nivel(luz, canal);
+                if (vizinho == 0)
+                    continue;
+                bool dependia = vizinho < q.level ||
+                    (canal == CANAL_CEU && f == FACE_BAIXO && q.level == LUZ_MAX && vizinho == LUZ_MAX);
+                if (dependia) {
+                    world.setLight(nx, ny, nz, comNivel(luz, canal, 0));
+                    remover.push_back({ nx, ny, nz, (uint8_t)vizinho });
+                    lastStats.cellsRemoved++;
+                    // Um emissor apagado volta com a própria luz
+                    if (canal == CANAL_BLOCO && emissao(world.get(nx, ny, nz)) > 0)
+                        addQueue[canal].push_back({ nx, ny, nz, (uint8_t)emissao(world.get(nx, ny, nz)) });
+                } else {
+                    addQueue[canal].push_back({ nx, ny, nz, (uint8_t)vizinho });
+                }
+            }
+        }
+        remover.clear();
+
+        // As posições editadas recebem a luz própria (emissor, topo do mundo) e a dos vizinhos
+        for (const VoxelEdit& e : edits) {
+            uint8_t voxel = world.get(e.x, e.y, e.z);
+            int propria = 0;
+            if (canal == CANAL_BLOCO)
+                propria = emissao(voxel);
+            else if (e.y == world.sizeY() - 1 && passaLuz(voxel))
+                propria = LUZ_MAX;
+            if (propria > 0)
+                addQueue[canal].push_back({ e.x, e.y, e.z, (uint8_t)propria });
+            for (int f = 0; f < NUM_FACES; f++) {
+                int nx = e.x + FACE_DIR[f][0], ny = e.y + FACE_DIR[f][1], nz = e.z + FACE_DIR[f][2];
+                if (world.inside(nx, ny, nz) && nivel(world.light(nx, ny, nz), canal) > 0)
+                    addQueue[canal].push_back({ nx, ny, nz, (uint8_t)nivel(world.light(nx, ny, nz), canal) });
+            }
+        }
+
+        // Sementes com nível acima do atual (emissores e topo) são gravadas antes de propagar
+        for (const Node& q : addQueue[canal]) {
+            uint8_t luz = world.light(q.x, q.y, q.z);
+            if (q.level > nivel(luz, canal)) {
+                world.setLight(q.x, q.y, q.z, comNivel(luz, canal, q.level));
+                lastStats.cellsLit++;
+            }
+        }
+        propagate(world, canal);
+    }
+    edits.clear();
+}
+
+void LightEngine::relightAll(World& world) {
+    lastStats = LightStats();
+    lastStats.full = true;
+    int numThreads = threads > 0 ? threads : max(1u, thread::hardware_concurrency());
+    const int sx = world.sizeX(), sy = world.sizeY(), sz = world.sizeZ();
+
+    // 1. Por coluna, a célula mais alta que barra a luz (-1 = coluna toda aberta)
+    vector<int> topo((size_t)sx * sz, -1);
+    parallelFor(world.chunksX() * world.chunksZ(), numThreads, [&](int coluna) {
+        int x0 = (coluna % world.chunksX()) * CHUNK_TAM, z0 = (coluna / world.chunksX()) * CHUNK_TAM;
+        for (int z = z0; z < min(z0 + CHUNK_TAM, sz); z++)
+            for (int x = x0; x < min(x0 + CHUNK_TAM, sx); x++)
+                for (int y = sy - 1; y >= 0; y--)
+                    if (!passaLuz(world.get(x, y, z))) {
+                        topo[(size_t)z * sx + x] = y;
+                        break;
+                    }
+    });
+
+    // 2. Cada chunk sozinho: céu aberto, emissores e propagação só dentro do chunk
+    atomic<long long> acesas(0);
+    parallelFor(world.chunkCount(), numThreads, [&](int ci) {
+        int cx = ci % world.chunksX(), cz = (ci / world.chunksX()) % world.chunksZ();
+        int cy = ci / (world.chunksX() * world.chunksZ());
+        int bx = cx * CHUNK_TAM, by = cy * CHUNK_TAM, bz = cz * CHUNK_TAM;
+        int rx = min(CHUNK_TAM, sx - bx), ry = min(CHUNK_TAM, sy - by), rz = min(CHUNK_TAM, sz - bz);
+        // Fora da memória (streaming): fica com a luz que foi gravada
+        if (!world.chunkResident(cx, cy, cz))
+            return;
+        Chunk& chunk = world.chunk(cx, cy, cz);
+
+        static thread_local vector<uint16_t> fila;
+        fila.clear();
+        for (int y = 0; y < CHUNK_TAM; y++)
+            for (int z = 0; z < CHUNK_TAM; z++)
+                for (int x = 0; x < CHUNK_TAM; x++) {
+                    int i = Chunk::index(x, y, z);
+                    if (x >= rx || y >= ry || z >= rz) {
+                        chunk.light[i] = 0;
+                        continue;
+                    }
+                    uint8_t voxel = chunk.voxels[i];
+                    int ceu = (passaLuz(voxel) && by + y > topo[(size_t)(bz + z) * sx + bx + x]) ? LUZ_MAX : 0;
+                    chunk.light[i] = empacotaLuz(ceu, emissao(voxel));
+                    if (chunk.light[i] != 0)
+                        fila.push_back((uint16_t)i);
+                }
+
+        long long n = 0;
+        for (size_t k = 0; k < fila.size(); k++) {
+            int i = fila[k];
+            int x = i % CHUNK_TAM, z = (i / CHUNK_TAM) % CHUNK_TAM, y = i / (CHUNK_TAM * CHUNK_TAM);
+            uint8_t luz = chunk.light[i];
+            for (int f = 0; f < NUM_FACES; f++) {
+                int nx = x + FACE_DIR[f][0], ny = y + FACE_DIR[f][1], nz = z + FACE_DIR[f][2];
+                if (nx < 0 || ny < 0 || nz < 0 || nx >= rx || ny >= ry || nz >= rz)
+                    continue;
+                int j = Chunk::index(nx, ny, nz);
+                if (!passaLuz(chunk.voxels[j]))
+                    continue;
+                uint8_t antes = chunk.light[j], depois = antes;
+                for (int canal = 0; canal < 2; canal++) {
+                    int novo = nivelVizinho(canal, nivel(luz, canal), f);
+                    if (novo > nivel(depois, canal))
+                        depois = comNivel(depois, canal, novo);
+                }
+                if (depois != antes) {
+                    chunk.light[j] = depois;
+                    fila.push_back((uint16_t)j);
+                    n++;
+                }
+            }
+        }
+        acesas += n;
+    });
+
+    // 3. Sementes globais: células de borda que acendem o chunk vizinho
+    vector<vector<Node>> sementes(world.chunkCount());
+    parallelFor(world.chunkCount(), numThreads, [&](int ci) {
+        int cx = ci % world.chunksX(), cz = (ci / world.chunksX()) % world.chunksZ();
+        int cy = ci / (world.chunksX() * world.chunksZ());
+        int bx = cx * CHUNK_TAM, by = cy * CHUNK_TAM, bz = cz * CHUNK_TAM;
+        int rx = min(CHUNK_TAM, sx - bx), ry = min(CHUNK_TAM, sy - by), rz = min(CHUNK_TAM, sz - bz);
+        if (!world.chunkResident(cx, cy, cz))
+            return;
+        const Chunk& chunk = world.chunk(cx, cy, cz);
+        for (int y = 0; y < ry; y++)
+            for (int z = 0; z < rz; z++)
+                for (int x = 0; x < rx; x++) {
+                    if (x != 0 && y != 0 && z != 0 && x != rx - 1 && y != ry - 1 && z != rz - 1)
+                        continue;
+                    uint8_t luz = chunk.light[Chunk::index(x, y, z)];
+                    if (luz == 0)
+                        continue;
+                    for (int f = 0; f < NUM_FACES; f++) {
+                        int lx = x + FACE_DIR[f][0], ly = y + FACE_DIR[f][1], lz = z + FACE_DIR[f][2];
+                        if (lx >= 0 && ly >= 0 && lz >= 0 && lx < rx && ly < ry && lz < rz)
+                            continue;
+                        int nx = bx + lx, ny = by + ly, nz = bz + lz;
+                        if (!world.inside(nx, ny, nz) || !passaLuz(world.get(nx, ny, nz)))
+                            continue;
+                        uint8_t vizinho = world.light(nx, ny, nz);
+                        bool acende = false;
+                        for (int canal = 0; canal < 2; canal++)
+                            acende |= nivelVizinho(canal, nivel(luz, canal), f) > nivel(vizinho, canal);
+                        if (acende) {
+                            sementes[ci].push_back({ bx + x, by + y, bz + z, 0 });
+                            break;
+                        }
+                    }
+                }
+    });
+
+    // 4. Propagação global (sequencial) pelos dois canais de uma vez
+    vector<Node>& fila = addQueue[0];
+    fila.clear();
+    for (const vector<Node>& s : sementes)
+        fila.insert(fila.end(), s.begin(), s.end());
+    long long n = 0;
+    for (size_t k = 0; k < fila.size(); k++) {
+        Node q = fila[k];
+        uint8_t luz = luzRef(world, q.x, q.y, q.z);
+        for (int f = 0; f < NUM_FACES; f++) {
+            int nx = q.x + FACE_DIR[f][0], ny = q.y + FACE_DIR[f][1], nz = q.z + FACE_DIR[f][2];
+            if (!world.inside(nx, ny, nz) || !passaLuz(world.get(nx, ny, nz)) ||
+                !world.chunkResident(nx / CHUNK_TAM, ny / CHUNK_TAM, nz / CHUNK_TAM))
+                continue;
+            uint8_t& vizinho = luzRef(world, nx, ny, nz);
+            uint8_t depois = vizinho;
+            for (int canal = 0; canal < 2; canal++) {
+                int novo = nivelVizinho(canal, nivel(luz, canal), f);
+                if (novo > nivel(depois, canal))
+                    depois = comNivel(depois, canal, novo);
+            }
+            if (depois != vizinho) {
+                vizinho = depois;
+                fila.push_back({ nx, ny, nz, 0 });
+                n++;
+            }
+        }
+    }
+    fila.clear();
+    lastStats.cellsLit = acesas + n;
+
+    // As luzes foram escritas direto nos chunks: marca tudo de uma vez
+    world.touchAll();
+    world.takeEdits(edits);
+    edits.clear();
+}
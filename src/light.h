@@ -0,0 +1,49 @@
+#pragma once
+
+#include "world.h"
+
+#include <vector>
+
+// Estatísticas da última chamada de update/relightAll
+struct LightStats {
+    bool full = false;          // refez o mundo inteiro
+    int edits = 0;              // posições editadas processadas
+    long long cellsRemoved = 0; // células apagadas no pass de remoção
+    long long cellsLit = 0;     // células que receberam luz no pass de propagação
+};
+
+// Luz do céu e dos blocos (0..15 cada, guardadas em Chunk::light) por propagação em
+// largura: a luz perde 1 a cada passo por células que deixam a luz passar (vazias ou
+// transparentes); a do céu desce sem perder nada enquanto vale 15.
+//
+// As edições são tratadas de forma incremental pelo algoritmo de duas filas: a fila
+// de remoção apaga as células que dependiam da luz antiga (nível menor que o da
+// célula de onde veio) e junta as que têm luz própria na borda da região apagada;
+// a fila de propagação reacende a partir delas. Uma edição só mexe no raio que a luz
+// alcança. O mundo inteiro só é refeito no início, depois de R/resize/carga de
+// arquivo ou se o registro de edições do mundo transbordar
+class LightEngine {
+public:
+    // Processa as edições registradas no mundo desde a última chamada
+    void update(World& world);
+    // Refaz a luz do mundo inteiro: altura do céu por coluna e propagação dentro de
+    // cada chunk em paralelo, depois uma propagação global a partir das bordas
+    void relightAll(World& world);
+
+    const LightStats& stats() const { return lastStats; }
+
+    // Threads do relightAll (0 = hardware_concurrency)
+    int threads = 0;
+
+private:
+    struct Node {
+        int x, y, z;
+        uint8_t level;
+    };
+
+    void propagate(World& world, int canal);
+
+    std::vector<VoxelEdit> edits;
+    std::vector<Node> removeQueue[2], addQueue[2];
+    LightStats lastStats;
+};
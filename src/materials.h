@@ -0,0 +1,32 @@
+#pragma once
+
+// Tabela de materiais (texturas de bloco). O índice é o texID guardado no voxel
+const int NUM_TEXTURES = 9;
+
+// Textura do cubo de seleção (não pode ser aplicada a voxels)
+const int TEXTURA_SELECAO = 8;
+
+inline const char* const textureNames[NUM_TEXTURES] = {
+    "Moss Block", "Glass", "Blackstone Bricks", "Sponge",
+    "Honey Block", "Loom", "Packed Mud", "Frosted Ice", "Selection"
+};
+
+// Arquivos em assets/block_tex
+inline const char* const textureFiles[NUM_TEXTURES] = {
+    "moss_block.png", "glass.png", "polished_blackstone_bricks.png", "sponge.png",
+    "honey_block_top.png", "loom_bottom.png", "packed_mud.png", "frosted_ice_0.png", "selected.png"
+};
+
+// Texturas com transparência (vão para o pass transparente da fila de desenho)
+inline const bool texturaTransparente[NUM_TEXTURES] = {
+    false, true, false, false, true, false, false, true, true
+};
+
+// Luz que o bloco emite (0..15, ver LightEngine). O mel brilha
+inline const uint8_t luzEmitida[NUM_TEXTURES] = {
+    0, 0, 0, 0, 12, 0, 0, 0, 0
+};
+
+inline bool isTransparent(int texID) {
+    return texID >= 0 && texID < NUM_TEXTURES && texturaTransparente[texID];
+}
@@ -0,0 +1,175 @@
+#include "mesher.h"
+#include "materials.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+// Cantos de cada face no sentido anti-horário visto de fora, na ordem de FACE_DIR
+static const uint8_t FACE_CORNERS[NUM_FACES][4][3] = {
+    { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } }, // +X
+    { { 0, 0, 1 }, { 0, 1, 1 }, { 0, 1, 0 }, { 0, 0, 0 } }, // -X
+    { { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 }, { 1, 1, 0 } }, // +Y
+    { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } }, // -Y
+    { { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } }, // +Z
+    { { 1, 0, 0 }, { 0, 0, 0 }, { 0, 1, 0 }, { 1, 1, 0 } }  // -Z
+};
+
+// Voxel escondido conta como vazio
+static inline uint8_t solidValue(uint8_t voxel) {
+    return voxelVisivel(voxel) ? voxel : 0;
+}
+
+// Material majoritário num bloco de s^3 voxels (vazio também vota).
+// Em caso de empate ganha o material sólido, para não apagar estruturas finas
+static uint8_t majority(const World& world, int x0, int y0, int z0, int s) {
+    uint16_t count[256];
+    uint8_t seen[512];
+    int numSeen = 0;
+    memset(count, 0, sizeof(count));
+
+    for (int y = y0; y < y0 + s; y++)
+        for (int z = z0; z < z0 + s; z++)
+            for (int x = x0; x < x0 + s; x++) {
+                uint8_t v = solidValue(world.get(x, y, z));
+                if (count[v]++ == 0)
+                    seen[numSeen++] = v;
+            }
+
+    uint8_t best = 0;
+    int bestCount = -1;
+    for (int i = 0; i < numSeen; i++) {
+        uint8_t v = seen[i];
+        if (count[v] > bestCount || (count[v] == bestCount && best == 0)) {
+            best = v;
+            bestCount = count[v];
+        }
+    }
+    return best;
+}
+
+// Luz de um bloco de s^3 voxels: o maior nível de cada canal
+static uint8_t blockLight(const World& world, int x0, int y0, int z0, int s) {
+    int ceu = 0, bloco = 0;
+    for (int y = y0; y < y0 + s; y++)
+        for (int z = z0; z < z0 + s; z++)
+            for (int x = x0; x < x0 + s; x++) {
+                uint8_t luz = world.light(x, y, z);
+                ceu = max(ceu, luzCeu(luz));
+                bloco = max(bloco, luzBloco(luz));
+            }
+    return empacotaLuz(ceu, bloco);
+}
+
+// A face do voxel 'a' voltada para o vizinho 'b' aparece?
+static inline bool faceVisible(uint8_t a, uint8_t b) {
+    if (!voxelVisivel(b)) return true;
+    bool ta = isTransparent(voxelTextura(a));
+    bool tb = isTransparent(voxelTextura(b));
+    if (!tb) return false;    // vizinho opaco esconde
+    if (ta) return a != b;    // entre transparentes, só entre materiais diferentes
+    return true;              // opaco atrás de transparente
+}
+
+// Célula que faz sombra: sólida e opaca (vidro e mel não escurecem os cantos)
+static inline bool occludes(uint8_t cell) {
+    return voxelVisivel(cell) && !isTransparent(voxelTextura(cell));
+}
+
+// ao[i] é a oclusão do canto FACE_CORNERS[face][i]; luz é a da célula em frente à face
+static void emitQuad(vector<ChunkVertex>& out, int x, int y, int z, int s, int face, uint8_t voxel, const int ao[4],
+                     uint8_t luz) {
+    // Diagonal pelos cantos mais claros: com a soma menor em 0-2, começa do canto 1
+    int start = (ao[0] + ao[2] < ao[1] + ao[3]) ? 1 : 0;
+    for (int k = 0; k < 4; k++) {
+        int i = (start + k) & 3;
+        ChunkVertex v;
+        v.x = (uint8_t)(x + FACE_CORNERS[face][i][0] * s);
+        v.y = (uint8_t)(y + FACE_CORNERS[face][i][1] * s);
+        v.z = (uint8_t)(z + FACE_CORNERS[face][i][2] * s);
+        v.face = (uint8_t)face;
+        v.material = (uint8_t)voxelTextura(voxel);
+        v.ao = (uint8_t)ao[i];
+        v.light = luz;
+        v.reserved = 0;
+        out.push_back(v);
+    }
+}
+
+void meshChunk(const World& world, int cx, int cy, int cz, int lod, ChunkMesh& mesh) {
+    const int s = 1 << lod;
+    const int R = CHUNK_TAM >> lod;
+    const int P = R + 2;
+    const int bx = cx * CHUNK_TAM, by = cy * CHUNK_TAM, bz = cz * CHUNK_TAM;
+
+    // Células do LOD (e a luz de cada uma) com uma borda de 1 célula tirada dos chunks vizinhos
+    static thread_local vector<uint8_t> cells, lights;
+    cells.assign((size_t)P * P * P, 0);
+    lights.assign((size_t)P * P * P, 0);
+    auto at = [&](int x, int y, int z) {
+        return ((size_t)(y + 1) * P + (z + 1)) * P + (x + 1);
+    };
+    auto cell = [&](int x, int y, int z) -> uint8_t& { return cells[at(x, y, z)]; };
+    for (int y = -1; y <= R; y++)
+        for (int z = -1; z <= R; z++)
+            for (int x = -1; x <= R; x++) {
+                if (lod == 0) {
+                    cell(x, y, z) = solidValue(world.get(bx + x, by + y, bz + z));
+                    lights[at(x, y, z)] = world.light(bx + x, by + y, bz + z);
+                } else {
+                    cell(x, y, z) = majority(world, bx + x * s, by + y * s, bz + z * s, s);
+                    lights[at(x, y, z)] = blockLight(world, bx + x * s, by + y * s, bz + z * s, s);
+                }
+            }
+
+    static thread_local vector<ChunkVertex> opaque, skirt, transparent;
+    opaque.clear();
+    skirt.clear();
+    transparent.clear();
+
+    for (int y = 0; y < R; y++)
+        for (int z = 0; z < R; z++)
+            for (int x = 0; x < R; x++) {
+                uint8_t a = cell(x, y, z);
+                if (!voxelVisivel(a)) continue;
+                bool transp = isTransparent(voxelTextura(a));
+
+                for (int f = 0; f < NUM_FACES; f++) {
+                    int nx = x + FACE_DIR[f][0], ny = y + FACE_DIR[f][1], nz = z + FACE_DIR[f][2];
+                    uint8_t b = cell(nx, ny, nz);
+                    vector<ChunkVertex>* out;
+                    if (faceVisible(a, b))
+                        out = transp ? &transparent : &opaque;
+                    else if (!transp && (nx < 0 || ny < 0 || nz < 0 || nx >= R || ny >= R || nz >= R))
+                        out = &skirt;
+                    else
+                        continue;
+
+                    // Vizinhos de cada canto na camada da frente (a célula nx, ny, nz):
+                    // nos dois eixos da face, o canto 0/1 vira o passo -1/+1
+                    int u = (FACE_DIR[f][0] == 0) ? 0 : 1;
+                    int w = (FACE_DIR[f][2] == 0) ? 2 : 1;
+                    int ao[4];
+                    for (int i = 0; i < 4; i++) {
+                        int side1[3] = { 0, 0, 0 }, side2[3] = { 0, 0, 0 };
+                        side1[u] = FACE_CORNERS[f][i][u] * 2 - 1;
+                        side2[w] = FACE_CORNERS[f][i][w] * 2 - 1;
+                        ao[i] = vertexAO(occludes(cell(nx + side1[0], ny + side1[1], nz + side1[2])),
+                                         occludes(cell(nx + side2[0], ny + side2[1], nz + side2[2])),
+                                         occludes(cell(nx + side1[0] + side2[0], ny + side1[1] + side2[1],
+                                                       nz + side1[2] + side2[2])));
+                    }
+                    emitQuad(*out, x * s, y * s, z * s, s, f, a, ao, lights[at(nx, ny, nz)]);
+                }
+            }
+
+    mesh.opaqueQuads = (int)opaque.size() / 4;
+    mesh.skirtQuads = (int)skirt.size() / 4;
+    mesh.transparentQuads = (int)transparent.size() / 4;
+    mesh.vertices.clear();
+    mesh.vertices.reserve(opaque.size() + skirt.size() + transparent.size());
+    mesh.vertices.insert(mesh.vertices.end(), opaque.begin(), opaque.end());
+    mesh.vertices.insert(mesh.vertices.end(), skirt.begin(), skirt.end());
+    mesh.vertices.insert(mesh.vertices.end(), transparent.begin(), transparent.end());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "world.h"
+
+#include <cstdint>
+#include <vector>
+
+// Níveis de detalhe: 0 = resolução cheia, 1..3 = reduzido 2x, 4x e 8x
+const int MAX_LOD = 3;
+const int NUM_LODS = MAX_LOD + 1;
+
+// Vértice compacto de chunk (8 bytes). Posição local em voxels do LOD 0 (0..CHUNK_TAM),
+// a coordenada de textura é derivada da posição e da face no shader. ao é a oclusão
+// ambiente do canto, calculada na geração da malha (0 = canto fechado, 3 = livre), e
+// light a luz da célula em frente à face (céu << 4 | blocos, ver LightEngine)
+struct ChunkVertex {
+    uint8_t x, y, z, face;
+    uint8_t material;
+    uint8_t ao;
+    uint8_t light;
+    uint8_t reserved;
+};
+static_assert(sizeof(ChunkVertex) == 8, "ChunkVertex deve ter 8 bytes");
+
+// Oclusão de um canto pela regra dos 3 vizinhos: as duas células de lado e a da
+// diagonal, na camada em frente à face. Dois lados fechados escurecem ao máximo
+inline int vertexAO(bool side1, bool side2, bool corner) {
+    if (side1 && side2)
+        return 0;
+    return 3 - ((int)side1 + (int)side2 + (int)corner);
+}
+
+// Malha de um chunk num LOD. Quads de 4 vértices em três faixas consecutivas:
+// opacos | saia | transparentes. A saia são as faces de borda escondidas só pelo
+// chunk vizinho; ela é desenhada quando o vizinho está em outro LOD, fechando as
+// frestas entre níveis diferentes. Cada quad começa pelo vértice que faz a diagonal
+// dos dois triângulos (0-2) passar pelos cantos mais claros, para a oclusão
+// interpolar sem a dobra na diagonal errada. As faces não são fundidas (um quad por
+// face de célula); quem fundir faces tem de exigir a mesma oclusão nos cantos
+struct ChunkMesh {
+    std::vector<ChunkVertex> vertices;
+    int opaqueQuads = 0;
+    int skirtQuads = 0;
+    int transparentQuads = 0;
+
+    int quads() const { return opaqueQuads + skirtQuads + transparentQuads; }
+};
+
+void meshChunk(const World& world, int cx, int cy, int cz, int lod, ChunkMesh& mesh);
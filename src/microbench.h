@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Microbenchmarks no estilo do Google Benchmark, só com cabeçalho (o projeto não
+// baixa a biblioteca para isso). Cada benchmark é uma função que recebe State e
+// repete o trabalho em "for (auto _ : state)"; o que vem antes do laço é preparação
+// e não é medido. O executor repete a função aumentando as iterações até passar do
+// tempo mínimo e informa o tempo por iteração e, se a função disse quantos itens ou
+// bytes cada iteração processa, a vazão. Os argumentos (state.range(i)) vêm do
+// produto cartesiano de listas registradas com ArgsProduct
+namespace microbench {
+
+// Impede o compilador de descartar um valor ou uma escrita na memória
+template <typename T>
+inline void DoNotOptimize(const T& valor) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(valor) : "memory");
+#else
+    static volatile const void* sumidouro;
+    sumidouro = &valor;
+#endif
+}
+
+inline void ClobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#endif
+}
+
+class State {
+public:
+    using Relogio = std::chrono::steady_clock;
+
+    State(int64_t iteracoes, const std::vector<int64_t>& argumentos)
+        : maxIteracoes(iteracoes), args(argumentos) {}
+
+    // Valor do "_" do laço (marcado como sem uso para o compilador não avisar)
+#if defined(__GNUC__) || defined(__clang__)
+    struct __attribute__((unused)) Volta {};
+#else
+    struct Volta {};
+#endif
+
+    // Iterador do laço: começa o relógio na primeira volta e para na última
+    struct Iterador {
+        State* state;
+        int64_t restantes;
+        bool operator!=(const Iterador&) {
+            if (restantes > 0)
+                return true;
+            state->termina();
+            return false;
+        }
+        void operator++() { restantes--; }
+        Volta operator*() const { return Volta(); }
+    };
+    Iterador begin() {
+        inicio = Relogio::now();
+        rodando = true;
+        return Iterador{ this, maxIteracoes };
+    }
+    Iterador end() { return Iterador{ this, 0 }; }
+
+    int64_t range(int i = 0) const { return i < (int)args.size() ? args[i] : 0; }
+    int64_t iterations() const { return maxIteracoes; }
+
+    // Trabalho fora da medida dentro do laço (ex. refazer a entrada)
+    void PauseTiming() {
+        if (rodando) {
+            acumulado += Relogio::now() - inicio;
+            rodando = false;
+        }
+    }
+    void ResumeTiming() {
+        if (!rodando) {
+            inicio = Relogio::now();
+            rodando = true;
+        }
+    }
+
+    void SetItemsProcessed(int64_t n) { itens = n; }
+    void SetBytesProcessed(int64_t n) { bytes = n; }
+    void SetLabel(const std::string& texto) { rotulo = texto; }
+    void SkipWithError(const std::string& mensagem) { erro = mensagem; }
+
+    double seconds() const { return std::chrono::duration<double>(acumulado).count(); }
+
+private:
+    friend struct Runner;
+    void termina() { PauseTiming(); }
+
+    int64_t maxIteracoes;
+    std::vector<int64_t> args;
+    Relogio::time_point inicio;
+    Relogio::duration acumulado = Relogio::duration::zero();
+    bool rodando = false;
+    int64_t itens = 0, bytes = 0;
+    std::string rotulo, erro;
+};
+
+struct Benchmark {
+    std::string nome;
+    std::function<void(State&)> funcao;
+    std::vector<std::string> nomesArgs;
+    std::vector<std::vector<int64_t>> combinacoes;
+
+    Benchmark* Args(const std::vector<int64_t>& args) {
+        combinacoes.push_back(args);
+        return this;
+    }
+    Benchmark* ArgsProduct(const std::vector<std::vector<int64_t>>& listas) {
+        std::vector<std::vector<int64_t>> produto = { {} };
+        for (const std::vector<int64_t>& lista : listas) {
+            std::vector<std::vector<int64_t>> proximo;
+            for (const std::vector<int64_t>& prefixo : produto)
+                for (int64_t valor : lista) {
+                    proximo.push_back(prefixo);
+                    proximo.back().push_back(valor);
+                }
+            produto.swap(proximo);
+        }
+        combinacoes.insert(combinacoes.end(), produto.begin(), produto.end());
+        return this;
+    }
+    Benchmark* ArgNames(const std::vector<std::string>& nomes) {
+        nomesArgs = nomes;
+        return this;
+    }
+};
+
+inline std::vector<Benchmark*>& registro() {
+    static std::vector<Benchmark*> lista;
+    return lista;
+}
+
+inline Benchmark* registra(const char* nome, std::function<void(State&)> funcao) {
+    Benchmark* b = new Benchmark();
+    b->nome = nome;
+    b->funcao = std::move(funcao);
+    registro().push_back(b);
+    return b;
+}
+
+struct Runner {
+    double tempoMinimo = 0.2;   // segundos medidos por caso
+    std::string filtro;         // só os casos cujo nome contém o texto
+
+    static std::string nomeCaso(const Benchmark& b, const std::vector<int64_t>& args) {
+        std::string nome = b.nome;
+        for (size_t i = 0; i < args.size(); i++) {
+            nome += "/";
+            if (i < b.nomesArgs.size())
+                nome += b.nomesArgs[i] + ":";
+            nome += std::to_string(args[i]);
+        }
+        return nome;
+    }
+
+    static std::string vazao(double porSegundo, const char* unidade) {
+        const char* prefixos[] = { "", "k", "M", "G", "T" };
+        int p = 0;
+        while (porSegundo >= 1000.0 && p < 4) {
+            porSegundo /= 1000.0;
+            p++;
+        }
+        char texto[64];
+        snprintf(texto, sizeof(texto), "%.2f%s%s/s", porSegundo, prefixos[p], unidade);
+        return texto;
+    }
+
+    // Executa um caso até o tempo mínimo e imprime uma linha. Devolve false em erro
+    bool executa(const Benchmark& b, const std::vector<int64_t>& args) {
+        std::string nome = nomeCaso(b, args);
+        if (!filtro.empty() && nome.find(filtro) == std::string::npos)
+            return true;
+
+        int64_t iteracoes = 1;
+        for (;;) {
+            State state(iteracoes, args);
+            b.funcao(state);
+            if (!state.erro.empty()) {
+                printf("%-48s ERRO: %s\n", nome.c_str(), state.erro.c_str());
+                return false;
+            }
+            double s = state.seconds();
+            if (s >= tempoMinimo || iteracoes >= 1000000000) {
+                double ns = s * 1e9 / iteracoes;
+                printf("%-48s %14.1f ns %12lld", nome.c_str(), ns, (long long)iteracoes);
+                if (state.itens > 0)
+                    printf("  itens=%s", vazao(state.itens / s, "").c_str());
+                if (state.bytes > 0)
+                    printf("  bytes=%s", vazao(state.bytes / s, "B").c_str());
+                if (!state.rotulo.empty())
+                    printf("  %s", state.rotulo.c_str());
+                printf("\n");
+                fflush(stdout);
+                return true;
+            }
+            // Estima as iterações para o tempo mínimo (com folga), no máximo 10x por vez
+            double fator = s > 0.0 ? tempoMinimo * 1.4 / s : 10.0;
+            iteracoes = std::min<int64_t>(1000000000, std::max<int64_t>(iteracoes + 1,
+                                          (int64_t)(iteracoes * std::min(10.0, fator))));
+        }
+    }
+
+    int executaTodos() {
+        printf("%-48s %17s %12s\n", "Benchmark", "Tempo", "Iteracoes");
+        printf("%s\n", std::string(80, '-').c_str());
+        int falhas = 0;
+        for (Benchmark* b : registro()) {
+            if (b->combinacoes.empty())
+                b->combinacoes.push_back({});
+            for (const std::vector<int64_t>& args : b->combinacoes)
+                falhas += executa(*b, args) ? 0 : 1;
+        }
+        return falhas == 0 ? 0 : 1;
+    }
+};
+
+} // namespace microbench
+
+#define MICROBENCH_CONCAT2(a, b) a##b
+#define MICROBENCH_CONCAT(a, b) MICROBENCH_CONCAT2(a, b)
+#define BENCHMARK(funcao) \
+    static microbench::Benchmark* MICROBENCH_CONCAT(benchmark_, __LINE__) = microbench::registra(#funcao, funcao)
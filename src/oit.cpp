@@ -0,0 +1,171 @@
+#include "oit.h"
+#include "profiler.h"
+#include "shader.h"
+
+#include <iostream>
+
+using namespace std;
+
+// Triângulo que cobre a tela, gerado a partir de gl_VertexID
+static const GLchar* fullscreenVertexSource = R"glsl(
+    #version 450
+    void main()
+    {
+        vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+        gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+    }
+)glsl";
+
+static const GLchar* compositeFragmentSource = R"glsl(
+    #version 450
+    out vec4 color;
+    uniform sampler2D accum_buff;
+    uniform sampler2D reveal_buff;
+    void main()
+    {
+        ivec2 coord = ivec2(gl_FragCoord.xy);
+        float reveal = texelFetch(reveal_buff, coord, 0).r;
+        if (reveal >= 1.0)
+            discard;
+        vec4 accum = texelFetch(accum_buff, coord, 0);
+        if (isinf(max(max(abs(accum.r), abs(accum.g)), abs(accum.b))))
+            accum.rgb = vec3(accum.a);
+        vec3 average = accum.rgb / max(accum.a, 1e-5);
+        color = vec4(average, 1.0 - reveal);
+    }
+)glsl";
+
+// Alvos de renderização
+static GLuint sceneFBO = 0, sceneColor = 0, sceneDepth = 0;
+static GLuint oitFBO = 0, accumTex = 0, revealTex = 0;
+static GLuint compositeProgram = 0, emptyVAO = 0;
+static int targetWidth = 0, targetHeight = 0;
+
+static GLuint createTarget(GLint internalFormat, GLenum format, GLenum type, int width, int height) {
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return tex;
+}
+
+static void createTargets(int width, int height) {
+    targetWidth = width;
+    targetHeight = height;
+
+    sceneColor = createTarget(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, width, height);
+    sceneDepth = createTarget(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, width, height);
+    accumTex = createTarget(GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, width, height);
+    revealTex = createTarget(GL_R8, GL_RED, GL_UNSIGNED_BYTE, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColor, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, sceneDepth, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "Framebuffer da cena incompleto!" << endl;
+
+    // O depth é o mesmo da cena: transparentes são testados contra os opacos
+    glGenFramebuffers(1, &oitFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, oitFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, revealTex, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, sceneDepth, 0);
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        cout << "Framebuffer de OIT incompleto!" << endl;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+static void destroyTargets() {
+    GLuint textures[] = { sceneColor, sceneDepth, accumTex, revealTex };
+    glDeleteTextures(4, textures);
+    glDeleteFramebuffers(1, &sceneFBO);
+    glDeleteFramebuffers(1, &oitFBO);
+}
+
+void setupOIT(int width, int height) {
+    createTargets(width, height);
+
+    compositeProgram = setupShader(fullscreenVertexSource, compositeFragmentSource);
+    glUseProgram(compositeProgram);
+    glUniform1i(glGetUniformLocation(compositeProgram, "accum_buff"), 0);
+    glUniform1i(glGetUniformLocation(compositeProgram, "reveal_buff"), 1);
+    glGenVertexArrays(1, &emptyVAO);
+}
+
+void resizeOIT(int width, int height) {
+    if (width <= 0 || height <= 0 || (width == targetWidth && height == targetHeight))
+        return;
+    destroyTargets();
+    createTargets(width, height);
+}
+
+void destroyOIT() {
+    destroyTargets();
+    glDeleteProgram(compositeProgram);
+    glDeleteVertexArrays(1, &emptyVAO);
+}
+
+// Junta a média ponderada dos transparentes sobre a cor dos opacos
+static void composite() {
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glUseProgram(compositeProgram);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, revealTex);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, accumTex);
+    glBindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_DEPTH_TEST);
+}
+
+void beginOITPass(RenderPass pass) {
+    glViewport(0, 0, targetWidth, targetHeight);
+
+    if (pass == PASS_OPACO) {
+        glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    else if (pass == PASS_TRANSPARENTE) {
+        glBindFramebuffer(GL_FRAMEBUFFER, oitFBO);
+        const GLfloat zeros[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const GLfloat ones[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glClearBufferfv(GL_COLOR, 0, zeros);
+        glClearBufferfv(GL_COLOR, 1, ones);
+
+        // Testa contra os opacos mas não escreve profundidade
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+        glBlendFunci(0, GL_ONE, GL_ONE);
+        glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+    }
+    else if (pass == PASS_SELECAO) {
+        composite();
+        glDepthMask(GL_TRUE);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+}
+
+void presentOIT(GLuint framebuffer) {
+    PERFIL_GPU("apresentacao");
+    int width = targetWidth, height = targetHeight;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glad/glad.h>
+#include "render_queue.h"
+
+// Transparência independente de ordem (Weighted Blended OIT, McGuire & Bavoil 2013).
+// Os opacos são desenhados num framebuffer de cena; os transparentes acumulam
+// cor ponderada e "revealage" em dois alvos que compartilham o depth da cena, e a
+// composição junta tudo antes do pass de seleção. O custo não depende de quantos
+// voxels transparentes há na tela e não precisa ordenar de trás para frente.
+
+// Cria os alvos e o programa de composição. Os shaders dos objetos transparentes
+// escrevem a cor ponderada em location 0 e o alpha ("revealage") em location 1
+void setupOIT(int width, int height);
+void resizeOIT(int width, int height);
+void destroyOIT();
+
+// Callback de pass da fila de desenho (liga framebuffers, blend e faz a composição)
+void beginOITPass(RenderPass pass);
+
+// Copia a cena final para o framebuffer padrão da janela (ou outro, no modo sem janela)
+void presentOIT(GLuint framebuffer = 0);
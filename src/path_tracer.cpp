@@ -0,0 +1,358 @@
+#include "path_tracer.h"
+#include "materials.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace std;
+
+// Sol e céu da prévia (radiância em RGB linear)
+static const glm::vec3 DIRECAO_SOL = glm::normalize(glm::vec3(0.45f, 0.85f, 0.3f));
+static const glm::vec3 COR_SOL = glm::vec3(2.6f, 2.45f, 2.2f);
+static const glm::vec3 CEU_HORIZONTE = glm::vec3(0.75f, 0.8f, 0.85f);
+static const glm::vec3 CEU_ZENITE = glm::vec3(0.3f, 0.5f, 0.85f);
+static const glm::vec3 CHAO = glm::vec3(0.2f, 0.19f, 0.18f);
+// Radiância de um bloco com luzEmitida = 15
+const float EMISSAO_MAX = 4.0f;
+const int MAX_PASSOS = 4096;
+const float EPS = 1e-3f;
+
+struct PathTracer::Packet {
+    alignas(32) float ox[PACOTE_RAIOS], oy[PACOTE_RAIOS], oz[PACOTE_RAIOS];
+    alignas(32) float dx[PACOTE_RAIOS], dy[PACOTE_RAIOS], dz[PACOTE_RAIOS];
+    int active[PACOTE_RAIOS];
+};
+
+struct PathTracer::Hits {
+    float t[PACOTE_RAIOS];
+    int material[PACOTE_RAIOS];   // -1 = saiu do mundo
+    int face[PACOTE_RAIOS];       // face do voxel atingida, na ordem de FACE_DIR
+};
+
+static inline uint32_t proximo(uint32_t& estado) {
+    // xorshift32
+    estado ^= estado << 13;
+    estado ^= estado >> 17;
+    estado ^= estado << 5;
+    return estado;
+}
+
+static inline float aleatorio(uint32_t& estado) {
+    return (proximo(estado) >> 8) * (1.0f / 16777216.0f);
+}
+
+static glm::vec3 ceu(const glm::vec3& d) {
+    if (d.y < 0.0f)
+        return CHAO;
+    float t = sqrt(d.y);
+    return CEU_HORIZONTE * (1.0f - t) + CEU_ZENITE * t;
+}
+
+void PathTracer::setup(const World& world, const BlockImages& images) {
+    sx = world.sizeX();
+    sy = world.sizeY();
+    sz = world.sizeZ();
+    origin = world.origin();
+    grid.assign((size_t)sx * sy * sz, 0);
+    for (int z = 0; z < sz; z++)
+        for (int y = 0; y < sy; y++)
+            for (int x = 0; x < sx; x++) {
+                uint8_t voxel = world.get(x, y, z);
+                if (voxelVisivel(voxel))
+                    grid[((size_t)z * sy + y) * sx + x] = (uint8_t)(voxelTextura(voxel) + 1);
+            }
+
+    // sRGB para linear uma vez, para a soma das amostras ser fisicamente correta
+    float linear[256];
+    for (int i = 0; i < 256; i++)
+        linear[i] = pow(i / 255.0f, 2.2f);
+    texSize = images.size;
+    texCount = images.count;
+    albedo.resize((size_t)texCount * texSize * texSize);
+    for (size_t i = 0; i < albedo.size(); i++) {
+        const uint8_t* p = &images.rgba[i * 4];
+        albedo[i] = glm::vec4(linear[p[0]], linear[p[1]], linear[p[2]], p[3] / 255.0f);
+    }
+}
+
+// Mesma projeção de coordenada de textura do shader dos chunks, amostra mais próxima
+glm::vec4 PathTracer::texel(int material, int face, const glm::vec3& p) const {
+    if (material >= texCount)
+        return glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+    float u, v;
+    if (face == 0) { u = -p.z; v = p.y; }
+    else if (face == 1) { u = p.z; v = p.y; }
+    else if (face <= 3) { u = p.x; v = p.z; }
+    else if (face == 4) { u = p.x; v = p.y; }
+    else { u = -p.x; v = p.y; }
+    v = 1.0f - v;
+    int tx = min(texSize - 1, (int)((u - floor(u)) * texSize));
+    int ty = min(texSize - 1, (int)((v - floor(v)) * texSize));
+    return albedo[((size_t)material * texSize + ty) * texSize + tx];
+}
+
+// DDA do pacote: o primeiro voxel que para cada raio (para o raio de sombra, basta saber se houve)
+void PathTracer::traverse(const Packet& packet, Hits& hits, uint32_t* rng) const {
+    alignas(32) int vx[PACOTE_RAIOS], vy[PACOTE_RAIOS], vz[PACOTE_RAIOS];
+    alignas(32) int px[PACOTE_RAIOS], py[PACOTE_RAIOS], pz[PACOTE_RAIOS];
+    alignas(32) float tx[PACOTE_RAIOS], ty[PACOTE_RAIOS], tz[PACOTE_RAIOS];
+    alignas(32) float ddx[PACOTE_RAIOS], ddy[PACOTE_RAIOS], ddz[PACOTE_RAIOS];
+    alignas(32) float t[PACOTE_RAIOS], tFim[PACOTE_RAIOS];
+    alignas(32) int eixo[PACOTE_RAIOS], vivo[PACOTE_RAIOS], anterior[PACOTE_RAIOS];
+
+    for (int i = 0; i < PACOTE_RAIOS; i++) {
+        hits.material[i] = -1;
+        hits.t[i] = 0.0f;
+        hits.face[i] = 0;
+        vivo[i] = 0;
+        anterior[i] = 0;
+        if (!packet.active[i])
+            continue;
+
+        // Entrada e saída da caixa do mundo
+        float o[3] = { packet.ox[i], packet.oy[i], packet.oz[i] };
+        float d[3] = { packet.dx[i], packet.dy[i], packet.dz[i] };
+        float tam[3] = { (float)sx, (float)sy, (float)sz };
+        float tPerto = 0.0f, tLonge = 1e30f, inv[3];
+        int eixoEntrada = 0;
+        for (int a = 0; a < 3; a++) {
+            inv[a] = 1.0f / (fabs(d[a]) > 1e-8f ? d[a] : (d[a] < 0.0f ? -1e-8f : 1e-8f));
+            float t0 = -o[a] * inv[a], t1 = (tam[a] - o[a]) * inv[a];
+            if (t0 > t1) swap(t0, t1);
+            if (t0 > tPerto) { tPerto = t0; eixoEntrada = a; }
+            tLonge = min(tLonge, t1);
+        }
+        if (tPerto > tLonge)
+            continue;
+
+        int v[3], passo[3];
+        float tMax[3];
+        for (int a = 0; a < 3; a++) {
+            v[a] = min((int)tam[a] - 1, max(0, (int)floor(o[a] + d[a] * (tPerto + 1e-4f))));
+            passo[a] = d[a] >= 0.0f ? 1 : -1;
+            tMax[a] = (v[a] + (passo[a] > 0 ? 1 : 0) - o[a]) * inv[a];
+        }
+        vx[i] = v[0]; vy[i] = v[1]; vz[i] = v[2];
+        px[i] = passo[0]; py[i] = passo[1]; pz[i] = passo[2];
+        tx[i] = tMax[0]; ty[i] = tMax[1]; tz[i] = tMax[2];
+        ddx[i] = fabs(inv[0]); ddy[i] = fabs(inv[1]); ddz[i] = fabs(inv[2]);
+        t[i] = tPerto;
+        tFim[i] = tLonge;
+        eixo[i] = eixoEntrada;
+        vivo[i] = 1;
+    }
+
+    for (int iter = 0; iter < MAX_PASSOS; iter++) {
+        // Leitura da grade (um acesso por raio)
+        for (int i = 0; i < PACOTE_RAIOS; i++) {
+            if (!vivo[i])
+                continue;
+            int m = grid[((size_t)vz[i] * sy + vy[i]) * sx + vx[i]];
+            if (m != 0 && m != anterior[i]) {
+                int material = m - 1;
+                int passo = eixo[i] == 0 ? px[i] : (eixo[i] == 1 ? py[i] : pz[i]);
+                int face = eixo[i] * 2 + (passo > 0 ? 1 : 0);
+                bool acerta = !isTransparent(material);
+                if (!acerta) {
+                    glm::vec3 p(packet.ox[i] + packet.dx[i] * t[i], packet.oy[i] + packet.dy[i] * t[i],
+                                packet.oz[i] + packet.dz[i] * t[i]);
+                    acerta = aleatorio(rng[i]) < texel(material, face, p).w;
+                }
+                if (acerta) {
+                    hits.material[i] = material;
+                    hits.t[i] = t[i];
+                    hits.face[i] = face;
+                    vivo[i] = 0;
+                }
+            }
+            anterior[i] = m;
+        }
+
+        // Passo da DDA em todos os raios do pacote, sem desvios
+        int algum = 0;
+        for (int i = 0; i < PACOTE_RAIOS; i++) {
+            int mx = (tx[i] < ty[i]) & (tx[i] < tz[i]);
+            int my = (1 - mx) & (ty[i] < tz[i]);
+            int mz = 1 - mx - my;
+            float tNovo = mx ? tx[i] : (my ? ty[i] : tz[i]);
+            vx[i] += mx * px[i];
+            vy[i] += my * py[i];
+            vz[i] += mz * pz[i];
+            tx[i] += mx ? ddx[i] : 0.0f;
+            ty[i] += my ? ddy[i] : 0.0f;
+            tz[i] += mz ? ddz[i] : 0.0f;
+            eixo[i] = my + 2 * mz;
+            t[i] = tNovo;
+            int fora = (vx[i] < 0) | (vy[i] < 0) | (vz[i] < 0) | (vx[i] >= sx) | (vy[i] >= sy) | (vz[i] >= sz) |
+                       (tNovo > tFim[i]);
+            vivo[i] &= 1 - fora;
+            algum |= vivo[i];
+        }
+        if (!algum)
+            break;
+    }
+}
+
+void PathTracer::renderTile(int tile, const PathTraceCamera& camera, const PathTraceSettings& settings,
+                            vector<uint8_t>& rgb, long long& rays) const {
+    int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    int x0 = (tile % tilesX) * settings.tileSize, y0 = (tile / tilesX) * settings.tileSize;
+    int x1 = min(settings.width, x0 + settings.tileSize), y1 = min(settings.height, y0 + settings.tileSize);
+
+    // Base da câmera (mesma conta de mouse_callback e lookAt do editor)
+    glm::vec3 front;
+    front.x = cos(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch));
+    front.y = sin(glm::radians(camera.pitch));
+    front.z = sin(glm::radians(camera.yaw)) * cos(glm::radians(camera.pitch));
+    front = glm::normalize(front);
+    glm::vec3 right = glm::normalize(glm::cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
+    glm::vec3 up = glm::cross(right, front);
+    float tanY = tan(glm::radians(camera.fov) * 0.5f);
+    float tanX = tanY * settings.width / settings.height;
+    glm::vec3 o = camera.position - origin;
+
+    Packet raios, sombra;
+    Hits acertos, bloqueios;
+    uint32_t rng[PACOTE_RAIOS];
+
+    for (int by = y0; by < y1; by += 2)
+        for (int bx = x0; bx < x1; bx += 4) {
+            int pixX[PACOTE_RAIOS], pixY[PACOTE_RAIOS], valido[PACOTE_RAIOS];
+            glm::vec3 soma[PACOTE_RAIOS];
+            for (int i = 0; i < PACOTE_RAIOS; i++) {
+                pixX[i] = bx + (i & 3);
+                pixY[i] = by + (i >> 2);
+                valido[i] = pixX[i] < x1 && pixY[i] < y1;
+                soma[i] = glm::vec3(0.0f);
+                rng[i] = (uint32_t)(pixY[i] * settings.width + pixX[i]) * 9781u + settings.seed * 6271u + 1u;
+                proximo(rng[i]);
+            }
+
+            for (int s = 0; s < settings.samples; s++) {
+                glm::vec3 peso[PACOTE_RAIOS], radiancia[PACOTE_RAIOS];
+                for (int i = 0; i < PACOTE_RAIOS; i++) {
+                    float ndcX = 2.0f * (pixX[i] + aleatorio(rng[i])) / settings.width - 1.0f;
+                    float ndcY = 1.0f - 2.0f * (pixY[i] + aleatorio(rng[i])) / settings.height;
+                    glm::vec3 d = glm::normalize(front + right * (ndcX * tanX) + up * (ndcY * tanY));
+                    raios.ox[i] = o.x; raios.oy[i] = o.y; raios.oz[i] = o.z;
+                    raios.dx[i] = d.x; raios.dy[i] = d.y; raios.dz[i] = d.z;
+                    raios.active[i] = valido[i];
+                    peso[i] = glm::vec3(1.0f);
+                    radiancia[i] = glm::vec3(0.0f);
+                }
+
+                for (int salto = 0; salto <= settings.bounces; salto++) {
+                    int vivos = 0;
+                    for (int i = 0; i < PACOTE_RAIOS; i++)
+                        vivos += raios.active[i];
+                    if (vivos == 0)
+                        break;
+                    traverse(raios, acertos, rng);
+                    rays += vivos;
+
+                    for (int i = 0; i < PACOTE_RAIOS; i++) {
+                        sombra.active[i] = 0;
+                        if (!raios.active[i])
+                            continue;
+                        glm::vec3 d(raios.dx[i], raios.dy[i], raios.dz[i]);
+                        if (acertos.material[i] < 0) {
+                            radiancia[i] += peso[i] * ceu(d);
+                            raios.active[i] = 0;
+                            continue;
+                        }
+
+                        int material = acertos.material[i], face = acertos.face[i];
+                        glm::vec3 p = glm::vec3(raios.ox[i], raios.oy[i], raios.oz[i]) + d * acertos.t[i];
+                        glm::vec4 amostra = texel(material, face, p);
+                        glm::vec3 cor(amostra.x, amostra.y, amostra.z);
+                        if (material < NUM_TEXTURES && luzEmitida[material] > 0)
+                            radiancia[i] += peso[i] * cor * (EMISSAO_MAX * luzEmitida[material] / LUZ_MAX);
+
+                        glm::vec3 n((float)FACE_DIR[face][0], (float)FACE_DIR[face][1], (float)FACE_DIR[face][2]);
+                        p += n * EPS;
+                        peso[i] *= cor;
+
+                        // Raio de sombra para o sol
+                        float cosSol = glm::dot(n, DIRECAO_SOL);
+                        if (cosSol > 0.0f) {
+                            sombra.ox[i] = p.x; sombra.oy[i] = p.y; sombra.oz[i] = p.z;
+                            sombra.dx[i] = DIRECAO_SOL.x; sombra.dy[i] = DIRECAO_SOL.y; sombra.dz[i] = DIRECAO_SOL.z;
+                            sombra.active[i] = 1;
+                        }
+
+                        // Próxima direção: cosseno em volta da normal (eixo da face)
+                        float r1 = aleatorio(rng[i]), r2 = aleatorio(rng[i]);
+                        float r = sqrt(r1), phi = 6.2831853f * r2;
+                        int eixoN = face / 2, u = (eixoN + 1) % 3, w = (eixoN + 2) % 3;
+                        float nova[3];
+                        nova[eixoN] = n[eixoN] * sqrt(max(0.0f, 1.0f - r1));
+                        nova[u] = r * cos(phi);
+                        nova[w] = r * sin(phi);
+                        raios.ox[i] = p.x; raios.oy[i] = p.y; raios.oz[i] = p.z;
+                        raios.dx[i] = nova[0]; raios.dy[i] = nova[1]; raios.dz[i] = nova[2];
+                        raios.active[i] = salto < settings.bounces;
+                    }
+
+                    int sombras = 0;
+                    for (int i = 0; i < PACOTE_RAIOS; i++)
+                        sombras += sombra.active[i];
+                    if (sombras == 0)
+                        continue;
+                    traverse(sombra, bloqueios, rng);
+                    rays += sombras;
+                    for (int i = 0; i < PACOTE_RAIOS; i++)
+                        if (sombra.active[i] && bloqueios.material[i] < 0)
+                            radiancia[i] += peso[i] * COR_SOL *
+                                glm::dot(glm::vec3(FACE_DIR[acertos.face[i]][0], FACE_DIR[acertos.face[i]][1],
+                                                   FACE_DIR[acertos.face[i]][2]), DIRECAO_SOL);
+                }
+                for (int i = 0; i < PACOTE_RAIOS; i++)
+                    soma[i] += radiancia[i];
+            }
+
+            // Exposição exponencial e gama 2.2
+            for (int i = 0; i < PACOTE_RAIOS; i++) {
+                if (!valido[i])
+                    continue;
+                glm::vec3 c = soma[i] / (float)settings.samples;
+                uint8_t* out = &rgb[((size_t)pixY[i] * settings.width + pixX[i]) * 3];
+                for (int k = 0; k < 3; k++) {
+                    float mapeado = 1.0f - exp(-c[k] * 1.5f);
+                    out[k] = (uint8_t)min(255.0f, pow(mapeado, 1.0f / 2.2f) * 255.0f + 0.5f);
+                }
+            }
+        }
+}
+
+PathTraceStats PathTracer::render(const PathTraceCamera& camera, const PathTraceSettings& settings, vector<uint8_t>& rgb) const {
+    PathTraceStats stats;
+    stats.threads = settings.threads > 0 ? settings.threads : (int)max(1u, thread::hardware_concurrency());
+    int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    int tilesY = (settings.height + settings.tileSize - 1) / settings.tileSize;
+    stats.tiles = tilesX * tilesY;
+    rgb.assign((size_t)settings.width * settings.height * 3, 0);
+
+    // Cada thread pega o próximo bloco livre; os raios são somados no fim
+    atomic<int> proximoBloco(0);
+    atomic<long long> total(0);
+    auto worker = [&]() {
+        long long raios = 0;
+        for (int tile = proximoBloco++; tile < stats.tiles; tile = proximoBloco++)
+            renderTile(tile, camera, settings, rgb, raios);
+        total += raios;
+    };
+
+    auto inicio = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (int t = 1; t < stats.threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (thread& t : pool)
+        t.join();
+    stats.seconds = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+    stats.rays = total;
+    return stats;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "block_images.h"
+#include "world.h"
+
+#include <cstdint>
+#include <vector>
+
+// Câmera como a do editor: posição de mundo, yaw/pitch em graus (mesma convenção do
+// mouse_callback) e fov vertical em graus
+struct PathTraceCamera {
+    glm::vec3 position = glm::vec3(0.0f);
+    float yaw = -90.0f;
+    float pitch = 0.0f;
+    float fov = 45.0f;
+};
+
+struct PathTraceSettings {
+    int width = 1200, height = 800;
+    int samples = 16;      // amostras por pixel
+    int bounces = 3;       // rebatidas difusas depois do primeiro acerto
+    int threads = 0;       // 0 = hardware_concurrency
+    int tileSize = 32;     // lado do bloco de pixels que cada thread pega por vez
+    uint32_t seed = 1;
+};
+
+struct PathTraceStats {
+    long long rays = 0;    // raios de câmera, de rebatida e de sombra
+    double seconds = 0.0;
+    int threads = 0;
+    int tiles = 0;
+
+    double raysPerSecond() const { return seconds > 0.0 ? rays / seconds : 0.0; }
+};
+
+// Path tracer na CPU para prévias sem GPU. A grade é copiada para um array plano
+// (material + 1, 0 = vazio) e os raios andam em pacotes de PACOTE_RAIOS pela DDA
+// voxel a voxel: a leitura da grade é por raio, o passo da DDA é escrito em
+// estrutura de arrays sem desvios para o compilador vetorizar (SSE/AVX/NEON).
+// Iluminação: céu em gradiente, sol direcional com raio de sombra e blocos que
+// emitem luz (luzEmitida), rebatidas difusas com amostragem por cosseno. Vidro, mel
+// e gelo deixam passar o raio com probabilidade 1 - alfa da textura.
+//
+// A imagem é dividida em blocos de tileSize^2 pixels distribuídos entre as threads
+// por um contador atômico; cada pacote é um retângulo de 4x2 pixels
+const int PACOTE_RAIOS = 8;
+
+class PathTracer {
+public:
+    void setup(const World& world, const BlockImages& images);
+
+    // rgb recebe width * height * 3 bytes (sRGB), linha 0 no topo
+    PathTraceStats render(const PathTraceCamera& camera, const PathTraceSettings& settings, std::vector<uint8_t>& rgb) const;
+
+private:
+    struct Packet;
+    struct Hits;
+
+    void traverse(const Packet& packet, Hits& hits, uint32_t* rng) const;
+    void renderTile(int tile, const PathTraceCamera& camera, const PathTraceSettings& settings,
+                    std::vector<uint8_t>& rgb, long long& rays) const;
+    glm::vec4 texel(int material, int face, const glm::vec3& p) const;
+
+    int sx = 0, sy = 0, sz = 0;
+    glm::vec3 origin = glm::vec3(0.0f);
+    std::vector<uint8_t> grid;          // x varia mais rápido, depois y, depois z
+    std::vector<glm::vec4> albedo;      // texels em RGB linear + alfa, por material
+    int texSize = 16, texCount = 0;
+};
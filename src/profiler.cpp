@@ -0,0 +1,329 @@
+#include "profiler.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace std;
+
+std::atomic<bool> perfilLigado(false);
+
+// Eventos por buffer de thread (potência de 2) e frames de GPU em voo
+const uint32_t EVENTOS_POR_THREAD = 1 << 14;
+const int FRAMES_GPU = 4;
+// Histograma: baldes de 0,1 ms até 250 ms (o último junta o resto), janela de frames
+const double BALDE_MS = 0.1;
+const int NUM_BALDES = 2500;
+const int JANELA_FRAMES = 1000;
+// Limite de eventos no trace (uns 40 MB de JSON)
+const size_t MAX_EVENTOS_TRACE = 1000000;
+// tid da GPU no trace
+const int TID_GPU = 0;
+
+struct CpuEvent {
+    const char* name;
+    uint64_t start, end;
+};
+
+// Buffer circular de uma produtora (a thread dona) e uma consumidora (a principal).
+// Quando a thread termina, o buffer fica livre e a próxima thread nova o reaproveita
+// (as threads do parallelFor da luz são criadas a cada chamada)
+struct ThreadBuffer {
+    CpuEvent events[EVENTOS_POR_THREAD];
+    atomic<uint32_t> head{ 0 }, tail{ 0 };
+    atomic<bool> livre{ false };
+    int tid = 0;
+    string nome;
+};
+
+struct TraceEvent {
+    const char* name;
+    uint64_t start, end;
+    int tid;
+};
+
+struct GpuRange {
+    const char* name;
+    GLuint begin, end;
+};
+
+static mutex registro;
+static vector<unique_ptr<ThreadBuffer>> buffers;
+static atomic<long long> perdidos(0);
+static thread_local ThreadBuffer* bufferLocal = nullptr;
+
+static bool gravando = false;
+static uint64_t inicioTrace = 0;
+static vector<TraceEvent> trace;
+
+// Consultas de GPU: as do frame atual e as dos frames anteriores ainda não lidas
+static vector<GLuint> consultasLivres;
+static vector<GpuRange> gpuAtual;
+static vector<GpuRange> gpuPendente[FRAMES_GPU];
+static int gpuFrame = 0;
+static int64_t gpuParaCpu = 0;     // ns a somar no tempo da GPU para cair no da CPU
+static bool gpuCalibrada = false;
+static double ultimoGpuMs = 0.0;
+
+static float janela[JANELA_FRAMES];
+static int janelaInicio = 0, janelaFrames = 0;
+static int baldes[NUM_BALDES];
+
+uint64_t profilerNow() {
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Libera o buffer quando a thread termina
+struct ThreadBufferOwner {
+    ~ThreadBufferOwner() {
+        if (bufferLocal)
+            bufferLocal->livre = true;
+    }
+};
+
+static ThreadBuffer* bufferDaThread() {
+    if (bufferLocal)
+        return bufferLocal;
+    static thread_local ThreadBufferOwner dono;
+    (void)dono;
+    lock_guard<mutex> lock(registro);
+    for (unique_ptr<ThreadBuffer>& b : buffers) {
+        bool esperado = true;
+        if (b->livre.compare_exchange_strong(esperado, false)) {
+            bufferLocal = b.get();
+            return bufferLocal;
+        }
+    }
+    buffers.push_back(make_unique<ThreadBuffer>());
+    bufferLocal = buffers.back().get();
+    bufferLocal->tid = (int)buffers.size();
+    bufferLocal->nome = "thread " + to_string(buffers.size());
+    return bufferLocal;
+}
+
+void profilerThreadName(const char* name) {
+    ThreadBuffer* b = bufferDaThread();
+    lock_guard<mutex> lock(registro);
+    b->nome = name;
+}
+
+void profilerRecord(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer* b = bufferDaThread();
+    uint32_t h = b->head.load(memory_order_relaxed);
+    if (h - b->tail.load(memory_order_acquire) >= EVENTOS_POR_THREAD) {
+        perdidos.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    b->events[h & (EVENTOS_POR_THREAD - 1)] = { name, start, end };
+    b->head.store(h + 1, memory_order_release);
+}
+
+int profilerGpuBegin(const char* name) {
+    if (!gpuCalibrada) {
+        // Relógio da GPU x da CPU, medidos juntos uma vez
+        GLint64 gpu = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpu);
+        gpuParaCpu = (int64_t)profilerNow() - gpu;
+        gpuCalibrada = true;
+    }
+    GLuint ids[2];
+    for (GLuint& id : ids) {
+        if (consultasLivres.empty()) {
+            glGenQueries(1, &id);
+        }
+        else {
+            id = consultasLivres.back();
+            consultasLivres.pop_back();
+        }
+    }
+    glQueryCounter(ids[0], GL_TIMESTAMP);
+    gpuAtual.push_back({ name, ids[0], ids[1] });
+    return (int)gpuAtual.size() - 1;
+}
+
+void profilerGpuEnd(int range) {
+    if (range < (int)gpuAtual.size())
+        glQueryCounter(gpuAtual[range].end, GL_TIMESTAMP);
+}
+
+// Lê as consultas de um frame em voo, se a última já terminou (ou esperando)
+static void coletaGpu(int slot, bool esperar) {
+    vector<GpuRange>& frame = gpuPendente[slot];
+    if (frame.empty())
+        return;
+    GLint pronta = 0;
+    glGetQueryObjectiv(frame.back().end, GL_QUERY_RESULT_AVAILABLE, &pronta);
+    if (!pronta && !esperar)
+        return;
+
+    uint64_t primeiro = UINT64_MAX, ultimo = 0;
+    for (const GpuRange& r : frame) {
+        GLuint64 a = 0, b = 0;
+        glGetQueryObjectui64v(r.begin, GL_QUERY_RESULT, &a);
+        glGetQueryObjectui64v(r.end, GL_QUERY_RESULT, &b);
+        primeiro = min<uint64_t>(primeiro, a);
+        ultimo = max<uint64_t>(ultimo, b);
+        if (gravando && trace.size() < MAX_EVENTOS_TRACE)
+            trace.push_back({ r.name, a + gpuParaCpu, b + gpuParaCpu, TID_GPU });
+        consultasLivres.push_back(r.begin);
+        consultasLivres.push_back(r.end);
+    }
+    ultimoGpuMs = ultimo > primeiro ? (ultimo - primeiro) / 1e6 : 0.0;
+    frame.clear();
+}
+
+static void drenaBuffers() {
+    lock_guard<mutex> lock(registro);
+    for (unique_ptr<ThreadBuffer>& b : buffers) {
+        uint32_t t = b->tail.load(memory_order_relaxed);
+        uint32_t h = b->head.load(memory_order_acquire);
+        for (; t != h; t++) {
+            const CpuEvent& e = b->events[t & (EVENTOS_POR_THREAD - 1)];
+            if (gravando && trace.size() < MAX_EVENTOS_TRACE)
+                trace.push_back({ e.name, e.start, e.end, b->tid });
+        }
+        b->tail.store(h, memory_order_release);
+    }
+}
+
+void profilerEndFrame(double frameMs) {
+    // Janela deslizante: o frame mais antigo sai do histograma
+    auto balde = [](float ms) { return min(NUM_BALDES - 1, (int)(ms / BALDE_MS)); };
+    if (janelaFrames == JANELA_FRAMES) {
+        baldes[balde(janela[janelaInicio])]--;
+        janelaInicio = (janelaInicio + 1) % JANELA_FRAMES;
+        janelaFrames--;
+    }
+    float ms = (float)max(0.0, frameMs);
+    janela[(janelaInicio + janelaFrames) % JANELA_FRAMES] = ms;
+    janelaFrames++;
+    baldes[balde(ms)]++;
+
+    if (!perfilLigado.load(memory_order_relaxed) && gpuAtual.empty())
+        return;
+    drenaBuffers();
+
+    // Os frames em voo são lidos do mais antigo ao mais novo, sem esperar; o atual
+    // entra no lugar do mais antigo (que só espera a GPU com o anel cheio)
+    for (int i = 1; i <= FRAMES_GPU; i++)
+        coletaGpu((gpuFrame + i) % FRAMES_GPU, i == 1);
+    gpuFrame = (gpuFrame + 1) % FRAMES_GPU;
+    gpuPendente[gpuFrame].swap(gpuAtual);
+    gpuAtual.clear();
+}
+
+FrameTimeStats profilerFrameStats() {
+    FrameTimeStats s;
+    s.frames = janelaFrames;
+    s.gpuMs = ultimoGpuMs;
+    s.dropped = perdidos.load(memory_order_relaxed);
+    if (janelaFrames == 0)
+        return s;
+
+    double soma = 0.0;
+    for (int i = 0; i < janelaFrames; i++)
+        soma += janela[(janelaInicio + i) % JANELA_FRAMES];
+    s.mean = soma / janelaFrames;
+
+    // Percentis pelo limite superior do balde
+    auto percentil = [&](double p) {
+        int alvo = max(1, (int)(p * janelaFrames + 0.5)), acumulado = 0;
+        for (int b = 0; b < NUM_BALDES; b++) {
+            acumulado += baldes[b];
+            if (acumulado >= alvo)
+                return (b + 1) * BALDE_MS;
+        }
+        return NUM_BALDES * BALDE_MS;
+    };
+    s.p50 = percentil(0.50);
+    s.p95 = percentil(0.95);
+    s.p99 = percentil(0.99);
+
+    // 1% low: média dos piores frames, do balde mais alto para baixo (centro do balde)
+    int piores = max(1, janelaFrames / 100), contados = 0;
+    double somaPiores = 0.0;
+    for (int b = NUM_BALDES - 1; b >= 0 && contados < piores; b--) {
+        int n = min(baldes[b], piores - contados);
+        somaPiores += n * (b + 0.5) * BALDE_MS;
+        contados += n;
+    }
+    s.low1 = somaPiores / piores;
+    return s;
+}
+
+void profilerStart() {
+    drenaBuffers();
+    trace.clear();
+    inicioTrace = profilerNow();
+    gravando = true;
+    perfilLigado = true;
+}
+
+void profilerStop() {
+    perfilLigado = false;
+    drenaBuffers();
+    gravando = false;
+}
+
+bool profilerEnabled() {
+    return perfilLigado.load(memory_order_relaxed);
+}
+
+bool profilerSaveTrace(const string& path) {
+    // Consultas de GPU ainda em voo entram no trace (espera a GPU aqui, fora do frame)
+    bool estava = gravando;
+    gravando = true;
+    for (int i = 1; i <= FRAMES_GPU; i++)
+        coletaGpu((gpuFrame + i) % FRAMES_GPU, true);
+    gpuPendente[gpuFrame].swap(gpuAtual);
+    coletaGpu(gpuFrame, true);
+    gpuAtual.clear();
+    drenaBuffers();
+    gravando = estava;
+
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f)
+        return false;
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", TID_GPU);
+    {
+        lock_guard<mutex> lock(registro);
+        for (const unique_ptr<ThreadBuffer>& b : buffers)
+            fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    b->tid, b->nome.c_str());
+    }
+    for (const TraceEvent& e : trace) {
+        if (e.start < inicioTrace)
+            continue;
+        fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                e.name, e.tid == TID_GPU ? "gpu" : "cpu", e.tid, (e.start - inicioTrace) / 1000.0,
+                (e.end - e.start) / 1000.0);
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return true;
+}
+
+void profilerShutdown() {
+    for (vector<GpuRange>& frame : gpuPendente) {
+        for (const GpuRange& r : frame) {
+            consultasLivres.push_back(r.begin);
+            consultasLivres.push_back(r.end);
+        }
+        frame.clear();
+    }
+    for (const GpuRange& r : gpuAtual) {
+        consultasLivres.push_back(r.begin);
+        consultasLivres.push_back(r.end);
+    }
+    gpuAtual.clear();
+    if (!consultasLivres.empty())
+        glDeleteQueries((GLsizei)consultasLivres.size(), consultasLivres.data());
+    consultasLivres.clear();
+    gpuCalibrada = false;
+}
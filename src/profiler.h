@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Profiler de frame. Escopos de CPU (RAII) gravam início e fim em nanossegundos num
+// buffer circular por thread, sem trava: só a própria thread escreve e só a thread
+// principal lê, em profilerEndFrame. Escopos de GPU gravam GL_TIMESTAMP
+// (glQueryCounter) no início e no fim; os resultados são lidos alguns frames depois,
+// quando ficam prontos, sem esperar a GPU, e entram na mesma linha do tempo da CPU.
+// O trace gravado sai no formato JSON do Chrome (chrome://tracing ou Perfetto).
+//
+// O tempo de cada frame entra sempre num histograma da janela dos últimos frames,
+// de onde saem p50/p95/p99 e o "1% low" (média do 1% de frames mais lentos).
+// Desligado, um escopo custa uma leitura atômica relaxada e um desvio; compilado
+// com VOXEL_SEM_PERFIL os macros somem (VoxelRender, sem GL, compila assim)
+
+extern std::atomic<bool> perfilLigado;
+
+uint64_t profilerNow();
+void profilerRecord(const char* name, uint64_t start, uint64_t end);
+// Nome da thread atual no trace (sem nome: "thread N")
+void profilerThreadName(const char* name);
+
+// GPU (só na thread do contexto de GL). Devolve -1 se desligado
+int profilerGpuBegin(const char* name);
+void profilerGpuEnd(int range);
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : nome(name), inicio(perfilLigado.load(std::memory_order_relaxed) ? profilerNow() : 0) {}
+    ~ProfileScope() {
+        if (inicio)
+            profilerRecord(nome, inicio, profilerNow());
+    }
+
+private:
+    const char* nome;
+    uint64_t inicio;
+};
+
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name)
+        : range(perfilLigado.load(std::memory_order_relaxed) ? profilerGpuBegin(name) : -1) {}
+    ~GpuProfileScope() {
+        if (range >= 0)
+            profilerGpuEnd(range);
+    }
+
+private:
+    int range;
+};
+
+#define PERFIL_CONCAT2(a, b) a##b
+#define PERFIL_CONCAT(a, b) PERFIL_CONCAT2(a, b)
+#ifndef VOXEL_SEM_PERFIL
+#define PERFIL_ESCOPO(nome) ProfileScope PERFIL_CONCAT(perfilEscopo, __LINE__)(nome)
+#define PERFIL_GPU(nome) GpuProfileScope PERFIL_CONCAT(perfilGpu, __LINE__)(nome)
+// Nomeia a thread só com o profiler ligado (threads de vida curta não ocupam buffer)
+#define PERFIL_THREAD(nome) (perfilLigado.load(std::memory_order_relaxed) ? profilerThreadName(nome) : (void)0)
+#else
+#define PERFIL_ESCOPO(nome)
+#define PERFIL_GPU(nome)
+#define PERFIL_THREAD(nome)
+#endif
+
+// Tempos de frame da janela (ms)
+struct FrameTimeStats {
+    int frames = 0;
+    double mean = 0.0, p50 = 0.0, p95 = 0.0, p99 = 0.0;
+    double low1 = 0.0;        // média do 1% mais lento
+    double gpuMs = 0.0;       // último frame de GPU completo (do primeiro ao último escopo)
+    long long dropped = 0;    // eventos perdidos com um buffer de thread cheio
+};
+
+// Liga a gravação (descarta o trace anterior) e desliga
+void profilerStart();
+void profilerStop();
+bool profilerEnabled();
+
+// Fim do frame na thread que desenha (a do contexto de GL): drena os buffers das threads, lê as consultas
+// de GPU prontas e põe frameMs no histograma
+void profilerEndFrame(double frameMs);
+FrameTimeStats profilerFrameStats();
+
+bool profilerSaveTrace(const std::string& path);
+// Libera as consultas de GL (antes de destruir o contexto)
+void profilerShutdown();
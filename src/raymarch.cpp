@@ -0,0 +1,231 @@
+#include "raymarch.h"
+#include "materials.h"
+#include "shader.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <cmath>
+
+using namespace std;
+
+// Unidades de textura do raymarching (a 0 é o array de blocos, ligado pela fila)
+const int UNIDADE_VOXELS = 2;
+const int UNIDADE_OCUPACAO = 3;
+const int UNIDADE_LUZ = 4;
+
+static const GLchar* raymarchVertexSource = R"glsl(
+    #version 450
+    out vec2 ndc;
+    void main()
+    {
+        vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+        ndc = pos;
+        gl_Position = vec4(pos, 0.0, 1.0);
+    }
+)glsl";
+
+// DDA em dois níveis: fora de bricks ocupados o raio avança até a saída do brick;
+// dentro, voxel a voxel. Coordenadas da grade: o voxel (x, y, z) ocupa [x, x+1)
+static const GLchar* raymarchFragmentSource = R"glsl(
+    #version 450
+    in vec2 ndc;
+    out vec4 color;
+
+    uniform mat4 invViewProj;
+    uniform mat4 viewProj;
+    uniform vec3 cameraPos;
+    uniform vec3 gridOrigin;
+    uniform ivec3 gridSize;
+    uniform vec3 background;
+    uniform uint transparentMask;
+    uniform float pixelAngle;
+
+    uniform sampler2DArray blocks;
+    uniform usampler3D voxels;
+    uniform usampler3D occupancy;
+    uniform usampler3D light;
+
+    const int BRICK = 8;
+    const int MAX_PASSOS = 4096;
+
+    // Mesma luz do shader dos chunks: a da célula em frente à face (fora do mundo, céu aberto)
+    float brilho(ivec3 v, int axis, ivec3 stepDir) {
+        ivec3 frente = v;
+        frente[axis] -= stepDir[axis];
+        uint l = 0xF0u;
+        if (all(greaterThanEqual(frente, ivec3(0))) && all(lessThan(frente, gridSize)))
+            l = texelFetch(light, frente, 0).r;
+        return 0.06 + 0.94 * pow(0.8, float(15u - max(l >> 4, l & 15u)));
+    }
+
+    // Mesma projeção de coordenada de textura do shader dos chunks
+    vec4 shade(uint material, int axis, ivec3 stepDir, vec3 p, float t) {
+        int face = axis * 2 + (stepDir[axis] > 0 ? 1 : 0);
+        vec2 uv;
+        if (face == 0) uv = vec2(-p.z, p.y);
+        else if (face == 1) uv = vec2(p.z, p.y);
+        else if (face <= 3) uv = vec2(p.x, p.z);
+        else if (face == 4) uv = vec2(p.x, p.y);
+        else uv = vec2(-p.x, p.y);
+        float lod = log2(max(t * pixelAngle * 16.0, 1.0));
+        return textureLod(blocks, vec3(uv.x, 1.0 - uv.y, float(material)), lod);
+    }
+
+    void main()
+    {
+        vec4 far = invViewProj * vec4(ndc, 1.0, 1.0);
+        vec3 rd = normalize(far.xyz / far.w - cameraPos);
+        vec3 ro = cameraPos - gridOrigin;
+        vec3 invDir = 1.0 / max(abs(rd), vec3(1e-8)) * sign(rd + vec3(1e-20));
+        ivec3 stepDir = ivec3(rd.x >= 0.0 ? 1 : -1, rd.y >= 0.0 ? 1 : -1, rd.z >= 0.0 ? 1 : -1);
+
+        // Entrada e saída da caixa do mundo
+        vec3 t0 = (vec3(0.0) - ro) * invDir;
+        vec3 t1 = (vec3(gridSize) - ro) * invDir;
+        vec3 tNear3 = min(t0, t1), tFar3 = max(t0, t1);
+        float tNear = max(max(tNear3.x, tNear3.y), tNear3.z);
+        float tFar = min(min(tFar3.x, tFar3.y), tFar3.z);
+
+        vec4 acc = vec4(0.0);
+        float hitT = -1.0;
+        if (tNear <= tFar && tFar > 0.0) {
+            float t = max(tNear, 0.0);
+            int axis = (tNear3.x >= tNear3.y && tNear3.x >= tNear3.z) ? 0 : (tNear3.y >= tNear3.z ? 1 : 2);
+            uint prevMat = 0u;
+            int passos = 0;
+            bool fim = false;
+
+            while (!fim && passos < MAX_PASSOS && t <= tFar) {
+                ivec3 v = ivec3(floor(ro + rd * t + vec3(stepDir) * 1e-4));
+                if (any(lessThan(v, ivec3(0))) || any(greaterThanEqual(v, gridSize)))
+                    break;
+                ivec3 brick = v / BRICK;
+
+                if (texelFetch(occupancy, brick, 0).r == 0u) {
+                    // Brick vazio: pula para a face de saída
+                    vec3 bmin = vec3(brick * BRICK);
+                    vec3 bound = bmin + vec3(max(stepDir, ivec3(0)) * BRICK);
+                    vec3 tb = (bound - ro) * invDir;
+                    axis = (tb.x <= tb.y && tb.x <= tb.z) ? 0 : (tb.y <= tb.z ? 1 : 2);
+                    t = tb[axis];
+                    prevMat = 0u;
+                    passos++;
+                    continue;
+                }
+
+                // DDA voxel a voxel até sair do brick
+                vec3 tMax = (vec3(v) + vec3(max(stepDir, ivec3(0))) - ro) * invDir;
+                vec3 tDelta = abs(invDir);
+                while (passos < MAX_PASSOS) {
+                    passos++;
+                    uint m = texelFetch(voxels, v, 0).r;
+                    if (m != 0u) {
+                        uint material = m - 1u;
+                        vec3 p = ro + rd * t;
+                        if ((transparentMask & (1u << material)) == 0u) {
+                            vec4 c = shade(material, axis, stepDir, p, t);
+                            c.rgb *= brilho(v, axis, stepDir);
+                            acc += (1.0 - acc.a) * vec4(c.rgb, 1.0);
+                            hitT = t;
+                            fim = true;
+                            break;
+                        }
+                        if (m != prevMat) {
+                            vec4 c = shade(material, axis, stepDir, p, t);
+                            c.rgb *= brilho(v, axis, stepDir);
+                            acc += (1.0 - acc.a) * vec4(c.rgb * c.a, c.a);
+                        }
+                    }
+                    prevMat = m;
+
+                    if (tMax.x < tMax.y && tMax.x < tMax.z) { axis = 0; }
+                    else if (tMax.y < tMax.z) { axis = 1; }
+                    else { axis = 2; }
+                    v[axis] += stepDir[axis];
+                    t = tMax[axis];
+                    tMax[axis] += tDelta[axis];
+
+                    if (any(lessThan(v, ivec3(0))) || any(greaterThanEqual(v, gridSize))) {
+                        fim = true;
+                        break;
+                    }
+                    if (v / BRICK != brick)
+                        break;
+                }
+            }
+        }
+
+        color = vec4(acc.rgb + (1.0 - acc.a) * background, 1.0);
+        if (hitT >= 0.0) {
+            vec4 clip = viewProj * vec4(cameraPos + rd * hitT, 1.0);
+            gl_FragDepth = clamp(clip.z / clip.w * 0.5 + 0.5, 0.0, 1.0);
+        }
+        else {
+            // Logo antes do plano far, para passar no GL_LESS contra o depth limpo
+            gl_FragDepth = 1.0 - 1.0 / 8388608.0;
+        }
+    }
+)glsl";
+
+void VoxelRaymarcher::setup(GLuint textures) {
+    blockTextures = textures;
+    program = setupShader(raymarchVertexSource, raymarchFragmentSource);
+    glGenVertexArrays(1, &emptyVAO);
+
+    uint32_t transparentMask = 0;
+    for (int i = 0; i < NUM_TEXTURES; i++)
+        if (isTransparent(i))
+            transparentMask |= 1u << i;
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "blocks"), 0);
+    glUniform1i(glGetUniformLocation(program, "voxels"), UNIDADE_VOXELS);
+    glUniform1i(glGetUniformLocation(program, "occupancy"), UNIDADE_OCUPACAO);
+    glUniform1i(glGetUniformLocation(program, "light"), UNIDADE_LUZ);
+    glUniform1ui(glGetUniformLocation(program, "transparentMask"), transparentMask);
+    glUseProgram(0);
+}
+
+void VoxelRaymarcher::destroy() {
+    glDeleteProgram(program);
+    glDeleteVertexArrays(1, &emptyVAO);
+    program = emptyVAO = 0;
+}
+
+void VoxelRaymarcher::enqueue(const World& world, const GpuVolume& volume, RenderQueue& queue,
+                              const RaymarchView& camera) {
+    if (volume.sizeX() == 0 || volume.sizeY() == 0 || volume.sizeZ() == 0)
+        return;
+
+    glm::mat4 viewProj = camera.proj * camera.view;
+    glm::mat4 invViewProj = glm::inverse(viewProj);
+    float pixelAngle = 2.0f * tan(camera.fovY * 0.5f) / camera.viewportHeight;
+
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "invViewProj"), 1, GL_FALSE, glm::value_ptr(invViewProj));
+    glUniformMatrix4fv(glGetUniformLocation(program, "viewProj"), 1, GL_FALSE, glm::value_ptr(viewProj));
+    glUniform3fv(glGetUniformLocation(program, "cameraPos"), 1, glm::value_ptr(camera.cameraPos));
+    glUniform3fv(glGetUniformLocation(program, "gridOrigin"), 1, glm::value_ptr(world.origin()));
+    glUniform3i(glGetUniformLocation(program, "gridSize"), volume.sizeX(), volume.sizeY(), volume.sizeZ());
+    glUniform3fv(glGetUniformLocation(program, "background"), 1, glm::value_ptr(camera.background));
+    glUniform1f(glGetUniformLocation(program, "pixelAngle"), pixelAngle);
+
+    // As texturas 3D ficam em unidades que a fila não usa
+    glActiveTexture(GL_TEXTURE0 + UNIDADE_VOXELS);
+    glBindTexture(GL_TEXTURE_3D, volume.voxelTexture());
+    glActiveTexture(GL_TEXTURE0 + UNIDADE_OCUPACAO);
+    glBindTexture(GL_TEXTURE_3D, volume.occupancyTexture());
+    glActiveTexture(GL_TEXTURE0 + UNIDADE_LUZ);
+    glBindTexture(GL_TEXTURE_3D, volume.lightTexture());
+    glActiveTexture(GL_TEXTURE0);
+
+    DrawItem item;
+    item.pass = PASS_OPACO;
+    item.program = program;
+    item.vao = emptyVAO;
+    item.textureTarget = GL_TEXTURE_2D_ARRAY;
+    item.texture = blockTextures;
+    item.first = 0;
+    item.count = 3;
+    item.key = makeSortKey(PASS_OPACO, 4, 0, 0);
+    queue.push(item);
+}
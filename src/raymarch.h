@@ -0,0 +1,36 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gpu_volume.h"
+#include "render_queue.h"
+#include "world.h"
+
+// Câmera do frame para o raymarching
+struct RaymarchView {
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec3 cameraPos;
+    float fovY;           // radianos
+    int viewportHeight;
+    glm::vec3 background; // cor de fundo (o raio que não acerta nada termina nela)
+};
+
+// Modo de renderização alternativo: cada pixel percorre a grade do GpuVolume com
+// DDA (Amanatides & Woo). A textura de ocupação (um texel por brick de 8^3) deixa
+// o raio pular bricks vazios inteiros. O custo depende dos pixels da tela, não do
+// número de voxels
+class VoxelRaymarcher {
+public:
+    void setup(GLuint blockTextures);
+    void destroy();
+
+    // Coloca o triângulo de tela cheia na fila (pass opaco). Os transparentes são
+    // compostos no próprio raio. O volume deve ter sido atualizado antes
+    void enqueue(const World& world, const GpuVolume& volume, RenderQueue& queue, const RaymarchView& camera);
+
+private:
+    GLuint program = 0, emptyVAO = 0;
+    GLuint blockTextures = 0;
+};
@@ -0,0 +1,549 @@
+#include "region_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+using namespace std;
+
+// Primeiro setor: marca, versão, tamanho do mundo e posição da região. A tabela vem
+// logo depois (8 bytes por chunk, 64 setores) e os conteúdos a partir de DADOS_INICIO
+const char MARCA_REGIAO[4] = { 'V', 'X', 'R', 'G' };
+const uint32_t VERSAO_REGIAO = 1;
+struct CabecalhoRegiao {
+    char marca[4];
+    uint32_t versao;
+    int32_t tamanhoMundo[3];
+    int32_t posicao[3];
+};
+const uint32_t SETORES_TABELA = (uint32_t)(REGIAO_CHUNKS * sizeof(RegionEntry) / REGIAO_SETOR);
+const uint32_t DADOS_INICIO = 1 + SETORES_TABELA;
+static_assert(REGIAO_CHUNKS * sizeof(RegionEntry) % REGIAO_SETOR == 0, "tabela fora do alinhamento");
+
+// Na criação do mundo, os conteúdos de uma região vão em lotes deste tamanho
+const size_t LOTE_CRIACAO = (size_t)4 << 20;
+
+// --- Conteúdo ---
+
+uint32_t encodeChunkPayload(const Chunk& chunk, uint8_t* saida) {
+    // O registro é voxels e depois luz: a RLE corre pelos dois como um bloco só
+    const uint8_t* partes[2] = { chunk.voxels, chunk.light };
+    bool vazio = true;
+    for (int p = 0; p < 2 && vazio; p++)
+        for (int i = 0; i < CHUNK_VOLUME && vazio; i++)
+            vazio = partes[p][i] == 0;
+    if (vazio)
+        return 0;
+
+    uint32_t n = 0;
+    for (int p = 0; p < 2; p++) {
+        const uint8_t* dados = partes[p];
+        for (int i = 0; i < CHUNK_VOLUME;) {
+            uint8_t valor = dados[i];
+            int corrida = 1;
+            while (i + corrida < CHUNK_VOLUME && corrida < 255 && dados[i + corrida] == valor)
+                corrida++;
+            // Do tamanho do cru em diante não compensa: vai cru
+            if (n + 2 >= REGIAO_MAX_CONTEUDO) {
+                packChunk(chunk, saida);
+                return REGIAO_MAX_CONTEUDO;
+            }
+            saida[n++] = (uint8_t)corrida;
+            saida[n++] = valor;
+            i += corrida;
+        }
+    }
+    return n;
+}
+
+bool decodeChunkPayload(const uint8_t* dados, uint32_t bytes, Chunk& chunk) {
+    if (bytes == REGIAO_MAX_CONTEUDO) {
+        unpackChunk(dados, chunk);
+        return true;
+    }
+    if (bytes > REGIAO_MAX_CONTEUDO || bytes % 2 != 0)
+        return false;
+    uint8_t registro[CHUNK_REGISTRO];
+    size_t n = 0;
+    for (uint32_t i = 0; i < bytes; i += 2) {
+        if (n + dados[i] > CHUNK_REGISTRO)
+            return false;
+        memset(registro + n, dados[i + 1], dados[i]);
+        n += dados[i];
+    }
+    if (bytes == 0)
+        memset(registro, 0, CHUNK_REGISTRO);
+    else if (n != CHUNK_REGISTRO)
+        return false;
+    unpackChunk(registro, chunk);
+    return true;
+}
+
+// --- RegionFile ---
+
+RegionFile::~RegionFile() {
+    close();
+}
+
+bool RegionFile::open(const string& path, bool create, const int worldSize[3], const int position[3]) {
+    close();
+    error_code erro;
+    if (!create && !filesystem::exists(path, erro))
+        return false;
+    fd = openChunkFile(path.c_str(), true, true);
+    if (fd < 0)
+        return false;
+    caminho = path;
+    cabecalho.allocate(DADOS_INICIO * REGIAO_SETOR);
+    CabecalhoRegiao cab;
+    if (create) {
+        memcpy(cab.marca, MARCA_REGIAO, 4);
+        cab.versao = VERSAO_REGIAO;
+        for (int i = 0; i < 3; i++) {
+            cab.tamanhoMundo[i] = worldSize ? worldSize[i] : 0;
+            cab.posicao[i] = position ? position[i] : 0;
+        }
+        memcpy(cabecalho.data(), &cab, sizeof(cab));
+        if (!truncateChunkFile(fd, 0) ||
+            writeChunkFile(fd, cabecalho.data(), cabecalho.size(), 0) != (int64_t)cabecalho.size()) {
+            cerr << "Falha ao criar a regiao " << path << endl;
+            close();
+            return false;
+        }
+    }
+    else if (readChunkFile(fd, cabecalho.data(), cabecalho.size(), 0) != (int64_t)cabecalho.size()) {
+        cerr << "Regiao sem cabecalho: " << path << endl;
+        close();
+        return false;
+    }
+    memcpy(&cab, cabecalho.data(), sizeof(cab));
+    if (memcmp(cab.marca, MARCA_REGIAO, 4) != 0 || cab.versao != VERSAO_REGIAO) {
+        cerr << "Regiao invalida: " << path << endl;
+        close();
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        tamanhoMundo[i] = cab.tamanhoMundo[i];
+        posicao[i] = cab.posicao[i];
+    }
+    setoresSujos.assign(SETORES_TABELA, 0);
+    tabelaSuja = false;
+    temporario.allocate(REGIAO_MAX_CONTEUDO);
+    return montaLivres();
+}
+
+void RegionFile::close() {
+    closeChunkFile(fd);
+    fd = -1;
+    livres.clear();
+    pendentes.clear();
+    setoresPendentes = 0;
+}
+
+// Os buracos são o que nenhuma entrada da tabela cobre entre DADOS_INICIO e o fim.
+// Entradas que passam do arquivo ou se sobrepõem a outra viram chunks vazios
+bool RegionFile::montaLivres() {
+    int64_t tamanhoArquivo = chunkFileSize(fd);
+    if (tamanhoArquivo < 0)
+        return false;
+    uint32_t setoresArquivo = (uint32_t)((tamanhoArquivo + REGIAO_SETOR - 1) / REGIAO_SETOR);
+
+    RegionEntry* t = tabela();
+    vector<pair<uint32_t, int>> usados;
+    for (int i = 0; i < REGIAO_CHUNKS; i++) {
+        if (t[i].bytes == 0)
+            continue;
+        uint32_t n = regionSectors(t[i].bytes);
+        if (t[i].bytes > REGIAO_MAX_CONTEUDO || t[i].sector < DADOS_INICIO || t[i].sector + n > setoresArquivo) {
+            cerr << "Regiao " << caminho << ": chunk " << i << " fora do arquivo, fica vazio" << endl;
+            t[i] = RegionEntry();
+            continue;
+        }
+        usados.push_back({ t[i].sector, i });
+    }
+    sort(usados.begin(), usados.end());
+    livres.clear();
+    pendentes.clear();
+    setoresPendentes = 0;
+    fim = DADOS_INICIO;
+    for (const auto& u : usados) {
+        RegionEntry& e = t[u.second];
+        if (e.sector < fim) {
+            cerr << "Regiao " << caminho << ": chunk " << u.second << " sobreposto, fica vazio" << endl;
+            e = RegionEntry();
+            continue;
+        }
+        if (e.sector > fim)
+            livres.push_back({ fim, e.sector - fim });
+        fim = e.sector + regionSectors(e.bytes);
+    }
+    return true;
+}
+
+// Fica pendente até o próximo commit (a tabela no disco ainda pode apontar para ele)
+void RegionFile::libera(uint32_t setor, uint32_t n) {
+    pendentes.push_back({ setor, n });
+    setoresPendentes += n;
+}
+
+uint64_t RegionFile::allocate(int local, uint32_t bytes) {
+    RegionEntry& e = tabela()[local];
+    if (e.bytes > 0)
+        libera(e.sector, regionSectors(e.bytes));
+    e = RegionEntry();
+    if (bytes > 0) {
+        uint32_t n = regionSectors(bytes);
+        e.bytes = bytes;
+        // Primeiro buraco que caiba; senão, no fim
+        auto buraco = find_if(livres.begin(), livres.end(), [&](const pair<uint32_t, uint32_t>& l) {
+            return l.second >= n;
+        });
+        if (buraco != livres.end()) {
+            e.sector = buraco->first;
+            buraco->first += n;
+            buraco->second -= n;
+            if (buraco->second == 0)
+                livres.erase(buraco);
+        }
+        else {
+            e.sector = fim;
+            fim += n;
+        }
+    }
+    setoresSujos[(size_t)local * sizeof(RegionEntry) / REGIAO_SETOR] = 1;
+    tabelaSuja = true;
+    return (uint64_t)e.sector * REGIAO_SETOR;
+}
+
+bool RegionFile::commit() {
+    if (fd < 0)
+        return false;
+    if (!tabelaSuja)
+        return true;
+    // Os conteúdos alocados desde o último commit chegam ao disco antes da tabela que
+    // aponta para eles
+    bool ok = syncChunkFile(fd);
+    for (uint32_t s = 0; ok && s < SETORES_TABELA; s++) {
+        if (!setoresSujos[s])
+            continue;
+        uint64_t offset = (uint64_t)(1 + s) * REGIAO_SETOR;
+        ok = writeChunkFile(fd, cabecalho.data() + offset, REGIAO_SETOR, offset) == (int64_t)REGIAO_SETOR;
+        // Só limpo se foi gravado: o próximo commit tenta de novo o que falhou
+        if (ok)
+            setoresSujos[s] = 0;
+    }
+    ok = ok && syncChunkFile(fd);
+    if (!ok) {
+        cerr << "Falha ao gravar a tabela de " << caminho << endl;
+        return false;
+    }
+    tabelaSuja = false;
+
+    // A tabela no disco já não aponta para os pendentes: viram buracos, emendados com
+    // os vizinhos; o que encosta no fim volta ao fim
+    livres.insert(livres.end(), pendentes.begin(), pendentes.end());
+    pendentes.clear();
+    setoresPendentes = 0;
+    sort(livres.begin(), livres.end());
+    vector<pair<uint32_t, uint32_t>> juntos;
+    for (const auto& l : livres) {
+        if (!juntos.empty() && juntos.back().first + juntos.back().second == l.first)
+            juntos.back().second += l.second;
+        else
+            juntos.push_back(l);
+    }
+    while (!juntos.empty() && juntos.back().first + juntos.back().second == fim) {
+        fim = juntos.back().first;
+        juntos.pop_back();
+    }
+    livres.swap(juntos);
+    return true;
+}
+
+bool RegionFile::readPayload(int local, uint8_t* buffer) {
+    const RegionEntry& e = entry(local);
+    if (e.bytes == 0)
+        return true;
+    size_t bytes = (size_t)regionSectors(e.bytes) * REGIAO_SETOR;
+    return readChunkFile(fd, buffer, bytes, offsetOf(e)) == (int64_t)bytes;
+}
+
+bool RegionFile::writePayload(int local, const uint8_t* buffer, uint32_t bytes) {
+    uint64_t offset = allocate(local, bytes);
+    if (bytes == 0)
+        return true;
+    size_t total = (size_t)regionSectors(bytes) * REGIAO_SETOR;
+    return writeChunkFile(fd, buffer, total, offset) == (int64_t)total;
+}
+
+bool RegionFile::readChunk(int local, Chunk& chunk) {
+    if (!readPayload(local, temporario.data()))
+        return false;
+    return decodeChunkPayload(temporario.data(), entry(local).bytes, chunk);
+}
+
+bool RegionFile::writeChunk(int local, const Chunk& chunk) {
+    uint32_t bytes = encodeChunkPayload(chunk, temporario.data());
+    // O resto do último setor vai zerado
+    memset(temporario.data() + bytes, 0, (size_t)regionSectors(bytes) * REGIAO_SETOR - bytes);
+    return writePayload(local, temporario.data(), bytes);
+}
+
+RegionStats RegionFile::stats() const {
+    RegionStats s;
+    const RegionEntry* t = tabela();
+    for (int i = 0; i < REGIAO_CHUNKS; i++) {
+        if (t[i].bytes == 0)
+            continue;
+        s.chunks++;
+        s.usedSectors += regionSectors(t[i].bytes);
+    }
+    for (const auto& l : livres)
+        s.freeSectors += l.second;
+    s.pendingSectors = setoresPendentes;
+    s.fileSectors = fim;
+    return s;
+}
+
+bool compactRegionFile(const string& path, RegionStats* antes, RegionStats* depois) {
+    RegionFile original;
+    if (!original.open(path, false))
+        return false;
+    if (antes)
+        *antes = original.stats();
+
+    string temporario = path + ".tmp";
+    RegionFile nova;
+    if (!nova.open(temporario, true, original.worldSize(), original.position()))
+        return false;
+    // Sem buracos no arquivo novo: cada conteúdo vai para o fim, na ordem dos chunks
+    AlignedBuffer conteudo(REGIAO_MAX_CONTEUDO);
+    bool ok = true;
+    for (int i = 0; ok && i < REGIAO_CHUNKS; i++) {
+        uint32_t bytes = original.entry(i).bytes;
+        if (bytes == 0)
+            continue;
+        ok = original.readPayload(i, conteudo.data()) && nova.writePayload(i, conteudo.data(), bytes);
+    }
+    ok = ok && nova.commit();
+    if (depois)
+        *depois = nova.stats();
+    nova.close();
+    original.close();
+    // filesystem::rename troca um arquivo existente também no Windows (o rename do C não)
+    error_code erro;
+    if (ok)
+        filesystem::rename(temporario, path, erro);
+    if (!ok || erro) {
+        cerr << "Falha ao compactar " << path << endl;
+        filesystem::remove(temporario, erro);
+        return false;
+    }
+    return true;
+}
+
+// --- RegionStore ---
+
+string RegionStore::regionPath(const string& dir, int rx, int ry, int rz) {
+    return dir + "/r." + to_string(rx) + "." + to_string(ry) + "." + to_string(rz) + ".vxr";
+}
+
+bool RegionStore::open(const string& dir) {
+    close();
+    RegionFile primeira;
+    if (!primeira.open(regionPath(dir, 0, 0, 0), false))
+        return false;
+    const int* t = primeira.worldSize();
+    const int* p = primeira.position();
+    if (t[0] <= 0 || t[1] <= 0 || t[2] <= 0) {
+        cerr << "Regiao sem o tamanho do mundo: " << dir << endl;
+        return false;
+    }
+    if (p[0] != 0 || p[1] != 0 || p[2] != 0) {
+        cerr << "Regiao fora do lugar: " << regionPath(dir, 0, 0, 0) << " diz ser a " << p[0] << "." << p[1]
+             << "." << p[2] << endl;
+        return false;
+    }
+    dimensiona(dir, t);
+    return true;
+}
+
+void RegionStore::dimensiona(const string& dir, const int worldSize[3]) {
+    diretorio = dir;
+    for (int i = 0; i < 3; i++)
+        tamanho[i] = worldSize[i];
+    cx = (tamanho[0] + CHUNK_TAM - 1) / CHUNK_TAM;
+    cy = (tamanho[1] + CHUNK_TAM - 1) / CHUNK_TAM;
+    cz = (tamanho[2] + CHUNK_TAM - 1) / CHUNK_TAM;
+    regioesX = (cx + REGIAO_TAM - 1) / REGIAO_TAM;
+    regioesY = (cy + REGIAO_TAM - 1) / REGIAO_TAM;
+    regioesZ = (cz + REGIAO_TAM - 1) / REGIAO_TAM;
+    regioes.clear();
+    regioes.resize((size_t)regioesX * regioesY * regioesZ);
+}
+
+bool RegionStore::create(const string& dir, const World& world, ChunkIO& io) {
+    int tam[3] = { world.sizeX(), world.sizeY(), world.sizeZ() };
+    if (!beginCreate(dir, tam))
+        return false;
+    // Região por região, para cada uma sair em poucos lotes grandes
+    for (int ry = 0; ry < regioesY; ry++)
+        for (int rz = 0; rz < regioesZ; rz++)
+            for (int rx = 0; rx < regioesX; rx++)
+                for (int ly = 0; ly < REGIAO_TAM; ly++)
+                    for (int lz = 0; lz < REGIAO_TAM; lz++)
+                        for (int lx = 0; lx < REGIAO_TAM; lx++) {
+                            int x = rx * REGIAO_TAM + lx, y = ry * REGIAO_TAM + ly, z = rz * REGIAO_TAM + lz;
+                            if (x >= cx || y >= cy || z >= cz)
+                                continue;
+                            if (!put(world.chunkIndex(x, y, z), world.chunk(x, y, z), io)) {
+                                close();
+                                return false;
+                            }
+                        }
+    return finishCreate(io);
+}
+
+bool RegionStore::beginCreate(const string& dir, const int worldSize[3]) {
+    close();
+    error_code erro;
+    filesystem::create_directories(dir, erro);
+    if (erro) {
+        cerr << "Falha ao criar o diretorio " << dir << endl;
+        return false;
+    }
+    dimensiona(dir, worldSize);
+    criando = true;
+    lote.allocate(LOTE_CRIACAO);
+    regiaoLote = -1;
+    usadoLote = 0;
+    return true;
+}
+
+// Os conteúdos vão para o fim da região em ordem (o arquivo novo não tem buracos) e se
+// acumulam no lote enquanto os chunks seguidos são da mesma região
+bool RegionStore::put(int chunkIndex, const Chunk& chunk, ChunkIO& io) {
+    int local;
+    RegionFile* regiao = region(chunkIndex, local);
+    if (!regiao)
+        return false;
+    int x = chunkIndex % cx, z = (chunkIndex / cx) % cz, y = chunkIndex / (cx * cz);
+    int indice = indiceRegiao(x / REGIAO_TAM, y / REGIAO_TAM, z / REGIAO_TAM);
+    if (indice != regiaoLote || usadoLote + REGIAO_MAX_CONTEUDO > lote.size()) {
+        if (!gravaLote(io))
+            return false;
+        regiaoLote = indice;
+    }
+    uint8_t* destino = lote.data() + usadoLote;
+    uint32_t bytes = encodeChunkPayload(chunk, destino);
+    uint64_t offset = regiao->allocate(local, bytes);
+    if (bytes == 0)
+        return true;
+    if (usadoLote == 0)
+        inicioLote = offset;
+    size_t setores = (size_t)regionSectors(bytes) * REGIAO_SETOR;
+    memset(destino + bytes, 0, setores - bytes);
+    usadoLote += setores;
+    return true;
+}
+
+bool RegionStore::gravaLote(ChunkIO& io) {
+    if (usadoLote == 0)
+        return true;
+    RegionFile& regiao = *regioes[regiaoLote];
+    bool ok = writeSequential(io, regiao.descriptor(), inicioLote, lote.data(), usadoLote);
+    usadoLote = 0;
+    if (!ok) {
+        int rx = regiaoLote % regioesX, rz = (regiaoLote / regioesX) % regioesZ, ry = regiaoLote / (regioesX * regioesZ);
+        cerr << "Falha ao gravar " << regionPath(diretorio, rx, ry, rz) << endl;
+    }
+    return ok;
+}
+
+bool RegionStore::finishCreate(ChunkIO& io) {
+    bool ok = gravaLote(io) && commit();
+    string dir = diretorio;
+    close();
+    if (!ok)
+        return false;
+    return open(dir);
+}
+
+void RegionStore::close() {
+    regioes.clear();
+    diretorio.clear();
+    criando = false;
+    lote = AlignedBuffer();
+    usadoLote = 0;
+}
+
+// Uma região de outro mundo ou trocada de nome poria os chunks nos lugares errados: o
+// cabeçalho tem de ter o tamanho do mundo do store e a posição do nome do arquivo
+bool RegionStore::confere(const RegionFile& regiao, int rx, int ry, int rz) const {
+    const int* t = regiao.worldSize();
+    const int* p = regiao.position();
+    if (t[0] != tamanho[0] || t[1] != tamanho[1] || t[2] != tamanho[2]) {
+        cerr << "Regiao de outro mundo: " << regionPath(diretorio, rx, ry, rz) << " tem " << t[0] << "x" << t[1]
+             << "x" << t[2] << ", o mundo " << tamanho[0] << "x" << tamanho[1] << "x" << tamanho[2] << endl;
+        return false;
+    }
+    if (p[0] != rx || p[1] != ry || p[2] != rz) {
+        cerr << "Regiao fora do lugar: " << regionPath(diretorio, rx, ry, rz) << " diz ser a " << p[0] << "."
+             << p[1] << "." << p[2] << endl;
+        return false;
+    }
+    return true;
+}
+
+RegionFile* RegionStore::region(int chunkIndex, int& local) {
+    int x = chunkIndex % cx, z = (chunkIndex / cx) % cz, y = chunkIndex / (cx * cz);
+    local = RegionFile::localIndex(x % REGIAO_TAM, y % REGIAO_TAM, z % REGIAO_TAM);
+    int rx = x / REGIAO_TAM, ry = y / REGIAO_TAM, rz = z / REGIAO_TAM;
+    unique_ptr<RegionFile>& r = regioes[indiceRegiao(rx, ry, rz)];
+    if (!r) {
+        r = make_unique<RegionFile>();
+        string path = regionPath(diretorio, rx, ry, rz);
+        // Na criação, o que houver de um mundo anterior no diretório é recriado
+        error_code erro;
+        bool existe = !criando && filesystem::exists(path, erro);
+        int posicao[3] = { rx, ry, rz };
+        if (!r->open(path, !existe, tamanho, posicao) || !confere(*r, rx, ry, rz)) {
+            r.reset();
+            return nullptr;
+        }
+    }
+    return r.get();
+}
+
+bool RegionStore::commit() {
+    bool ok = true;
+    for (auto& r : regioes)
+        if (r && r->dirty())
+            ok = r->commit() && ok;
+    return ok;
+}
+
+uint32_t RegionStore::pendingSectors() const {
+    uint32_t n = 0;
+    for (const auto& r : regioes)
+        if (r)
+            n += r->pendingSectors();
+    return n;
+}
+
+RegionStats RegionStore::stats() const {
+    RegionStats total;
+    for (const auto& r : regioes) {
+        if (!r)
+            continue;
+        RegionStats s = r->stats();
+        total.chunks += s.chunks;
+        total.usedSectors += s.usedSectors;
+        total.freeSectors += s.freeSectors;
+        total.pendingSectors += s.pendingSectors;
+        total.fileSectors += s.fileSectors;
+    }
+    return total;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "chunk_io.h"
+#include "world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Lado de uma região em chunks (32^3 chunks, 512^3 voxels por arquivo)
+const int REGIAO_TAM = 32;
+const int REGIAO_CHUNKS = REGIAO_TAM * REGIAO_TAM * REGIAO_TAM;
+// Unidade de alocação dentro do arquivo: o bloco de O_DIRECT
+const size_t REGIAO_SETOR = IO_ALINHAMENTO;
+// Maior conteúdo de um chunk em disco (o registro cru) e quantos setores ocupa
+const uint32_t REGIAO_MAX_CONTEUDO = (uint32_t)CHUNK_REGISTRO;
+const uint32_t REGIAO_MAX_SETORES = (uint32_t)(CHUNK_REGISTRO / REGIAO_SETOR);
+
+// Onde está o chunk no arquivo: primeiro setor e tamanho do conteúdo em bytes (0 =
+// chunk vazio, sem setores)
+struct RegionEntry {
+    uint32_t sector = 0;
+    uint32_t bytes = 0;
+};
+
+inline uint32_t regionSectors(uint32_t bytes) {
+    return (uint32_t)((bytes + REGIAO_SETOR - 1) / REGIAO_SETOR);
+}
+
+// Conteúdo de um chunk no disco, a partir do registro de packChunk: nada se o registro
+// é todo zero, RLE por byte (corrida, valor) se fica menor que o registro, senão o
+// registro cru. saida tem REGIAO_MAX_CONTEUDO bytes. Devolve o tamanho
+uint32_t encodeChunkPayload(const Chunk& chunk, uint8_t* saida);
+// O inverso (bytes == REGIAO_MAX_CONTEUDO é cru, menos é RLE, 0 é vazio). false se o
+// conteúdo não dá um registro inteiro
+bool decodeChunkPayload(const uint8_t* dados, uint32_t bytes, Chunk& chunk);
+
+struct RegionStats {
+    int chunks = 0;               // com conteúdo (os vazios não ocupam setor)
+    uint32_t usedSectors = 0;
+    uint32_t freeSectors = 0;     // buracos reaproveitáveis, já gravados na tabela
+    uint32_t pendingSectors = 0;  // liberados desde o último commit
+    uint32_t fileSectors = 0;     // até o fim do último conteúdo
+};
+
+// Um arquivo de região: 32^3 chunks com acesso direto a cada um. O primeiro setor tem
+// a marca, a versão, o tamanho do mundo e a posição da região; os 64 seguintes, a
+// tabela fixa com um RegionEntry por chunk; depois vêm os conteúdos, cada um em setores
+// inteiros e alinhados. Ler ou regravar um chunk é um pread/pwrite no offset da tabela.
+//
+// Um chunk regravado vai para o primeiro buraco livre que caiba (ou para o fim) e os
+// setores antigos viram buraco. Os buracos só voltam a ser usados depois de commit(),
+// que grava a tabela e sincroniza: até lá a tabela no disco ainda aponta para eles, e
+// uma queda no meio deixa o arquivo no estado do último commit. Com o tempo os buracos
+// espalham o arquivo; compactRegionFile o reescreve contíguo (voxel_region compacta)
+class RegionFile {
+public:
+    RegionFile() = default;
+    ~RegionFile();
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    // Abre para leitura e escrita (O_DIRECT se o sistema de arquivos deixar). Com create
+    // recria o arquivo vazio com worldSize e position no cabeçalho
+    bool open(const std::string& path, bool create, const int worldSize[3] = nullptr,
+              const int position[3] = nullptr);
+    // Sem commit: o que não foi gravado na tabela se perde
+    void close();
+    bool isOpen() const { return fd >= 0; }
+    int descriptor() const { return fd; }
+    const int* worldSize() const { return tamanhoMundo; }
+    const int* position() const { return posicao; }
+
+    // Índice do chunk dentro da região: x mais rápido, depois z, depois y (como World)
+    static int localIndex(int x, int y, int z) { return (y * REGIAO_TAM + z) * REGIAO_TAM + x; }
+    const RegionEntry& entry(int local) const { return tabela()[local]; }
+    uint64_t offsetOf(const RegionEntry& e) const { return (uint64_t)e.sector * REGIAO_SETOR; }
+
+    // Lugar para um conteúdo novo do chunk (a tabela muda só na memória). Devolve o
+    // offset onde gravar regionSectors(bytes) setores; 0 se bytes == 0 (chunk vazio)
+    uint64_t allocate(int local, uint32_t bytes);
+    // Grava os setores alterados da tabela, sincroniza e libera os buracos pendentes.
+    // Chamar só com os conteúdos alocados já gravados
+    bool commit();
+    bool dirty() const { return tabelaSuja; }
+    uint32_t pendingSectors() const { return setoresPendentes; }
+
+    // Síncronos, um pread/pwrite por chunk (ferramentas e criação; o streaming usa o
+    // ChunkIO). buffer alinhado com REGIAO_MAX_CONTEUDO bytes
+    bool readPayload(int local, uint8_t* buffer);
+    bool writePayload(int local, const uint8_t* buffer, uint32_t bytes);
+    bool readChunk(int local, Chunk& chunk);
+    bool writeChunk(int local, const Chunk& chunk);
+
+    RegionStats stats() const;
+
+private:
+    RegionEntry* tabela() { return reinterpret_cast<RegionEntry*>(cabecalho.data() + REGIAO_SETOR); }
+    const RegionEntry* tabela() const {
+        return reinterpret_cast<const RegionEntry*>(cabecalho.data() + REGIAO_SETOR);
+    }
+    bool montaLivres();
+    void libera(uint32_t setor, uint32_t n);
+
+    int fd = -1;
+    std::string caminho;
+    int tamanhoMundo[3] = { 0, 0, 0 };
+    int posicao[3] = { 0, 0, 0 };
+    // Cabeçalho e tabela como estão no disco (alinhados para o O_DIRECT)
+    AlignedBuffer cabecalho;
+    std::vector<uint8_t> setoresSujos;   // um por setor da tabela
+    bool tabelaSuja = false;
+    // Buracos (primeiro setor, quantidade) em ordem, e os liberados desde o último commit
+    std::vector<std::pair<uint32_t, uint32_t>> livres, pendentes;
+    uint32_t setoresPendentes = 0;
+    uint32_t fim = 0;                    // primeiro setor depois do último conteúdo
+    AlignedBuffer temporario;            // readChunk/writeChunk
+};
+
+// Reescreve a região com os conteúdos contíguos, na ordem dos chunks, num arquivo
+// temporário que depois toma o lugar do original. antes/depois opcionais
+bool compactRegionFile(const std::string& path, RegionStats* antes = nullptr, RegionStats* depois = nullptr);
+
+// Um mundo inteiro em regiões num diretório (r.X.Y.Z.vxr), cada uma aberta quando é
+// usada pela primeira vez (e criada vazia se ainda não existe). O tamanho do mundo fica
+// no cabeçalho de todas; open lê o da região 0.0.0 e cada região aberta depois tem de
+// bater com ele e com a posição do seu nome
+class RegionStore {
+public:
+    bool open(const std::string& dir);
+    // Grava world inteiro (os conteúdos de cada região em lotes sequenciais pelo io)
+    bool create(const std::string& dir, const World& world, ChunkIO& io);
+    // Criação aos poucos, para mundos que não cabem na memória: beginCreate recria as
+    // regiões de um mundo de worldSize voxels, put grava cada chunk uma vez, em qualquer
+    // ordem (os seguidos da mesma região saem juntos num lote sequencial), e
+    // finishCreate grava as tabelas e segue como open
+    bool beginCreate(const std::string& dir, const int worldSize[3]);
+    bool put(int chunkIndex, const Chunk& chunk, ChunkIO& io);
+    bool finishCreate(ChunkIO& io);
+    // Sem commit (chamar commit antes para guardar as tabelas)
+    void close();
+    bool isOpen() const { return !diretorio.empty(); }
+    const int* worldSize() const { return tamanho; }
+
+    // Região de um chunk do mundo (índice de World::chunkIndex) e o índice dentro dela.
+    // nullptr se não deu para abrir nem criar o arquivo
+    RegionFile* region(int chunkIndex, int& local);
+    // commit de todas as regiões com a tabela alterada
+    bool commit();
+    // Setores liberados e ainda presos até o próximo commit
+    uint32_t pendingSectors() const;
+    RegionStats stats() const;
+
+    static std::string regionPath(const std::string& dir, int rx, int ry, int rz);
+
+private:
+    int indiceRegiao(int x, int y, int z) const { return (y * regioesZ + z) * regioesX + x; }
+    bool confere(const RegionFile& regiao, int rx, int ry, int rz) const;
+    void dimensiona(const std::string& dir, const int worldSize[3]);
+    bool gravaLote(ChunkIO& io);
+
+    std::string diretorio;
+    int tamanho[3] = { 0, 0, 0 };
+    int cx = 0, cy = 0, cz = 0;          // chunks do mundo por eixo
+    int regioesX = 0, regioesY = 0, regioesZ = 0;
+    std::vector<std::unique_ptr<RegionFile>> regioes;
+
+    // Criação (beginCreate..finishCreate): conteúdos da região regiaoLote ainda por
+    // gravar a partir de inicioLote
+    bool criando = false;
+    AlignedBuffer lote;
+    int regiaoLote = -1;
+    uint64_t inicioLote = 0;
+    size_t usadoLote = 0;
+};
@@ -0,0 +1,153 @@
+#include "render_queue.h"
+#include "gl_ext.h"
+#include "profiler.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+uint64_t makeSortKey(RenderPass pass, uint32_t shader, uint32_t material, uint32_t depth, uint32_t seq) {
+    return ((uint64_t)(pass & 0xF) << 60) |
+           ((uint64_t)(shader & 0xFF) << 52) |
+           ((uint64_t)(material & 0xFFF) << 40) |
+           ((uint64_t)(depth & 0xFFFFFF) << 16) |
+           (uint64_t)(seq & 0xFFFF);
+}
+
+uint32_t quantizeDepth(float distance, float farPlane) {
+    float t = distance / farPlane;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+    return (uint32_t)(t * 0xFFFFFF);
+}
+
+void RenderQueue::clear() {
+    items.clear();
+}
+
+void RenderQueue::push(const DrawItem& item) {
+    items.push_back(item);
+}
+
+// Radix sort LSD de 8 bits sobre as chaves de 64 bits. Ordena apenas os índices,
+// e pula os dígitos em que todas as chaves são iguais (comum nos bits de pass/shader)
+void RenderQueue::sort() {
+    size_t n = items.size();
+    keys.resize(n);
+    keysTmp.resize(n);
+    order.resize(n);
+    orderTmp.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = items[i].key;
+        order[i] = (uint32_t)i;
+    }
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t count[256] = {0};
+        for (size_t i = 0; i < n; i++)
+            count[(keys[i] >> shift) & 0xFF]++;
+        if (n == 0 || count[(keys[0] >> shift) & 0xFF] == n)
+            continue;
+
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++) {
+            size_t c = count[d];
+            count[d] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            size_t dst = count[(keys[i] >> shift) & 0xFF]++;
+            keysTmp[dst] = keys[i];
+            orderTmp[dst] = order[i];
+        }
+        keys.swap(keysTmp);
+        order.swap(orderTmp);
+    }
+}
+
+// Simula a submissão numa dada ordem e conta as trocas de estado necessárias
+int RenderQueue::countStateChanges(const std::vector<uint32_t>& itemOrder) const {
+    GLState state;
+    int changes = 0;
+    int pass = -1;
+    for (uint32_t idx : itemOrder) {
+        const DrawItem& item = items[idx];
+        // Cada troca de pass reconfigura framebuffer/blend e invalida os binds
+        if (item.pass != pass) {
+            pass = item.pass;
+            state = GLState();
+            changes++;
+        }
+        if (state.program != item.program) { state.program = item.program; changes++; }
+        if (state.vao != item.vao) { state.vao = item.vao; changes++; }
+        if (state.texture != item.texture) { state.texture = item.texture; changes++; }
+    }
+    return changes;
+}
+
+// Nomes dos passes no profiler
+static const char* const NOMES_PASSES[NUM_PASSES] = { "opacos", "transparentes", "selecao" };
+
+void RenderQueue::submit() {
+    PERFIL_ESCOPO("desenho");
+    frameStats = RenderStats();
+    frameStats.items = (int)items.size();
+
+    // Ordem de coleta, só para a estatística de comparação
+    orderTmp.resize(items.size());
+    for (size_t i = 0; i < items.size(); i++)
+        orderTmp[i] = (uint32_t)i;
+    frameStats.stateChangesUnsorted = countStateChanges(orderTmp);
+
+    GLState state;
+    int changes = 0;
+    size_t next = 0;
+    for (int pass = 0; pass < NUM_PASSES; pass++) {
+        PERFIL_GPU(NOMES_PASSES[pass]);
+        if (passCallback) {
+            passCallback((RenderPass)pass);
+            state = GLState();
+            changes++;
+        }
+        for (; next < order.size() && items[order[next]].pass == pass; next++) {
+            const DrawItem& item = items[order[next]];
+            if (state.program != item.program) {
+                glUseProgram(item.program);
+                state.program = item.program;
+                state.modelLoc = glGetUniformLocation(item.program, "model");
+                changes++;
+            }
+            if (state.vao != item.vao) {
+                glBindVertexArray(item.vao);
+                state.vao = item.vao;
+                changes++;
+            }
+            if (state.texture != item.texture) {
+                glBindTexture(item.textureTarget, item.texture);
+                state.texture = item.texture;
+                changes++;
+            }
+            glUniformMatrix4fv(state.modelLoc, 1, GL_FALSE, glm::value_ptr(item.model));
+            if (item.indirectBuffer) {
+                // Sem contagem na GPU, os comandos que sobram têm count = 0 e não desenham
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, item.indirectBuffer);
+                if (item.countBuffer && glExt.indirectCount) {
+                    glBindBuffer(GL_PARAMETER_BUFFER, item.countBuffer);
+                    glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)item.indirectOffset,
+                                                     item.countOffset, item.count, 0);
+                    glBindBuffer(GL_PARAMETER_BUFFER, 0);
+                }
+                else {
+                    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)item.indirectOffset,
+                                                item.count, 0);
+                }
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+            }
+            else if (item.indexed)
+                glDrawElementsBaseVertex(GL_TRIANGLES, item.count, GL_UNSIGNED_INT,
+                                         (const void*)(item.first * sizeof(GLuint)), item.baseVertex);
+            else
+                glDrawArrays(GL_TRIANGLES, item.first, item.count);
+            frameStats.drawCalls++;
+        }
+    }
+    frameStats.stateChangesSorted = changes;
+}
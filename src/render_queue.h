@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+// Passes de renderização, na ordem em que são submetidos
+enum RenderPass : uint8_t {
+    PASS_OPACO = 0,
+    PASS_TRANSPARENTE = 1,
+    PASS_SELECAO = 2,
+    NUM_PASSES
+};
+
+// Chamado no início de cada pass (mesmo sem itens) para configurar framebuffer,
+// blend e profundidade do pass. Pode alterar qualquer estado de GL.
+typedef void (*PassCallback)(RenderPass pass);
+
+// Layout da chave de ordenação (64 bits, do mais para o menos significativo):
+// pass (4) | shader (8) | material (12) | profundidade (24) | sequência (16)
+uint64_t makeSortKey(RenderPass pass, uint32_t shader, uint32_t material, uint32_t depth, uint32_t seq = 0);
+
+// Quantiza a distância até a câmera em 24 bits (0 = perto, 2^24-1 = plano far)
+uint32_t quantizeDepth(float distance, float farPlane);
+
+// Um item de desenho com todo o estado que ele precisa
+struct DrawItem {
+    uint64_t key = 0;
+    RenderPass pass = PASS_OPACO;
+    GLuint program = 0;
+    GLuint vao = 0;
+    GLenum textureTarget = GL_TEXTURE_2D;
+    GLuint texture = 0;
+    glm::mat4 model = glm::mat4(1.0f);
+    // Sem índices: glDrawArrays(first, count). Indexado: glDrawElementsBaseVertex
+    // com 'count' índices GL_UNSIGNED_INT a partir de 'first' e 'baseVertex'
+    bool indexed = false;
+    GLint first = 0;
+    GLsizei count = 0;
+    GLint baseVertex = 0;
+    // Multi-draw indireto (indexado): até 'count' comandos DrawElementsIndirectCommand
+    // em indirectBuffer a partir de indirectOffset. Se countBuffer != 0, o número
+    // real de comandos é o uint em countOffset (gerado na GPU)
+    GLuint indirectBuffer = 0;
+    GLintptr indirectOffset = 0;
+    GLuint countBuffer = 0;
+    GLintptr countOffset = 0;
+};
+
+// Contadores do último frame
+struct RenderStats {
+    int items = 0;
+    int drawCalls = 0;
+    int stateChangesUnsorted = 0; // trocas de estado se submetido na ordem de coleta
+    int stateChangesSorted = 0;   // trocas de estado efetivamente feitas após a ordenação
+};
+
+// Fila de desenho: coleta os itens do frame, ordena por chave (radix sort)
+// e submete em ordem pulando binds e trocas de estado redundantes
+class RenderQueue {
+public:
+    void clear();
+    void push(const DrawItem& item);
+    void sort();
+    void submit();
+
+    void setPassCallback(PassCallback callback) { passCallback = callback; }
+
+    const RenderStats& stats() const { return frameStats; }
+
+private:
+    // Estado de GL que a fila controla
+    struct GLState {
+        GLuint program = 0;
+        GLuint vao = 0;
+        GLuint texture = 0;
+        GLint modelLoc = -1;
+    };
+
+    int countStateChanges(const std::vector<uint32_t>& order) const;
+
+    std::vector<DrawItem> items;
+    std::vector<uint64_t> keys, keysTmp;
+    std::vector<uint32_t> order, orderTmp;
+    RenderStats frameStats;
+    PassCallback passCallback = nullptr;
+};
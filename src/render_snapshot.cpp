@@ -0,0 +1,102 @@
+#include "render_snapshot.h"
+
+#include <chrono>
+
+using namespace std;
+
+void SnapshotMailbox::publishView(RenderSnapshot&& snapshot) {
+    {
+        lock_guard<mutex> lock(trava);
+        if (pendente)
+            estatisticas.merged++;
+        // O mundo e as cópias continuam os do quadro (pendente ou o último)
+        for (int i = 0; i < 3; i++)
+            snapshot.worldSize[i] = proximo.worldSize[i];
+        snapshot.worldGeneration = proximo.worldGeneration;
+        snapshot.chunks.swap(proximo.chunks);
+        proximo = move(snapshot);
+        pendente = true;
+        estatisticas.published++;
+    }
+    chegou.notify_one();
+}
+
+void SnapshotMailbox::publishWorld(const int size[3], uint32_t generation,
+                                   vector<pair<int, shared_ptr<const Chunk>>>&& chunks) {
+    {
+        lock_guard<mutex> lock(trava);
+        if (pendente)
+            estatisticas.merged++;
+        // Mesmo mundo: as cópias ainda não pegas vêm antes das novas. Mundo recriado:
+        // a publicação nova já traz todos os chunks
+        if (generation == proximo.worldGeneration && !proximo.chunks.empty()) {
+            proximo.chunks.insert(proximo.chunks.end(), make_move_iterator(chunks.begin()),
+                                  make_move_iterator(chunks.end()));
+        }
+        else {
+            proximo.chunks = move(chunks);
+        }
+        for (int i = 0; i < 3; i++)
+            proximo.worldSize[i] = size[i];
+        proximo.worldGeneration = generation;
+        pendente = true;
+        estatisticas.published++;
+    }
+    chegou.notify_one();
+}
+
+bool SnapshotMailbox::take(RenderSnapshot& out, double timeout) {
+    unique_lock<mutex> lock(trava);
+    if (!pendente && !fechada && timeout > 0.0)
+        chegou.wait_for(lock, chrono::duration<double>(timeout), [this] { return pendente || fechada; });
+    if (!pendente || fechada)
+        return false;
+    // As cópias vão junto; a vista e o mundo ficam para completar as próximas publicações
+    vector<pair<int, shared_ptr<const Chunk>>> copias;
+    copias.swap(proximo.chunks);
+    out = proximo;
+    out.chunks = move(copias);
+    pendente = false;
+    estatisticas.taken++;
+    lock.unlock();
+    pego.notify_all();
+    return true;
+}
+
+bool SnapshotMailbox::waitTaken(double timeout) {
+    unique_lock<mutex> lock(trava);
+    return pego.wait_for(lock, chrono::duration<double>(timeout), [this] { return !pendente || fechada; });
+}
+
+void SnapshotMailbox::close() {
+    {
+        lock_guard<mutex> lock(trava);
+        fechada = true;
+    }
+    chegou.notify_all();
+    pego.notify_all();
+}
+
+bool SnapshotMailbox::closed() const {
+    lock_guard<mutex> lock(trava);
+    return fechada;
+}
+
+SnapshotMailboxStats SnapshotMailbox::stats() const {
+    lock_guard<mutex> lock(trava);
+    return estatisticas;
+}
+
+void applySnapshotChunks(const RenderSnapshot& snapshot, World& mirror, uint32_t& mirroredGeneration) {
+    if (snapshot.worldGeneration != mirroredGeneration || mirror.sizeX() != snapshot.worldSize[0] ||
+        mirror.sizeY() != snapshot.worldSize[1] || mirror.sizeZ() != snapshot.worldSize[2]) {
+        mirror.resize(snapshot.worldSize[0], snapshot.worldSize[1], snapshot.worldSize[2], false);
+        mirroredGeneration = snapshot.worldGeneration;
+    }
+    for (const auto& copia : snapshot.chunks) {
+        if (copia.second)
+            mirror.copyChunk(copia.first, *copia.second);
+        else
+            mirror.evictChunk(copia.first);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "world.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Tudo o que o desenho de um frame lê, para a thread de render (dona do contexto de
+// GL). A vista (câmera, opções, pedidos) vem da thread principal e o mundo da thread
+// do mundo (edições e luz). Depois de publicado não muda mais: os chunks vão como
+// cópias imutáveis, só os que mudaram desde a publicação anterior (todos quando o
+// mundo é recriado), e a thread de render os aplica num espelho do mundo. Pedidos
+// pontuais (captura, profiler) são contadores que só crescem: a thread de render
+// atende até alcançar o valor
+struct RenderSnapshot {
+    // Câmera e tamanho do framebuffer
+    glm::vec3 cameraPos = glm::vec3(0.0f);
+    glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
+    glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
+    float fov = 45.0f;
+    int width = 1, height = 1;
+
+    // Seleção e opções de desenho
+    int selection[3] = { 0, 0, 0 };
+    bool raymarch = false;
+    bool lod = true, gpuCulling = true, gpuMeshing = false;
+    bool hud = true;
+
+    // Pedidos: F12 (capturas), F11 (sequência ligada) e F9 (alternâncias do profiler)
+    int captureRequests = 0;
+    bool sequence = false;
+    int profilerToggles = 0;
+
+    // Redesenho sob demanda e tempo ocioso (para o HUD)
+    bool onDemand = true;
+    bool idle = false;              // publicado com o editor ocioso
+    double idleSeconds = 0.0;
+
+    // Mundo: tamanho, geração (muda no resize) e cópias dos chunks alterados, em
+    // ordem de publicação (a última cópia de um índice vale). Cópia nula: o chunk saiu
+    // da memória (streaming)
+    int worldSize[3] = { 0, 0, 0 };
+    uint32_t worldGeneration = 0;
+    std::vector<std::pair<int, std::shared_ptr<const Chunk>>> chunks;
+};
+
+struct SnapshotMailboxStats {
+    long long published = 0;
+    long long taken = 0;
+    long long merged = 0;           // publicações juntadas a um quadro ainda não pego
+};
+
+// Caixa de um lugar para a thread de render, com dois produtores: a vista e o mundo.
+// Cada publicação completa o quadro pendente (ou um novo, a partir da última vista e
+// do último mundo). As cópias de chunks de publicações ainda não pegas se acumulam
+// (o mundo espelhado não pode perder edições); a câmera e os pedidos são sempre os
+// mais novos
+class SnapshotMailbox {
+public:
+    // Vista: os campos de mundo e os chunks de snapshot são ignorados
+    void publishView(RenderSnapshot&& snapshot);
+    // Mundo: tamanho, geração e as cópias dos chunks que mudaram
+    void publishWorld(const int size[3], uint32_t generation,
+                      std::vector<std::pair<int, std::shared_ptr<const Chunk>>>&& chunks);
+    // Pega o mais novo, esperando até timeout segundos (0 = não espera). Devolve false
+    // sem quadro novo (ou com a caixa fechada)
+    bool take(RenderSnapshot& out, double timeout);
+    // Thread principal: espera o último publicado ser pego. Devolve false no timeout
+    bool waitTaken(double timeout);
+
+    // Acorda as duas threads para encerrar
+    void close();
+    bool closed() const;
+
+    SnapshotMailboxStats stats() const;
+
+private:
+    mutable std::mutex trava;
+    std::condition_variable chegou, pego;
+    RenderSnapshot proximo;         // pendente, ou a última vista/mundo sem chunks
+    bool pendente = false;
+    bool fechada = false;
+    SnapshotMailboxStats estatisticas;
+};
+
+// Aplica as cópias de chunks de um quadro ao espelho do mundo (recriado se o tamanho
+// ou a geração mudaram, sem chunks: a publicação de um mundo novo traz os que estão
+// na memória)
+void applySnapshotChunks(const RenderSnapshot& snapshot, World& mirror, uint32_t& mirroredGeneration);
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Compila um vertex e um fragment shader e cria o programa
+GLuint setupShader(const GLchar* vertexSource, const GLchar* fragmentSource);
+
+// Compila um compute shader e cria o programa (requer GL 4.3, ver gl_ext.h)
+GLuint setupComputeShader(const GLchar* computeSource);
@@ -0,0 +1,364 @@
+#include "soft_raster.h"
+#include "materials.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace std;
+
+// Grade de subpixel dos vértices (1/16 de pixel): com os centros dos pixels em .5, as
+// funções de aresta caem numa grade de 1/256 e saem exatas em float
+const float SUBPIXEL = 16.0f;
+const float MEIO_PASSO = 0.5f / (SUBPIXEL * SUBPIXEL);
+// Abaixo disso (pixels por voxel do LOD) a textura vira a cor média
+const float PIXELS_TEXTURA = 3.0f;
+
+struct SoftRasterizer::ChunkTriangles {
+    vector<Triangle> triangles;
+    vector<pair<int, int>> tiles;   // (bloco, triângulo) para cada bloco que o triângulo toca
+};
+
+// Vértice em espaço de recorte com os atributos do shader dos chunks
+struct RasterVertex {
+    glm::vec4 clip;
+    float u, v, shade;
+};
+
+// Distribui os índices 0..n-1 entre as threads (a chamadora também trabalha)
+template <typename F>
+static void parallelFor(int n, int threads, F func) {
+    atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < n; i = next++)
+            func(i);
+    };
+    vector<thread> pool;
+    for (int t = 1; t < min(threads, n); t++)
+        pool.emplace_back(worker);
+    worker();
+    for (thread& t : pool)
+        t.join();
+}
+
+void SoftRasterizer::setup(const BlockImages& images) {
+    texSize = images.size;
+    texCount = images.count;
+    const int porTextura = texSize * texSize;
+    texels.resize((size_t)texCount * porTextura);
+    average.assign(texCount, glm::vec4(0.0f));
+    for (int m = 0; m < texCount; m++) {
+        glm::vec4 soma(0.0f);
+        for (int i = 0; i < porTextura; i++) {
+            const uint8_t* p = &images.rgba[((size_t)m * porTextura + i) * 4];
+            glm::vec4 c(p[0] / 255.0f, p[1] / 255.0f, p[2] / 255.0f, p[3] / 255.0f);
+            texels[(size_t)m * porTextura + i] = c;
+            soma = soma + glm::vec4(c.x * c.w, c.y * c.w, c.z * c.w, c.w);
+        }
+        // Média ponderada pelo alfa (o vidro é quase todo transparente)
+        if (soma.w > 0.0f)
+            average[m] = glm::vec4(soma.x / soma.w, soma.y / soma.w, soma.z / soma.w, soma.w / porTextura);
+    }
+}
+
+// Recorta o triângulo no plano near (z >= -w) e devolve até 4 vértices (leque)
+static int clipNear(const RasterVertex in[3], RasterVertex out[4]) {
+    int n = 0;
+    for (int i = 0; i < 3; i++) {
+        const RasterVertex& a = in[i];
+        const RasterVertex& b = in[(i + 1) % 3];
+        float da = a.clip.z + a.clip.w, db = b.clip.z + b.clip.w;
+        if (da >= 0.0f)
+            out[n++] = a;
+        if ((da >= 0.0f) != (db >= 0.0f)) {
+            float t = da / (da - db);
+            RasterVertex& r = out[n++];
+            r.clip = a.clip + (b.clip - a.clip) * t;
+            r.u = a.u + (b.u - a.u) * t;
+            r.v = a.v + (b.v - a.v) * t;
+            r.shade = a.shade + (b.shade - a.shade) * t;
+        }
+    }
+    return n;
+}
+
+void SoftRasterizer::buildChunk(const World& world, int cx, int cy, int cz, const glm::mat4& viewProj,
+                                const glm::vec3& cameraPos, float pixelsPerUnitAt1, const SoftRasterSettings& settings,
+                                ChunkTriangles& out) const {
+    out.triangles.clear();
+    out.tiles.clear();
+
+    // LOD pela distância, com a mesma regra de ChunkRenderer::chooseLod
+    glm::vec3 base = world.origin() + glm::vec3((float)cx, (float)cy, (float)cz) * (float)CHUNK_TAM;
+    glm::vec3 center = base + glm::vec3(CHUNK_TAM * 0.5f);
+    float distance = max(1.0f, glm::length(center - cameraPos) - CHUNK_TAM * 0.8660254f);
+    float pixelsPerUnit = pixelsPerUnitAt1 / distance;
+    int lod = 0;
+    while (lod < MAX_LOD && (1 << (lod + 1)) * pixelsPerUnit <= settings.lodPixelSize)
+        lod++;
+    bool flat = (1 << lod) * pixelsPerUnit < PIXELS_TEXTURA;
+
+    static thread_local ChunkMesh mesh;
+    meshChunk(world, cx, cy, cz, lod, mesh);
+
+    const float W = (float)settings.width, H = (float)settings.height;
+    const int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    const int firstTransparent = mesh.opaqueQuads + mesh.skirtQuads;
+    for (int q = 0; q < mesh.quads(); q++) {
+        RasterVertex quad[4];
+        for (int k = 0; k < 4; k++) {
+            const ChunkVertex& cv = mesh.vertices[(size_t)q * 4 + k];
+            glm::vec3 p((float)cv.x, (float)cv.y, (float)cv.z);
+            RasterVertex& r = quad[k];
+            r.clip = viewProj * glm::vec4(base + p, 1.0f);
+            // Mesma coordenada de textura e sombreamento do shader dos chunks
+            float u, v;
+            if (cv.face == 0) { u = -p.z; v = p.y; }
+            else if (cv.face == 1) { u = p.z; v = p.y; }
+            else if (cv.face <= 3) { u = p.x; v = p.z; }
+            else if (cv.face == 4) { u = p.x; v = p.y; }
+            else { u = -p.x; v = p.y; }
+            r.u = u;
+            r.v = 1.0f - v;
+            r.shade = 0.55f + 0.15f * cv.ao;
+            if (settings.lighting) {
+                int l = max(luzCeu(cv.light), luzBloco(cv.light));
+                r.shade *= 0.06f + 0.94f * pow(0.8f, (float)(LUZ_MAX - l));
+            }
+        }
+        int material = mesh.vertices[(size_t)q * 4].material;
+        bool transparent = q >= firstTransparent;
+
+        // Dois triângulos por quad, 0,1,2 e 0,2,3 como o índice dos chunks
+        for (int t = 0; t < 2; t++) {
+            RasterVertex tri[3] = { quad[0], quad[1 + t], quad[2 + t] };
+            RasterVertex poly[4];
+            int n = clipNear(tri, poly);
+
+            for (int f = 1; f + 1 < n; f++) {
+                const RasterVertex* vs[3] = { &poly[0], &poly[f], &poly[f + 1] };
+                float x[3], y[3];
+                Triangle T;
+                float zs[3], invW[3], us[3], vs2[3], shades[3];
+                for (int k = 0; k < 3; k++) {
+                    float w = vs[k]->clip.w;
+                    invW[k] = 1.0f / w;
+                    x[k] = round(((vs[k]->clip.x * invW[k]) * 0.5f + 0.5f) * W * SUBPIXEL) / SUBPIXEL;
+                    y[k] = round((0.5f - (vs[k]->clip.y * invW[k]) * 0.5f) * H * SUBPIXEL) / SUBPIXEL;
+                    zs[k] = (vs[k]->clip.z * invW[k]) * 0.5f + 0.5f;
+                    us[k] = vs[k]->u * invW[k];
+                    vs2[k] = vs[k]->v * invW[k];
+                    shades[k] = vs[k]->shade;
+                }
+
+                // Na tela (y para baixo) as faces da frente ficam no sentido horário
+                float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if (area >= 0.0f)
+                    continue;
+
+                float minXf = min(x[0], min(x[1], x[2])), maxXf = max(x[0], max(x[1], x[2]));
+                float minYf = min(y[0], min(y[1], y[2])), maxYf = max(y[0], max(y[1], y[2]));
+                T.minX = max(0, (int)floor(minXf));
+                T.minY = max(0, (int)floor(minYf));
+                T.maxX = min(settings.width - 1, (int)ceil(maxXf));
+                T.maxY = min(settings.height - 1, (int)ceil(maxYf));
+                if (T.minX > T.maxX || T.minY > T.maxY)
+                    continue;
+
+                // Arestas com o interior positivo; o empate (E == 0) fica com um só
+                // dos dois triângulos que dividem a aresta
+                for (int e = 0; e < 3; e++) {
+                    int a = e, b = (e + 1) % 3;
+                    float A = y[b] - y[a], B = -(x[b] - x[a]);
+                    T.edge[e][0] = A;
+                    T.edge[e][1] = B;
+                    T.edge[e][2] = -(A * x[a] + B * y[a]);
+                    bool topLeft = A > 0.0f || (A == 0.0f && B > 0.0f);
+                    T.edgeBias[e] = topLeft ? 0.0f : MEIO_PASSO;
+                }
+
+                // Planos a + b*x + c*y dos atributos
+                auto plano = [&](const float f[3], float out[3]) {
+                    float dx = ((f[1] - f[0]) * (y[2] - y[0]) - (f[2] - f[0]) * (y[1] - y[0])) / area;
+                    float dy = ((f[2] - f[0]) * (x[1] - x[0]) - (f[1] - f[0]) * (x[2] - x[0])) / area;
+                    out[0] = f[0] - dx * x[0] - dy * y[0];
+                    out[1] = dx;
+                    out[2] = dy;
+                };
+                plano(zs, T.z);
+                plano(invW, T.invW);
+                plano(us, T.uw);
+                plano(vs2, T.vw);
+                plano(shades, T.shade);
+                T.material = material;
+                T.transparent = transparent;
+                T.flat = flat;
+
+                int index = (int)out.triangles.size();
+                out.triangles.push_back(T);
+                for (int ty = T.minY / settings.tileSize; ty <= T.maxY / settings.tileSize; ty++)
+                    for (int tx = T.minX / settings.tileSize; tx <= T.maxX / settings.tileSize; tx++)
+                        out.tiles.push_back({ ty * tilesX + tx, index });
+            }
+        }
+    }
+}
+
+void SoftRasterizer::rasterTile(int tile, const vector<ChunkTriangles>& chunks, const vector<uint64_t>& entries,
+                                int first, int last, const SoftRasterSettings& settings, vector<float>& color,
+                                vector<float>& depth) const {
+    const int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    const int x0 = (tile % tilesX) * settings.tileSize, y0 = (tile / tilesX) * settings.tileSize;
+    const int x1 = min(settings.width, x0 + settings.tileSize) - 1;
+    const int y1 = min(settings.height, y0 + settings.tileSize) - 1;
+    const int porTextura = texSize * texSize;
+
+    // Opacos do mais perto ao mais longe (o depth test descarta mais cedo), depois os
+    // transparentes do mais longe ao mais perto, misturados por cima
+    for (int pass = 0; pass < 2; pass++) {
+        bool transparentPass = pass == 1;
+        for (int k = 0; k < last - first; k++) {
+            uint64_t entry = entries[transparentPass ? first + k : last - 1 - k];
+            const Triangle& T = chunks[entry >> 32].triangles[(uint32_t)entry];
+            if (T.transparent != transparentPass)
+                continue;
+
+            int rx0 = max(T.minX, x0), rx1 = min(T.maxX, x1);
+            int ry0 = max(T.minY, y0), ry1 = min(T.maxY, y1);
+            for (int y = ry0; y <= ry1; y++) {
+                float py = y + 0.5f;
+                for (int xs = rx0; xs <= rx1; xs += RASTER_LARGURA) {
+                    // Funções de aresta e profundidade de RASTER_LARGURA pixels
+                    alignas(32) int visivel[RASTER_LARGURA];
+                    alignas(32) float zs[RASTER_LARGURA];
+                    const float* linha = &depth[(size_t)y * settings.width + xs];
+                    int algum = 0;
+                    for (int i = 0; i < RASTER_LARGURA; i++) {
+                        float px = xs + i + 0.5f;
+                        float e0 = T.edge[0][0] * px + T.edge[0][1] * py + T.edge[0][2];
+                        float e1 = T.edge[1][0] * px + T.edge[1][1] * py + T.edge[1][2];
+                        float e2 = T.edge[2][0] * px + T.edge[2][1] * py + T.edge[2][2];
+                        float z = T.z[0] + T.z[1] * px + T.z[2] * py;
+                        zs[i] = z;
+                        visivel[i] = (e0 >= T.edgeBias[0]) & (e1 >= T.edgeBias[1]) & (e2 >= T.edgeBias[2]) &
+                                     (xs + i <= rx1) & (z >= 0.0f) & (z < linha[i]);
+                        algum |= visivel[i];
+                    }
+                    if (!algum)
+                        continue;
+
+                    for (int i = 0; i < RASTER_LARGURA; i++) {
+                        if (!visivel[i])
+                            continue;
+                        float px = xs + i + 0.5f;
+                        glm::vec4 c;
+                        if (T.flat || T.material >= texCount) {
+                            c = T.material < texCount ? average[T.material] : glm::vec4(0.8f, 0.8f, 0.8f, 1.0f);
+                        } else {
+                            float w = 1.0f / (T.invW[0] + T.invW[1] * px + T.invW[2] * py);
+                            float u = (T.uw[0] + T.uw[1] * px + T.uw[2] * py) * w;
+                            float v = (T.vw[0] + T.vw[1] * px + T.vw[2] * py) * w;
+                            int tx = min(texSize - 1, max(0, (int)((u - floor(u)) * texSize)));
+                            int ty = min(texSize - 1, max(0, (int)((v - floor(v)) * texSize)));
+                            c = texels[(size_t)T.material * porTextura + ty * texSize + tx];
+                        }
+                        if (c.w < 0.01f)
+                            continue;
+                        float shade = T.shade[0] + T.shade[1] * px + T.shade[2] * py;
+                        size_t p = (size_t)y * settings.width + xs + i;
+                        float* out = &color[p * 3];
+                        if (!transparentPass) {
+                            out[0] = c.x * shade;
+                            out[1] = c.y * shade;
+                            out[2] = c.z * shade;
+                            depth[p] = zs[i];
+                        } else {
+                            out[0] = c.x * shade * c.w + out[0] * (1.0f - c.w);
+                            out[1] = c.y * shade * c.w + out[1] * (1.0f - c.w);
+                            out[2] = c.z * shade * c.w + out[2] * (1.0f - c.w);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+SoftRasterStats SoftRasterizer::render(const World& world, const glm::mat4& view, const glm::mat4& proj,
+                                       const glm::vec3& cameraPos, float fovY, const SoftRasterSettings& settings,
+                                       vector<uint8_t>& rgb) const {
+    using relogio = chrono::steady_clock;
+    auto ms = [](relogio::time_point a, relogio::time_point b) {
+        return chrono::duration<double, milli>(b - a).count();
+    };
+    SoftRasterStats stats;
+    int numThreads = settings.threads > 0 ? settings.threads : (int)max(1u, thread::hardware_concurrency());
+    glm::mat4 viewProj = proj * view;
+    float pixelsPerUnitAt1 = settings.height / (2.0f * tan(fovY * 0.5f));
+
+    // Chunks não vazios do mais longe ao mais perto
+    vector<pair<float, int>> ordem;
+    for (int cy = 0; cy < world.chunksY(); cy++)
+        for (int cz = 0; cz < world.chunksZ(); cz++)
+            for (int cx = 0; cx < world.chunksX(); cx++) {
+                if (world.chunk(cx, cy, cz).visibleCount == 0)
+                    continue;
+                glm::vec3 center = world.origin() + (glm::vec3((float)cx, (float)cy, (float)cz) + glm::vec3(0.5f)) * (float)CHUNK_TAM;
+                glm::vec3 d = center - cameraPos;
+                ordem.push_back({ -glm::dot(d, d), world.chunkIndex(cx, cy, cz) });
+            }
+    sort(ordem.begin(), ordem.end());
+    stats.chunks = (int)ordem.size();
+
+    auto inicio = relogio::now();
+    vector<ChunkTriangles> chunks(ordem.size());
+    parallelFor((int)ordem.size(), numThreads, [&](int i) {
+        int ci = ordem[i].second;
+        int cx = ci % world.chunksX(), cz = (ci / world.chunksX()) % world.chunksZ();
+        int cy = ci / (world.chunksX() * world.chunksZ());
+        buildChunk(world, cx, cy, cz, viewProj, cameraPos, pixelsPerUnitAt1, settings, chunks[i]);
+    });
+    auto malhas = relogio::now();
+    stats.meshMs = ms(inicio, malhas);
+
+    // Listas por bloco (ordenação por contagem, estável na ordem dos chunks)
+    const int tilesX = (settings.width + settings.tileSize - 1) / settings.tileSize;
+    const int tilesY = (settings.height + settings.tileSize - 1) / settings.tileSize;
+    const int numTiles = tilesX * tilesY;
+    vector<int> offsets(numTiles + 1, 0);
+    for (const ChunkTriangles& c : chunks) {
+        stats.triangles += (long long)c.triangles.size();
+        for (const pair<int, int>& t : c.tiles)
+            offsets[t.first + 1]++;
+    }
+    for (int t = 0; t < numTiles; t++)
+        offsets[t + 1] += offsets[t];
+    vector<uint64_t> entries(offsets[numTiles]);
+    vector<int> cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < chunks.size(); i++)
+        for (const pair<int, int>& t : chunks[i].tiles)
+            entries[cursor[t.first]++] = ((uint64_t)i << 32) | (uint32_t)t.second;
+    stats.binned = (long long)entries.size();
+    auto listas = relogio::now();
+    stats.setupMs = ms(malhas, listas);
+
+    // Profundidade com folga de uma linha SIMD no fim (a última linha lê além da largura)
+    vector<float> color((size_t)settings.width * settings.height * 3);
+    for (size_t p = 0; p < color.size(); p += 3) {
+        color[p] = settings.background.x;
+        color[p + 1] = settings.background.y;
+        color[p + 2] = settings.background.z;
+    }
+    vector<float> depth((size_t)settings.width * settings.height + RASTER_LARGURA, 1.0f);
+    parallelFor(numTiles, numThreads, [&](int tile) {
+        rasterTile(tile, chunks, entries, offsets[tile], offsets[tile + 1], settings, color, depth);
+    });
+
+    rgb.resize(color.size());
+    for (size_t i = 0; i < color.size(); i++)
+        rgb[i] = (uint8_t)min(255.0f, max(0.0f, color[i]) * 255.0f + 0.5f);
+    stats.rasterMs = ms(listas, relogio::now());
+    return stats;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "block_images.h"
+#include "mesher.h"
+#include "world.h"
+
+#include <cstdint>
+#include <vector>
+
+struct SoftRasterSettings {
+    int width = 256, height = 256;
+    int threads = 0;             // 0 = hardware_concurrency
+    int tileSize = 64;           // lado do bloco de pixels de cada lista de triângulos
+    bool lighting = false;       // usa Chunk::light (precisa de LightEngine); senão tudo aceso
+    float lodPixelSize = 2.0f;   // como ChunkRenderer::lodPixelSize
+    glm::vec3 background = glm::vec3(0.1f, 0.1f, 0.1f);
+};
+
+struct SoftRasterStats {
+    int chunks = 0;              // chunks não vazios com malha
+    long long triangles = 0;     // depois do backface culling e do recorte
+    long long binned = 0;        // entradas nas listas dos blocos
+    double meshMs = 0.0, setupMs = 0.0, rasterMs = 0.0;
+};
+
+// Rasterizador na CPU para miniaturas e renderização sem GPU. Usa as mesmas malhas
+// de chunk (meshChunk, com LOD pela distância) e as mesmas texturas e sombreamento dos
+// shaders dos chunks (oclusão dos cantos e luz).
+//
+// Três fases, todas em paralelo: (1) malha, transformação, recorte no plano near e
+// preparo dos triângulos por chunk, com cada triângulo anotado nos blocos de tela que
+// a sua caixa toca; (2) as anotações viram uma lista por bloco, na ordem dos chunks
+// do mais longe ao mais perto; (3) cada thread pega um bloco e rasteriza a lista dele
+// contra o seu pedaço do depth buffer: primeiro os opacos, depois os transparentes
+// misturados por cima sem escrever profundidade. As funções de aresta são avaliadas
+// em linhas de RASTER_LARGURA pixels em estrutura de arrays, sem desvios, para o
+// compilador vetorizar; o sombreamento só roda nos pixels cobertos e visíveis
+const int RASTER_LARGURA = 8;
+
+class SoftRasterizer {
+public:
+    void setup(const BlockImages& images);
+
+    // rgb recebe width * height * 3 bytes, linha 0 no topo
+    SoftRasterStats render(const World& world, const glm::mat4& view, const glm::mat4& proj, const glm::vec3& cameraPos,
+                           float fovY, const SoftRasterSettings& settings, std::vector<uint8_t>& rgb) const;
+
+private:
+    // Triângulo pronto para rasterizar: arestas e planos em coordenadas de tela
+    struct Triangle {
+        float edge[3][3];       // A, B, C de cada aresta (dentro >= 0)
+        float edgeBias[3];      // regra top-left: 0 ou meio passo da grade de subpixel
+        float z[3], invW[3], uw[3], vw[3], shade[3];   // planos a + b*x + c*y
+        int minX, minY, maxX, maxY;
+        int material;
+        bool transparent;
+        bool flat;              // voxel pequeno na tela: cor média da textura
+    };
+    struct ChunkTriangles;
+
+    void buildChunk(const World& world, int cx, int cy, int cz, const glm::mat4& viewProj, const glm::vec3& cameraPos,
+                    float pixelsPerUnitAt1, const SoftRasterSettings& settings, ChunkTriangles& out) const;
+    void rasterTile(int tile, const std::vector<ChunkTriangles>& chunks, const std::vector<uint64_t>& entries,
+                    int first, int last, const SoftRasterSettings& settings, std::vector<float>& color,
+                    std::vector<float>& depth) const;
+
+    int texSize = 16, texCount = 0;
+    std::vector<glm::vec4> texels;      // RGBA 0..1 por material
+    std::vector<glm::vec4> average;     // cor média de cada material
+};
@@ -0,0 +1,852 @@
+// Microbenchmarks do lado dos dados: leitura/escrita de células, varreduras, o reset
+// da tecla R, gravar/carregar o .dat, malhas por chunk, picks por raio, preenchimento
+// (luz e BFS), codificação dos chunks, o mapa concorrente de chunks sob disputa e a
+// E/S de chunks (ifstream/ofstream contra io_uring e grupo de threads). Cada caso
+// recebe o tamanho do mundo (N^3) e a densidade de voxels (%). Os casos "Plano" medem
+// a mesma operação na grade original do editor (Voxel grid[TAM][TAM][TAM], um int e
+// um bool por voxel), a referência para as mudanças de estrutura de dados. Sem janela
+// nem OpenGL.
+//
+// Uso: voxel_bench [--filtro TEXTO] [--tempo-min S]
+
+#include "chunk_io.h"
+#include "chunk_map.h"
+#include "light.h"
+#include "materials.h"
+#include "mesher.h"
+#include "microbench.h"
+#include "world.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using microbench::State;
+
+static const vector<int64_t> TAMANHOS = { 32, 64, 128 };
+static const vector<int64_t> DENSIDADES = { 10, 50, 100 };
+
+// Números pseudoaleatórios com semente fixa: os mesmos dados em toda execução
+struct Lcg {
+    uint32_t estado;
+    explicit Lcg(uint32_t semente) : estado(semente) {}
+    uint32_t operator()() {
+        estado = estado * 1664525u + 1013904223u;
+        return estado >> 8;
+    }
+};
+
+// Voxel como na grade original do editor
+struct VoxelPlano {
+    int texID;
+    bool visivel;
+};
+
+// Grade original: um array plano em ordem y, x, z (a ordem do .dat)
+struct GradePlana {
+    int tam = 0;
+    vector<VoxelPlano> voxels;
+
+    size_t indice(int x, int y, int z) const { return ((size_t)y * tam + x) * tam + z; }
+};
+
+// Material do voxel (x, y, z) com a densidade pedida: opacos e transparentes misturados
+static int materialDe(Lcg& aleatorio, int densidade) {
+    if ((int)(aleatorio() % 100) >= densidade)
+        return -1;
+    return (int)(aleatorio() % TEXTURA_SELECAO);
+}
+
+// Mundos de teste guardados por (tamanho, densidade): a preparação sai uma vez
+static World& mundoTeste(int tam, int densidade) {
+    static World mundo;
+    static int tamAtual = -1, densidadeAtual = -1;
+    static uint64_t editsAtual = 0;
+    if (tam != tamAtual || densidade != densidadeAtual || mundo.edits() != editsAtual) {
+        mundo.resize(tam, tam, tam);
+        Lcg aleatorio(1234);
+        for (int y = 0; y < tam; y++)
+            for (int x = 0; x < tam; x++)
+                for (int z = 0; z < tam; z++) {
+                    int texID = materialDe(aleatorio, densidade);
+                    if (texID >= 0)
+                        mundo.set(x, y, z, (uint8_t)(VOXEL_VISIVEL | texID));
+                }
+        vector<VoxelEdit> descartadas;
+        mundo.takeEdits(descartadas);
+        tamAtual = tam;
+        densidadeAtual = densidade;
+        editsAtual = mundo.edits();
+    }
+    return mundo;
+}
+
+static GradePlana& gradeTeste(int tam, int densidade) {
+    static GradePlana grade;
+    static int densidadeAtual = -1;
+    if (tam != grade.tam || densidade != densidadeAtual) {
+        grade.tam = tam;
+        grade.voxels.assign((size_t)tam * tam * tam, VoxelPlano{ 0, false });
+        Lcg aleatorio(1234);
+        for (int y = 0; y < tam; y++)
+            for (int x = 0; x < tam; x++)
+                for (int z = 0; z < tam; z++) {
+                    int texID = materialDe(aleatorio, densidade);
+                    if (texID >= 0)
+                        grade.voxels[grade.indice(x, y, z)] = VoxelPlano{ texID, true };
+                }
+        densidadeAtual = densidade;
+    }
+    return grade;
+}
+
+struct Coordenada {
+    int x, y, z;
+};
+
+static vector<Coordenada> coordenadasAleatorias(int tam, int n) {
+    Lcg aleatorio(99);
+    vector<Coordenada> lista(n);
+    for (Coordenada& c : lista)
+        c = { (int)(aleatorio() % tam), (int)(aleatorio() % tam), (int)(aleatorio() % tam) };
+    return lista;
+}
+
+const int NUM_ACESSOS = 4096;
+
+// --- Leitura e escrita de células ---
+
+static void BM_GetAleatorio(State& state) {
+    const World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    vector<Coordenada> coords = coordenadasAleatorias(mundo.sizeX(), NUM_ACESSOS);
+    for (auto _ : state) {
+        int visiveis = 0;
+        for (const Coordenada& c : coords)
+            visiveis += voxelVisivel(mundo.get(c.x, c.y, c.z));
+        microbench::DoNotOptimize(visiveis);
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_ACESSOS);
+}
+BENCHMARK(BM_GetAleatorio)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+static void BM_GetAleatorioPlano(State& state) {
+    const GradePlana& grade = gradeTeste((int)state.range(0), (int)state.range(1));
+    vector<Coordenada> coords = coordenadasAleatorias(grade.tam, NUM_ACESSOS);
+    for (auto _ : state) {
+        int visiveis = 0;
+        for (const Coordenada& c : coords)
+            visiveis += grade.voxels[grade.indice(c.x, c.y, c.z)].visivel;
+        microbench::DoNotOptimize(visiveis);
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_ACESSOS);
+}
+BENCHMARK(BM_GetAleatorioPlano)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// set alterna a visibilidade (duas passadas deixam o mundo como estava). Conta o
+// registro de edições e as versões dos chunks, como no editor
+static void BM_SetAleatorio(State& state) {
+    World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    vector<Coordenada> coords = coordenadasAleatorias(mundo.sizeX(), NUM_ACESSOS);
+    vector<VoxelEdit> descartadas;
+    for (auto _ : state) {
+        for (const Coordenada& c : coords)
+            mundo.set(c.x, c.y, c.z, mundo.get(c.x, c.y, c.z) ^ VOXEL_VISIVEL);
+        state.PauseTiming();
+        mundo.takeEdits(descartadas);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_ACESSOS);
+}
+BENCHMARK(BM_SetAleatorio)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+static void BM_SetAleatorioPlano(State& state) {
+    GradePlana& grade = gradeTeste((int)state.range(0), (int)state.range(1));
+    vector<Coordenada> coords = coordenadasAleatorias(grade.tam, NUM_ACESSOS);
+    for (auto _ : state) {
+        for (const Coordenada& c : coords) {
+            VoxelPlano& v = grade.voxels[grade.indice(c.x, c.y, c.z)];
+            v.visivel = !v.visivel;
+        }
+        microbench::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_ACESSOS);
+}
+BENCHMARK(BM_SetAleatorioPlano)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// --- Varreduras do mundo inteiro ---
+
+// Por coordenadas, como o editor percorre a grade (y, x, z)
+static void BM_Varredura(State& state) {
+    const World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    const int tam = mundo.sizeX();
+    for (auto _ : state) {
+        int visiveis = 0;
+        for (int y = 0; y < tam; y++)
+            for (int x = 0; x < tam; x++)
+                for (int z = 0; z < tam; z++)
+                    visiveis += voxelVisivel(mundo.get(x, y, z));
+        microbench::DoNotOptimize(visiveis);
+    }
+    state.SetItemsProcessed(state.iterations() * tam * tam * tam);
+}
+BENCHMARK(BM_Varredura)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// Direto nos arrays dos chunks, na ordem da memória
+static void BM_VarreduraChunks(State& state) {
+    World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    for (auto _ : state) {
+        int visiveis = 0;
+        for (int cy = 0; cy < mundo.chunksY(); cy++)
+            for (int cz = 0; cz < mundo.chunksZ(); cz++)
+                for (int cx = 0; cx < mundo.chunksX(); cx++) {
+                    const Chunk& chunk = mundo.chunk(cx, cy, cz);
+                    for (int i = 0; i < CHUNK_VOLUME; i++)
+                        visiveis += chunk.voxels[i] >> 7;
+                }
+        microbench::DoNotOptimize(visiveis);
+    }
+    int64_t celulas = (int64_t)mundo.sizeX() * mundo.sizeY() * mundo.sizeZ();
+    state.SetItemsProcessed(state.iterations() * celulas);
+    state.SetBytesProcessed(state.iterations() * celulas);
+}
+BENCHMARK(BM_VarreduraChunks)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+static void BM_VarreduraPlano(State& state) {
+    const GradePlana& grade = gradeTeste((int)state.range(0), (int)state.range(1));
+    for (auto _ : state) {
+        int visiveis = 0;
+        for (const VoxelPlano& v : grade.voxels)
+            visiveis += v.visivel;
+        microbench::DoNotOptimize(visiveis);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)grade.voxels.size());
+    state.SetBytesProcessed(state.iterations() * (int64_t)(grade.voxels.size() * sizeof(VoxelPlano)));
+}
+BENCHMARK(BM_VarreduraPlano)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// --- Reset (tecla R) ---
+
+static void BM_Reset(State& state) {
+    int tam = (int)state.range(0);
+    World mundo;
+    mundo.resize(tam, tam, tam);
+    for (auto _ : state) {
+        mundo.clear();
+        microbench::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * tam * tam * tam);
+}
+BENCHMARK(BM_Reset)->ArgsProduct({ TAMANHOS })->ArgNames({ "tam" });
+
+static void BM_ResetPlano(State& state) {
+    int tam = (int)state.range(0);
+    vector<VoxelPlano> voxels((size_t)tam * tam * tam);
+    for (auto _ : state) {
+        for (VoxelPlano& v : voxels)
+            v = VoxelPlano{ 0, false };
+        microbench::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * tam * tam * tam);
+}
+BENCHMARK(BM_ResetPlano)->ArgsProduct({ TAMANHOS })->ArgNames({ "tam" });
+
+// --- Gravar e carregar o .dat ---
+
+static const char* ARQUIVO_TEMP = "voxel_bench.dat";
+
+static long tamanhoArquivo(const char* caminho) {
+    FILE* f = fopen(caminho, "rb");
+    if (!f)
+        return 0;
+    fseek(f, 0, SEEK_END);
+    long bytes = ftell(f);
+    fclose(f);
+    return bytes;
+}
+
+static void BM_SalvaGrid(State& state) {
+    const World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    for (auto _ : state) {
+        if (!saveGrid(mundo, ARQUIVO_TEMP)) {
+            state.SkipWithError("falha ao gravar");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * tamanhoArquivo(ARQUIVO_TEMP));
+    remove(ARQUIVO_TEMP);
+}
+BENCHMARK(BM_SalvaGrid)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+static void BM_CarregaGrid(State& state) {
+    const World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    saveGrid(mundo, ARQUIVO_TEMP);
+    World carregado;
+    for (auto _ : state) {
+        if (!loadGrid(carregado, ARQUIVO_TEMP)) {
+            state.SkipWithError("falha ao carregar");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * tamanhoArquivo(ARQUIVO_TEMP));
+    remove(ARQUIVO_TEMP);
+}
+BENCHMARK(BM_CarregaGrid)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// --- Malhas ---
+
+// Todos os chunks do mundo no LOD pedido (terceiro argumento)
+static void BM_MalhaChunk(State& state) {
+    const World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    int lod = (int)state.range(2);
+    ChunkMesh malha;
+    long long quads = 0;
+    for (auto _ : state) {
+        quads = 0;
+        for (int cy = 0; cy < mundo.chunksY(); cy++)
+            for (int cz = 0; cz < mundo.chunksZ(); cz++)
+                for (int cx = 0; cx < mundo.chunksX(); cx++) {
+                    meshChunk(mundo, cx, cy, cz, lod, malha);
+                    quads += malha.quads();
+                }
+        microbench::DoNotOptimize(quads);
+    }
+    state.SetItemsProcessed(state.iterations() * mundo.chunkCount());
+    state.SetLabel(to_string(quads) + " quads");
+}
+BENCHMARK(BM_MalhaChunk)->ArgsProduct({ TAMANHOS, DENSIDADES, { 0, 2 } })->ArgNames({ "tam", "dens", "lod" });
+
+// --- Picks por raio ---
+
+// DDA voxel a voxel (Amanatides & Woo) a partir de fora do mundo até o primeiro
+// voxel visível, como um pick do mouse. Devolve os passos dados (-1 se não acertou)
+static int pickRaio(const World& mundo, glm::vec3 origem, glm::vec3 direcao) {
+    // Entra na caixa do mundo pelo método das placas
+    glm::vec3 tamanho((float)mundo.sizeX(), (float)mundo.sizeY(), (float)mundo.sizeZ());
+    float tEntrada = 0.0f, tSaida = 1e30f;
+    for (int e = 0; e < 3; e++) {
+        if (fabs(direcao[e]) < 1e-8f) {
+            if (origem[e] < 0.0f || origem[e] > tamanho[e])
+                return -1;
+            continue;
+        }
+        float t0 = -origem[e] / direcao[e], t1 = (tamanho[e] - origem[e]) / direcao[e];
+        if (t0 > t1)
+            swap(t0, t1);
+        tEntrada = max(tEntrada, t0);
+        tSaida = min(tSaida, t1);
+    }
+    if (tEntrada > tSaida)
+        return -1;
+
+    glm::vec3 p = origem + direcao * (tEntrada + 1e-4f);
+    int celula[3], passo[3];
+    float proximo[3], delta[3];
+    for (int e = 0; e < 3; e++) {
+        celula[e] = min((int)tamanho[e] - 1, max(0, (int)floor(p[e])));
+        passo[e] = direcao[e] >= 0.0f ? 1 : -1;
+        delta[e] = fabs(direcao[e]) < 1e-8f ? 1e30f : fabs(1.0f / direcao[e]);
+        float borda = (float)celula[e] + (passo[e] > 0 ? 1.0f : 0.0f);
+        proximo[e] = fabs(direcao[e]) < 1e-8f ? 1e30f : (borda - p[e]) / direcao[e];
+    }
+    for (int passos = 0;; passos++) {
+        if (mundo.visible(celula[0], celula[1], celula[2]))
+            return passos;
+        int e = (proximo[0] < proximo[1]) ? (proximo[0] < proximo[2] ? 0 : 2) : (proximo[1] < proximo[2] ? 1 : 2);
+        celula[e] += passo[e];
+        if (celula[e] < 0 || celula[e] >= (int)tamanho[e])
+            return -1;
+        proximo[e] += delta[e];
+    }
+}
+
+static void BM_PickRaio(State& state) {
+    const World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    const int numRaios = 1024;
+    const float tam = (float)mundo.sizeX();
+    // Origens numa esfera em volta do mundo, mirando pontos aleatórios dentro dele
+    Lcg aleatorio(7);
+    auto unidade = [&]() { return (aleatorio() % 10000) / 10000.0f; };
+    vector<glm::vec3> origens(numRaios), direcoes(numRaios);
+    for (int i = 0; i < numRaios; i++) {
+        float teta = unidade() * 6.2831853f, fi = (unidade() - 0.5f) * 3.1415926f;
+        glm::vec3 centro(tam * 0.5f);
+        origens[i] = centro + glm::vec3(cos(teta) * cos(fi), sin(fi), sin(teta) * cos(fi)) * tam;
+        glm::vec3 alvo(unidade() * tam, unidade() * tam, unidade() * tam);
+        direcoes[i] = glm::normalize(alvo - origens[i]);
+    }
+    long long passos = 0;
+    int acertos = 0;
+    for (auto _ : state) {
+        passos = 0;
+        acertos = 0;
+        for (int i = 0; i < numRaios; i++) {
+            int n = pickRaio(mundo, origens[i], direcoes[i]);
+            if (n >= 0) {
+                passos += n;
+                acertos++;
+            }
+        }
+        microbench::DoNotOptimize(passos);
+    }
+    state.SetItemsProcessed(state.iterations() * numRaios);
+    state.SetLabel(to_string(acertos) + " acertos, " + to_string(acertos ? passos / acertos : 0) + " passos");
+}
+BENCHMARK(BM_PickRaio)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// --- Preenchimento ---
+
+// Luz do mundo inteiro (céu e blocos) numa thread: a propagação em largura do editor
+static void BM_LuzInteira(State& state) {
+    World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    LightEngine luz;
+    luz.threads = 1;
+    for (auto _ : state) {
+        luz.relightAll(mundo);
+        microbench::DoNotOptimize(luz.stats().cellsLit);
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)mundo.sizeX() * mundo.sizeY() * mundo.sizeZ());
+    state.SetLabel(to_string(luz.stats().cellsLit) + " celulas acesas");
+    // A luz conta como edição: o próximo caso refaz o mundo de teste
+}
+BENCHMARK(BM_LuzInteira)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// Preenchimento por BFS (6 vizinhos) do espaço vazio conectado a um canto, como um
+// balde de tinta. Visitados num bitset do tamanho do mundo
+static void BM_PreenchimentoBFS(State& state) {
+    const World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    const int tam = mundo.sizeX();
+    vector<uint64_t> visitado(((size_t)tam * tam * tam + 63) / 64);
+    vector<int> fila;
+    fila.reserve((size_t)tam * tam * tam);
+    long long preenchidas = 0;
+    for (auto _ : state) {
+        fill(visitado.begin(), visitado.end(), 0);
+        fila.clear();
+        preenchidas = 0;
+        auto tenta = [&](int x, int y, int z) {
+            if (!mundo.inside(x, y, z) || mundo.visible(x, y, z))
+                return;
+            int i = (y * tam + z) * tam + x;
+            uint64_t bit = 1ull << (i & 63);
+            if (visitado[i >> 6] & bit)
+                return;
+            visitado[i >> 6] |= bit;
+            fila.push_back(i);
+        };
+        tenta(0, tam - 1, 0);
+        for (size_t cabeca = 0; cabeca < fila.size(); cabeca++) {
+            int i = fila[cabeca];
+            int x = i % tam, z = (i / tam) % tam, y = i / (tam * tam);
+            preenchidas++;
+            for (int f = 0; f < NUM_FACES; f++)
+                tenta(x + FACE_DIR[f][0], y + FACE_DIR[f][1], z + FACE_DIR[f][2]);
+        }
+        microbench::DoNotOptimize(preenchidas);
+    }
+    state.SetItemsProcessed(state.iterations() * max<long long>(1, preenchidas));
+    state.SetLabel(to_string(preenchidas) + " celulas");
+}
+BENCHMARK(BM_PreenchimentoBFS)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// --- Codificação dos chunks ---
+
+// RLE por byte (corrida, valor) dos voxels de cada chunk: a referência para os
+// formatos compactos em disco
+static size_t codificaRLE(const uint8_t* dados, int n, vector<uint8_t>& saida) {
+    size_t inicio = saida.size();
+    for (int i = 0; i < n;) {
+        uint8_t valor = dados[i];
+        int corrida = 1;
+        while (i + corrida < n && corrida < 255 && dados[i + corrida] == valor)
+            corrida++;
+        saida.push_back((uint8_t)corrida);
+        saida.push_back(valor);
+        i += corrida;
+    }
+    return saida.size() - inicio;
+}
+
+static size_t decodificaRLE(const uint8_t* dados, size_t bytes, uint8_t* saida) {
+    size_t n = 0;
+    for (size_t i = 0; i + 1 < bytes; i += 2) {
+        memset(saida + n, dados[i + 1], dados[i]);
+        n += dados[i];
+    }
+    return n;
+}
+
+static void BM_CodificaRLE(State& state) {
+    World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    vector<uint8_t> saida;
+    for (auto _ : state) {
+        saida.clear();
+        for (int c = 0; c < mundo.chunkCount(); c++) {
+            const Chunk& chunk = mundo.chunk(c % mundo.chunksX(), c / (mundo.chunksX() * mundo.chunksZ()),
+                                             (c / mundo.chunksX()) % mundo.chunksZ());
+            codificaRLE(chunk.voxels, CHUNK_VOLUME, saida);
+        }
+        microbench::DoNotOptimize(saida.data());
+    }
+    int64_t bytes = (int64_t)mundo.chunkCount() * CHUNK_VOLUME;
+    state.SetBytesProcessed(state.iterations() * bytes);
+    char razao[64];
+    snprintf(razao, sizeof(razao), "razao %.3f", (double)saida.size() / bytes);
+    state.SetLabel(razao);
+}
+BENCHMARK(BM_CodificaRLE)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+static void BM_DecodificaRLE(State& state) {
+    World& mundo = mundoTeste((int)state.range(0), (int)state.range(1));
+    vector<uint8_t> codificado;
+    vector<size_t> inicios;
+    for (int c = 0; c < mundo.chunkCount(); c++) {
+        const Chunk& chunk = mundo.chunk(c % mundo.chunksX(), c / (mundo.chunksX() * mundo.chunksZ()),
+                                         (c / mundo.chunksX()) % mundo.chunksZ());
+        inicios.push_back(codificado.size());
+        codificaRLE(chunk.voxels, CHUNK_VOLUME, codificado);
+    }
+    inicios.push_back(codificado.size());
+    vector<uint8_t> voxels(CHUNK_VOLUME);
+    for (auto _ : state) {
+        for (size_t c = 0; c + 1 < inicios.size(); c++)
+            decodificaRLE(&codificado[inicios[c]], inicios[c + 1] - inicios[c], voxels.data());
+        microbench::DoNotOptimize(voxels.data());
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)mundo.chunkCount() * CHUNK_VOLUME);
+}
+BENCHMARK(BM_DecodificaRLE)->ArgsProduct({ TAMANHOS, DENSIDADES })->ArgNames({ "tam", "dens" });
+
+// --- Mapa concorrente de chunks ---
+
+// Leitores buscando chunks enquanto uma thread escreve (troca chunks por cópias e
+// tira/põe chunks, como o streaming): o ConcurrentChunkMap (leitura sem trava, épocas)
+// contra um unordered_map com mutex (tipo 1) e com shared_mutex (tipo 2). Por volta,
+// cada leitor faz LEITURAS_POR_LEITOR buscas em chaves aleatórias e o escritor
+// trabalha até os leitores acabarem. Vazão = buscas/s somando os leitores
+const int MAPA_X = 16, MAPA_Y = 4, MAPA_Z = 16;
+const int LEITURAS_POR_LEITOR = 20000;
+
+struct MapaTravado {
+    unordered_map<uint64_t, unique_ptr<Chunk>> chunks;
+    mutex trava;
+    shared_mutex travaLeitura;
+};
+
+static void BM_MapaChunks(State& state) {
+    const int leitores = (int)state.range(0), tipo = (int)state.range(1);
+    ConcurrentChunkMap mapa;
+    MapaTravado travado;
+    for (int y = 0; y < MAPA_Y; y++)
+        for (int z = 0; z < MAPA_Z; z++)
+            for (int x = 0; x < MAPA_X; x++) {
+                mapa.insert(x, y, z, make_unique<Chunk>());
+                travado.chunks[ConcurrentChunkMap::key(x, y, z)] = make_unique<Chunk>();
+            }
+
+    // Busca de uma chave: o visibleCount do chunk (-1 sem chunk)
+    auto busca = [&](int x, int y, int z) -> int {
+        if (tipo == 0) {
+            EpochGuard secao;
+            const Chunk* c = mapa.find(x, y, z);
+            return c ? c->visibleCount : -1;
+        }
+        uint64_t chave = ConcurrentChunkMap::key(x, y, z);
+        if (tipo == 1) {
+            lock_guard<mutex> lock(travado.trava);
+            auto it = travado.chunks.find(chave);
+            return it != travado.chunks.end() ? it->second->visibleCount : -1;
+        }
+        shared_lock<shared_mutex> lock(travado.travaLeitura);
+        auto it = travado.chunks.find(chave);
+        return it != travado.chunks.end() ? it->second->visibleCount : -1;
+    };
+    // Escrita: metade das vezes uma cópia nova do chunk, metade tira e põe de volta
+    auto escreve = [&](int x, int y, int z, bool troca) {
+        unique_ptr<Chunk> novo = make_unique<Chunk>();
+        novo->visibleCount = x + y + z;
+        if (tipo == 0) {
+            if (!troca)
+                mapa.erase(x, y, z);
+            mapa.insert(x, y, z, move(novo));
+            return;
+        }
+        uint64_t chave = ConcurrentChunkMap::key(x, y, z);
+        unique_ptr<Chunk> antigo;
+        if (tipo == 1) {
+            lock_guard<mutex> lock(travado.trava);
+            if (!troca)
+                travado.chunks.erase(chave);
+            antigo = move(travado.chunks[chave]);
+            travado.chunks[chave] = move(novo);
+        }
+        else {
+            unique_lock<shared_mutex> lock(travado.travaLeitura);
+            if (!troca)
+                travado.chunks.erase(chave);
+            antigo = move(travado.chunks[chave]);
+            travado.chunks[chave] = move(novo);
+        }
+    };
+
+    long long escritas = 0;
+    for (auto _ : state) {
+        atomic<int> restantes(leitores);
+        thread escritor([&]() {
+            Lcg aleatorio(99);
+            for (uint32_t i = 0; restantes.load(memory_order_acquire) > 0; i++) {
+                escreve(aleatorio() % MAPA_X, aleatorio() % MAPA_Y, aleatorio() % MAPA_Z, (i & 1) == 0);
+                escritas++;
+            }
+        });
+        vector<thread> threads;
+        for (int r = 0; r < leitores; r++)
+            threads.emplace_back([&, r]() {
+                Lcg aleatorio(1000 + r);
+                long long soma = 0;
+                for (int i = 0; i < LEITURAS_POR_LEITOR; i++)
+                    soma += busca(aleatorio() % MAPA_X, aleatorio() % MAPA_Y, aleatorio() % MAPA_Z);
+                microbench::DoNotOptimize(soma);
+                restantes.fetch_sub(1, memory_order_release);
+            });
+        for (thread& t : threads)
+            t.join();
+        escritor.join();
+    }
+    epochCollect();
+    state.SetItemsProcessed(state.iterations() * leitores * LEITURAS_POR_LEITOR);
+    const char* nomes[] = { "epocas", "mutex", "shared_mutex" };
+    state.SetLabel(string(nomes[tipo]) + ", " + to_string(escritas / max<int64_t>(1, state.iterations())) +
+                   " escritas/volta");
+}
+BENCHMARK(BM_MapaChunks)->ArgsProduct({ { 1, 2, 4, 8 }, { 0, 1, 2 } })->ArgNames({ "leitores", "tipo" });
+
+// --- E/S de chunks ---
+
+// Arquivo com NUM_REGISTROS chunks (16 MiB, registros de CHUNK_REGISTRO) tirados do
+// mundo 128^3 a 50%
+static const char* ARQUIVO_CHUNKS = "voxel_bench_chunks.bin";
+const int NUM_REGISTROS = 2048;
+// Pedidos por submit e buffers em uso ao mesmo tempo (dois lotes em andamento)
+const int LOTE_IO = 64;
+const int JANELA_IO = 2 * LOTE_IO;
+
+static void apagaArquivoChunks() {
+    remove(ARQUIVO_CHUNKS);
+}
+
+static bool preparaArquivoChunks() {
+    static bool pronto = false;
+    if (pronto)
+        return true;
+    World& mundo = mundoTeste(128, 50);
+    AlignedBuffer dados((size_t)NUM_REGISTROS * CHUNK_REGISTRO);
+    for (int i = 0; i < NUM_REGISTROS; i++) {
+        int c = i % mundo.chunkCount();
+        const Chunk& chunk = mundo.chunk(c % mundo.chunksX(), c / (mundo.chunksX() * mundo.chunksZ()),
+                                         (c / mundo.chunksX()) % mundo.chunksZ());
+        packChunk(chunk, dados.data() + (size_t)i * CHUNK_REGISTRO);
+    }
+    FILE* f = fopen(ARQUIVO_CHUNKS, "wb");
+    if (!f)
+        return false;
+    pronto = fwrite(dados.data(), 1, dados.size(), f) == dados.size();
+    fclose(f);
+    atexit(apagaArquivoChunks);
+    return pronto;
+}
+
+static unique_ptr<ChunkIO> backendDoTipo(int tipo) {
+    return createChunkIO(tipo == 2 ? IO_URING : IO_THREADS);
+}
+
+// Carregar os chunks do arquivo em ordem embaralhada, como o streaming pede: o caminho
+// por ifstream (um seekg + read por chunk, tipo 0) contra o ChunkIO com grupo de
+// threads (1) e io_uring (2), LOTE_IO pedidos por submit e até JANELA_IO em andamento.
+// origem 0 = disco: o arquivo sai do cache de páginas antes de cada volta e o ChunkIO
+// abre com O_DIRECT; 1 = cache de páginas. Cada registro lido vira um Chunk
+// (unpackChunk) nos três casos. Vazão em itens = chunks/s
+static void BM_CarregaChunks(State& state) {
+    const int tipo = (int)state.range(0), origem = (int)state.range(1);
+    if (!preparaArquivoChunks()) {
+        state.SkipWithError("falha ao gravar o arquivo de chunks");
+        return;
+    }
+    vector<int> ordem(NUM_REGISTROS);
+    for (int i = 0; i < NUM_REGISTROS; i++)
+        ordem[i] = i;
+    Lcg aleatorio(4321);
+    for (int i = NUM_REGISTROS - 1; i > 0; i--)
+        swap(ordem[i], ordem[aleatorio() % (i + 1)]);
+
+    unique_ptr<ChunkIO> io;
+    int fd = -1;
+    bool direto = false;
+    if (tipo > 0) {
+        io = backendDoTipo(tipo);
+        if (!io) {
+            state.SkipWithError("io_uring indisponivel");
+            return;
+        }
+        fd = openChunkFile(ARQUIVO_CHUNKS, false, origem == 0, &direto);
+    }
+    AlignedBuffer buffers((size_t)JANELA_IO * CHUNK_REGISTRO);
+    unique_ptr<Chunk[]> chunks(new Chunk[JANELA_IO]);
+    vector<ChunkIORequest> pedidos;
+    vector<ChunkIOCompletion> concluidos;
+    vector<int> livres;
+    bool falhou = false;
+    if (origem == 1) {
+        // Uma leitura inteira antes de medir põe o arquivo no cache
+        ifstream aquece(ARQUIVO_CHUNKS, ios::binary);
+        while (aquece.read(reinterpret_cast<char*>(buffers.data()), (streamsize)buffers.size()))
+            ;
+    }
+
+    for (auto _ : state) {
+        if (origem == 0) {
+            state.PauseTiming();
+            int f = openChunkFile(ARQUIVO_CHUNKS, false, false);
+            dropFileCache(f);
+            closeChunkFile(f);
+            state.ResumeTiming();
+        }
+
+        if (tipo == 0) {
+            ifstream arquivo(ARQUIVO_CHUNKS, ios::binary);
+            for (int i = 0; i < NUM_REGISTROS; i++) {
+                arquivo.seekg((streamoff)ordem[i] * (streamoff)CHUNK_REGISTRO);
+                arquivo.read(reinterpret_cast<char*>(buffers.data()), CHUNK_REGISTRO);
+                unpackChunk(buffers.data(), chunks[i % JANELA_IO]);
+            }
+            falhou = falhou || !arquivo;
+            continue;
+        }
+
+        livres.clear();
+        for (int s = JANELA_IO - 1; s >= 0; s--)
+            livres.push_back(s);
+        int proximo = 0, feitos = 0;
+        while (feitos < NUM_REGISTROS) {
+            // Um lote novo assim que houver buffers livres para ele
+            while (proximo < NUM_REGISTROS && (int)livres.size() >= min(LOTE_IO, NUM_REGISTROS - proximo)) {
+                pedidos.clear();
+                for (int j = 0; j < LOTE_IO && proximo < NUM_REGISTROS; j++, proximo++) {
+                    int s = livres.back();
+                    livres.pop_back();
+                    ChunkIORequest p;
+                    p.op = IO_LEITURA;
+                    p.fd = fd;
+                    p.offset = (uint64_t)ordem[proximo] * CHUNK_REGISTRO;
+                    p.buffer = buffers.data() + (size_t)s * CHUNK_REGISTRO;
+                    p.bytes = (uint32_t)CHUNK_REGISTRO;
+                    p.tag = (uint64_t)s;
+                    pedidos.push_back(p);
+                }
+                io->submit(pedidos.data(), pedidos.size());
+            }
+            concluidos.clear();
+            io->poll(concluidos, true);
+            for (const ChunkIOCompletion& c : concluidos) {
+                falhou = falhou || c.result != (int64_t)CHUNK_REGISTRO;
+                unpackChunk(static_cast<const uint8_t*>(c.buffer), chunks[c.tag]);
+                livres.push_back((int)c.tag);
+                feitos++;
+            }
+        }
+    }
+    microbench::DoNotOptimize(chunks[0].visibleCount);
+    if (falhou)
+        state.SkipWithError("leitura curta ou com erro");
+    state.SetItemsProcessed(state.iterations() * NUM_REGISTROS);
+    state.SetBytesProcessed(state.iterations() * NUM_REGISTROS * (int64_t)CHUNK_REGISTRO);
+    string rotulo = tipo == 0 ? "ifstream" : io->name();
+    if (direto)
+        rotulo += ", O_DIRECT";
+    if (io)
+        rotulo += ", " + to_string(io->stats().syscalls / max<int64_t>(1, state.iterations())) + " syscalls/volta";
+    state.SetLabel(rotulo);
+    closeChunkFile(fd);
+}
+BENCHMARK(BM_CarregaChunks)->ArgsProduct({ { 0, 1, 2 }, { 0, 1 } })->ArgNames({ "tipo", "origem" });
+
+// Salvar os NUM_REGISTROS chunks de uma vez num arquivo novo: ofstream com um write por
+// chunk (tipo 0) contra um buffer alinhado gravado em pedaços de 1 MiB com O_DIRECT
+// num lote só (writeSequential) pelo grupo de threads (1) e pelo io_uring (2). Todos
+// terminam com fdatasync: a volta mede até os dados estarem no disco
+static void BM_SalvaChunks(State& state) {
+    const int tipo = (int)state.range(0);
+    const char* caminho = "voxel_bench_salva.bin";
+    World& mundo = mundoTeste(128, 50);
+    unique_ptr<ChunkIO> io;
+    if (tipo > 0) {
+        io = backendDoTipo(tipo);
+        if (!io) {
+            state.SkipWithError("io_uring indisponivel");
+            return;
+        }
+    }
+    AlignedBuffer dados((size_t)NUM_REGISTROS * CHUNK_REGISTRO);
+    bool direto = false, falhou = false;
+
+    for (auto _ : state) {
+        if (tipo == 0) {
+            ofstream arquivo(caminho, ios::binary | ios::trunc);
+            for (int i = 0; i < NUM_REGISTROS; i++) {
+                int c = i % mundo.chunkCount();
+                packChunk(mundo.chunk(c % mundo.chunksX(), c / (mundo.chunksX() * mundo.chunksZ()),
+                                      (c / mundo.chunksX()) % mundo.chunksZ()),
+                          dados.data());
+                arquivo.write(reinterpret_cast<const char*>(dados.data()), CHUNK_REGISTRO);
+            }
+            arquivo.close();
+            falhou = falhou || !arquivo;
+            int f = openChunkFile(caminho, false, false);
+            syncChunkFile(f);
+            closeChunkFile(f);
+            continue;
+        }
+        for (int i = 0; i < NUM_REGISTROS; i++) {
+            int c = i % mundo.chunkCount();
+            packChunk(mundo.chunk(c % mundo.chunksX(), c / (mundo.chunksX() * mundo.chunksZ()),
+                                  (c / mundo.chunksX()) % mundo.chunksZ()),
+                      dados.data() + (size_t)i * CHUNK_REGISTRO);
+        }
+        int fd = openChunkFile(caminho, true, true, &direto);
+        falhou = falhou || fd < 0 || !truncateChunkFile(fd, 0) ||
+                 !writeSequential(*io, fd, 0, dados.data(), dados.size());
+        syncChunkFile(fd);
+        closeChunkFile(fd);
+    }
+    if (falhou)
+        state.SkipWithError("falha ao gravar");
+    state.SetItemsProcessed(state.iterations() * NUM_REGISTROS);
+    state.SetBytesProcessed(state.iterations() * NUM_REGISTROS * (int64_t)CHUNK_REGISTRO);
+    string rotulo = tipo == 0 ? "ofstream" : io->name();
+    if (direto)
+        rotulo += ", O_DIRECT";
+    state.SetLabel(rotulo);
+    remove(caminho);
+}
+BENCHMARK(BM_SalvaChunks)->ArgsProduct({ { 0, 1, 2 } })->ArgNames({ "tipo" });
+
+int main(int argc, char** argv) {
+    microbench::Runner runner;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--filtro" && i + 1 < argc)
+            runner.filtro = argv[++i];
+        else if (string(argv[i]) == "--tempo-min" && i + 1 < argc)
+            runner.tempoMinimo = max(0.001, atof(argv[++i]));
+    }
+    return runner.executaTodos();
+}
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chunk_io.h"
+#include "light.h"
+#include "region_file.h"
+#include "world.h"
+
+using namespace std;
+
+// Ferramenta offline para os mundos em regiões (os diretórios do --streaming do
+// editor): mostra a ocupação de cada arquivo, compacta os buracos que as regravações
+// deixam e converte um .dat do editor em regiões. Compactar com o editor aberto no
+// mesmo diretório estraga as tabelas que ele tem na memória
+
+void printUso() {
+    cout << "Uso: voxel_region info DIR" << endl;
+    cout << "  chunks, setores em uso e buracos de cada regiao de DIR" << endl;
+    cout << "Uso: voxel_region compacta DIR" << endl;
+    cout << "  reescreve cada regiao de DIR sem buracos" << endl;
+    cout << "Uso: voxel_region converte ARQ.dat DIR" << endl;
+    cout << "  grava o mundo de ARQ.dat (com a luz calculada) em regioes novas em DIR" << endl;
+}
+
+// Arquivos r.X.Y.Z.vxr de dir, em ordem
+vector<string> listaRegioes(const string& dir) {
+    vector<string> arquivos;
+    error_code erro;
+    for (const auto& e : filesystem::directory_iterator(dir, erro)) {
+        string nome = e.path().filename().string();
+        if (e.is_regular_file() && nome.size() > 6 && nome.compare(0, 2, "r.") == 0 &&
+            nome.compare(nome.size() - 4, 4, ".vxr") == 0)
+            arquivos.push_back(e.path().string());
+    }
+    sort(arquivos.begin(), arquivos.end());
+    return arquivos;
+}
+
+static double mb(uint32_t setores) {
+    return setores * (double)REGIAO_SETOR / (1024.0 * 1024.0);
+}
+
+int info(const string& dir) {
+    vector<string> arquivos = listaRegioes(dir);
+    if (arquivos.empty()) {
+        cerr << "Nenhuma regiao em " << dir << endl;
+        return 1;
+    }
+    RegionStats total;
+    for (const string& arquivo : arquivos) {
+        RegionFile regiao;
+        if (!regiao.open(arquivo, false))
+            return 1;
+        RegionStats s = regiao.stats();
+        printf("%s: %d chunks, %.2f MB em uso, %.2f MB em buracos, %.2f MB no arquivo\n", arquivo.c_str(), s.chunks,
+               mb(s.usedSectors), mb(s.freeSectors), mb(s.fileSectors));
+        total.chunks += s.chunks;
+        total.usedSectors += s.usedSectors;
+        total.freeSectors += s.freeSectors;
+        total.fileSectors += s.fileSectors;
+    }
+    printf("Total: %zu regioes, %d chunks, %.2f MB em uso, %.2f MB em buracos, %.2f MB nos arquivos\n",
+           arquivos.size(), total.chunks, mb(total.usedSectors), mb(total.freeSectors), mb(total.fileSectors));
+    return 0;
+}
+
+int compacta(const string& dir) {
+    vector<string> arquivos = listaRegioes(dir);
+    if (arquivos.empty()) {
+        cerr << "Nenhuma regiao em " << dir << endl;
+        return 1;
+    }
+    uint32_t antesTotal = 0, depoisTotal = 0;
+    for (const string& arquivo : arquivos) {
+        RegionStats antes, depois;
+        if (!compactRegionFile(arquivo, &antes, &depois))
+            return 1;
+        printf("%s: %.2f MB -> %.2f MB\n", arquivo.c_str(), mb(antes.fileSectors), mb(depois.fileSectors));
+        antesTotal += antes.fileSectors;
+        depoisTotal += depois.fileSectors;
+    }
+    printf("Total: %.2f MB -> %.2f MB\n", mb(antesTotal), mb(depoisTotal));
+    return 0;
+}
+
+int converte(const string& arquivo, const string& dir) {
+    World world;
+    if (!loadGrid(world, arquivo.c_str())) {
+        cerr << "Falha ao carregar " << arquivo << endl;
+        return 1;
+    }
+    LightEngine luz;
+    luz.update(world);
+    unique_ptr<ChunkIO> io = createChunkIO();
+    RegionStore regioes;
+    if (!regioes.create(dir, world, *io))
+        return 1;
+    uintmax_t bytes = 0;
+    vector<string> arquivos = listaRegioes(dir);
+    for (const string& regiao : arquivos)
+        bytes += filesystem::file_size(regiao);
+    printf("%s -> %s: %dx%dx%d em %zu regioes, %.2f MB\n", arquivo.c_str(), dir.c_str(), world.sizeX(),
+           world.sizeY(), world.sizeZ(), arquivos.size(), bytes / (1024.0 * 1024.0));
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printUso();
+        return 1;
+    }
+    string comando = argv[1];
+    if (comando == "info")
+        return info(argv[2]);
+    if (comando == "compacta")
+        return compacta(argv[2]);
+    if (comando == "converte" && argc >= 4)
+        return converte(argv[2], argv[3]);
+    printUso();
+    return 1;
+}
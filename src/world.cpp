@@ -0,0 +1,349 @@
+#include "world.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+void World::resize(int sizeX, int sizeY, int sizeZ, bool resident) {
+    sx = sizeX;
+    sy = sizeY;
+    sz = sizeZ;
+    cx = (sx + CHUNK_TAM - 1) / CHUNK_TAM;
+    cy = (sy + CHUNK_TAM - 1) / CHUNK_TAM;
+    cz = (sz + CHUNK_TAM - 1) / CHUNK_TAM;
+    orig = glm::vec3(-(sx / 2) - 0.5f, -(sy / 2) - 0.5f, -(sz / 2) - 0.5f);
+
+    chunks.clear();
+    chunks.resize((size_t)cx * cy * cz);
+    evictedVersion.assign(chunks.size(), 0);
+    residentes = 0;
+    if (resident) {
+        for (unique_ptr<Chunk>& c : chunks) {
+            c = make_unique<Chunk>();
+            memset(c->voxels, 0, sizeof(c->voxels));
+            memset(c->light, 0, sizeof(c->light));
+        }
+        residentes = (int)chunks.size();
+    }
+    editCount++;
+    gen++;
+    editLog.clear();
+    editLogOverflow = true;
+    changedChunks.clear();
+    changedMark.assign(chunks.size(), 0);
+    changedAll = true;
+}
+
+// Esconde todos os voxels e volta a textura para 0 (tecla R)
+void World::clear() {
+    for (unique_ptr<Chunk>& c : chunks) {
+        if (!c)
+            continue;
+        memset(c->voxels, 0, sizeof(c->voxels));
+        c->visibleCount = 0;
+    }
+    touchAll();
+    editLog.clear();
+    editLogOverflow = true;
+}
+
+void World::touchAll() {
+    for (unique_ptr<Chunk>& c : chunks) {
+        if (!c)
+            continue;
+        c->version++;
+        for (int f = 0; f < NUM_FACES; f++)
+            c->faceVersion[f]++;
+        for (int b = 0; b < BRICKS_POR_CHUNK; b++)
+            c->brickVersion[b]++;
+    }
+    editCount++;
+    markAllChanged();
+}
+
+void World::copyChunk(int index, const Chunk& source) {
+    if (!chunks[index]) {
+        chunks[index] = make_unique<Chunk>(source);
+        residentes++;
+    }
+    else {
+        *chunks[index] = source;
+    }
+    editCount++;
+    markChanged(index);
+}
+
+const Chunk& World::ausente() {
+    static const Chunk vazio = []() {
+        Chunk c;
+        memset(c.voxels, 0, sizeof(c.voxels));
+        memset(c.light, 0, sizeof(c.light));
+        c.version = 0;
+        for (int f = 0; f < NUM_FACES; f++)
+            c.faceVersion[f] = 0;
+        for (int b = 0; b < BRICKS_POR_CHUNK; b++)
+            c.brickVersion[b] = 0;
+        return c;
+    }();
+    return vazio;
+}
+
+void World::installChunk(int index, unique_ptr<Chunk> chunk) {
+    uint32_t v = evictedVersion[index] + 1;
+    chunk->version = v;
+    for (int f = 0; f < NUM_FACES; f++)
+        chunk->faceVersion[f] = v;
+    for (int b = 0; b < BRICKS_POR_CHUNK; b++)
+        chunk->brickVersion[b] = v;
+    if (!chunks[index])
+        residentes++;
+    chunks[index] = move(chunk);
+    editCount++;
+    markChanged(index);
+}
+
+unique_ptr<Chunk> World::evictChunk(int index) {
+    unique_ptr<Chunk> c = move(chunks[index]);
+    if (c) {
+        // As outras versões nunca passam da do chunk (toda marca sobe version)
+        evictedVersion[index] = c->version;
+        residentes--;
+        editCount++;
+        markChanged(index);
+    }
+    return c;
+}
+
+// Marca o chunk, o brick e as bordas que a posição toca
+static void touch(Chunk& c, int lx, int ly, int lz) {
+    c.version++;
+    c.brickVersion[Chunk::brickIndex(lx, ly, lz)]++;
+    if (lx == CHUNK_TAM - 1) c.faceVersion[0]++;
+    if (lx == 0) c.faceVersion[1]++;
+    if (ly == CHUNK_TAM - 1) c.faceVersion[2]++;
+    if (ly == 0) c.faceVersion[3]++;
+    if (lz == CHUNK_TAM - 1) c.faceVersion[4]++;
+    if (lz == 0) c.faceVersion[5]++;
+}
+
+// Registro limitado: uma carga de arquivo inteira vira "refazer tudo"
+const size_t MAX_EDICOES_REGISTRADAS = 4096;
+
+void World::set(int x, int y, int z, uint8_t voxel) {
+    if (!inside(x, y, z)) return;
+
+    int lx = x % CHUNK_TAM, ly = y % CHUNK_TAM, lz = z % CHUNK_TAM;
+    int i = chunkIndex(x / CHUNK_TAM, y / CHUNK_TAM, z / CHUNK_TAM);
+    Chunk* c = chunks[i].get();
+    if (!c) return;
+    uint8_t& atual = c->voxels[Chunk::index(lx, ly, lz)];
+    if (atual == voxel) return;
+
+    c->visibleCount += (int)voxelVisivel(voxel) - (int)voxelVisivel(atual);
+    atual = voxel;
+    touch(*c, lx, ly, lz);
+    editCount++;
+    logEdit(x, y, z);
+    markChanged(i);
+}
+
+void World::logEdit(int x, int y, int z) {
+    if (editLogOverflow)
+        return;
+    if (editLog.size() < MAX_EDICOES_REGISTRADAS)
+        editLog.push_back({ x, y, z });
+    else {
+        editLog.clear();
+        editLogOverflow = true;
+    }
+}
+
+void World::writeBatched(int x, int y, int z, uint8_t voxel) {
+    if (!inside(x, y, z)) return;
+
+    int lx = x % CHUNK_TAM, ly = y % CHUNK_TAM, lz = z % CHUNK_TAM;
+    int i = chunkIndex(x / CHUNK_TAM, y / CHUNK_TAM, z / CHUNK_TAM);
+    Chunk* c = chunks[i].get();
+    if (!c) return;
+    uint8_t& atual = c->voxels[Chunk::index(lx, ly, lz)];
+    if (atual == voxel) return;
+
+    c->visibleCount += (int)voxelVisivel(voxel) - (int)voxelVisivel(atual);
+    atual = voxel;
+    logEdit(x, y, z);
+
+    // Mesmos bits que touch, guardados até o fim do lote
+    BatchMark& m = batchMarks[i];
+    if (!m.touched) {
+        m.touched = true;
+        batchChunks.push_back(i);
+    }
+    m.bits |= (uint16_t)(1u << Chunk::brickIndex(lx, ly, lz));
+    if (lx == CHUNK_TAM - 1) m.bits |= 1u << 8;
+    if (lx == 0) m.bits |= 1u << 9;
+    if (ly == CHUNK_TAM - 1) m.bits |= 1u << 10;
+    if (ly == 0) m.bits |= 1u << 11;
+    if (lz == CHUNK_TAM - 1) m.bits |= 1u << 12;
+    if (lz == 0) m.bits |= 1u << 13;
+}
+
+// Uma marca por chunk, brick e borda tocados, e uma edição para o mundo todo
+int World::finishBatch() {
+    for (int i : batchChunks) {
+        Chunk& c = *chunks[i];
+        BatchMark& m = batchMarks[i];
+        c.version++;
+        for (int b = 0; b < BRICKS_POR_CHUNK; b++)
+            if (m.bits & (1u << b))
+                c.brickVersion[b]++;
+        for (int f = 0; f < NUM_FACES; f++)
+            if (m.bits & (1u << (8 + f)))
+                c.faceVersion[f]++;
+        m = BatchMark();
+        markChanged(i);
+    }
+    int marcados = (int)batchChunks.size();
+    if (marcados > 0)
+        editCount++;
+    batchChunks.clear();
+    return marcados;
+}
+
+int World::applyWrites(const VoxelWrite* writes, size_t count) {
+    batchMarks.resize(chunks.size());
+    for (size_t i = 0; i < count; i++)
+        writeBatched(writes[i].x, writes[i].y, writes[i].z, writes[i].voxel);
+    return finishBatch();
+}
+
+int World::fill(int x0, int y0, int z0, int x1, int y1, int z1, uint8_t voxel) {
+    batchMarks.resize(chunks.size());
+    x0 = max(x0, 0), y0 = max(y0, 0), z0 = max(z0, 0);
+    x1 = min(x1, sx - 1), y1 = min(y1, sy - 1), z1 = min(z1, sz - 1);
+    for (int y = y0; y <= y1; y++)
+        for (int z = z0; z <= z1; z++)
+            for (int x = x0; x <= x1; x++)
+                writeBatched(x, y, z, voxel);
+    return finishBatch();
+}
+
+void World::setLight(int x, int y, int z, uint8_t luz) {
+    if (!inside(x, y, z)) return;
+
+    int lx = x % CHUNK_TAM, ly = y % CHUNK_TAM, lz = z % CHUNK_TAM;
+    int i = chunkIndex(x / CHUNK_TAM, y / CHUNK_TAM, z / CHUNK_TAM);
+    Chunk* c = chunks[i].get();
+    if (!c) return;
+    uint8_t& atual = c->light[Chunk::index(lx, ly, lz)];
+    if (atual == luz) return;
+    atual = luz;
+    touch(*c, lx, ly, lz);
+    editCount++;
+    markChanged(i);
+}
+
+bool World::takeEdits(vector<VoxelEdit>& out) {
+    out.swap(editLog);
+    editLog.clear();
+    bool ok = !editLogOverflow;
+    editLogOverflow = false;
+    return ok;
+}
+
+void World::markChanged(int index) {
+    if (changedAll || changedMark[index])
+        return;
+    changedMark[index] = 1;
+    changedChunks.push_back(index);
+}
+
+void World::markAllChanged() {
+    for (int i : changedChunks)
+        changedMark[i] = 0;
+    changedChunks.clear();
+    changedAll = true;
+}
+
+bool World::takeChangedChunks(vector<int>& out) {
+    out.clear();
+    out.swap(changedChunks);
+    for (int i : out)
+        changedMark[i] = 0;
+    bool ok = !changedAll;
+    changedAll = false;
+    return ok;
+}
+
+void World::setVisible(int x, int y, int z, bool visivel) {
+    uint8_t voxel = get(x, y, z);
+    set(x, y, z, visivel ? (voxel | VOXEL_VISIVEL) : (voxel & VOXEL_TEXTURA));
+}
+
+void World::setTexture(int x, int y, int z, int texID) {
+    uint8_t voxel = get(x, y, z);
+    set(x, y, z, (uint8_t)((voxel & VOXEL_VISIVEL) | (texID & VOXEL_TEXTURA)));
+}
+
+// Salva o estado da grid em um arquivo .dat
+bool saveGrid(const World& world, const char* filename) {
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) {
+        cerr << "Falha ao salvar grid!" << endl;
+        return false;
+    }
+
+    for (int y = 0; y < world.sizeY(); y++) {
+        for (int x = 0; x < world.sizeX(); x++) {
+            for (int z = 0; z < world.sizeZ(); z++) {
+                int texID = world.texture(x, y, z);
+                bool visivel = world.visible(x, y, z);
+                file.write(reinterpret_cast<char*>(&texID), sizeof(int));
+                file.write(reinterpret_cast<char*>(&visivel), sizeof(bool));
+            }
+        }
+    }
+
+    file.close();
+    return true;
+}
+
+// Carrega o estado da grid de um arquivo .dat
+bool loadGrid(World& world, const char* filename) {
+    ifstream file(filename, ios::binary | ios::ate);
+    if (!file.is_open()) {
+        cerr << "Falha ao carregar grid!" << endl;
+        return false;
+    }
+
+    // Cada voxel ocupa sizeof(int) + sizeof(bool) bytes
+    const long long voxelBytes = sizeof(int) + sizeof(bool);
+    long long total = (long long)file.tellg() / voxelBytes;
+    int tam = (int)llround(cbrt((double)total));
+    if ((long long)tam * tam * tam != total || tam == 0) {
+        cerr << "Arquivo de grid com tamanho invalido: " << filename << endl;
+        return false;
+    }
+    file.seekg(0);
+
+    if (world.sizeX() != tam || world.sizeY() != tam || world.sizeZ() != tam)
+        world.resize(tam, tam, tam);
+
+    for (int y = 0; y < tam; y++) {
+        for (int x = 0; x < tam; x++) {
+            for (int z = 0; z < tam; z++) {
+                int texID = 0;
+                bool visivel = false;
+                file.read(reinterpret_cast<char*>(&texID), sizeof(int));
+                file.read(reinterpret_cast<char*>(&visivel), sizeof(bool));
+                world.set(x, y, z, (uint8_t)((visivel ? VOXEL_VISIVEL : 0) | (texID & VOXEL_TEXTURA)));
+            }
+        }
+    }
+
+    file.close();
+    return true;
+}
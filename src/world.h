@@ -0,0 +1,196 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Lado de um chunk em voxels
+const int CHUNK_TAM = 16;
+const int CHUNK_VOLUME = CHUNK_TAM * CHUNK_TAM * CHUNK_TAM;
+
+// Bricks de 8^3 voxels (2x2x2 por chunk), a unidade de envio do espelho na GPU
+const int BRICK_TAM = 8;
+const int BRICKS_POR_EIXO = CHUNK_TAM / BRICK_TAM;
+const int BRICKS_POR_CHUNK = BRICKS_POR_EIXO * BRICKS_POR_EIXO * BRICKS_POR_EIXO;
+
+// Um voxel ocupa 1 byte: bits 0-6 = textura, bit 7 = visível.
+// A textura é mantida quando o voxel é escondido (V volta com a mesma textura)
+const uint8_t VOXEL_VISIVEL = 0x80;
+const uint8_t VOXEL_TEXTURA = 0x7F;
+
+inline bool voxelVisivel(uint8_t voxel) { return (voxel & VOXEL_VISIVEL) != 0; }
+inline int voxelTextura(uint8_t voxel) { return voxel & VOXEL_TEXTURA; }
+
+// Luz de um voxel em 1 byte: bits 4-7 = luz do céu, bits 0-3 = luz de blocos (0..15)
+const int LUZ_MAX = 15;
+inline int luzCeu(uint8_t luz) { return luz >> 4; }
+inline int luzBloco(uint8_t luz) { return luz & 0x0F; }
+inline uint8_t empacotaLuz(int ceu, int bloco) { return (uint8_t)((ceu << 4) | bloco); }
+// Fora do mundo é céu aberto
+const uint8_t LUZ_FORA = (uint8_t)(LUZ_MAX << 4);
+
+// Faces na ordem +X, -X, +Y, -Y, +Z, -Z
+const int NUM_FACES = 6;
+const int FACE_DIR[NUM_FACES][3] = {
+    { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+};
+
+struct Chunk {
+    uint8_t voxels[CHUNK_VOLUME];
+    uint8_t light[CHUNK_VOLUME];   // mesma ordem de voxels (ver LightEngine)
+    int visibleCount = 0;
+
+    // Incrementadas a cada edição (de voxel ou de luz). faceVersion[f] só muda quando
+    // a edição encosta na borda da face f (é o que os vizinhos enxergam no LOD 0)
+    uint32_t version = 1;
+    uint32_t faceVersion[NUM_FACES] = { 1, 1, 1, 1, 1, 1 };
+    // Uma versão por brick de 8^3, na mesma ordem y, z, x dos voxels
+    uint32_t brickVersion[BRICKS_POR_CHUNK] = { 1, 1, 1, 1, 1, 1, 1, 1 };
+
+    static int index(int x, int y, int z) { return (y * CHUNK_TAM + z) * CHUNK_TAM + x; }
+    static int brickIndex(int x, int y, int z) {
+        return ((y / BRICK_TAM) * BRICKS_POR_EIXO + z / BRICK_TAM) * BRICKS_POR_EIXO + x / BRICK_TAM;
+    }
+};
+
+// Posição editada por set, para quem precisa reagir voxel a voxel (luz)
+struct VoxelEdit {
+    int x, y, z;
+};
+
+// Escrita de um voxel num lote (applyWrites)
+struct VoxelWrite {
+    int x, y, z;
+    uint8_t voxel;
+};
+
+// Mundo de voxels dividido em chunks de CHUNK_TAM^3
+class World {
+public:
+    // Com resident = false nenhum chunk fica na memória (streaming: installChunk põe)
+    void resize(int sizeX, int sizeY, int sizeZ, bool resident = true);
+    void clear();
+
+    int sizeX() const { return sx; }
+    int sizeY() const { return sy; }
+    int sizeZ() const { return sz; }
+    int chunksX() const { return cx; }
+    int chunksY() const { return cy; }
+    int chunksZ() const { return cz; }
+    int chunkCount() const { return (int)chunks.size(); }
+    // Contador de edições do mundo inteiro (qualquer set/clear/resize)
+    uint64_t edits() const { return editCount; }
+    // Muda a cada resize: os chunks são recriados e as versões recomeçam
+    uint32_t generation() const { return gen; }
+
+    bool inside(int x, int y, int z) const {
+        return x >= 0 && y >= 0 && z >= 0 && x < sx && y < sy && z < sz;
+    }
+
+    // Fora do mundo é sempre vazio
+    uint8_t get(int x, int y, int z) const {
+        if (!inside(x, y, z)) return 0;
+        const Chunk& c = chunkAt(chunkIndex(x / CHUNK_TAM, y / CHUNK_TAM, z / CHUNK_TAM));
+        return c.voxels[Chunk::index(x % CHUNK_TAM, y % CHUNK_TAM, z % CHUNK_TAM)];
+    }
+    void set(int x, int y, int z, uint8_t voxel);
+    // Lotes (fila de edições): os voxels mudam um a um, mas cada chunk, brick e borda
+    // tocados são marcados uma vez só no fim. Devolvem quantos chunks mudaram
+    int applyWrites(const VoxelWrite* writes, size_t count);
+    // Caixa de x0..x1, y0..y1, z0..z1 (inclusivos, cortada nos limites do mundo)
+    int fill(int x0, int y0, int z0, int x1, int y1, int z1, uint8_t voxel);
+
+    uint8_t light(int x, int y, int z) const {
+        if (!inside(x, y, z)) return LUZ_FORA;
+        const Chunk& c = chunkAt(chunkIndex(x / CHUNK_TAM, y / CHUNK_TAM, z / CHUNK_TAM));
+        return c.light[Chunk::index(x % CHUNK_TAM, y % CHUNK_TAM, z % CHUNK_TAM)];
+    }
+    // Conta como edição do chunk (a luz vai para a malha e para o volume da GPU)
+    void setLight(int x, int y, int z, uint8_t luz);
+    // Depois de reescrever a luz de todos os chunks direto nos arrays
+    void touchAll();
+    // Substitui um chunk pela cópia de outro mundo do mesmo tamanho, com as versões
+    // dele (espelho do mundo na thread de render)
+    void copyChunk(int index, const Chunk& source);
+
+    // Residência (streaming). Um chunk fora da memória se lê como vazio, sem luz e com
+    // todas as versões 0; escritas nele (voxel ou luz) são ignoradas, como fora do
+    // mundo. Quem escreve direto nos arrays (chunk() não const) confere antes
+    bool resident(int index) const { return chunks[index] != nullptr; }
+    bool chunkResident(int x, int y, int z) const { return resident(chunkIndex(x, y, z)); }
+    int residentCount() const { return residentes; }
+    // Põe um chunk lido do disco. As versões passam todas a um valor acima das do chunk
+    // que saiu desse lugar, para quem as compara (malhas, volume, espelho) refazer
+    void installChunk(int index, std::unique_ptr<Chunk> chunk);
+    // Tira o chunk da memória e o devolve (para gravar, se mudou)
+    std::unique_ptr<Chunk> evictChunk(int index);
+
+    // Posições editadas desde a última chamada. Retorna false se o registro
+    // transbordou ou o mundo foi limpo/redimensionado: aí é preciso refazer tudo
+    bool takeEdits(std::vector<VoxelEdit>& out);
+    // Chunks que mudaram (versão ou residência) desde a última chamada, cada um uma vez.
+    // Retorna false na primeira chamada e depois de resize ou touchAll: aí é preciso
+    // olhar todos. Um leitor por mundo (quem publica o mundo ou quem o desenha)
+    bool takeChangedChunks(std::vector<int>& out);
+
+    bool visible(int x, int y, int z) const { return voxelVisivel(get(x, y, z)); }
+    int texture(int x, int y, int z) const { return voxelTextura(get(x, y, z)); }
+    void setVisible(int x, int y, int z, bool visivel);
+    void setTexture(int x, int y, int z, int texID);
+
+    int chunkIndex(int x, int y, int z) const { return (y * cz + z) * cx + x; }
+    bool chunkInside(int x, int y, int z) const {
+        return x >= 0 && y >= 0 && z >= 0 && x < cx && y < cy && z < cz;
+    }
+    // A versão não const só para chunks residentes
+    Chunk& chunk(int x, int y, int z) { return *chunks[chunkIndex(x, y, z)]; }
+    const Chunk& chunk(int x, int y, int z) const { return chunkAt(chunkIndex(x, y, z)); }
+    const Chunk& chunk(int index) const { return chunkAt(index); }
+
+    // Posição de mundo do canto mínimo do voxel (0, 0, 0). O voxel (x, y, z) ocupa
+    // o cubo unitário centrado em (x - sizeX/2, y - sizeY/2, z - sizeZ/2)
+    glm::vec3 origin() const { return orig; }
+    glm::vec3 voxelCenter(int x, int y, int z) const { return orig + glm::vec3(x + 0.5f, y + 0.5f, z + 0.5f); }
+
+private:
+    // Chunk vazio e constante no lugar dos que não estão na memória
+    static const Chunk& ausente();
+    const Chunk& chunkAt(int index) const { return chunks[index] ? *chunks[index] : ausente(); }
+
+    // Escrita sem marcar versões (só anota o chunk, o brick e as bordas em batchMarks)
+    void writeBatched(int x, int y, int z, uint8_t voxel);
+    int finishBatch();
+    void logEdit(int x, int y, int z);
+    void markChanged(int index);
+    void markAllChanged();
+
+    // Bricks (bits 0-7) e bordas (bits 8-13) tocados por chunk no lote em andamento
+    struct BatchMark {
+        uint16_t bits = 0;
+        bool touched = false;
+    };
+
+    int sx = 0, sy = 0, sz = 0;
+    int cx = 0, cy = 0, cz = 0;
+    glm::vec3 orig = glm::vec3(0.0f);
+    uint64_t editCount = 0;
+    uint32_t gen = 0;
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    // Versão de cada chunk ao sair da memória (a volta começa acima dela)
+    std::vector<uint32_t> evictedVersion;
+    int residentes = 0;
+    std::vector<VoxelEdit> editLog;
+    bool editLogOverflow = true;
+    std::vector<int> changedChunks;
+    std::vector<uint8_t> changedMark;
+    bool changedAll = true;
+    std::vector<BatchMark> batchMarks;
+    std::vector<int> batchChunks;
+};
+
+// Salva/carrega no formato .dat do editor: para cada voxel em ordem y, x, z,
+// um int com a textura e um bool de visibilidade. O tamanho do mundo é
+// deduzido do tamanho do arquivo (TAM^3 voxels)
+bool saveGrid(const World& world, const char* filename);
+bool loadGrid(World& world, const char* filename);